@@ -204,6 +204,11 @@ RasterLayerImp::RasterLayerImp(const string& id, const string& layerName, DataEl
    mpRedRasterElement.addSignal(SIGNAL_NAME(RasterElement, DataModified), Slot(this, &RasterLayerImp::fullImageRegenRed));
    mpGreenRasterElement.addSignal(SIGNAL_NAME(RasterElement, DataModified), Slot(this, &RasterLayerImp::fullImageRegenGreen));
    mpBlueRasterElement.addSignal(SIGNAL_NAME(RasterElement, DataModified), Slot(this, &RasterLayerImp::fullImageRegenBlue));
+   // Force total image regeneration when the statistics used by the stretch are refined
+   mpGrayStatistics.addSignal(SIGNAL_NAME(Statistics, Calculated), Slot(this, &RasterLayerImp::statisticsCalculatedGray));
+   mpRedStatistics.addSignal(SIGNAL_NAME(Statistics, Calculated), Slot(this, &RasterLayerImp::statisticsCalculatedRed));
+   mpGreenStatistics.addSignal(SIGNAL_NAME(Statistics, Calculated), Slot(this, &RasterLayerImp::statisticsCalculatedGreen));
+   mpBlueStatistics.addSignal(SIGNAL_NAME(Statistics, Calculated), Slot(this, &RasterLayerImp::statisticsCalculatedBlue));
 }
 
 RasterLayerImp::~RasterLayerImp()
@@ -261,6 +266,26 @@ void RasterLayerImp::elementModifiedBlue(Subject& subject, const string& signal,
    elementModified(subject, signal, v);
 }
 
+void RasterLayerImp::statisticsCalculatedGray(Subject& subject, const string& signal, const boost::any& v)
+{
+   statisticsCalculated(subject, signal, v);
+}
+
+void RasterLayerImp::statisticsCalculatedRed(Subject& subject, const string& signal, const boost::any& v)
+{
+   statisticsCalculated(subject, signal, v);
+}
+
+void RasterLayerImp::statisticsCalculatedGreen(Subject& subject, const string& signal, const boost::any& v)
+{
+   statisticsCalculated(subject, signal, v);
+}
+
+void RasterLayerImp::statisticsCalculatedBlue(Subject& subject, const string& signal, const boost::any& v)
+{
+   statisticsCalculated(subject, signal, v);
+}
+
 void RasterLayerImp::elementDeletedGray(Subject& subject, const string& signal, const boost::any& data)
 {
    setDisplayedBand(GRAY, DimensionDescriptor());
@@ -415,6 +440,7 @@ void RasterLayerImp::draw()
 
    if (mbRegenerate == true)
    {
+      calculateDisplayedStatistics();
       generateImage();
    }
 
@@ -3368,6 +3394,46 @@ Statistics* RasterLayerImp::getStatistics(RasterChannelType eColor) const
    return pRasterElement->getStatistics(band);
 }
 
+void RasterLayerImp::calculateDisplayedStatistics()
+{
+   // The statistics used by the stretch of the displayed bands are calculated from a subsample of the
+   // data at first, and the image is regenerated when the refined statistics are available
+   ComplexComponent eComponent = getComplexComponent();
+   bool bFastContrast = canApplyFastContrastStretch();
+   bool bGrayscale = (getDisplayMode() == GRAYSCALE_MODE);
+
+   const RasterChannelType channels[] = { GRAY, RED, GREEN, BLUE };
+   const DimensionDescriptor* pBands[] = { &mGrayBand, &mRedBand, &mGreenBand, &mBlueBand };
+   AttachmentPtr<Statistics>* pAttachments[] = { &mpGrayStatistics, &mpRedStatistics, &mpGreenStatistics,
+      &mpBlueStatistics };
+
+   for (int i = 0; i < 4; ++i)
+   {
+      Statistics* pStatistics = NULL;
+      if (bGrayscale == (channels[i] == GRAY) && pBands[i]->isValid() &&
+         (bFastContrast || getStretchUnits(channels[i]) != RAW_VALUE))
+      {
+         pStatistics = getStatistics(channels[i]);
+      }
+
+      pAttachments[i]->reset(pStatistics);
+      if (pStatistics != NULL)
+      {
+         pStatistics->calculateProgressively(eComponent);
+      }
+   }
+}
+
+void RasterLayerImp::statisticsCalculated(Subject& subject, const string& signal, const boost::any& v)
+{
+   if (boost::any_cast<ComplexComponent>(v) == getComplexComponent())
+   {
+      setImageChanged(true);
+      emit modified();
+      notify(SIGNAL_NAME(Subject, Modified));
+   }
+}
+
 double RasterLayerImp::percentileToRaw(double value, const double* pdPercentiles) const
 {
    if (pdPercentiles == NULL)
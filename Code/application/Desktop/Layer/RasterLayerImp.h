@@ -16,6 +16,7 @@
 #include "DimensionDescriptor.h"
 #include "LayerImp.h"
 #include "RasterElement.h"
+#include "Statistics.h"
 #include "TypesFile.h"
 
 #include <string>
@@ -27,7 +28,6 @@ class Image;
 class ImageFilterDescriptor;
 class QAction;
 class QMenu;
-class Statistics;
 
 class RasterLayerImp : public LayerImp
 {
@@ -77,6 +77,15 @@ public:
    void fullImageRegenGreen(Subject& subject, const std::string& signal, const boost::any& v);
    void fullImageRegenBlue(Subject& subject, const std::string& signal, const boost::any& v);
 
+   // Since Subject::attach does not reference count attachments, we need 4 
+   // separate slots to force attach/detach pairs to function correctly. When 
+   // Subject::attach is updated to reference count, these can be removed and
+   // statisticsCalculated can be used directly.
+   void statisticsCalculatedGray(Subject& subject, const std::string& signal, const boost::any& v);
+   void statisticsCalculatedRed(Subject& subject, const std::string& signal, const boost::any& v);
+   void statisticsCalculatedGreen(Subject& subject, const std::string& signal, const boost::any& v);
+   void statisticsCalculatedBlue(Subject& subject, const std::string& signal, const boost::any& v);
+
    RasterLayerImp& operator= (const RasterLayerImp& rasterLayer);
 
    LayerType getLayerType() const;
@@ -201,6 +210,8 @@ protected:
    virtual void applyFastContrastStretch();
    void applyFastContrastStretch(RasterChannelType element);
    virtual Statistics* getStatistics(RasterChannelType eColor) const;
+   void calculateDisplayedStatistics();
+   void statisticsCalculated(Subject& subject, const std::string& signal, const boost::any& v);
    double percentileToRaw(double value, const double* pdPercentiles) const;
    double rawToPercentile(double value, const double* pdPercentiles) const;
 
@@ -241,6 +252,12 @@ private:
    AttachmentPtr<RasterElement> mpGreenRasterElement;
    AttachmentPtr<RasterElement> mpBlueRasterElement;
 
+   // the statistics which are refined in the background for the stretch of the displayed bands
+   AttachmentPtr<Statistics> mpGrayStatistics;
+   AttachmentPtr<Statistics> mpRedStatistics;
+   AttachmentPtr<Statistics> mpGreenStatistics;
+   AttachmentPtr<Statistics> mpBlueStatistics;
+
    std::vector<double> mlstGrayStretchValues;
    std::vector<double> mlstRedStretchValues;
    std::vector<double> mlstGreenStretchValues;
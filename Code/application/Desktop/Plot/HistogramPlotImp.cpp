@@ -525,6 +525,8 @@ HistogramPlotImp::HistogramPlotImp(const string& id, const string& viewName, QGL
    // Connections
    mpElement.addSignal(SIGNAL_NAME(Subject, Deleted), Slot(this, &HistogramPlotImp::elementDeleted));
    mpElement.addSignal(SIGNAL_NAME(Subject, Modified), Slot(this, &HistogramPlotImp::elementModified));
+   mpDisplayedStatistics.addSignal(SIGNAL_NAME(Statistics, Calculated),
+      Slot(this, &HistogramPlotImp::statisticsCalculated));
 
    VERIFYNR(connect(this, SIGNAL(classificationChanged(const Classification*)), this,
       SLOT(updateElementClassification(const Classification*))));
@@ -885,6 +887,12 @@ void HistogramPlotImp::elementModified(Subject& subject, const string& signal, c
    }
 }
 
+void HistogramPlotImp::statisticsCalculated(Subject& subject, const string& signal, const boost::any& value)
+{
+   // Update the histogram when the statistics calculated from a subsample of the data are refined
+   updateHistogramValues();
+}
+
 void HistogramPlotImp::setName(const string& name)
 {
    if (name.empty() == true)
@@ -3156,6 +3164,7 @@ void HistogramPlotImp::updateHistogramValues(bool force)
       const double* pHistogramLocations = NULL;
 
       Statistics* pStatistics = getStatistics();
+      mpDisplayedStatistics.reset(pStatistics);
       if (pStatistics != NULL)
       {
          ComplexComponent eComponent = RasterLayer::getSettingComplexComponent();
@@ -3166,6 +3175,7 @@ void HistogramPlotImp::updateHistogramValues(bool force)
             eComponent = pRasterLayer->getComplexComponent();
          }
 
+         pStatistics->calculateProgressively(eComponent);
          pStatistics->getHistogram(pHistogramLocations, pHistogramCounts, eComponent);
       }
 
@@ -22,6 +22,7 @@
 #include "Layer.h"
 #include "Observer.h"
 #include "RasterElement.h"
+#include "Statistics.h"
 #include "StringUtilities.h"
 #include "TypesFile.h"
 
@@ -61,6 +62,7 @@ public:
    void classificationModified(Subject& subject, const std::string& signal, const boost::any& value);
    void elementModified(Subject &subject, const std::string &signal, const boost::any &v);
    void elementDeleted(Subject &subject, const std::string &signal, const boost::any &v);
+   void statisticsCalculated(Subject& subject, const std::string& signal, const boost::any& value);
 
    void setName(const std::string& name);
 
@@ -201,6 +203,7 @@ private:
    RasterChannelType mRasterChannelType;
    SafePtr<Layer> mpLayer;
    AttachmentPtr<RasterElement> mpElement;
+   AttachmentPtr<Statistics> mpDisplayedStatistics;
    bool mAutoZoom;
 
    Statistics* mpStats;
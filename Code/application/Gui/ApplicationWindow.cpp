@@ -215,6 +215,14 @@ ApplicationWindow::ApplicationWindow(QWidget* pSplash) :
       setAutoSaveTimerEnabled(true);
    }
 
+   ///////////////////////////
+   // Raster Pager Counters //
+   ///////////////////////////
+
+   mpPagerCountersTimer = new QTimer(this);
+   VERIFYNR(connect(mpPagerCountersTimer, SIGNAL(timeout()), this, SLOT(logRasterPagerCounters())));
+   setPagerCountersTimerInterval(ConfigurationSettings::getSettingRasterPagerCountersLogInterval());
+
    //////////////////
    // User Actions //
    //////////////////
@@ -2698,6 +2706,11 @@ void ApplicationWindow::autoSaveSession()
    mpSaveTimer->start();
 }
 
+void ApplicationWindow::logRasterPagerCounters()
+{
+   Service<ModelServices>()->logRasterPagerCounters();
+}
+
 bool ApplicationWindow::saveSession()
 {
    Service<SessionManager> pManager;
@@ -5262,6 +5275,18 @@ void ApplicationWindow::setAutoSaveTimerInterval(unsigned int interval)
    mpSaveTimer->setInterval(interval < 1 ? 1*minute : interval > 1440 ? 1440*minute : interval*minute);
 }
 
+void ApplicationWindow::setPagerCountersTimerInterval(unsigned int interval)
+{
+   if (interval == 0)
+   {
+      mpPagerCountersTimer->stop();
+   }
+   else
+   {
+      mpPagerCountersTimer->start(static_cast<int>(min(interval, 86400U)) * 1000);
+   }
+}
+
 void ApplicationWindow::optionsModified(Subject &subject, const string &signal, const boost::any &value)
 {
    string key = boost::any_cast<string>(value);
@@ -5273,6 +5298,10 @@ void ApplicationWindow::optionsModified(Subject &subject, const string &signal,
    {
       setAutoSaveTimerEnabled(SessionManager::getSettingAutoSaveEnabled());
    }
+   else if (key == ConfigurationSettings::getSettingRasterPagerCountersLogIntervalKey())
+   {
+      setPagerCountersTimerInterval(ConfigurationSettings::getSettingRasterPagerCountersLogInterval());
+   }
 }
 
 void ApplicationWindow::closeEvent(QCloseEvent* e)
@@ -137,6 +137,7 @@ public:
 
    void setAutoSaveTimerEnabled(bool enabled);
    void setAutoSaveTimerInterval(unsigned int interval); // interval is a number of minutes in the range [1,1440].
+   void setPagerCountersTimerInterval(unsigned int interval); // interval is a number of seconds, 0 to disable.
    void optionsModified(Subject &subject, const std::string &signal, const boost::any &value);
 
 public slots:
@@ -182,6 +183,7 @@ protected:
 
    QTimer *mpSaveTimer;
    bool mAutoTimerRetryOnLock;
+   QTimer *mpPagerCountersTimer;
 
    // Application Window management
    bool eventFilter(QObject* o, QEvent* e);
@@ -199,6 +201,7 @@ protected slots:
    void openSession();
    bool newSession();
    void autoSaveSession();
+   void logRasterPagerCounters();
    bool saveSession();
    bool saveSessionAs();
 
@@ -540,6 +540,7 @@ public:
    SETTING_PTR(MessageLogPath, FileLocations, Filename)
    SETTING(NumberOfMruFiles, General, unsigned int, 3)
    SETTING_PTR(SupportFilesPath, FileLocations, Filename)
+   SETTING_PTR(StatisticsCachePath, FileLocations, Filename)
    SETTING(ShowStatusBarCubeValue, StatusBar, bool, true)
    SETTING(ShowStatusBarCubeValueUnits, StatusBar, bool, true)
    SETTING(ShowStatusBarElevationValue, StatusBar, bool, true)
@@ -557,6 +558,8 @@ public:
    CUSTOM_SETTING_PTR(PluginWorkingDirectory, FileLocations, Filename)
    SETTING(AlternateMouseWheelZoom, Edit, bool, true)
    SETTING(GpuTextureCacheSize, General, unsigned int, 0)
+   SETTING(RasterCacheSize, General, unsigned int, 512)
+   SETTING(RasterPagerCountersLogInterval, General, unsigned int, 0)
    SETTING(DisplayClassificationMarkings, General, bool, true)
 
    /**
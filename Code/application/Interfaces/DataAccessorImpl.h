@@ -16,6 +16,7 @@
 #include "DataRequest.h"
 #include "TypesFile.h"
 #include "ObjectResource.h"
+#include <algorithm>
 #include <exception>
 #include <stdexcept>
 
@@ -23,6 +24,8 @@ class RasterPage;
 
 typedef double (*convertToDouble)(const void*, int, ComplexComponent);
 typedef int64_t (*convertToInteger)(const void*, int, ComplexComponent);
+typedef void (*convertRowToDouble)(const void*, size_t, double*, size_t, ComplexComponent);
+typedef void (*convertRowToFloat)(const void*, size_t, float*, size_t, ComplexComponent);
 
 /**
  * Provides a generic interface to the dataset.
@@ -56,7 +59,30 @@ typedef int64_t (*convertToInteger)(const void*, int, ComplexComponent);
  *    nextRow()
  * @endcode
  *
- * @see      RasterElement::getDataAccessor()
+ * Algorithms which operate on a neighborhood of pixels can instead use a
+ * tiled DataRequest so that only cache-sized blocks of the data are held in
+ * memory at once.  Each tile is concurrentRows by concurrentColumns in size,
+ * except at the right and bottom edges of the request where it is clipped.
+ *
+ * @code
+ *   while the accessor is valid
+ *      for each row in getTileRowCount()
+ *         for each column in getTileColumnCount()
+ *            value = *getColumn()
+ *            // Do something useful with the value.
+ *            nextColumn()
+ *         nextRow()
+ *      nextTile()
+ * @endcode
+ *
+ * For a DataRequest with a row or column stride, nextRow() and nextColumn()
+ * advance to the next requested row and column, and toPixel() accepts the
+ * active numbers of requested pixels.  The requested columns of a row are
+ * not adjacent, so use getColumn() or getRowAs() instead of indexing
+ * from getRow().
+ *
+ * @see      RasterElement::getDataAccessor(), DataRequest::setTiled(),
+ *           DataRequest::setRowStride()
  */
 class DataAccessorImpl
 {
@@ -89,11 +115,20 @@ public:
     *           example, sizeof(long), sizeof(float), etc.
     *  @param   pRasterElement
     *           This is a reference to the RasterElement class "owning" this DataAccessor.
+    *  @param   rowStep
+    *           The number of rows of each page between consecutive requested rows.
+    *           This is greater than 1 if the RasterPager does not skip the rows
+    *           between those of a strided request.
+    *  @param   columnStep
+    *           The number of columns of each page between consecutive requested
+    *           columns.  Pages always hold adjacent columns, so this is the
+    *           column stride of the request.
     */
    DataAccessorImpl(char *pPage, DataRequest *pRequest, size_t concurrentRows,
       size_t interLineBytes, size_t concurrentColumns,
       size_t concurrentBands, 
-      size_t elementSize, RasterElement* pRasterElement) :
+      size_t elementSize, RasterElement* pRasterElement,
+      size_t rowStep = 1, size_t columnStep = 1) :
       mbValid(true),
       mpPage(pPage),
       mpRasterElement(pRasterElement),
@@ -101,15 +136,20 @@ public:
       mpRasterPager(NULL),
       mpRequest(pRequest),
       mConcurrentRows(concurrentRows),
+      mReadAheadRow(concurrentRows),
       mConcurrentColumns(concurrentColumns),
       mConcurrentBands(concurrentBands),
       mCurrentRow(0),
       mCurrentColumn(0),
+      mRowStep(std::max(rowStep, static_cast<size_t>(1))),
+      mColumnStep(std::max(columnStep, static_cast<size_t>(1))),
       mRowOffset(0),
       mColumnOffset(0),
       mRefCount(0),
       mConvertToDoubleFunc(NULL),
-      mConvertToIntegerFunc(NULL)
+      mConvertToIntegerFunc(NULL),
+      mConvertRowToDoubleFunc(NULL),
+      mConvertRowToFloatFunc(NULL)
    {
       if (pPage == NULL || mpRasterElement == NULL || mpRequest.get() == NULL)
       {
@@ -118,6 +158,9 @@ public:
       mAccessorRow = mpRequest->getStartRow().getActiveNumber();
       mAccessorColumn = mpRequest->getStartColumn().getActiveNumber();
       mAccessorBand = mpRequest->getStartBand().getActiveNumber();
+      mTileRow = mAccessorRow;
+      mTileColumn = mAccessorColumn;
+      mRowStride = mRowStep * mpRequest->getRowStride();
       updateDataSizes(elementSize, interLineBytes);
    }
 
@@ -163,7 +206,10 @@ public:
       {
          mCurrentColumn = mColumnOffset = 0;
       } 
-      updateIfNeeded();
+      if (isPastTile() == false)
+      {
+         updateIfNeeded();
+      }
    }
 
    /**
@@ -191,7 +237,10 @@ public:
          {
             mCurrentColumn=mColumnOffset=0;
          } 
-         updateIfNeeded(); 
+         if (isPastTile() == false)
+         {
+            updateIfNeeded();
+         }
       } 
    }
 
@@ -246,6 +295,89 @@ public:
       return mConvertToIntegerFunc(&mpPage[mRowOffset + mColumnOffset], iIndex, component);
    }
 
+   /**
+    * Converts a run of columns in the current row to doubles.
+    *
+    * This is equivalent to calling getColumnAsDouble() for each column, but
+    * the data type is only dispatched once for the whole run so the
+    * conversion can be vectorized by the compiler.  The current column is
+    * not changed.
+    *
+    * @param pValues
+    *        The buffer which receives the values.  It must hold at least
+    *        \p count values.
+    * @param count
+    *        The number of columns to convert, starting with the current
+    *        column.  No bounds checking is performed on the count.
+    * @param band
+    *        The band to convert, relative to the first band available in
+    *        the accessor.  For BSQ data, only band 0 is available.
+    * @param component
+    *        For complex data, the component of the complex data to convert.
+    *        For non-complex data, this value is ignored.
+    * @param columnStep
+    *        The number of accessor columns between converted values.  Only
+    *        every columnStep-th column is converted, and the values are
+    *        stored contiguously in \p pValues.
+    *
+    * @see getColumnAs()
+    */
+   inline void getRowAs(double* pValues, size_t count, unsigned int band = 0,
+      ComplexComponent component = COMPLEX_MAGNITUDE, unsigned int columnStep = 1) const
+   {
+      mConvertRowToDoubleFunc(&mpPage[mRowOffset + mColumnOffset + band * mBandSize], mColumnSize * columnStep,
+         pValues, count, component);
+   }
+
+   /**
+    * Converts a run of columns in the current row to floats.
+    *
+    * The values are converted in the same way as the double overload of
+    * getRowAs(), and then narrowed to a float.
+    */
+   inline void getRowAs(float* pValues, size_t count, unsigned int band = 0,
+      ComplexComponent component = COMPLEX_MAGNITUDE, unsigned int columnStep = 1) const
+   {
+      mConvertRowToFloatFunc(&mpPage[mRowOffset + mColumnOffset + band * mBandSize], mColumnSize * columnStep,
+         pValues, count, component);
+   }
+
+   /**
+    * Converts the bands of the current column to doubles.
+    *
+    * This is intended for BIP data, where it converts the spectrum of the
+    * current pixel at once.  For BIL data, the bands are read across the
+    * current row.  For BSQ data, only one band is available.
+    *
+    * @param pValues
+    *        The buffer which receives the values.  It must hold at least
+    *        \p count values.
+    * @param count
+    *        The number of bands to convert, starting with the first band
+    *        available in the accessor.  No bounds checking is performed on
+    *        the count.
+    * @param component
+    *        For complex data, the component of the complex data to convert.
+    *        For non-complex data, this value is ignored.
+    *
+    * @see getRowAs()
+    */
+   inline void getColumnAs(double* pValues, size_t count, ComplexComponent component = COMPLEX_MAGNITUDE) const
+   {
+      mConvertRowToDoubleFunc(&mpPage[mRowOffset + mColumnOffset], mBandSize, pValues, count, component);
+   }
+
+   /**
+    * Converts the bands of the current column to floats.
+    *
+    * The values are converted in the same way as the double overload of
+    * getColumnAs(), and then narrowed to a float.
+    */
+   inline void getColumnAs(float* pValues, size_t count, ComplexComponent component = COMPLEX_MAGNITUDE) const
+   {
+      mConvertRowToFloatFunc(&mpPage[mRowOffset + mColumnOffset], mBandSize, pValues, count, component);
+   }
+
    /**
     *  Advances to the next column in the dataset.
     *
@@ -297,11 +429,111 @@ public:
    { 
       mCurrentRow = row-mAccessorRow; 
       mCurrentColumn = column-mAccessorColumn; 
+      if (mRowStride != 1)
+      {
+         mCurrentRow /= mRowStride;
+      }
+      if (mColumnStep != 1)
+      {
+         mCurrentColumn /= mColumnStep;
+      }
       mRowOffset = mCurrentRow * mRowSize;
       mColumnOffset = mCurrentColumn * mColumnSize;
       updateIfNeeded(); 
    }
 
+   /**
+    *  Advances to the next tile in the dataset.
+    *
+    *  Tiles are visited from left to right across the requested columns and
+    *  then from top to bottom across the requested rows.  The current row and
+    *  column are reset to the top left pixel of the new tile.  Once the last
+    *  tile of the request has been passed, the accessor becomes invalid.
+    *
+    *  If the request is not tiled, each tile spans all of the requested
+    *  columns, so this advances by the number of concurrent rows.
+    *
+    *  @see     DataRequest::setTiled(), getTileRowCount(), getTileColumnCount()
+    */
+   inline void nextTile()
+   {
+      if (mpRasterElement == NULL)
+      {
+         throw std::logic_error("DataAccessor back-pointer to data cube has become corrupted");
+      }
+
+      getNextTile(mTileRow, mTileColumn);
+      mAccessorRow = mTileRow;
+      mAccessorColumn = mTileColumn;
+      mCurrentRow = mCurrentColumn = mRowOffset = mColumnOffset = 0;
+      if (mTileRow > mpRequest->getStopRow().getActiveNumber())
+      {
+         mbValid = false;
+         return;
+      }
+
+      mpRasterElement->incrementDataAccessor(*this);
+   }
+
+   /**
+    *  Access the first row of the current tile.
+    *
+    *  @return The active row number of the top row of the current tile.
+    *
+    *  @see     nextTile()
+    */
+   inline size_t getTileRow() const
+   {
+      return mTileRow;
+   }
+
+   /**
+    *  Access the first column of the current tile.
+    *
+    *  @return The active column number of the left column of the current tile.
+    *
+    *  @see     nextTile()
+    */
+   inline size_t getTileColumn() const
+   {
+      return mTileColumn;
+   }
+
+   /**
+    *  Access the number of rows in the current tile.
+    *
+    *  @return The number of rows in the current tile.  This is the number of
+    *          concurrent rows in the request, unless the tile is at the
+    *          bottom edge of the request.
+    *
+    *  @see     nextTile()
+    */
+   inline size_t getTileRowCount() const
+   {
+      size_t remainingRows = (mpRequest->getStopRow().getActiveNumber() - mTileRow) / mRowStride + 1;
+      return std::min(static_cast<size_t>(mpRequest->getConcurrentRows()), remainingRows);
+   }
+
+   /**
+    *  Access the number of columns in the current tile.
+    *
+    *  @return The number of columns in the current tile.  This is the number
+    *          of concurrent columns in a tiled request, unless the tile is at
+    *          the right edge of the request.
+    *
+    *  @see     nextTile()
+    */
+   inline size_t getTileColumnCount() const
+   {
+      size_t remainingColumns = (mpRequest->getStopColumn().getActiveNumber() - mTileColumn) / mColumnStep + 1;
+      if (mpRequest->getTiled() == false)
+      {
+         return remainingColumns;
+      }
+
+      return std::min(static_cast<size_t>(mpRequest->getConcurrentColumns()), remainingColumns);
+   }
+
    /**
     *  Returns the RasterElement associated with this DataAccessor.
     *
@@ -372,7 +604,7 @@ public:
     */
    inline size_t getRowSize() const
    {
-      return mRowSize - mInterlineBytes;
+      return mRowSize / mRowStep - mInterlineBytes;
    }
 
    /**
@@ -387,6 +619,20 @@ public:
       return mConcurrentColumns;
    }
 
+   /**
+    *  Access the number of bands available concurrently.
+    *
+    *  This may be more than the number of bands in the request.
+    *
+    *  @return The number of concurrent bands.
+    *
+    *  @see getColumn()
+    */
+   inline size_t getConcurrentBands() const
+   {
+      return mConcurrentBands;
+   }
+
 private:
    friend class RasterElementImp;
 
@@ -394,19 +640,66 @@ private:
     *  Jumps to the next column and row.
     *
     *  This method enables the DataAccessor to update the view into the dataset
-    *  or read in the next block of data, if necessary.
+    *  or read in the next block of data, if necessary.  Once the read-ahead
+    *  row of the current block has been passed, the pager is asked to start
+    *  loading the next block.
     */
    inline void updateIfNeeded()
    {
-      if (mCurrentRow >= mConcurrentRows)
+      if (mCurrentRow >= mReadAheadRow)
       {
          if (mpRasterElement == NULL)
          {
             throw std::logic_error("DataAccessor back-pointer to data cube has become corrupted");
          }
-         mpRasterElement->incrementDataAccessor(*this);
-         mCurrentRow = 0;
-         mRowOffset = 0;
+         if (mCurrentRow >= mConcurrentRows)
+         {
+            mpRasterElement->incrementDataAccessor(*this);
+            mCurrentRow = 0;
+            mRowOffset = 0;
+         }
+         else
+         {
+            mpRasterElement->prefetchDataAccessor(*this);
+         }
+      }
+   }
+
+   /**
+    *  Queries whether the current row is below the current tile.
+    *
+    *  The rows of a tiled request below the tile are fetched by nextTile(),
+    *  so nextRow() does not fetch them.
+    *
+    *  @return True if the request is tiled and the current row is past the
+    *          last row of the tile, otherwise false.
+    */
+   inline bool isPastTile() const
+   {
+      if (mpRequest.get() == NULL || mpRequest->getTiled() == false)
+      {
+         return false;
+      }
+
+      return (mAccessorRow - mTileRow) / mRowStride + mCurrentRow >= getTileRowCount();
+   }
+
+   /**
+    *  Find the tile which follows the current tile.
+    *
+    *  @param row
+    *         Set to the active number of the first row of the next tile.
+    *  @param column
+    *         Set to the active number of the first column of the next tile.
+    */
+   inline void getNextTile(size_t& row, size_t& column) const
+   {
+      row = mTileRow;
+      column = mTileColumn + mpRequest->getConcurrentColumns();
+      if (mpRequest->getTiled() == false || column > mpRequest->getStopColumn().getActiveNumber())
+      {
+         row += mpRequest->getConcurrentRows() * mRowStride;
+         column = mpRequest->getStartColumn().getActiveNumber();
       }
    }
 
@@ -420,6 +713,10 @@ private:
     *  @param interLineBytes
     *         the number of bytes between each line that do not contain
     *         raw data. This includes bytes which come before the next line.
+    *
+    *  The concurrent rows and columns of the page are reduced to the number of
+    *  requested rows and columns it holds, and the row and column sizes step
+    *  over the rows and columns between them.
     */
    void updateDataSizes(size_t elementSize, size_t interLineBytes)
    {
@@ -429,18 +726,32 @@ private:
       case BIP:
          mColumnSize = elementSize * mConcurrentBands;
          mRowSize = mColumnSize * mConcurrentColumns + interLineBytes;
+         mBandSize = elementSize;
          break;
       case BIL:
          mColumnSize = elementSize;
          mRowSize = mColumnSize * mConcurrentColumns * mConcurrentBands + interLineBytes;
+         mBandSize = elementSize * mConcurrentColumns;
          break;
       case BSQ:
          mColumnSize = elementSize;
          mRowSize = mColumnSize * mConcurrentColumns + interLineBytes;
+         mBandSize = 0;
          break;
       default:
          throw std::logic_error("DataAccessorImpl constructor received unknown interleave");
       }
+
+      if (mRowStep > 1)
+      {
+         mConcurrentRows = (mConcurrentRows + mRowStep - 1) / mRowStep;
+         mRowSize *= mRowStep;
+      }
+      if (mColumnStep > 1)
+      {
+         mConcurrentColumns = (mConcurrentColumns + mColumnStep - 1) / mColumnStep;
+         mColumnSize *= mColumnStep;
+      }
    }
 
    bool mbValid;
@@ -450,12 +761,17 @@ private:
    RasterPager* mpRasterPager;
    FactoryResource<DataRequest> mpRequest;
    size_t mConcurrentRows;             // Number of rows currently available in memory at once.
+   size_t mReadAheadRow;               // Row at which the next block is prefetched, never more than mConcurrentRows
    size_t mConcurrentColumns;          // Number of columns currently available in memory at once.
    size_t mConcurrentBands;            // Number of bands currently available in memory at once.
    size_t mCurrentRow;                 // Current processing row
    size_t mCurrentColumn;              // Current processing column
+   size_t mRowStep;                    // Rows of a page between requested rows
+   size_t mColumnStep;                 // Columns of a page between requested columns
+   size_t mRowStride;                  // Rows of the element between requested rows
    size_t mRowSize;                    // Size of a full row
    size_t mColumnSize;                 // Size of a full column
+   size_t mBandSize;                   // Offset between bands of a column, 0 if only one band is available
    size_t mRowOffset;                  // Row offset into the cube
    size_t mColumnOffset;               // Column offset into the cube
    size_t mInterlineBytes;             // Number of bytes of non-data between rows
@@ -464,9 +780,14 @@ private:
    size_t mAccessorRow;
    size_t mAccessorBand;
 
+   size_t mTileRow;                    // First row of the current tile
+   size_t mTileColumn;                 // First column of the current tile
+
    int mRefCount;
    convertToDouble mConvertToDoubleFunc;
    convertToInteger mConvertToIntegerFunc;
+   convertRowToDouble mConvertRowToDoubleFunc;
+   convertRowToFloat mConvertRowToFloatFunc;
 };
 
 #endif
@@ -81,7 +81,10 @@ public:
     *        The descriptor to use to determine required version.
     *
     * @return The smallest version number which can properly use this
-    *         DataRequest.  Currently always returns 1.
+    *         DataRequest.  Returns 3 if the request has a row or column
+    *         stride, 2 if the request is tiled, or 1 otherwise.
+    *
+    * @see setTiled(), setRowStride(), setColumnStride()
     *
     * @see RasterPager::getSupportedRequestVersion()
     */
@@ -286,6 +289,107 @@ public:
     */
    virtual void setWritable(bool writable) = 0;
 
+   /**
+    * Get whether the request is for tiled access.
+    *
+    * This defaults to false.
+    *
+    * @return True if the request is for tiled access, false otherwise.
+    *
+    * @see setTiled()
+    */
+   virtual bool getTiled() const = 0;
+
+   /**
+    * Set whether the request is for tiled access.
+    *
+    * A tiled request divides the requested rows and columns into tiles of
+    * concurrent rows by concurrent columns.  Each page provided for the
+    * request only contains the columns of a single tile, so algorithms
+    * which operate on a neighborhood of pixels do not need to hold entire
+    * rows of a wide data set in memory.  Use DataAccessorImpl::nextTile()
+    * to step through the tiles.
+    *
+    * If the request is not tiled, the concurrent columns are a hint and
+    * pages may contain more columns than requested.
+    *
+    * @warning Tiled access to BIL data is only supported for a single band
+    *          at a time.  Tiled access requires a RasterPager which supports
+    *          request version 2.
+    *
+    * @param tiled
+    *        True if the request is for tiled access, false otherwise.
+    *
+    * @see getTiled(), getRequestVersion(), RasterPager::getSupportedRequestVersion()
+    */
+   virtual void setTiled(bool tiled) = 0;
+
+   /**
+    * Get the requested row stride.
+    *
+    * This defaults to 1.
+    *
+    * @return The number of rows between consecutive requested rows.
+    *
+    * @see setRowStride()
+    */
+   virtual unsigned int getRowStride() const = 0;
+
+   /**
+    * Set the requested row stride.
+    *
+    * A strided request only accesses every n-th row between the start and
+    * stop rows, beginning with the start row.  The concurrent rows count
+    * requested rows, so a DataAccessor for a request with a row stride of 4
+    * and 2 concurrent rows holds rows \c start and \c start+4 at once.
+    * DataAccessorImpl::nextRow() advances to the next requested row.
+    *
+    * Pagers which support request version 3 read only the requested rows,
+    * so decimated passes over a data set read proportionally less data.
+    * Other pagers read the intervening rows and the accessor skips them.
+    *
+    * @warning Strided requests cannot be tiled or writable.
+    *
+    * @param stride
+    *        The number of rows between consecutive requested rows.
+    *        A value of 0 is treated as 1.
+    *
+    * @see getRowStride(), setColumnStride(), getRequestVersion()
+    */
+   virtual void setRowStride(unsigned int stride) = 0;
+
+   /**
+    * Get the requested column stride.
+    *
+    * This defaults to 1.
+    *
+    * @return The number of columns between consecutive requested columns.
+    *
+    * @see setColumnStride()
+    */
+   virtual unsigned int getColumnStride() const = 0;
+
+   /**
+    * Set the requested column stride.
+    *
+    * A strided request only accesses every n-th column between the start and
+    * stop columns, beginning with the start column.  The concurrent columns
+    * count requested columns and default to all of the requested columns.
+    * DataAccessorImpl::nextColumn() advances to the next requested column.
+    *
+    * @warning Strided requests cannot be tiled or writable.  The requested
+    *          columns of a row are not necessarily adjacent in memory, so
+    *          use DataAccessorImpl::getColumn() rather than indexing from
+    *          DataAccessorImpl::getRow().
+    *
+    * @param stride
+    *        The number of columns between consecutive requested columns.
+    *        A value of 0 is treated as 1.
+    *
+    * @see getColumnStride(), setRowStride(), getRequestVersion()
+    */
+   virtual void setColumnStride(unsigned int stride) = 0;
+
 protected:
    /**
     * This should be destroyed by calling ObjectFactory::destroyObject.
@@ -13,6 +13,7 @@
 #include "Any.h"
 #include "AnyData.h"
 #include "ComplexData.h"
+#include "RasterPagerCounters.h"
 #include "Service.h"
 #include "Subject.h"
 #include "switchOnEncoding.h"
@@ -25,6 +26,8 @@
 class DataDescriptor;
 class DataElement;
 class ImportDescriptor;
+class RasterCache;
+class RasterElement;
 
 /**
  *  \ingroup ServiceModule
@@ -723,6 +726,107 @@ public:
     */
    virtual void deleteMemoryBlock(char* memory) = 0; 
 
+   /**
+    *  Adds a raster cache to the process-wide raster memory budget.
+    *
+    *  Memory held by registered caches counts against
+    *  ConfigurationSettings::getSettingRasterCacheSize().  When the budget is
+    *  exceeded, the least recently used data across all registered caches is
+    *  released first.
+    *
+    *  @param   pCache
+    *           The cache to register.  The cache must be unregistered with
+    *           unregisterRasterCache() before it is destroyed.
+    *
+    *  @see     enforceRasterCacheBudget()
+    */
+   virtual void registerRasterCache(RasterCache* pCache) = 0;
+
+   /**
+    *  Removes a raster cache from the process-wide raster memory budget.
+    *
+    *  Once this method returns, the cache will no longer be accessed by
+    *  ModelServices.
+    *
+    *  @param   pCache
+    *           The cache to unregister.
+    */
+   virtual void unregisterRasterCache(RasterCache* pCache) = 0;
+
+   /**
+    *  Returns a new access time for raster cache data.
+    *
+    *  Registered caches stamp their data with the returned value whenever it
+    *  is used, so that data can be ordered by use across all caches.
+    *
+    *  This method may be called simultaneously by multiple threads.
+    *
+    *  @return  A value greater than any previously returned value.
+    */
+   virtual uint64_t getRasterCacheAccess() = 0;
+
+   /**
+    *  Releases raster cache data until the registered caches fit within
+    *  the raster memory budget.
+    *
+    *  Caches should call this method after they have grown.  It must not be
+    *  called while holding any lock which is needed by
+    *  RasterCache::releaseOldest().
+    */
+   virtual void enforceRasterCacheBudget() = 0;
+
+   /**
+    *  Returns the amount of memory held by registered raster caches.
+    *
+    *  @param   pElement
+    *           The element for which to report memory usage.  If \c NULL, the
+    *           memory held by all registered caches is returned.
+    *
+    *  @return  The number of bytes held by caches of the given element.
+    */
+   virtual size_t getRasterCacheSize(const RasterElement* pElement = NULL) const = 0;
+
+   /**
+    *  Adds the usage counters of a raster pager to those which can be
+    *  queried.
+    *
+    *  @param   pCounters
+    *           The counters to register.  The counters must be unregistered
+    *           with unregisterRasterPagerCounters() before they are destroyed.
+    */
+   virtual void registerRasterPagerCounters(RasterPagerCounters* pCounters) = 0;
+
+   /**
+    *  Removes the usage counters of a raster pager.
+    *
+    *  @param   pCounters
+    *           The counters to unregister.
+    */
+   virtual void unregisterRasterPagerCounters(RasterPagerCounters* pCounters) = 0;
+
+   /**
+    *  Returns the combined usage counters of registered raster pagers.
+    *
+    *  This method may be called simultaneously by multiple threads.
+    *
+    *  @param   pElement
+    *           The element for which to report the counters.  If \c NULL,
+    *           the counters of all registered pagers are combined.
+    *
+    *  @return  The sum of the counters of the pagers of the given element.
+    */
+   virtual RasterPagerCounters::Values getRasterPagerCounters(const RasterElement* pElement = NULL) const = 0;
+
+   /**
+    *  Writes the usage counters of every registered raster pager to the
+    *  message log.
+    *
+    *  The application calls this periodically when
+    *  ConfigurationSettings::getSettingRasterPagerCountersLogInterval() is
+    *  not zero.  This method must be called from the main thread.
+    */
+   virtual void logRasterPagerCounters() const = 0;
+
    /**
     *  This static method retrieves an individual data value from a block of memory.
     *
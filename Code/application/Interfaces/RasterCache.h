@@ -0,0 +1,82 @@
+/*
+ * The information in this file is
+ * Copyright(c) 2007 Ball Aerospace & Technologies Corporation
+ * and is subject to the terms and conditions of the
+ * GNU Lesser General Public License Version 2.1
+ * The license text is available from   
+ * http://www.gnu.org/licenses/lgpl.html
+ */
+
+#ifndef RASTERCACHE_H
+#define RASTERCACHE_H
+
+#include "AppConfig.h"
+
+#include <stddef.h>
+
+class RasterElement;
+
+/**
+ *  Memory held by a RasterPager on behalf of a RasterElement.
+ *
+ *  Caches of raster data register with ModelServices::registerRasterCache()
+ *  so that the memory used by all RasterPager instances in the process can
+ *  be kept within ConfigurationSettings::getSettingRasterCacheSize().  When
+ *  the budget is exceeded, ModelServices releases the least recently used
+ *  data across all registered caches, regardless of which RasterElement it
+ *  belongs to.
+ *
+ *  Access times are compared between caches, so implementations must stamp
+ *  their data with values returned by ModelServices::getRasterCacheAccess().
+ *
+ *  The methods of this interface may be called from any thread while other
+ *  threads are using the cache.
+ *
+ *  @see ModelServices::enforceRasterCacheBudget()
+ */
+class RasterCache
+{
+public:
+   /**
+    *  Returns the element whose data is held by the cache.
+    *
+    *  @return The element whose data is cached, or \c NULL if the cache is
+    *          not associated with a single element.
+    */
+   virtual const RasterElement* getRasterElement() const = 0;
+
+   /**
+    *  Returns the amount of memory held by the cache.
+    *
+    *  @return The number of bytes currently held by the cache, including
+    *          data which cannot be released.
+    */
+   virtual size_t getCacheSize() const = 0;
+
+   /**
+    *  Returns the access time of the least recently used data which can be
+    *  released.
+    *
+    *  @return The value of ModelServices::getRasterCacheAccess() when the
+    *          data was last used, or the maximum value of a \c uint64_t if
+    *          the cache holds nothing which can be released.
+    */
+   virtual uint64_t getOldestAccess() const = 0;
+
+   /**
+    *  Releases the least recently used data which can be released.
+    *
+    *  @return \c True if any memory was released, \c false if the cache
+    *          holds nothing which can be released.
+    */
+   virtual bool releaseOldest() = 0;
+
+protected:
+   /**
+    *  The cache must unregister itself with
+    *  ModelServices::unregisterRasterCache() before it is destroyed.
+    */
+   virtual ~RasterCache() {}
+};
+
+#endif
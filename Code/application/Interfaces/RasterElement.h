@@ -12,6 +12,7 @@
 
 #include "AppConfig.h"
 #include "ComplexData.h"
+#include "ConfigurationSettings.h"
 #include "DataAccessor.h"
 #include "DataElement.h"
 #include "DimensionDescriptor.h"
@@ -45,6 +46,40 @@ class Statistics;
 class RasterElement : public DataElement
 {
 public:
+   /**
+    *  Whether elements processed in memory hold their data compressed.
+    *
+    *  If \c true, data which would otherwise be held uncompressed in memory
+    *  is held as compressed blocks, which are decompressed as they are
+    *  accessed.  This typically needs much less memory than the uncompressed
+    *  data, but getRawData() returns \c NULL for such elements and the data
+    *  is slower to access.
+    *
+    *  @see ProcessingLocation
+    */
+   SETTING(CompressInMemoryData, RasterElement, bool, false)
+
+   /**
+    *  The maximum number of bytes of data converted to a different interleave
+    *  or byte order, or decompressed, which are kept for reuse by each
+    *  element.
+    *
+    *  Converted data still used by a DataAccessor is not included.
+    *
+    *  @see DataRequest::setInterleaveFormat()
+    */
+   SETTING(ConvertedPageCacheSize, RasterElement, unsigned int, 16 * 1024 * 1024)
+
+   /**
+    *  The fraction of a page a DataAccessor must progress through before the
+    *  RasterPager is asked to read ahead the following page.
+    *
+    *  A value outside of [0, 1) disables read-ahead.
+    *
+    *  @see RasterPager::prefetchPage()
+    */
+   SETTING(ReadAheadThreshold, RasterElement, double, 0.5)
+
    /**
     *  Emitted with any<RasterElement*> when the associated terrain object is changed.
     */
@@ -128,6 +163,18 @@ public:
     */
    virtual void incrementDataAccessor(DataAccessorImpl& accessor) = 0;
 
+   /**
+    *  Asks the pager to read ahead the segment of memory following the
+    *  Data Accessor's current segment.
+    *
+    *  The prefetchDataAccessor() method is called by the Data Accessor
+    *  once it has progressed past getSettingReadAheadThreshold() of its
+    *  current segment.
+    *
+    *  @see     DataAccessor, RasterPager::prefetchPage()
+    */
+   virtual void prefetchDataAccessor(DataAccessorImpl& accessor) = 0;
+
    /**
     *  Notifies all observers of the object that its data has changed.
     *
@@ -164,6 +211,27 @@ public:
     */
    virtual Statistics* getStatistics(DimensionDescriptor band = DimensionDescriptor()) const = 0;
 
+   /**
+    *  Calculates the statistics of several bands with one pass over the data.
+    *
+    *  Calculating the statistics of each band from its Statistics object reads
+    *  the data once per band.  This method instead calculates the statistics
+    *  of all of the given bands together, reading BIP and BIL data only once.
+    *  The statistics which are already calculated are not changed, and the
+    *  calculated values are then returned by the Statistics object of each
+    *  band without further calculation.
+    *
+    *  @param   bands
+    *           The bands for which to calculate the statistics.
+    *  @param   component
+    *           The complex component for which to calculate the statistics.
+    *           For non-complex data, this value is ignored.
+    *
+    *  @see     getStatistics()
+    */
+   virtual void calculateStatistics(const std::vector<DimensionDescriptor>& bands,
+      ComplexComponent component = COMPLEX_MAGNITUDE) const = 0;
+
    /**
     * This method will create a new RasterElement which is a
     * chip of the object it is called on.  Its active row, column, and
@@ -209,6 +277,52 @@ public:
       const std::vector<DimensionDescriptor> &selectedColumns,
       const std::vector<DimensionDescriptor> &selectedBands = std::vector<DimensionDescriptor>()) const = 0;
 
+   /**
+    * Creates a chip of this RasterElement which shares its data.
+    *
+    * The chip is created like createChip(), except that no data is copied.
+    * Read-only DataAccessor requests on the chip are served from the data of
+    * this RasterElement, so the chip is created at once and needs no memory
+    * or temporary file for its data.  Until the data is copied, changes to
+    * the data of this RasterElement are seen by the chip.
+    *
+    * The data is copied into the chip as by copyDataToChip() when the first
+    * writable DataAccessor is requested from the chip, or when this
+    * RasterElement is destroyed.  Any DataAccessor created from the chip
+    * before then must be destroyed before this RasterElement is destroyed.
+    *
+    *  @param   pParent
+    *           The element to use for the parent of the created cube.
+    *  @param   appendName
+    *           What to append to the name of the RasterElement.
+    *           Passing an empty string will result in using the RasterElement's
+    *           name as the chipped name.
+    *  @param   selectedRows
+    *           The DimensionDescriptors (unmodified from this object) for the rows
+    *           which should be included in this chip.
+    *           Passing an empty vector will result in using the RasterElement's
+    *           rows as the chipped rows.
+    *  @param   selectedColumns
+    *           The DimensionDescriptors (unmodified from this object) for the columns
+    *           which should be included in this chip.
+    *           Passing an empty vector will result in using the RasterElement's
+    *           columns as the chipped columns.
+    *  @param   selectedBands
+    *           The DimensionDescriptors (unmodified from this object) for the bands
+    *           which should be included in this chip.
+    *           Passing an empty vector will result in using the RasterElement's
+    *           bands as the chipped bands.
+    *
+    *  @return  A pointer to the created RasterElement, or \c NULL if the chip
+    *           could not be created.
+    *
+    *  @see RasterElement::createChip()
+    */
+   virtual RasterElement* createChipView(DataElement* pParent,
+      const std::string& appendName, const std::vector<DimensionDescriptor>& selectedRows,
+      const std::vector<DimensionDescriptor>& selectedColumns,
+      const std::vector<DimensionDescriptor>& selectedBands = std::vector<DimensionDescriptor>()) const = 0;
+
    /**
     * This method will copy data from this RasterElement to the chip RasterElement.
     *
@@ -128,6 +128,40 @@ public:
     */
    virtual void releasePage(RasterPage* pPage) = 0;
 
+   /**
+    *  Hints that a page will be requested soon.
+    *
+    *  This method is called by a DataAccessor which is reading rows
+    *  sequentially once it has progressed past
+    *  RasterElement::getSettingReadAheadThreshold() of its current page.  The
+    *  parameters describe the page which the DataAccessor will request next.
+    *
+    *  Implementations may begin loading the data in the background so that a
+    *  subsequent call to getPage() does not need to wait on the source.  This
+    *  method should return immediately and must not change the result of any
+    *  later getPage() call.  Pagers which do not benefit from read-ahead
+    *  need not override this method; the default implementation ignores the
+    *  hint.
+    *
+    *  This method may be called simultaneously by multiple threads and is up to
+    *  the implementer of this method to guarantee thread-safety in that case.
+    *
+    *  @param pOriginalRequest
+    *         The request as originally made.  The request is only valid for
+    *         the duration of this call, so implementations should copy it if
+    *         it is needed later.
+    *  @param startRow
+    *         the start row of the page which will be requested.
+    *  @param startColumn
+    *         the start column of the page which will be requested.
+    *  @param startBand
+    *         the start band of the page which will be requested.
+    */
+   virtual void prefetchPage(DataRequest *pOriginalRequest,
+      DimensionDescriptor startRow, 
+      DimensionDescriptor startColumn, 
+      DimensionDescriptor startBand) {}
+
    /**
     * Get the highest version of DataRequest that this pager supports.
     *
@@ -145,6 +179,12 @@ public:
     * If any higher-version fields are changed from the defaults, the core will
     * assume that the RasterPager is unable to handle them, and the request will not be fulfilled.
     *
+    * A pager which supports version 3 skips the rows between those of a strided request.
+    * Its pages only hold the requested rows: getNumRows() counts the requested rows, and the
+    * intervening rows are reported by getInterlineBytes().  The columns of a page are adjacent
+    * regardless of the column stride.  For a pager which supports an earlier version, the core
+    * requests every row and the DataAccessor steps over the rows which were not requested.
+    *
     * @return The highest request version supported.
     *
     * @see DataRequest::getRequestVersion()
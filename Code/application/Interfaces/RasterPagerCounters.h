@@ -0,0 +1,133 @@
+/*
+ * The information in this file is
+ * Copyright(c) 2007 Ball Aerospace & Technologies Corporation
+ * and is subject to the terms and conditions of the
+ * GNU Lesser General Public License Version 2.1
+ * The license text is available from   
+ * http://www.gnu.org/licenses/lgpl.html
+ */
+
+#ifndef RASTERPAGERCOUNTERS_H
+#define RASTERPAGERCOUNTERS_H
+
+#include "AppConfig.h"
+
+#include <string>
+
+class RasterElement;
+
+/**
+ *  Usage counters of a RasterPager.
+ *
+ *  Pagers register their counters with
+ *  ModelServices::registerRasterPagerCounters() so that the behavior of the
+ *  pagers of a RasterElement can be queried with
+ *  ModelServices::getRasterPagerCounters() and written to the message log
+ *  with ModelServices::logRasterPagerCounters().
+ *
+ *  The counters are updated while the pager is used by any number of
+ *  threads, so the values returned by getValues() may be slightly out of
+ *  step with one another.
+ */
+class RasterPagerCounters
+{
+public:
+   /**
+    *  A snapshot of the counters.
+    *
+    *  Counters which do not apply to a pager are always zero.
+    */
+   struct Values
+   {
+      Values() :
+         mGetPageCalls(0),
+         mCacheHits(0),
+         mCacheMisses(0),
+         mBytesFetched(0),
+         mDecodeTime(0),
+         mLockWaitTime(0),
+         mPagesLeased(0),
+         mPagesReleased(0)
+      {}
+
+      /**
+       *  The number of calls to RasterPager::getPage().
+       */
+      uint64_t mGetPageCalls;
+
+      /**
+       *  The number of pages which were served from data held by the pager.
+       */
+      uint64_t mCacheHits;
+
+      /**
+       *  The number of pages for which the pager had to read or convert data.
+       */
+      uint64_t mCacheMisses;
+
+      /**
+       *  The number of bytes read from the file.
+       */
+      uint64_t mBytesFetched;
+
+      /**
+       *  The number of microseconds spent reading, decoding and converting
+       *  data.
+       */
+      uint64_t mDecodeTime;
+
+      /**
+       *  The number of microseconds threads spent waiting for the locks of
+       *  the pager.
+       */
+      uint64_t mLockWaitTime;
+
+      /**
+       *  The number of pages returned by RasterPager::getPage().
+       */
+      uint64_t mPagesLeased;
+
+      /**
+       *  The number of pages passed to RasterPager::releasePage().
+       */
+      uint64_t mPagesReleased;
+   };
+
+   /**
+    *  Returns the name of the pager.
+    *
+    *  @return The name of the pager which updates the counters.
+    */
+   virtual std::string getPagerName() const = 0;
+
+   /**
+    *  Returns the element whose data is paged.
+    *
+    *  @return The element whose data is paged, or \c NULL if the pager is
+    *          not yet associated with an element.
+    */
+   virtual const RasterElement* getRasterElement() const = 0;
+
+   /**
+    *  Returns the current values of the counters.
+    *
+    *  @return The counters accumulated since the pager was created or the
+    *          counters were last reset.
+    */
+   virtual Values getValues() const = 0;
+
+   /**
+    *  Sets all of the counters to zero.
+    */
+   virtual void reset() = 0;
+
+protected:
+   /**
+    *  The counters must unregister themselves with
+    *  ModelServices::unregisterRasterPagerCounters() before they are
+    *  destroyed.
+    */
+   virtual ~RasterPagerCounters() {}
+};
+
+#endif
@@ -13,6 +13,7 @@
 #include "ComplexData.h"
 #include "ConfigurationSettings.h"
 #include "Serializable.h"
+#include "Subject.h"
 
 #include <vector>
 
@@ -33,6 +34,15 @@ class BadValues;
  *  set to avoid calculations when calling one of the get methods.  Typically
  *  the values would only be directly set by an importer.
  *
+ *  The values of large data sets can instead be calculated progressively with
+ *  calculateProgressively(), which sets values computed from a subsample of
+ *  the data at once and replaces them with the values at the statistics
+ *  resolution when they have been calculated in the background.
+ *
+ *  This subclass of Subject will notify upon the following conditions:
+ *  - The refined values of a progressive calculation have been set.
+ *  - Everything else documented in Subject.
+ *
  *  @warning Be careful when dealing with RasterElements that have NaN(Not a number) 
  *           values. Before doing anything with the dataset, be sure to sanitize the data
  *           first. Failure to do this may lead to Opticks crashing when you attempt to 
@@ -40,11 +50,48 @@ class BadValues;
  *
  *  @see    RasterElement::getStatistics()
  */
-class Statistics : public Serializable
+class Statistics : public Serializable, public Subject
 {
 public:
+   /**
+    *  Emitted with boost::any<ComplexComponent> when the values calculated in
+    *  the background by calculateProgressively() have replaced the coarse
+    *  values of the component.
+    */
+   SIGNAL_METHOD(Statistics, Calculated)
+
    SETTING(Resolution, Statistics, int, 0);
 
+   /**
+    *  Whether the histogram and percentiles are computed in the same pass over
+    *  the data as the other statistics.
+    *
+    *  A single pass reads the data once, which halves the time needed for
+    *  data which is not held in memory.  The histogram is then accumulated
+    *  over a range which adapts to the data as it is read, so the percentiles
+    *  may differ slightly from those of two passes over the data.
+    */
+   SETTING(SinglePass, Statistics, bool, true);
+
+   /**
+    *  The maximum size in megabytes of the statistics kept between sessions.
+    *
+    *  The statistics of data read from a file are kept in
+    *  ConfigurationSettings::getSettingStatisticsCachePath() so that they need
+    *  not be calculated again the next time the file is loaded.  A value of
+    *  zero places no limit on the size.
+    */
+   SETTING(CacheSize, Statistics, unsigned int, 64);
+
+   /**
+    *  Whether calculateProgressively() refines the statistics in the
+    *  background.
+    *
+    *  If this setting is \c false, calculateProgressively() calculates the
+    *  statistics at the statistics resolution before it returns.
+    */
+   SETTING(Progressive, Statistics, bool, true);
+
    /**
     *  Sets the minimum value for the data.
     *
@@ -449,6 +496,32 @@ public:
     */
    virtual bool areStatisticsCalculated(ComplexComponent component) const = 0;
 
+   /**
+    *  Calculates the statistics quickly from a subsample of the data and then
+    *  refines them in the background.
+    *
+    *  If the statistics of the component have not been calculated, values
+    *  computed from a subsample of the data are set before this method
+    *  returns, and the values at the statistics resolution are calculated in
+    *  a background thread.  The get methods return the subsampled values and
+    *  areStatisticsCalculated() returns \c false until the refined values
+    *  have been set.  Small data sets, statistics over an AOI or over more
+    *  than one band, and those calculated in batch mode or with
+    *  getSettingProgressive() disabled are calculated at once.
+    *
+    *  Changing the bad values or the statistics resolution cancels the
+    *  background calculation.
+    *
+    *  @param   component
+    *           The complex data component for which to calculate the
+    *           statistics.
+    *
+    *  @notify  This method will notify signalCalculated() with
+    *           boost::any<ComplexComponent> from the main thread when the
+    *           refined values have been set.
+    */
+   virtual void calculateProgressively(ComplexComponent component = COMPLEX_MAGNITUDE) = 0;
+
 protected:
    /**
     * A plug-in cannot create this object, it can only retrieve an already existing
@@ -0,0 +1,144 @@
+/*
+ * The information in this file is
+ * Copyright(c) 2007 Ball Aerospace & Technologies Corporation
+ * and is subject to the terms and conditions of the
+ * GNU Lesser General Public License Version 2.1
+ * The license text is available from   
+ * http://www.gnu.org/licenses/lgpl.html
+ */
+
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <vector>
+
+/**
+ *  A pool of worker threads which is shared by the whole application.
+ *
+ *  The pool keeps one worker for each of the threads in
+ *  ConfigurationSettings::getSettingThreadCount(), so the algorithms of the
+ *  application and of plug-ins which run at the same time share the processors
+ *  instead of each creating threads of their own.  Each worker keeps its own
+ *  queue of tasks and takes tasks from the queues of other workers when its
+ *  own queue is empty, so work which is split into many more tasks than there
+ *  are workers is balanced between them.
+ *
+ *  The mta::MultiThreadedAlgorithm class runs its threads in the pool.  Other
+ *  code can run tasks in the pool directly:
+ *  @code
+ *  class RowTask : public ThreadPool::Task
+ *  {
+ *  public:
+ *     RowTask(int firstRow, int lastRow) : mFirstRow(firstRow), mLastRow(lastRow) {}
+ *     void run()
+ *     {
+ *        // process the rows
+ *     }
+ *  private:
+ *     int mFirstRow;
+ *     int mLastRow;
+ *  };
+ *
+ *  std::vector<RowTask> rowTasks;
+ *  for (int row = 0; row < rowCount; row += 64)
+ *  {
+ *     rowTasks.push_back(RowTask(row, std::min(row + 64, rowCount) - 1));
+ *  }
+ *
+ *  std::vector<ThreadPool::Task*> tasks;
+ *  for (std::vector<RowTask>::iterator iter = rowTasks.begin(); iter != rowTasks.end(); ++iter)
+ *  {
+ *     tasks.push_back(&*iter);
+ *  }
+ *  Service<UtilityServices>()->getThreadPool()->runTasks(tasks);
+ *  @endcode
+ *
+ *  @see     UtilityServices::getThreadPool()
+ */
+class ThreadPool
+{
+public:
+   /**
+    *  A unit of work which is run by a worker of the pool.
+    */
+   class Task
+   {
+   public:
+      /**
+       *  Performs the work of the task.
+       *
+       *  This method is called in a worker thread.
+       */
+      virtual void run() = 0;
+
+   protected:
+      /**
+       *  Tasks are owned by the code which starts them.
+       */
+      virtual ~Task() {}
+   };
+
+   /**
+    *  The tasks which are started together by startTasks().
+    */
+   class TaskGroup;
+
+   /**
+    *  Returns the number of worker threads in the pool.
+    *
+    *  @return  The number of workers.
+    */
+   virtual unsigned int getWorkerCount() const = 0;
+
+   /**
+    *  Queries whether the calling thread is a worker of the pool.
+    *
+    *  @return  True if the calling thread is one of the workers, otherwise false.
+    */
+   virtual bool isWorkerThread() const = 0;
+
+   /**
+    *  Starts running tasks in the workers of the pool.
+    *
+    *  This method returns without waiting for the tasks to complete.  Every
+    *  group which is returned must be passed to waitForTasks().
+    *
+    *  @param   tasks
+    *           The tasks to run.  The tasks must remain valid until
+    *           waitForTasks() returns.
+    *
+    *  @return  The group of the tasks, which is used to wait for them.
+    *
+    *  @see     waitForTasks()
+    */
+   virtual TaskGroup* startTasks(const std::vector<Task*>& tasks) = 0;
+
+   /**
+    *  Waits for a group of tasks to complete.
+    *
+    *  When this method is called from a worker of the pool, the worker runs
+    *  queued tasks while it waits, so tasks which start other tasks and wait
+    *  for them do not take a worker away from the pool.
+    *
+    *  @param   pGroup
+    *           The group returned by startTasks().  The group is destroyed
+    *           and must not be used after this method returns.
+    */
+   virtual void waitForTasks(TaskGroup* pGroup) = 0;
+
+   /**
+    *  Runs tasks in the workers of the pool and waits for them to complete.
+    *
+    *  @param   tasks
+    *           The tasks to run.
+    */
+   virtual void runTasks(const std::vector<Task*>& tasks) = 0;
+
+protected:
+   /**
+    *  The pool is owned by UtilityServices.  Plug-ins do not need to destroy it.
+    */
+   virtual ~ThreadPool() {}
+};
+
+#endif
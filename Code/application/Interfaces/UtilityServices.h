@@ -15,6 +15,7 @@
 #include "MessageLogMgr.h"
 #include "Progress.h"
 #include "Service.h"
+#include "ThreadPool.h"
 
 #include <string>
 
@@ -91,6 +92,13 @@ public:
     */
    virtual unsigned int getNumProcessors() const = 0;
 
+   /**
+    *  Returns the pool of worker threads which is shared by the application and plug-ins.
+    *
+    *  @return  Pointer to the ThreadPool singleton.
+    */
+   virtual ThreadPool* getThreadPool() = 0;
+
    /**
     *  Returns the default classification level, based on the value in
     *  the first row of the SecurityMarkings/Classification.txt file.
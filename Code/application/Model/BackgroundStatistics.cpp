@@ -0,0 +1,90 @@
+/*
+ * The information in this file is
+ * Copyright(c) 2007 Ball Aerospace & Technologies Corporation
+ * and is subject to the terms and conditions of the
+ * GNU Lesser General Public License Version 2.1
+ * The license text is available from   
+ * http://www.gnu.org/licenses/lgpl.html
+ */
+
+#include "AppVerify.h"
+#include "BackgroundStatistics.h"
+#include "BadValues.h"
+#include "bthread.h"
+#include "RasterElement.h"
+#include "RasterElementImp.h"
+#include "StatisticsImp.h"
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QEvent>
+
+BackgroundStatistics::BackgroundStatistics(StatisticsImp* pStatistics, ComplexComponent component) :
+   mpStatistics(pStatistics),
+   mComponent(component),
+   mpRasterElement(NULL),
+   mResolution(1),
+   mAbort(false),
+   mSuccess(false)
+{
+   VERIFYNRV(mpStatistics != NULL);
+
+   mpRasterElement = dynamic_cast<const RasterElement*>(mpStatistics->mpRasterElement);
+   if (mpStatistics->mBands.empty() == false)
+   {
+      mBand = mpStatistics->mBands.front();
+   }
+
+   mpBadValues->setBadValues(mpStatistics->getBadValues());
+   mResolution = mpStatistics->getStatisticsResolution();
+}
+
+BackgroundStatistics::~BackgroundStatistics()
+{
+   mAbort = true;
+   if (mpThread.get() != NULL)
+   {
+      mpThread->ThreadWait();
+   }
+}
+
+void BackgroundStatistics::start()
+{
+   if (mpThread.get() == NULL)
+   {
+      mpThread.reset(new BThread(static_cast<void*>(this),
+         reinterpret_cast<void*>(BackgroundStatistics::calculationThread)));
+      mpThread->ThreadLaunch();
+   }
+}
+
+void BackgroundStatistics::customEvent(QEvent* pEvent)
+{
+   if (pEvent == NULL || pEvent->type() != QEvent::User)
+   {
+      return;
+   }
+
+   mpStatistics->backgroundCalculationFinished(mComponent, mSuccess ? &mValues : NULL);
+   deleteLater();
+}
+
+void BackgroundStatistics::calculationThread(BackgroundStatistics* pCalculation)
+{
+   if (pCalculation != NULL)
+   {
+      pCalculation->calculate();
+   }
+}
+
+void BackgroundStatistics::calculate()
+{
+   mSuccess = mpRasterElement != NULL && mBand.isValid() &&
+      StatisticsImp::calculateBandStatistics(mpRasterElement, mBand, mpBadValues.get(), mComponent, mResolution, 1,
+      NULL, &mAbort, mValues);
+
+   // A calculation which is stopped is being deleted by the main thread
+   if (mAbort == false)
+   {
+      QCoreApplication::postEvent(this, new QEvent(QEvent::User));
+   }
+}
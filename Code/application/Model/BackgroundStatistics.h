@@ -0,0 +1,70 @@
+/*
+ * The information in this file is
+ * Copyright(c) 2007 Ball Aerospace & Technologies Corporation
+ * and is subject to the terms and conditions of the
+ * GNU Lesser General Public License Version 2.1
+ * The license text is available from   
+ * http://www.gnu.org/licenses/lgpl.html
+ */
+
+#ifndef BACKGROUNDSTATISTICS_H
+#define BACKGROUNDSTATISTICS_H
+
+#include "ComplexData.h"
+#include "DimensionDescriptor.h"
+#include "ObjectResource.h"
+#include "StatisticsCache.h"
+
+#include <QtCore/QObject>
+
+#include <boost/atomic.hpp>
+#include <memory>
+
+class BadValues;
+class BThread;
+class QEvent;
+class RasterElement;
+class StatisticsImp;
+
+/**
+ * Refines the statistics of a band in a background thread.
+ *
+ * A calculation is created in the main thread by StatisticsImp::calculateProgressively(),
+ * which owns it until it finishes.  The values are posted back to the main thread and set on
+ * the statistics, after which the calculation deletes itself.  Deleting a calculation which
+ * has not finished stops its thread and waits for it.
+ */
+class BackgroundStatistics : public QObject
+{
+public:
+   BackgroundStatistics(StatisticsImp* pStatistics, ComplexComponent component);
+   ~BackgroundStatistics();
+
+   void start();
+
+protected:
+   void customEvent(QEvent* pEvent);
+
+private:
+   BackgroundStatistics(const BackgroundStatistics& rhs);
+   BackgroundStatistics& operator=(const BackgroundStatistics& rhs);
+
+   static void calculationThread(BackgroundStatistics* pCalculation);
+   void calculate();
+
+   StatisticsImp* mpStatistics;
+   ComplexComponent mComponent;
+
+   // copies of the inputs, which the main thread may change while the values are calculated
+   const RasterElement* mpRasterElement;
+   DimensionDescriptor mBand;
+   FactoryResource<BadValues> mpBadValues;
+   int mResolution;
+
+   boost::atomic<bool> mAbort;
+   bool mSuccess;
+   StatisticsCache::Entry mValues;
+   std::auto_ptr<BThread> mpThread;
+};
+
+#endif
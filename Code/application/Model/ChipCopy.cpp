@@ -0,0 +1,344 @@
+/*
+ * The information in this file is
+ * Copyright(c) 2007 Ball Aerospace & Technologies Corporation
+ * and is subject to the terms and conditions of the
+ * GNU Lesser General Public License Version 2.1
+ * The license text is available from   
+ * http://www.gnu.org/licenses/lgpl.html
+ */
+
+#include "AppVerify.h"
+#include "ChipCopy.h"
+#include "DataAccessorImpl.h"
+#include "DataRequest.h"
+#include "InterleaveConversion.h"
+#include "ObjectResource.h"
+#include "RasterDataDescriptor.h"
+#include "RasterElement.h"
+
+#include <string.h>
+
+using namespace mta;
+using namespace std;
+
+ChipCopyInput::ChipCopyInput(const RasterElement* pSource, RasterElement* pChip,
+                             const vector<DimensionDescriptor>& selectedRows,
+                             const vector<DimensionDescriptor>& selectedColumns,
+                             const vector<DimensionDescriptor>& selectedBands, bool& abort) :
+   mpSource(pSource),
+   mpChip(pChip),
+   mRows(selectedRows),
+   mColumns(selectedColumns),
+   mBands(selectedBands),
+   mAbort(abort)
+{
+   getRuns(mColumns, mColumnRuns);
+   getRuns(mBands, mBandRuns);
+}
+
+void ChipCopyInput::getRuns(const vector<DimensionDescriptor>& dims, vector<Run>& runs)
+{
+   runs.clear();
+   for (vector<DimensionDescriptor>::const_iterator iter = dims.begin(); iter != dims.end(); ++iter)
+   {
+      unsigned int number = iter->getActiveNumber();
+      if (runs.empty() == false && runs.back().mStart + runs.back().mCount == number)
+      {
+         ++runs.back().mCount;
+      }
+      else
+      {
+         Run run;
+         run.mStart = number;
+         run.mCount = 1;
+         runs.push_back(run);
+      }
+   }
+}
+
+bool ChipCopyOutput::compileOverallResults(const vector<ChipCopyThread*>& threads)
+{
+   if (threads.empty())
+   {
+      return false;
+   }
+
+   for (vector<ChipCopyThread*>::const_iterator iter = threads.begin(); iter != threads.end(); ++iter)
+   {
+      ChipCopyThread* pThread = *iter;
+      if (pThread == NULL || pThread->isComplete() == false)
+      {
+         return false;
+      }
+   }
+
+   return true;
+}
+
+ChipCopyThread::ChipCopyThread(const ChipCopyInput& input, int threadCount, int threadIndex,
+                               ThreadReporter& reporter) :
+   AlgorithmThread(threadIndex, reporter),
+   mInput(input),
+   mRowRange(getThreadRange(threadCount, static_cast<int>(input.mRows.size()))),
+   mBytesPerElement(0),
+   mComplete(false),
+   mPercentDone(0)
+{
+   const RasterDataDescriptor* pDescriptor =
+      dynamic_cast<const RasterDataDescriptor*>(input.mpSource->getDataDescriptor());
+   if (pDescriptor != NULL)
+   {
+      mBytesPerElement = pDescriptor->getBytesPerElement();
+   }
+}
+
+void ChipCopyThread::run()
+{
+   if (mRowRange.mLast < mRowRange.mFirst)
+   {
+      mComplete = true;
+      return;
+   }
+
+   const RasterDataDescriptor* pChipDescriptor =
+      dynamic_cast<const RasterDataDescriptor*>(mInput.mpChip->getDataDescriptor());
+   VERIFYNRV(pChipDescriptor != NULL && mBytesPerElement > 0);
+   VERIFYNRV(mInput.mColumnRuns.empty() == false && mInput.mBandRuns.empty() == false);
+
+   switch (pChipDescriptor->getInterleaveFormat())
+   {
+   case BIP:
+      mComplete = copyBip();
+      break;
+   case BIL:
+      mComplete = copyBil();
+      break;
+   case BSQ:
+      mComplete = copyBsq();
+      break;
+   default:
+      break;
+   }
+}
+
+bool ChipCopyThread::isComplete() const
+{
+   return mComplete;
+}
+
+bool ChipCopyThread::copyBip()
+{
+   const RasterDataDescriptor* pChipDescriptor =
+      static_cast<const RasterDataDescriptor*>(mInput.mpChip->getDataDescriptor());
+
+   FactoryResource<DataRequest> pSourceRequest;
+   pSourceRequest->setInterleaveFormat(BIP);
+   pSourceRequest->setRows(mInput.mRows[mRowRange.mFirst], mInput.mRows[mRowRange.mLast]);
+   pSourceRequest->setColumns(mInput.mColumns.front(), mInput.mColumns.back());
+   pSourceRequest->setBands(mInput.mBands.front(), mInput.mBands.back());
+   DataAccessor sourceDa = mInput.mpSource->getDataAccessor(pSourceRequest.release());
+
+   FactoryResource<DataRequest> pChipRequest;
+   pChipRequest->setInterleaveFormat(BIP);
+   pChipRequest->setWritable(true);
+   pChipRequest->setRows(pChipDescriptor->getActiveRow(mRowRange.mFirst),
+      pChipDescriptor->getActiveRow(mRowRange.mLast));
+   DataAccessor chipDa = mInput.mpChip->getDataAccessor(pChipRequest.release());
+
+   VERIFY(sourceDa.isValid() && chipDa.isValid());
+
+   // the pages may hold more bands than were requested
+   size_t sourcePixelSize = mBytesPerElement * sourceDa->getConcurrentBands();
+   size_t chipPixelSize = mBytesPerElement * chipDa->getConcurrentBands();
+   bool wholePixels = mInput.mBandRuns.size() == 1 && sourcePixelSize == chipPixelSize;
+   unsigned int firstBand = mInput.mBands.front().getActiveNumber();
+
+   int steps = mRowRange.mLast - mRowRange.mFirst + 1;
+   for (int row = mRowRange.mFirst; row <= mRowRange.mLast; ++row)
+   {
+      VERIFY(chipDa.isValid());
+      char* pChip = reinterpret_cast<char*>(chipDa->getRow());
+      unsigned int sourceRow = mInput.mRows[row].getActiveNumber();
+      for (vector<ChipCopyInput::Run>::const_iterator columnRun = mInput.mColumnRuns.begin();
+         columnRun != mInput.mColumnRuns.end(); ++columnRun)
+      {
+         sourceDa->toPixel(sourceRow, columnRun->mStart);
+         VERIFY(sourceDa.isValid());
+         const char* pSource = reinterpret_cast<const char*>(sourceDa->getColumn());
+         if (wholePixels)
+         {
+            memcpy(pChip, pSource, columnRun->mCount * chipPixelSize);
+         }
+         else
+         {
+            char* pChipBand = pChip;
+            for (vector<ChipCopyInput::Run>::const_iterator bandRun = mInput.mBandRuns.begin();
+               bandRun != mInput.mBandRuns.end(); ++bandRun)
+            {
+               const char* pSourceBand = pSource + (bandRun->mStart - firstBand) * mBytesPerElement;
+               size_t runSize = bandRun->mCount * mBytesPerElement;
+               if (bandRun->mCount == 1)
+               {
+                  InterleaveConversion::copyElements(pSourceBand, sourcePixelSize, pChipBand, chipPixelSize,
+                     columnRun->mCount, mBytesPerElement);
+               }
+               else
+               {
+                  for (unsigned int column = 0; column < columnRun->mCount; ++column)
+                  {
+                     memcpy(pChipBand + column * chipPixelSize, pSourceBand + column * sourcePixelSize, runSize);
+                  }
+               }
+
+               pChipBand += runSize;
+            }
+         }
+
+         pChip += columnRun->mCount * chipPixelSize;
+      }
+
+      chipDa->nextRow();
+      if (reportRow(row - mRowRange.mFirst, steps) == false)
+      {
+         return false;
+      }
+   }
+
+   return true;
+}
+
+bool ChipCopyThread::copyBil()
+{
+   const RasterDataDescriptor* pChipDescriptor =
+      static_cast<const RasterDataDescriptor*>(mInput.mpChip->getDataDescriptor());
+
+   FactoryResource<DataRequest> pSourceRequest;
+   pSourceRequest->setInterleaveFormat(BIL);
+   pSourceRequest->setRows(mInput.mRows[mRowRange.mFirst], mInput.mRows[mRowRange.mLast]);
+   pSourceRequest->setColumns(mInput.mColumns.front(), mInput.mColumns.back());
+   pSourceRequest->setBands(mInput.mBands.front(), mInput.mBands.back());
+   DataAccessor sourceDa = mInput.mpSource->getDataAccessor(pSourceRequest.release());
+
+   FactoryResource<DataRequest> pChipRequest;
+   pChipRequest->setInterleaveFormat(BIL);
+   pChipRequest->setWritable(true);
+   pChipRequest->setRows(pChipDescriptor->getActiveRow(mRowRange.mFirst),
+      pChipDescriptor->getActiveRow(mRowRange.mLast));
+   DataAccessor chipDa = mInput.mpChip->getDataAccessor(pChipRequest.release());
+
+   VERIFY(sourceDa.isValid() && chipDa.isValid());
+
+   // a run of bands is a single block when no columns are skipped
+   size_t sourceBandSize = mBytesPerElement * sourceDa->getConcurrentColumns();
+   size_t chipBandSize = mBytesPerElement * chipDa->getConcurrentColumns();
+   bool wholeBands = mInput.mColumnRuns.size() == 1 && sourceBandSize == chipBandSize;
+   unsigned int firstBand = mInput.mBands.front().getActiveNumber();
+   unsigned int firstColumn = mInput.mColumns.front().getActiveNumber();
+
+   int steps = mRowRange.mLast - mRowRange.mFirst + 1;
+   for (int row = mRowRange.mFirst; row <= mRowRange.mLast; ++row)
+   {
+      sourceDa->toPixel(mInput.mRows[row].getActiveNumber(), firstColumn);
+      VERIFY(sourceDa.isValid() && chipDa.isValid());
+      const char* pSourceRow = reinterpret_cast<const char*>(sourceDa->getRow());
+      char* pChip = reinterpret_cast<char*>(chipDa->getRow());
+      for (vector<ChipCopyInput::Run>::const_iterator bandRun = mInput.mBandRuns.begin();
+         bandRun != mInput.mBandRuns.end(); ++bandRun)
+      {
+         const char* pSource = pSourceRow + (bandRun->mStart - firstBand) * sourceBandSize;
+         if (wholeBands)
+         {
+            memcpy(pChip, pSource, bandRun->mCount * chipBandSize);
+            pChip += bandRun->mCount * chipBandSize;
+         }
+         else
+         {
+            for (unsigned int band = 0; band < bandRun->mCount; ++band)
+            {
+               copyColumns(pSource + band * sourceBandSize, pChip);
+               pChip += chipBandSize;
+            }
+         }
+      }
+
+      chipDa->nextRow();
+      if (reportRow(row - mRowRange.mFirst, steps) == false)
+      {
+         return false;
+      }
+   }
+
+   return true;
+}
+
+bool ChipCopyThread::copyBsq()
+{
+   const RasterDataDescriptor* pChipDescriptor =
+      static_cast<const RasterDataDescriptor*>(mInput.mpChip->getDataDescriptor());
+   unsigned int firstColumn = mInput.mColumns.front().getActiveNumber();
+
+   int rows = mRowRange.mLast - mRowRange.mFirst + 1;
+   int steps = rows * static_cast<int>(mInput.mBands.size());
+   int step = 0;
+   for (unsigned int chipBand = 0; chipBand < mInput.mBands.size(); ++chipBand)
+   {
+      FactoryResource<DataRequest> pSourceRequest;
+      pSourceRequest->setInterleaveFormat(BSQ);
+      pSourceRequest->setRows(mInput.mRows[mRowRange.mFirst], mInput.mRows[mRowRange.mLast]);
+      pSourceRequest->setColumns(mInput.mColumns.front(), mInput.mColumns.back());
+      pSourceRequest->setBands(mInput.mBands[chipBand], mInput.mBands[chipBand]);
+      DataAccessor sourceDa = mInput.mpSource->getDataAccessor(pSourceRequest.release());
+
+      FactoryResource<DataRequest> pChipRequest;
+      pChipRequest->setInterleaveFormat(BSQ);
+      pChipRequest->setWritable(true);
+      pChipRequest->setRows(pChipDescriptor->getActiveRow(mRowRange.mFirst),
+         pChipDescriptor->getActiveRow(mRowRange.mLast));
+      pChipRequest->setBands(pChipDescriptor->getActiveBand(chipBand), pChipDescriptor->getActiveBand(chipBand));
+      DataAccessor chipDa = mInput.mpChip->getDataAccessor(pChipRequest.release());
+
+      VERIFY(sourceDa.isValid() && chipDa.isValid());
+      for (int row = mRowRange.mFirst; row <= mRowRange.mLast; ++row)
+      {
+         sourceDa->toPixel(mInput.mRows[row].getActiveNumber(), firstColumn);
+         VERIFY(sourceDa.isValid() && chipDa.isValid());
+         copyColumns(reinterpret_cast<const char*>(sourceDa->getRow()), reinterpret_cast<char*>(chipDa->getRow()));
+         chipDa->nextRow();
+         if (reportRow(step++, steps) == false)
+         {
+            return false;
+         }
+      }
+   }
+
+   return true;
+}
+
+void ChipCopyThread::copyColumns(const char* pSource, char* pChip) const
+{
+   unsigned int firstColumn = mInput.mColumns.front().getActiveNumber();
+   for (vector<ChipCopyInput::Run>::const_iterator columnRun = mInput.mColumnRuns.begin();
+      columnRun != mInput.mColumnRuns.end(); ++columnRun)
+   {
+      size_t runSize = columnRun->mCount * mBytesPerElement;
+      memcpy(pChip, pSource + (columnRun->mStart - firstColumn) * mBytesPerElement, runSize);
+      pChip += runSize;
+   }
+}
+
+bool ChipCopyThread::reportRow(int step, int steps)
+{
+   if (mInput.mAbort)
+   {
+      return false;
+   }
+
+   int percentDone = (100 * (step + 1)) / steps;
+   if (percentDone > mPercentDone)
+   {
+      mPercentDone = percentDone;
+      getReporter().reportProgress(getThreadIndex(), percentDone);
+   }
+
+   return true;
+}
@@ -0,0 +1,113 @@
+/*
+ * The information in this file is
+ * Copyright(c) 2007 Ball Aerospace & Technologies Corporation
+ * and is subject to the terms and conditions of the
+ * GNU Lesser General Public License Version 2.1
+ * The license text is available from   
+ * http://www.gnu.org/licenses/lgpl.html
+ */
+
+#ifndef CHIPCOPY_H
+#define CHIPCOPY_H
+
+#include "DimensionDescriptor.h"
+#include "MultiThreadedAlgorithm.h"
+
+#include <vector>
+
+class RasterElement;
+
+/**
+ * The data copied from a RasterElement into a chip by
+ * RasterElementImp::copyDataToChip().
+ *
+ * The selected columns and bands are grouped into runs of consecutive active
+ * numbers, so that each run is copied as a single block.  Bands which are
+ * selected on their own out of BIP data are gathered with the strided kernels
+ * of the interleave conversion pagers.
+ *
+ * The rows of the chip are divided between the threads.  Every thread reads
+ * the source in the interleave of the chip and writes its own rows of the
+ * chip, so the pagers of both elements must exist before the threads start.
+ */
+class ChipCopyInput
+{
+public:
+   /**
+    * Consecutive active numbers in the source element.
+    */
+   struct Run
+   {
+      unsigned int mStart;
+      unsigned int mCount;
+   };
+
+   ChipCopyInput(const RasterElement* pSource, RasterElement* pChip,
+      const std::vector<DimensionDescriptor>& selectedRows,
+      const std::vector<DimensionDescriptor>& selectedColumns,
+      const std::vector<DimensionDescriptor>& selectedBands, bool& abort);
+
+   const RasterElement* mpSource;
+   RasterElement* mpChip;
+   const std::vector<DimensionDescriptor>& mRows;
+   const std::vector<DimensionDescriptor>& mColumns;
+   const std::vector<DimensionDescriptor>& mBands;
+   std::vector<Run> mColumnRuns;
+   std::vector<Run> mBandRuns;
+   bool& mAbort;
+
+private:
+   ChipCopyInput& operator=(const ChipCopyInput& rhs);
+
+   static void getRuns(const std::vector<DimensionDescriptor>& dims, std::vector<Run>& runs);
+};
+
+class ChipCopyThread;
+class ChipCopyOutput
+{
+public:
+   bool compileOverallResults(const std::vector<ChipCopyThread*>& threads);
+};
+
+class ChipCopyThread : public mta::AlgorithmThread
+{
+public:
+   ChipCopyThread(const ChipCopyInput& input, int threadCount, int threadIndex, mta::ThreadReporter& reporter);
+   virtual ~ChipCopyThread() {};
+
+   virtual void run();
+
+   /**
+    * Returns whether all of the rows of the thread were copied.
+    *
+    * @return False if the copy failed or was aborted.
+    */
+   bool isComplete() const;
+
+private:
+   ChipCopyThread& operator=(const ChipCopyThread& rhs);
+
+   bool copyBip();
+   bool copyBil();
+   bool copyBsq();
+
+   /**
+    * Copies the selected columns of a single band from a source row.
+    *
+    * @param pSource
+    *        The first requested column of the band in the source row.
+    * @param pChip
+    *        The band in the chip row.
+    */
+   void copyColumns(const char* pSource, char* pChip) const;
+
+   bool reportRow(int step, int steps);
+
+   const ChipCopyInput& mInput;
+   Range mRowRange;
+   unsigned int mBytesPerElement;
+   bool mComplete;
+   int mPercentDone;
+};
+
+#endif
@@ -0,0 +1,77 @@
+/*
+ * The information in this file is
+ * Copyright(c) 2007 Ball Aerospace & Technologies Corporation
+ * and is subject to the terms and conditions of the
+ * GNU Lesser General Public License Version 2.1
+ * The license text is available from   
+ * http://www.gnu.org/licenses/lgpl.html
+ */
+
+#include "ChipViewPage.h"
+#include "RasterPager.h"
+
+ChipViewPage::ChipViewPage(RasterPager* pSourcePager, RasterPage* pSourcePage, unsigned int rows,
+                           unsigned int columns, unsigned int bands) :
+   mpSourcePager(pSourcePager),
+   mpSourcePage(pSourcePage),
+   mpRawData(NULL),
+   mRows(rows),
+   mColumns(columns),
+   mBands(bands),
+   mInterlineBytes(0)
+{
+   if (mpSourcePage != NULL)
+   {
+      mpRawData = mpSourcePage->getRawData();
+      mInterlineBytes = mpSourcePage->getInterlineBytes();
+   }
+}
+
+ChipViewPage::ChipViewPage(std::vector<unsigned char>& data, size_t offset, unsigned int rows) :
+   mpSourcePager(NULL),
+   mpSourcePage(NULL),
+   mpRawData(NULL),
+   mRows(rows),
+   mColumns(0),
+   mBands(0),
+   mInterlineBytes(0)
+{
+   mData.swap(data);
+   if (offset < mData.size())
+   {
+      mpRawData = &mData[offset];
+   }
+}
+
+ChipViewPage::~ChipViewPage()
+{
+   if (mpSourcePager != NULL && mpSourcePage != NULL)
+   {
+      mpSourcePager->releasePage(mpSourcePage);
+   }
+}
+
+void* ChipViewPage::getRawData()
+{
+   return mpRawData;
+}
+
+unsigned int ChipViewPage::getNumRows()
+{
+   return mRows;
+}
+
+unsigned int ChipViewPage::getNumColumns()
+{
+   return mColumns;
+}
+
+unsigned int ChipViewPage::getNumBands()
+{
+   return mBands;
+}
+
+unsigned int ChipViewPage::getInterlineBytes()
+{
+   return mInterlineBytes;
+}
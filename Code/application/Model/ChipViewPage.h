@@ -0,0 +1,81 @@
+/*
+ * The information in this file is
+ * Copyright(c) 2007 Ball Aerospace & Technologies Corporation
+ * and is subject to the terms and conditions of the
+ * GNU Lesser General Public License Version 2.1
+ * The license text is available from   
+ * http://www.gnu.org/licenses/lgpl.html
+ */
+
+#ifndef CHIPVIEWPAGE_H
+#define CHIPVIEWPAGE_H
+
+#include "RasterPage.h"
+
+#include <vector>
+
+class RasterPager;
+
+/**
+ * A page of a chip which shares the data of its source element.
+ *
+ * The page either refers directly to a page of the source element, or holds
+ * a copy of rows of the source whose rows, columns or bands are not
+ * contiguous in the source.
+ */
+class ChipViewPage : public RasterPage
+{
+public:
+   /**
+    * Create a new ChipViewPage over a page of the source element.
+    *
+    * @param pSourcePager
+    *        The pager which created the source page.  It releases the source
+    *        page when this page is destroyed.
+    * @param pSourcePage
+    *        The page of the source element.
+    * @param rows
+    *        The number of rows in the page.
+    * @param columns
+    *        The number of columns in each row of the source page.
+    * @param bands
+    *        The number of bands in each row of the source page.
+    */
+   ChipViewPage(RasterPager* pSourcePager, RasterPage* pSourcePage, unsigned int rows, unsigned int columns,
+      unsigned int bands);
+
+   /**
+    * Create a new ChipViewPage over copied data.
+    *
+    * @param data
+    *        The copied rows, which are taken from the vector.
+    * @param offset
+    *        The offset in bytes of the first element of the page.
+    * @param rows
+    *        The number of rows in the page.
+    */
+   ChipViewPage(std::vector<unsigned char>& data, size_t offset, unsigned int rows);
+
+   ~ChipViewPage();
+
+   void* getRawData();
+   unsigned int getNumRows();
+   unsigned int getNumColumns();
+   unsigned int getNumBands();
+   unsigned int getInterlineBytes();
+
+private:
+   ChipViewPage(const ChipViewPage& rhs);
+   ChipViewPage& operator=(const ChipViewPage& rhs);
+
+   RasterPager* mpSourcePager;
+   RasterPage* mpSourcePage;
+   std::vector<unsigned char> mData;
+   void* mpRawData;
+   unsigned int mRows;
+   unsigned int mColumns;
+   unsigned int mBands;
+   unsigned int mInterlineBytes;
+};
+
+#endif
@@ -0,0 +1,446 @@
+/*
+ * The information in this file is
+ * Copyright(c) 2007 Ball Aerospace & Technologies Corporation
+ * and is subject to the terms and conditions of the
+ * GNU Lesser General Public License Version 2.1
+ * The license text is available from   
+ * http://www.gnu.org/licenses/lgpl.html
+ */
+
+#include "AppVersion.h"
+#include "AppVerify.h"
+#include "ChipViewPage.h"
+#include "ChipViewPager.h"
+#include "DataRequest.h"
+#include "ObjectResource.h"
+#include "PlugInArgList.h"
+#include "PlugInManagerServices.h"
+#include "RasterDataDescriptor.h"
+#include "RasterElement.h"
+
+#include <algorithm>
+#include <string.h>
+
+using namespace std;
+
+ChipViewPager::ChipViewPager() :
+   mpRaster(NULL),
+   mpSource(NULL),
+   mInterleave(BIP),
+   mBytesPerElement(0)
+{
+   setName("Chip View Pager");
+   setCopyright("Copyright (2007) by Ball Aerospace & Technologies Corp.");
+   setCreator("Ball Aerospace & Technologies Corp.");
+   setDescription("Provides access to the data of a chip through the pages of its source element");
+   setDescriptorId("{3C0C6D2E-7B0A-4c55-9E47-2F1B8D6A5E13}");
+   setVersion(APP_VERSION_NUMBER);
+   setProductionStatus(APP_IS_PRODUCTION_RELEASE);
+   setShortDescription("Shares the data of a source element with a chip");
+}
+
+ChipViewPager::~ChipViewPager()
+{
+}
+
+bool ChipViewPager::getInputSpecification(PlugInArgList*& pArgList)
+{
+   Service<PlugInManagerServices> pPlugInMgr;
+
+   pArgList = pPlugInMgr->getPlugInArgList();
+   VERIFY(pArgList != NULL);
+
+   VERIFY(pArgList->addArg<RasterElement>("Raster Element"));
+   VERIFY(pArgList->addArg<RasterElement>("Source Element"));
+   VERIFY(pArgList->addArg<vector<unsigned int> >("Rows"));
+   VERIFY(pArgList->addArg<vector<unsigned int> >("Columns"));
+   VERIFY(pArgList->addArg<vector<unsigned int> >("Bands"));
+
+   return true;
+}
+
+bool ChipViewPager::execute(PlugInArgList* pInput, PlugInArgList* pOutput)
+{
+   VERIFY(mpRaster == NULL && mpSource == NULL);
+   VERIFY(pInput != NULL);
+
+   mpRaster = pInput->getPlugInArgValue<RasterElement>("Raster Element");
+   mpSource = pInput->getPlugInArgValue<RasterElement>("Source Element");
+   vector<unsigned int>* pRows = pInput->getPlugInArgValue<vector<unsigned int> >("Rows");
+   vector<unsigned int>* pColumns = pInput->getPlugInArgValue<vector<unsigned int> >("Columns");
+   vector<unsigned int>* pBands = pInput->getPlugInArgValue<vector<unsigned int> >("Bands");
+   VERIFY(mpRaster != NULL && mpSource != NULL && mpRaster != mpSource);
+   VERIFY(pRows != NULL && pColumns != NULL && pBands != NULL);
+
+   const RasterDataDescriptor* pDescriptor = dynamic_cast<const RasterDataDescriptor*>(mpRaster->getDataDescriptor());
+   const RasterDataDescriptor* pSourceDescriptor =
+      dynamic_cast<const RasterDataDescriptor*>(mpSource->getDataDescriptor());
+   VERIFY(pDescriptor != NULL && pSourceDescriptor != NULL);
+
+   mInterleave = pDescriptor->getInterleaveFormat();
+   mBytesPerElement = pDescriptor->getBytesPerElement();
+   VERIFY(mInterleave == pSourceDescriptor->getInterleaveFormat());
+   VERIFY(mBytesPerElement == pSourceDescriptor->getBytesPerElement());
+   VERIFY(pRows->size() == pDescriptor->getRowCount() && !pRows->empty() &&
+      pRows->back() < pSourceDescriptor->getRowCount());
+   VERIFY(pColumns->size() == pDescriptor->getColumnCount() && !pColumns->empty() &&
+      pColumns->back() < pSourceDescriptor->getColumnCount());
+   VERIFY(pBands->size() == pDescriptor->getBandCount() && !pBands->empty() &&
+      pBands->back() < pSourceDescriptor->getBandCount());
+
+   mRows = *pRows;
+   mColumns = *pColumns;
+   mBands = *pBands;
+   getRuns(mRows, mRowRuns);
+   getRuns(mColumns, mColumnRuns);
+   getRuns(mBands, mBandRuns);
+
+   return true;
+}
+
+RasterPage* ChipViewPager::getPage(DataRequest* pOriginalRequest, DimensionDescriptor startRow,
+                                   DimensionDescriptor startColumn, DimensionDescriptor startBand)
+{
+   VERIFYRV(pOriginalRequest != NULL, NULL);
+
+   // the data is copied into the chip before it can be written
+   VERIFYRV(pOriginalRequest->getWritable() == false, NULL);
+
+   Selection selection;
+   if (getSelection(pOriginalRequest, startRow, startColumn, startBand, selection) == false)
+   {
+      return NULL;
+   }
+
+   if (isShared(selection) == false)
+   {
+      return copyPage(selection);
+   }
+
+   RasterPager* pSourcePager = mpSource->getPager();
+   const RasterDataDescriptor* pSourceDescriptor =
+      dynamic_cast<const RasterDataDescriptor*>(mpSource->getDataDescriptor());
+   VERIFYRV(pSourcePager != NULL && pSourceDescriptor != NULL, NULL);
+
+   FactoryResource<DataRequest> pRequest;
+   if (setSourceRequest(pRequest.get(), selection) == false ||
+      pSourcePager->getSupportedRequestVersion() < pRequest->getRequestVersion(pSourceDescriptor))
+   {
+      return NULL;
+   }
+
+   RasterPage* pSourcePage = pSourcePager->getPage(pRequest.get(), pRequest->getStartRow(),
+      pRequest->getStartColumn(), pRequest->getStartBand());
+   if (pSourcePage == NULL)
+   {
+      return NULL;
+   }
+
+   // the chip accessor needs the size of the source rows, which is given by the whole source page
+   unsigned int columns = pSourcePage->getNumColumns();
+   if (columns == 0)
+   {
+      columns = pSourceDescriptor->getColumnCount();
+   }
+
+   unsigned int bands = pSourcePage->getNumBands();
+   if (bands == 0)
+   {
+      bands = pSourceDescriptor->getBandCount();
+   }
+
+   unsigned int rows = min(pSourcePage->getNumRows(), mRowRuns[selection.mStartRow]);
+   if (pSourcePage->getRawData() == NULL || rows == 0)
+   {
+      pSourcePager->releasePage(pSourcePage);
+      return NULL;
+   }
+
+   return new ChipViewPage(pSourcePager, pSourcePage, rows, columns, bands);
+}
+
+void ChipViewPager::releasePage(RasterPage* pPage)
+{
+   ChipViewPage* pChipPage = dynamic_cast<ChipViewPage*>(pPage);
+   if (pChipPage != NULL)
+   {
+      delete pChipPage;
+   }
+}
+
+void ChipViewPager::prefetchPage(DataRequest* pOriginalRequest, DimensionDescriptor startRow,
+                                 DimensionDescriptor startColumn, DimensionDescriptor startBand)
+{
+   Selection selection;
+   if (pOriginalRequest == NULL ||
+      getSelection(pOriginalRequest, startRow, startColumn, startBand, selection) == false ||
+      isShared(selection) == false)
+   {
+      return;
+   }
+
+   RasterPager* pSourcePager = mpSource->getPager();
+   if (pSourcePager != NULL)
+   {
+      FactoryResource<DataRequest> pRequest;
+      if (setSourceRequest(pRequest.get(), selection))
+      {
+         pSourcePager->prefetchPage(pRequest.get(), pRequest->getStartRow(), pRequest->getStartColumn(),
+            pRequest->getStartBand());
+      }
+   }
+}
+
+int ChipViewPager::getSupportedRequestVersion() const
+{
+   return 1;
+}
+
+const RasterElement* ChipViewPager::getSource() const
+{
+   return mpSource;
+}
+
+const vector<unsigned int>& ChipViewPager::getRows() const
+{
+   return mRows;
+}
+
+const vector<unsigned int>& ChipViewPager::getColumns() const
+{
+   return mColumns;
+}
+
+const vector<unsigned int>& ChipViewPager::getBands() const
+{
+   return mBands;
+}
+
+bool ChipViewPager::getSelection(DataRequest* pOriginalRequest, DimensionDescriptor startRow,
+                                 DimensionDescriptor startColumn, DimensionDescriptor startBand,
+                                 Selection& selection) const
+{
+   VERIFY(mpRaster != NULL && mpSource != NULL);
+   if (pOriginalRequest->getInterleaveFormat() != mInterleave)
+   {
+      return false;
+   }
+
+   selection.mStartRow = startRow.getActiveNumber();
+   selection.mStartColumn = startColumn.getActiveNumber();
+   selection.mStartBand = startBand.getActiveNumber();
+   if (selection.mStartRow >= mRows.size() || selection.mStartColumn >= mColumns.size() ||
+      selection.mStartBand >= mBands.size())
+   {
+      return false;
+   }
+
+   selection.mStopRow = max(selection.mStartRow, min(pOriginalRequest->getStopRow().getActiveNumber(),
+      static_cast<unsigned int>(mRows.size() - 1)));
+   selection.mConcurrentRows = max(min(pOriginalRequest->getConcurrentRows(),
+      selection.mStopRow - selection.mStartRow + 1), 1U);
+   selection.mStopColumn = max(selection.mStartColumn, min(pOriginalRequest->getStopColumn().getActiveNumber(),
+      static_cast<unsigned int>(mColumns.size() - 1)));
+   selection.mStopBand = selection.mStartBand;
+   if (mInterleave != BSQ)
+   {
+      selection.mStopBand = max(selection.mStartBand, min(pOriginalRequest->getStopBand().getActiveNumber(),
+         static_cast<unsigned int>(mBands.size() - 1)));
+   }
+
+   return true;
+}
+
+bool ChipViewPager::isShared(const Selection& selection) const
+{
+   return mRowRuns[selection.mStartRow] >= selection.mConcurrentRows &&
+      mColumnRuns[selection.mStartColumn] > selection.mStopColumn - selection.mStartColumn &&
+      mBandRuns[selection.mStartBand] > selection.mStopBand - selection.mStartBand;
+}
+
+bool ChipViewPager::setSourceRequest(DataRequest* pRequest, const Selection& selection) const
+{
+   VERIFY(pRequest != NULL);
+   const RasterDataDescriptor* pSourceDescriptor =
+      dynamic_cast<const RasterDataDescriptor*>(mpSource->getDataDescriptor());
+   VERIFY(pSourceDescriptor != NULL);
+
+   // the source page may extend to the end of the contiguous rows
+   unsigned int stopRow = min(selection.mStartRow + mRowRuns[selection.mStartRow] - 1, selection.mStopRow);
+   pRequest->setInterleaveFormat(mInterleave);
+   pRequest->setRows(pSourceDescriptor->getActiveRow(mRows[selection.mStartRow]),
+      pSourceDescriptor->getActiveRow(mRows[stopRow]), selection.mConcurrentRows);
+   pRequest->setColumns(pSourceDescriptor->getActiveColumn(mColumns[selection.mStartColumn]),
+      pSourceDescriptor->getActiveColumn(mColumns[selection.mStopColumn]),
+      selection.mStopColumn - selection.mStartColumn + 1);
+   pRequest->setBands(pSourceDescriptor->getActiveBand(mBands[selection.mStartBand]),
+      pSourceDescriptor->getActiveBand(mBands[selection.mStopBand]),
+      selection.mStopBand - selection.mStartBand + 1);
+
+   return pRequest->polish(pSourceDescriptor) && pRequest->validate(pSourceDescriptor);
+}
+
+RasterPage* ChipViewPager::copyPage(const Selection& selection)
+{
+   RasterPager* pSourcePager = mpSource->getPager();
+   const RasterDataDescriptor* pSourceDescriptor =
+      dynamic_cast<const RasterDataDescriptor*>(mpSource->getDataDescriptor());
+   VERIFYRV(pSourcePager != NULL && pSourceDescriptor != NULL, NULL);
+
+   // The page holds every column and band of the chip rows, in the interleave of the chip.
+   unsigned int columns = static_cast<unsigned int>(mColumns.size());
+   unsigned int bands = static_cast<unsigned int>(mBands.size());
+   unsigned int firstBand = 0;
+   unsigned int lastBand = bands - 1;
+   size_t rowSize = static_cast<size_t>(columns) * mBytesPerElement;
+   size_t offset = static_cast<size_t>(selection.mStartColumn) * mBytesPerElement;
+   switch (mInterleave)
+   {
+   case BIP:
+      rowSize *= bands;
+      offset = (static_cast<size_t>(selection.mStartColumn) * bands + selection.mStartBand) * mBytesPerElement;
+      break;
+   case BIL:
+      rowSize *= bands;
+      offset = (static_cast<size_t>(selection.mStartBand) * columns + selection.mStartColumn) * mBytesPerElement;
+      break;
+   case BSQ:
+      firstBand = selection.mStartBand;
+      lastBand = selection.mStartBand;
+      break;
+   default:
+      return NULL;
+   }
+
+   vector<unsigned char> data;
+   try
+   {
+      data.resize(rowSize * selection.mConcurrentRows);
+   }
+   catch (const bad_alloc&)
+   {
+      return NULL;
+   }
+
+   FactoryResource<DataRequest> pRequest;
+   pRequest->setInterleaveFormat(mInterleave);
+   pRequest->setRows(pSourceDescriptor->getActiveRow(mRows[selection.mStartRow]),
+      pSourceDescriptor->getActiveRow(mRows[selection.mStartRow + selection.mConcurrentRows - 1]), 1);
+   pRequest->setColumns(pSourceDescriptor->getActiveColumn(mColumns.front()),
+      pSourceDescriptor->getActiveColumn(mColumns.back()), mColumns.back() - mColumns.front() + 1);
+   pRequest->setBands(pSourceDescriptor->getActiveBand(mBands[firstBand]),
+      pSourceDescriptor->getActiveBand(mBands[lastBand]), mBands[lastBand] - mBands[firstBand] + 1);
+   if (pRequest->polish(pSourceDescriptor) == false || pRequest->validate(pSourceDescriptor) == false ||
+      pSourcePager->getSupportedRequestVersion() < pRequest->getRequestVersion(pSourceDescriptor))
+   {
+      return NULL;
+   }
+
+   unsigned int sourceColumn = mColumns.front();
+   unsigned int sourceBand = mBands[firstBand];
+   RasterPage* pSourcePage = NULL;
+   unsigned int pageStartRow = 0;
+   unsigned int pageRows = 0;
+   size_t sourceRowSize = 0;
+   size_t sourceColumnSize = 0;
+   size_t sourceBandSize = 0;
+   bool success = true;
+   for (unsigned int row = 0; row < selection.mConcurrentRows && success; ++row)
+   {
+      unsigned int sourceRow = mRows[selection.mStartRow + row];
+      if (pSourcePage == NULL || sourceRow >= pageStartRow + pageRows)
+      {
+         if (pSourcePage != NULL)
+         {
+            pSourcePager->releasePage(pSourcePage);
+         }
+
+         pSourcePage = pSourcePager->getPage(pRequest.get(), pSourceDescriptor->getActiveRow(sourceRow),
+            pSourceDescriptor->getActiveColumn(sourceColumn), pSourceDescriptor->getActiveBand(sourceBand));
+         if (pSourcePage == NULL || pSourcePage->getRawData() == NULL || pSourcePage->getNumRows() == 0)
+         {
+            success = false;
+            break;
+         }
+
+         // the same sizes a DataAccessor uses for the page
+         unsigned int pageColumns = pSourcePage->getNumColumns();
+         unsigned int pageBands = pSourcePage->getNumBands();
+         pageColumns = (pageColumns == 0) ? pSourceDescriptor->getColumnCount() : pageColumns;
+         pageBands = (pageBands == 0) ? pSourceDescriptor->getBandCount() : pageBands;
+         pageStartRow = sourceRow;
+         pageRows = pSourcePage->getNumRows();
+         sourceColumnSize = mBytesPerElement;
+         sourceBandSize = static_cast<size_t>(pageColumns) * mBytesPerElement;
+         sourceRowSize = sourceBandSize * pageBands + pSourcePage->getInterlineBytes();
+         if (mInterleave == BIP)
+         {
+            sourceColumnSize = static_cast<size_t>(pageBands) * mBytesPerElement;
+            sourceBandSize = mBytesPerElement;
+         }
+         else if (mInterleave == BSQ)
+         {
+            sourceRowSize = static_cast<size_t>(pageColumns) * mBytesPerElement + pSourcePage->getInterlineBytes();
+            sourceBandSize = 0;
+         }
+      }
+
+      const unsigned char* pSource = reinterpret_cast<const unsigned char*>(pSourcePage->getRawData()) +
+         (sourceRow - pageStartRow) * sourceRowSize;
+      unsigned char* pDestination = &data[row * rowSize];
+
+      // copy each run of elements which is contiguous in both the chip and the source
+      if (mInterleave == BIP)
+      {
+         for (unsigned int column = 0; column < columns; ++column)
+         {
+            const unsigned char* pColumn = pSource + (mColumns[column] - sourceColumn) * sourceColumnSize;
+            for (unsigned int band = 0; band < bands; band += mBandRuns[band])
+            {
+               memcpy(pDestination + band * mBytesPerElement,
+                  pColumn + (mBands[band] - sourceBand) * sourceBandSize, mBandRuns[band] * mBytesPerElement);
+            }
+            pDestination += bands * mBytesPerElement;
+         }
+      }
+      else
+      {
+         for (unsigned int band = firstBand; band <= lastBand; ++band)
+         {
+            const unsigned char* pBand = pSource + (mBands[band] - sourceBand) * sourceBandSize;
+            for (unsigned int column = 0; column < columns; column += mColumnRuns[column])
+            {
+               memcpy(pDestination + column * mBytesPerElement,
+                  pBand + (mColumns[column] - sourceColumn) * sourceColumnSize, mColumnRuns[column] * mBytesPerElement);
+            }
+            pDestination += columns * mBytesPerElement;
+         }
+      }
+   }
+
+   if (pSourcePage != NULL)
+   {
+      pSourcePager->releasePage(pSourcePage);
+   }
+
+   if (success == false)
+   {
+      return NULL;
+   }
+
+   return new ChipViewPage(data, offset, selection.mConcurrentRows);
+}
+
+void ChipViewPager::getRuns(const vector<unsigned int>& numbers, vector<unsigned int>& runs)
+{
+   runs.resize(numbers.size());
+   for (size_t i = numbers.size(); i > 0; --i)
+   {
+      size_t index = i - 1;
+      runs[index] = 1;
+      if (i < numbers.size() && numbers[i] == numbers[index] + 1)
+      {
+         runs[index] += runs[i];
+      }
+   }
+}
@@ -0,0 +1,100 @@
+/*
+ * The information in this file is
+ * Copyright(c) 2007 Ball Aerospace & Technologies Corporation
+ * and is subject to the terms and conditions of the
+ * GNU Lesser General Public License Version 2.1
+ * The license text is available from   
+ * http://www.gnu.org/licenses/lgpl.html
+ */
+
+#ifndef CHIPVIEWPAGER_H
+#define CHIPVIEWPAGER_H
+
+#include "RasterPagerShell.h"
+#include "TypesFile.h"
+
+#include <vector>
+
+class RasterDataDescriptor;
+class RasterElement;
+
+/**
+ * Provides the data of a chip from the pages of its source element.
+ *
+ * The rows, columns and bands of the chip are mapped onto the active rows,
+ * columns and bands of the source.  Where the requested data is contiguous
+ * in the source, the pages of the chip refer directly to the pages of the
+ * source, otherwise the rows of a page are copied from the source.  The chip
+ * is read-only; RasterElementImp copies the data into a pager of its own
+ * before a writable DataAccessor is created.
+ */
+class ChipViewPager : public RasterPagerShell
+{
+public:
+   ChipViewPager();
+   ~ChipViewPager();
+
+   bool getInputSpecification(PlugInArgList*& pArgList);
+   bool execute(PlugInArgList* pInput, PlugInArgList* pOutput);
+
+   RasterPage* getPage(DataRequest* pOriginalRequest, DimensionDescriptor startRow, DimensionDescriptor startColumn,
+      DimensionDescriptor startBand);
+   void releasePage(RasterPage* pPage);
+   void prefetchPage(DataRequest* pOriginalRequest, DimensionDescriptor startRow, DimensionDescriptor startColumn,
+      DimensionDescriptor startBand);
+
+   int getSupportedRequestVersion() const;
+
+   const RasterElement* getSource() const;
+
+   /**
+    * Get the source active numbers of the chip rows.
+    */
+   const std::vector<unsigned int>& getRows() const;
+
+   /**
+    * Get the source active numbers of the chip columns.
+    */
+   const std::vector<unsigned int>& getColumns() const;
+
+   /**
+    * Get the source active numbers of the chip bands.
+    */
+   const std::vector<unsigned int>& getBands() const;
+
+private:
+   // The chip data needed by a page, in active numbers of the chip
+   struct Selection
+   {
+      unsigned int mStartRow;
+      unsigned int mStopRow;
+      unsigned int mConcurrentRows;
+      unsigned int mStartColumn;
+      unsigned int mStopColumn;
+      unsigned int mStartBand;
+      unsigned int mStopBand;
+   };
+
+   bool getSelection(DataRequest* pOriginalRequest, DimensionDescriptor startRow, DimensionDescriptor startColumn,
+      DimensionDescriptor startBand, Selection& selection) const;
+   bool isShared(const Selection& selection) const;
+   bool setSourceRequest(DataRequest* pRequest, const Selection& selection) const;
+   RasterPage* copyPage(const Selection& selection);
+   static void getRuns(const std::vector<unsigned int>& numbers, std::vector<unsigned int>& runs);
+
+   RasterElement* mpRaster;
+   RasterElement* mpSource;
+   InterleaveFormatType mInterleave;
+   unsigned int mBytesPerElement;
+
+   std::vector<unsigned int> mRows;
+   std::vector<unsigned int> mColumns;
+   std::vector<unsigned int> mBands;
+
+   // the number of chip rows, columns and bands from each one which are contiguous in the source
+   std::vector<unsigned int> mRowRuns;
+   std::vector<unsigned int> mColumnRuns;
+   std::vector<unsigned int> mBandRuns;
+};
+
+#endif
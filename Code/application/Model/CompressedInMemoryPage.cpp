@@ -0,0 +1,69 @@
+/*
+ * The information in this file is
+ * Copyright(c) 2007 Ball Aerospace & Technologies Corporation
+ * and is subject to the terms and conditions of the
+ * GNU Lesser General Public License Version 2.1
+ * The license text is available from   
+ * http://www.gnu.org/licenses/lgpl.html
+ */
+
+#include "CompressedInMemoryPage.h"
+
+CompressedInMemoryPage::CompressedInMemoryPage(ConvertedPageCache::UnitPtr pUnit, unsigned int plane, size_t offset,
+                                               unsigned int rows, bool writable) :
+   mpUnit(pUnit),
+   mPlane(plane),
+   mOffset(offset),
+   mRows(rows),
+   mWritable(writable)
+{
+}
+
+CompressedInMemoryPage::~CompressedInMemoryPage()
+{
+}
+
+ConvertedPageCache::UnitPtr CompressedInMemoryPage::getUnit() const
+{
+   return mpUnit;
+}
+
+unsigned int CompressedInMemoryPage::getPlane() const
+{
+   return mPlane;
+}
+
+bool CompressedInMemoryPage::isWritable() const
+{
+   return mWritable;
+}
+
+void* CompressedInMemoryPage::getRawData()
+{
+   if (mpUnit.get() == NULL || mpUnit->getRawData() == NULL)
+   {
+      return NULL;
+   }
+
+   return mpUnit->getRawData() + mOffset;
+}
+
+unsigned int CompressedInMemoryPage::getNumRows()
+{
+   return mRows;
+}
+
+unsigned int CompressedInMemoryPage::getNumColumns()
+{
+   return 0;
+}
+
+unsigned int CompressedInMemoryPage::getNumBands()
+{
+   return 0;
+}
+
+unsigned int CompressedInMemoryPage::getInterlineBytes()
+{
+   return 0;
+}
@@ -0,0 +1,64 @@
+/*
+ * The information in this file is
+ * Copyright(c) 2007 Ball Aerospace & Technologies Corporation
+ * and is subject to the terms and conditions of the
+ * GNU Lesser General Public License Version 2.1
+ * The license text is available from   
+ * http://www.gnu.org/licenses/lgpl.html
+ */
+
+#ifndef COMPRESSEDINMEMORYPAGE_H
+#define COMPRESSEDINMEMORYPAGE_H
+
+#include "ConvertedPageCache.h"
+#include "RasterPage.h"
+
+/**
+ * A page of decompressed data from a CompressedInMemoryPager.
+ *
+ * The data is held in a unit of the pager's working set.  A page which fits
+ * within one compressed block shares the unit of that block, while a page
+ * spanning several blocks holds a copy of their rows.
+ */
+class CompressedInMemoryPage : public RasterPage
+{
+public:
+   /**
+    * Create a new CompressedInMemoryPage over decompressed data.
+    *
+    * @param pUnit
+    *        The unit which holds the decompressed rows.
+    * @param plane
+    *        The band of the unit for BSQ data, or zero otherwise.
+    * @param offset
+    *        The offset in bytes of the first element of the page within the
+    *        unit.
+    * @param rows
+    *        The number of rows in the page.
+    * @param writable
+    *        True if the data of the page is compressed again when the page is
+    *        released.
+    */
+   CompressedInMemoryPage(ConvertedPageCache::UnitPtr pUnit, unsigned int plane, size_t offset, unsigned int rows,
+      bool writable);
+   ~CompressedInMemoryPage();
+
+   ConvertedPageCache::UnitPtr getUnit() const;
+   unsigned int getPlane() const;
+   bool isWritable() const;
+
+   void* getRawData();
+   unsigned int getNumRows();
+   unsigned int getNumColumns();
+   unsigned int getNumBands();
+   unsigned int getInterlineBytes();
+
+private:
+   ConvertedPageCache::UnitPtr mpUnit;
+   unsigned int mPlane;
+   size_t mOffset;
+   unsigned int mRows;
+   bool mWritable;
+};
+
+#endif
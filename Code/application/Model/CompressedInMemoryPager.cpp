@@ -0,0 +1,357 @@
+/*
+ * The information in this file is
+ * Copyright(c) 2007 Ball Aerospace & Technologies Corporation
+ * and is subject to the terms and conditions of the
+ * GNU Lesser General Public License Version 2.1
+ * The license text is available from   
+ * http://www.gnu.org/licenses/lgpl.html
+ */
+
+#include "AppVersion.h"
+#include "AppVerify.h"
+#include "CompressedInMemoryPage.h"
+#include "CompressedInMemoryPager.h"
+#include "DataRequest.h"
+#include "PlugInArgList.h"
+#include "PlugInManagerServices.h"
+#include "RasterDataDescriptor.h"
+#include "RasterElement.h"
+
+#include <algorithm>
+#include <string.h>
+#include <zlib.h>
+
+namespace
+{
+   // The preferred number of uncompressed bytes in each block
+   const size_t BLOCK_SIZE = 1024 * 1024;
+}
+
+CompressedInMemoryPager::Block::Block() :
+   mCompressed(false),
+   mCommittedWrite(0),
+   mLastWrite(0)
+{
+}
+
+CompressedInMemoryPager::CompressedInMemoryPager() :
+   mpRaster(NULL),
+   mInterleave(BIP),
+   mNumRows(0),
+   mNumColumns(0),
+   mNumBands(0),
+   mBytesPerElement(0),
+   mRowSize(0),
+   mBlockRows(0),
+   mBlocksPerPlane(0)
+{
+   setName("Compressed In Memory Pager");
+   setCopyright("Copyright (2007) by Ball Aerospace & Technologies Corp.");
+   setCreator("Ball Aerospace & Technologies Corp.");
+   setDescription("Provides access to data held in memory as compressed blocks");
+   setDescriptorId("{81530F85-92AA-4c2d-A78B-A9CBC0D37953}");
+   setVersion(APP_VERSION_NUMBER);
+   setProductionStatus(APP_IS_PRODUCTION_RELEASE);
+   setShortDescription("Provides a compressed RAM backing for data");
+}
+
+CompressedInMemoryPager::~CompressedInMemoryPager()
+{
+}
+
+bool CompressedInMemoryPager::getInputSpecification(PlugInArgList*& pArgList)
+{
+   Service<PlugInManagerServices> pPlugInMgr;
+
+   pArgList = pPlugInMgr->getPlugInArgList();
+   VERIFY(pArgList != NULL);
+
+   VERIFY(pArgList->addArg<RasterElement>("Raster Element"));
+
+   return true;
+}
+
+bool CompressedInMemoryPager::execute(PlugInArgList* pInput, PlugInArgList* pOutput)
+{
+   VERIFY(mpRaster == NULL);
+   VERIFY(pInput != NULL);
+
+   mpRaster = pInput->getPlugInArgValue<RasterElement>("Raster Element");
+   VERIFY(mpRaster != NULL);
+
+   const RasterDataDescriptor* pDescriptor = dynamic_cast<const RasterDataDescriptor*>(mpRaster->getDataDescriptor());
+   VERIFY(pDescriptor != NULL);
+
+   mInterleave = pDescriptor->getInterleaveFormat();
+   mNumRows = pDescriptor->getRowCount();
+   mNumColumns = pDescriptor->getColumnCount();
+   mNumBands = pDescriptor->getBandCount();
+   mBytesPerElement = pDescriptor->getBytesPerElement();
+   VERIFY(mNumRows > 0 && mNumColumns > 0 && mNumBands > 0 && mBytesPerElement > 0);
+
+   // BIP and BIL rows hold every band, while BSQ data is blocked one band at a time
+   unsigned int planes = 1;
+   mRowSize = static_cast<size_t>(mNumColumns) * mBytesPerElement;
+   if (mInterleave == BSQ)
+   {
+      planes = mNumBands;
+   }
+   else
+   {
+      mRowSize *= mNumBands;
+   }
+
+   mBlockRows = static_cast<unsigned int>(std::min(static_cast<size_t>(mNumRows),
+      std::max(BLOCK_SIZE / mRowSize, static_cast<size_t>(1))));
+   mBlocksPerPlane = (mNumRows + mBlockRows - 1) / mBlockRows;
+   mBlocks.resize(planes * mBlocksPerPlane);
+   mpWorkingSet.reset(new ConvertedPageCache(mpRaster, RasterElement::getSettingConvertedPageCacheSize()));
+
+   return true;
+}
+
+RasterPage* CompressedInMemoryPager::getPage(DataRequest* pOriginalRequest, DimensionDescriptor startRow,
+                                             DimensionDescriptor startColumn, DimensionDescriptor startBand)
+{
+   VERIFYRV(mpRaster != NULL && mpWorkingSet.get() != NULL, NULL);
+   VERIFYRV(pOriginalRequest != NULL, NULL);
+
+   if (pOriginalRequest->getInterleaveFormat() != mInterleave)
+   {
+      return NULL;
+   }
+
+   unsigned int rowNumber = startRow.getActiveNumber();
+   unsigned int colNumber = startColumn.getActiveNumber();
+   unsigned int bandNumber = startBand.getActiveNumber();
+   if (rowNumber >= mNumRows || colNumber >= mNumColumns || bandNumber >= mNumBands)
+   {
+      return NULL;
+   }
+
+   unsigned int stopRow = std::max(pOriginalRequest->getStopRow().getActiveNumber(), rowNumber);
+   unsigned int concurrentRows = std::max(std::min(pOriginalRequest->getConcurrentRows(),
+      std::min(stopRow, mNumRows - 1) - rowNumber + 1), 1U);
+
+   unsigned int plane = 0;
+   size_t elementOffset = 0;
+   switch (mInterleave)
+   {
+   case BIP:
+      elementOffset = (static_cast<size_t>(colNumber) * mNumBands + bandNumber) * mBytesPerElement;
+      break;
+   case BSQ:
+      plane = bandNumber;
+      elementOffset = static_cast<size_t>(colNumber) * mBytesPerElement;
+      break;
+   case BIL:
+      elementOffset = (static_cast<size_t>(bandNumber) * mNumColumns + colNumber) * mBytesPerElement;
+      break;
+   default:
+      return NULL;
+   }
+
+   bool writable = pOriginalRequest->getWritable();
+   unsigned int blockEnd = std::min(getBlockStartRow(rowNumber) + mBlockRows, mNumRows);
+   if (rowNumber + concurrentRows <= blockEnd)
+   {
+      ConvertedPageCache::UnitPtr pUnit = getBlockUnit(plane, rowNumber);
+      if (pUnit.get() == NULL)
+      {
+         return NULL;
+      }
+
+      return new CompressedInMemoryPage(pUnit, plane,
+         (rowNumber - pUnit->getStartRow()) * mRowSize + elementOffset,
+         pUnit->getStartRow() + pUnit->getRowCount() - rowNumber, writable);
+   }
+
+   // The rows needed at once span several blocks, so they are copied into a unit of their own
+   ConvertedPageCache::UnitPtr pUnit = mpWorkingSet->createUnit(rowNumber, concurrentRows, 0, mNumColumns,
+      plane, 1, mRowSize);
+   if (pUnit.get() == NULL)
+   {
+      return NULL;
+   }
+
+   for (unsigned int row = rowNumber; row < rowNumber + concurrentRows; )
+   {
+      ConvertedPageCache::UnitPtr pBlockUnit = getBlockUnit(plane, row);
+      if (pBlockUnit.get() == NULL)
+      {
+         return NULL;
+      }
+
+      unsigned int rows = std::min(pBlockUnit->getStartRow() + pBlockUnit->getRowCount(),
+         rowNumber + concurrentRows) - row;
+      memcpy(pUnit->getRawData() + (row - rowNumber) * mRowSize,
+         pBlockUnit->getRawData() + (row - pBlockUnit->getStartRow()) * mRowSize, rows * mRowSize);
+      row += rows;
+   }
+
+   return new CompressedInMemoryPage(pUnit, plane, elementOffset, concurrentRows, writable);
+}
+
+void CompressedInMemoryPager::releasePage(RasterPage* pPage)
+{
+   CompressedInMemoryPage* pCompressedPage = dynamic_cast<CompressedInMemoryPage*>(pPage);
+   if (pCompressedPage != NULL)
+   {
+      // Store the data while the page still holds the unit, so that the unit cannot be
+      // discarded and decompressed again from the old data in the meantime.
+      if (pCompressedPage->isWritable())
+      {
+         writeBlocks(pCompressedPage->getUnit(), pCompressedPage->getPlane());
+      }
+
+      delete pCompressedPage;
+   }
+}
+
+int CompressedInMemoryPager::getSupportedRequestVersion() const
+{
+   return 1;
+}
+
+size_t CompressedInMemoryPager::getBlockIndex(unsigned int plane, unsigned int row) const
+{
+   return plane * mBlocksPerPlane + row / mBlockRows;
+}
+
+unsigned int CompressedInMemoryPager::getBlockStartRow(unsigned int row) const
+{
+   return row - row % mBlockRows;
+}
+
+ConvertedPageCache::UnitPtr CompressedInMemoryPager::getBlockUnit(unsigned int plane, unsigned int row)
+{
+   size_t blockIndex = getBlockIndex(plane, row);
+   unsigned int blockStartRow = getBlockStartRow(row);
+   unsigned int blockRows = std::min(mBlockRows, mNumRows - blockStartRow);
+   VERIFYRV(blockIndex < mBlocks.size(), ConvertedPageCache::UnitPtr());
+
+   for (;;)
+   {
+      boost::shared_ptr<const std::vector<unsigned char> > pData;
+      bool compressed = false;
+      unsigned int committedWrite = 0;
+      {
+         mta::MutexLock lock(mMutex);
+         Block& block = mBlocks[blockIndex];
+         ConvertedPageCache::UnitPtr pUnit = block.mpUnit.lock();
+         if (pUnit.get() != NULL)
+         {
+            return pUnit;
+         }
+
+         pData = block.mpData;
+         compressed = block.mCompressed;
+         committedWrite = block.mCommittedWrite;
+      }
+
+      // Decompress without holding the lock so that other blocks can be used meanwhile
+      ConvertedPageCache::UnitPtr pUnit = mpWorkingSet->createUnit(blockStartRow, blockRows, 0, mNumColumns,
+         plane, 1, mRowSize);
+      if (pUnit.get() == NULL)
+      {
+         return pUnit;
+      }
+
+      if (pData.get() != NULL && pData->empty() == false)
+      {
+         if (compressed)
+         {
+            uLongf size = static_cast<uLongf>(pUnit->getSize());
+            VERIFYRV(uncompress(pUnit->getRawData(), &size, &pData->front(),
+               static_cast<uLong>(pData->size())) == Z_OK && size == pUnit->getSize(), ConvertedPageCache::UnitPtr());
+         }
+         else
+         {
+            VERIFYRV(pData->size() == pUnit->getSize(), ConvertedPageCache::UnitPtr());
+            memcpy(pUnit->getRawData(), &pData->front(), pData->size());
+         }
+      }
+
+      {
+         mta::MutexLock lock(mMutex);
+         Block& block = mBlocks[blockIndex];
+         ConvertedPageCache::UnitPtr pCurrentUnit = block.mpUnit.lock();
+         if (pCurrentUnit.get() != NULL)
+         {
+            return pCurrentUnit;
+         }
+
+         if (block.mCommittedWrite != committedWrite)
+         {
+            // the block was written while it was being decompressed
+            continue;
+         }
+
+         block.mpUnit = pUnit;
+      }
+
+      mpWorkingSet->addUnit(pUnit);
+      return pUnit;
+   }
+}
+
+void CompressedInMemoryPager::writeBlocks(ConvertedPageCache::UnitPtr pUnit, unsigned int plane)
+{
+   VERIFYNRV(pUnit.get() != NULL);
+
+   unsigned int startRow = pUnit->getStartRow();
+   unsigned int stopRow = startRow + pUnit->getRowCount();
+   for (unsigned int row = startRow; row < stopRow; )
+   {
+      ConvertedPageCache::UnitPtr pBlockUnit = getBlockUnit(plane, row);
+      VERIFYNRV(pBlockUnit.get() != NULL);
+
+      unsigned int rows = std::min(pBlockUnit->getStartRow() + pBlockUnit->getRowCount(), stopRow) - row;
+      if (pBlockUnit != pUnit)
+      {
+         memcpy(pBlockUnit->getRawData() + (row - pBlockUnit->getStartRow()) * mRowSize,
+            pUnit->getRawData() + (row - startRow) * mRowSize, rows * mRowSize);
+      }
+
+      compressBlock(getBlockIndex(plane, row), pBlockUnit);
+      row += rows;
+   }
+}
+
+void CompressedInMemoryPager::compressBlock(size_t blockIndex, ConvertedPageCache::UnitPtr pUnit)
+{
+   VERIFYNRV(blockIndex < mBlocks.size() && pUnit.get() != NULL && pUnit->getRawData() != NULL);
+
+   // Writes are numbered before the data is read, so a later write always holds the data of
+   // every earlier one and the data of an earlier write which finishes compressing last is dropped.
+   unsigned int write = 0;
+   {
+      mta::MutexLock lock(mMutex);
+      write = ++mBlocks[blockIndex].mLastWrite;
+   }
+
+   const unsigned char* pSource = pUnit->getRawData();
+   std::vector<unsigned char> buffer(compressBound(static_cast<uLong>(pUnit->getSize())));
+   uLongf size = static_cast<uLongf>(buffer.size());
+   bool compressed = compress2(&buffer.front(), &size, pSource, static_cast<uLong>(pUnit->getSize()),
+      Z_BEST_SPEED) == Z_OK && size < pUnit->getSize();
+
+   boost::shared_ptr<const std::vector<unsigned char> > pData;
+   if (compressed)
+   {
+      pData.reset(new std::vector<unsigned char>(buffer.begin(), buffer.begin() + size));
+   }
+   else
+   {
+      pData.reset(new std::vector<unsigned char>(pSource, pSource + pUnit->getSize()));
+   }
+
+   mta::MutexLock lock(mMutex);
+   Block& block = mBlocks[blockIndex];
+   if (write > block.mCommittedWrite)
+   {
+      block.mpData = pData;
+      block.mCompressed = compressed;
+      block.mCommittedWrite = write;
+   }
+}
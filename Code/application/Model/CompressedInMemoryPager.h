@@ -0,0 +1,83 @@
+/*
+ * The information in this file is
+ * Copyright(c) 2007 Ball Aerospace & Technologies Corporation
+ * and is subject to the terms and conditions of the
+ * GNU Lesser General Public License Version 2.1
+ * The license text is available from   
+ * http://www.gnu.org/licenses/lgpl.html
+ */
+
+#ifndef COMPRESSEDINMEMORYPAGER_H
+#define COMPRESSEDINMEMORYPAGER_H
+
+#include "ConvertedPageCache.h"
+#include "DMutex.h"
+#include "RasterPagerShell.h"
+#include "TypesFile.h"
+
+#include <boost/shared_ptr.hpp>
+#include <boost/weak_ptr.hpp>
+#include <memory>
+#include <vector>
+
+class RasterElement;
+
+/**
+ * Holds the data of a RasterElement in memory as compressed blocks of rows.
+ *
+ * Each block holds about a megabyte of rows in the interleave of the element,
+ * and a BSQ element has separate blocks for every band.  Blocks are
+ * decompressed into a working set of units held by a ConvertedPageCache, and
+ * the blocks of a writable page are compressed again when the page is
+ * released.  Blocks which have never been written hold no memory and read as
+ * zeros.
+ */
+class CompressedInMemoryPager : public RasterPagerShell
+{
+public:
+   CompressedInMemoryPager();
+   ~CompressedInMemoryPager();
+
+   bool getInputSpecification(PlugInArgList*& pArgList);
+   bool execute(PlugInArgList* pInput, PlugInArgList* pOutput);
+
+   RasterPage* getPage(DataRequest* pOriginalRequest, DimensionDescriptor startRow, DimensionDescriptor startColumn,
+      DimensionDescriptor startBand);
+   void releasePage(RasterPage* pPage);
+
+   int getSupportedRequestVersion() const;
+
+private:
+   struct Block
+   {
+      Block();
+
+      boost::shared_ptr<const std::vector<unsigned char> > mpData; // NULL if the block has never been written
+      bool mCompressed;                   // false if the data did not compress and is stored as is
+      unsigned int mCommittedWrite;       // the latest write stored in mpData
+      unsigned int mLastWrite;            // the latest write which has started compressing
+      boost::weak_ptr<ConvertedPageCache::Unit> mpUnit; // the decompressed block while it is in use
+   };
+
+   size_t getBlockIndex(unsigned int plane, unsigned int row) const;
+   unsigned int getBlockStartRow(unsigned int row) const;
+   ConvertedPageCache::UnitPtr getBlockUnit(unsigned int plane, unsigned int row);
+   void writeBlocks(ConvertedPageCache::UnitPtr pUnit, unsigned int plane);
+   void compressBlock(size_t blockIndex, ConvertedPageCache::UnitPtr pUnit);
+
+   RasterElement* mpRaster;
+   InterleaveFormatType mInterleave;
+   unsigned int mNumRows;
+   unsigned int mNumColumns;
+   unsigned int mNumBands;
+   unsigned int mBytesPerElement;
+   size_t mRowSize;
+   unsigned int mBlockRows;
+   size_t mBlocksPerPlane;
+   std::auto_ptr<ConvertedPageCache> mpWorkingSet;
+
+   mta::DMutex mMutex;
+   std::vector<Block> mBlocks;
+};
+
+#endif
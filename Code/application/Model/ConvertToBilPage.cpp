@@ -9,10 +9,11 @@
 
 #include "ConvertToBilPage.h"
 
-ConvertToBilPage::ConvertToBilPage(unsigned int rows, unsigned int columns, unsigned int bands,
-                                   unsigned int bytesPerElement) :
-   mCache(rows * columns * bands * bytesPerElement, true),
-   mRows(rows),
+ConvertToBilPage::ConvertToBilPage(ConvertedPageCache::UnitPtr pUnit, unsigned int startRow,
+                                   unsigned int columns, unsigned int bands, unsigned int bytesPerElement) :
+   mpUnit(pUnit),
+   mOffset(static_cast<size_t>(startRow - pUnit->getStartRow()) * columns * bands * bytesPerElement),
+   mRows(pUnit->getStartRow() + pUnit->getRowCount() - startRow),
    mColumns(columns),
    mBands(bands)
 {
@@ -44,5 +45,5 @@ unsigned int ConvertToBilPage::getInterlineBytes()
 
 void* ConvertToBilPage::getRawData()
 {
-   return mCache.get();
+   return mpUnit->getRawData() + mOffset;
 }
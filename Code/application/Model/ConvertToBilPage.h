@@ -10,7 +10,7 @@
 #ifndef CONVERTTOBILPAGE_H
 #define CONVERTTOBILPAGE_H
 
-#include "ObjectResource.h"
+#include "ConvertedPageCache.h"
 #include "RasterPage.h"
 
 /**
@@ -20,7 +20,8 @@
 class ConvertToBilPage : public RasterPage
 {
 public:
-   ConvertToBilPage(unsigned int rows, unsigned int columns, unsigned int bands, unsigned int bytesPerElement);
+   ConvertToBilPage(ConvertedPageCache::UnitPtr pUnit, unsigned int startRow, unsigned int columns,
+      unsigned int bands, unsigned int bytesPerElement);
    virtual ~ConvertToBilPage();
 
    // RasterPage methods
@@ -31,7 +32,8 @@ public:
    void* getRawData();
 
 private:
-   ArrayResource<unsigned char> mCache;
+   ConvertedPageCache::UnitPtr mpUnit;
+   size_t mOffset;
 
    unsigned int mRows;
    unsigned int mColumns;
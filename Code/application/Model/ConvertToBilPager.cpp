@@ -11,15 +11,18 @@
 #include "ConvertToBilPage.h"
 #include "ConvertToBilPager.h"
 #include "DataAccessorImpl.h"
+#include "InterleaveConversion.h"
 #include "RasterDataDescriptor.h"
 #include "RasterElement.h"
 
 #include <algorithm>
-#include <memory>
+#include <string.h>
 
 ConvertToBilPager::ConvertToBilPager(RasterElement* pRaster) :
    mpRaster(pRaster),
-   mBytesPerElement(0)
+   mBytesPerElement(0),
+   mCache(pRaster, RasterElement::getSettingConvertedPageCacheSize()),
+   mCounters("ConvertToBilPager", pRaster)
 {
    if (mpRaster != NULL)
    {
@@ -37,7 +40,18 @@ ConvertToBilPager::~ConvertToBilPager()
 void ConvertToBilPager::releasePage(RasterPage* pPage)
 {
    // Check that pPage is the correct type before deleting it.
-   delete dynamic_cast<ConvertToBilPage*>(pPage);
+   ConvertToBilPage* pConvertedPage = dynamic_cast<ConvertToBilPage*>(pPage);
+   if (pConvertedPage != NULL)
+   {
+      delete pConvertedPage;
+      mCounters.addPageReleased();
+   }
+}
+
+void ConvertToBilPager::prefetchPage(DataRequest* pOriginalRequest, DimensionDescriptor startRow,
+   DimensionDescriptor startColumn, DimensionDescriptor startBand)
+{
+   // Pages are converted from accessors on the source data, which read ahead on their own.
 }
 
 int ConvertToBilPager::getSupportedRequestVersion() const
@@ -45,9 +59,20 @@ int ConvertToBilPager::getSupportedRequestVersion() const
    return 1;
 }
 
+void ConvertToBilPager::clearCache()
+{
+   mCache.clear();
+}
+
+void ConvertToBilPager::clearCache(unsigned int startRow, unsigned int rowCount)
+{
+   mCache.clear(startRow, rowCount);
+}
+
 RasterPage* ConvertToBilPager::getPage(DataRequest* pOriginalRequest, DimensionDescriptor startRow,
    DimensionDescriptor startColumn, DimensionDescriptor startBand)
 {
+   mCounters.addGetPageCall();
    VERIFY(pOriginalRequest != NULL);
    if (pOriginalRequest->getWritable())
    {
@@ -89,16 +114,34 @@ RasterPage* ConvertToBilPager::getPage(DataRequest* pOriginalRequest, DimensionD
       return NULL;
    }
 
+   unsigned int startRowNumber = startRow.getActiveNumber();
    unsigned int cols = stopColumn.getActiveNumber() - startColumn.getActiveNumber() + 1;
    unsigned int rows = std::min(pOriginalRequest->getConcurrentRows(),
-      stopRow.getActiveNumber() - startRow.getActiveNumber() + 1);
+      stopRow.getActiveNumber() - startRowNumber + 1);
    unsigned int bands = stopBand.getActiveNumber() - startBand.getActiveNumber() + 1;
-   std::auto_ptr<ConvertToBilPage> pPage(new ConvertToBilPage(rows, cols, bands, mBytesPerElement));
-   if (pPage->getRawData() == NULL)
+   ConvertedPageCache::UnitPtr pUnit = mCache.getUnit(startRowNumber, rows,
+      startColumn.getActiveNumber(), cols, startBand.getActiveNumber(), bands);
+   if (pUnit.get() != NULL)
+   {
+      mCounters.addCacheHit();
+      mCounters.addPageLeased();
+      return new ConvertToBilPage(pUnit, startRowNumber, cols, bands, mBytesPerElement);
+   }
+
+   size_t bandRowSize = static_cast<size_t>(cols) * mBytesPerElement;
+   size_t rowSize = bandRowSize * bands;
+   unsigned int unitRows = ConvertedPageCache::getUnitRowCount(rows,
+      stopRow.getActiveNumber() - startRowNumber + 1, rowSize);
+   pUnit = mCache.createUnit(startRowNumber, unitRows, startColumn.getActiveNumber(), cols,
+      startBand.getActiveNumber(), bands, rowSize);
+   if (pUnit.get() == NULL)
    {
       return NULL;
    }
 
+   mCounters.addCacheMiss();
+   PagerCounters::Timer timer;
+   unsigned char* pDst = pUnit->getRawData();
    if (interleave == BSQ)
    {
       for (unsigned int band = 0; iter <= stopIter; ++iter, ++band)
@@ -109,16 +152,16 @@ RasterPage* ConvertToBilPager::getPage(DataRequest* pOriginalRequest, DimensionD
          pRequest->setBands(*iter, DimensionDescriptor());
 
          DataAccessor da = mpRaster->getDataAccessor(pRequest.release());
-         unsigned char* pDst = reinterpret_cast<unsigned char*>(pPage->getRawData()) + (band * cols * mBytesPerElement);
-         for (unsigned int row = 0; row < rows; ++row)
+         unsigned char* pRowDst = pDst + band * bandRowSize;
+         for (unsigned int row = 0; row < unitRows; ++row)
          {
             if (da.isValid() == false)
             {
                return NULL;
             }
 
-            memcpy(pDst, da->getRow(), mBytesPerElement * cols);
-            pDst += bands * cols * mBytesPerElement;
+            memcpy(pRowDst, da->getRow(), bandRowSize);
+            pRowDst += rowSize;
             da->nextRow();
          }
       }
@@ -132,31 +175,23 @@ RasterPage* ConvertToBilPager::getPage(DataRequest* pOriginalRequest, DimensionD
       pRequest->setBands(*iter, DimensionDescriptor());
 
       DataAccessor da = mpRaster->getDataAccessor(pRequest.release());
-      for (unsigned int row = 0; row < rows; ++row)
+      for (unsigned int row = 0; row < unitRows; ++row)
       {
-         for (unsigned int col = 0; col < cols; ++col)
+         if (da.isValid() == false)
          {
-            if (da.isValid() == false)
-            {
-               return NULL;
-            }
-
-            unsigned char* pDst = reinterpret_cast<unsigned char*>(pPage->getRawData()) +
-               (row * cols * bands + col) * mBytesPerElement;
-            unsigned char* pSrc = reinterpret_cast<unsigned char*>(da->getColumn());
-            for (unsigned int band = 0; band < bands; ++band)
-            {
-               memcpy(pDst, pSrc, mBytesPerElement);
-               pDst += cols * mBytesPerElement;
-               pSrc += mBytesPerElement;
-            }
-
-            da->nextColumn();
+            return NULL;
          }
 
+         // A BIP row is a columns x bands matrix, which is transposed into bands x columns.
+         InterleaveConversion::transpose(da->getRow(), numBands * mBytesPerElement,
+            pDst, bandRowSize, cols, bands, mBytesPerElement);
+         pDst += rowSize;
          da->nextRow();
       }
    }
 
-   return pPage.release();
+   mCounters.addDecodeTime(timer.getElapsed());
+   mCache.addUnit(pUnit);
+   mCounters.addPageLeased();
+   return new ConvertToBilPage(pUnit, startRowNumber, cols, bands, mBytesPerElement);
 }
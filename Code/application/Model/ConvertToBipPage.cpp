@@ -9,10 +9,11 @@
 
 #include "ConvertToBipPage.h"
 
-ConvertToBipPage::ConvertToBipPage(unsigned int rows, unsigned int columns, unsigned int bands,
-                                   unsigned int bytesPerElement) :
-   mCache(rows * columns * bands * bytesPerElement, true),
-   mRows(rows),
+ConvertToBipPage::ConvertToBipPage(ConvertedPageCache::UnitPtr pUnit, unsigned int startRow,
+                                   unsigned int columns, unsigned int bands, unsigned int bytesPerElement) :
+   mpUnit(pUnit),
+   mOffset(static_cast<size_t>(startRow - pUnit->getStartRow()) * columns * bands * bytesPerElement),
+   mRows(pUnit->getStartRow() + pUnit->getRowCount() - startRow),
    mColumns(columns),
    mBands(bands)
 {
@@ -44,5 +45,5 @@ unsigned int ConvertToBipPage::getInterlineBytes()
 
 void* ConvertToBipPage::getRawData()
 {
-   return mCache.get();
+   return mpUnit->getRawData() + mOffset;
 }
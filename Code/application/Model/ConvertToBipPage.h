@@ -10,7 +10,7 @@
 #ifndef CONVERTTOBIPPAGE_H
 #define CONVERTTOBIPPAGE_H
 
-#include "ObjectResource.h"
+#include "ConvertedPageCache.h"
 #include "RasterPage.h"
 
 /**
@@ -20,7 +20,8 @@
 class ConvertToBipPage : public RasterPage
 {
 public:
-   ConvertToBipPage(unsigned int rows, unsigned int columns, unsigned int bands, unsigned int bytesPerElement);
+   ConvertToBipPage(ConvertedPageCache::UnitPtr pUnit, unsigned int startRow, unsigned int columns,
+      unsigned int bands, unsigned int bytesPerElement);
    virtual ~ConvertToBipPage();
 
    // RasterPage methods
@@ -31,7 +32,8 @@ public:
    void* getRawData();
 
 private:
-   ArrayResource<unsigned char> mCache;
+   ConvertedPageCache::UnitPtr mpUnit;
+   size_t mOffset;
 
    unsigned int mRows;
    unsigned int mColumns;
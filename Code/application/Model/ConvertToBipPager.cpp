@@ -11,15 +11,17 @@
 #include "ConvertToBipPage.h"
 #include "ConvertToBipPager.h"
 #include "DataAccessorImpl.h"
+#include "InterleaveConversion.h"
 #include "RasterDataDescriptor.h"
 #include "RasterElement.h"
 
 #include <algorithm>
-#include <memory>
 
 ConvertToBipPager::ConvertToBipPager(RasterElement* pRaster) :
    mpRaster(pRaster),
-   mBytesPerElement(0)
+   mBytesPerElement(0),
+   mCache(pRaster, RasterElement::getSettingConvertedPageCacheSize()),
+   mCounters("ConvertToBipPager", pRaster)
 {
    if (mpRaster != NULL)
    {
@@ -37,7 +39,18 @@ ConvertToBipPager::~ConvertToBipPager()
 void ConvertToBipPager::releasePage(RasterPage* pPage)
 {
    // Check that pPage is the correct type before deleting it.
-   delete dynamic_cast<ConvertToBipPage*>(pPage);
+   ConvertToBipPage* pConvertedPage = dynamic_cast<ConvertToBipPage*>(pPage);
+   if (pConvertedPage != NULL)
+   {
+      delete pConvertedPage;
+      mCounters.addPageReleased();
+   }
+}
+
+void ConvertToBipPager::prefetchPage(DataRequest* pOriginalRequest, DimensionDescriptor startRow,
+   DimensionDescriptor startColumn, DimensionDescriptor startBand)
+{
+   // Pages are converted from accessors on the source data, which read ahead on their own.
 }
 
 int ConvertToBipPager::getSupportedRequestVersion() const
@@ -45,9 +58,20 @@ int ConvertToBipPager::getSupportedRequestVersion() const
    return 1;
 }
 
+void ConvertToBipPager::clearCache()
+{
+   mCache.clear();
+}
+
+void ConvertToBipPager::clearCache(unsigned int startRow, unsigned int rowCount)
+{
+   mCache.clear(startRow, rowCount);
+}
+
 RasterPage *ConvertToBipPager::getPage(DataRequest* pOriginalRequest, DimensionDescriptor startRow,
    DimensionDescriptor startColumn, DimensionDescriptor startBand)
 {
+   mCounters.addGetPageCall();
    VERIFY(pOriginalRequest != NULL);
    if (pOriginalRequest->getWritable())
    {
@@ -88,17 +112,34 @@ RasterPage *ConvertToBipPager::getPage(DataRequest* pOriginalRequest, DimensionD
       return NULL;
    }
 
+   unsigned int startRowNumber = startRow.getActiveNumber();
    unsigned int cols = stopColumn.getActiveNumber() - startColumn.getActiveNumber() + 1;
    unsigned int rows = std::min(pOriginalRequest->getConcurrentRows(),
-      stopRow.getActiveNumber() - startRow.getActiveNumber() + 1);
+      stopRow.getActiveNumber() - startRowNumber + 1);
    unsigned int bands = stopBand.getActiveNumber() - startBand.getActiveNumber() + 1;
-   std::auto_ptr<ConvertToBipPage> pPage(new ConvertToBipPage(rows, cols, bands, mBytesPerElement));
-   unsigned char* pDst = reinterpret_cast<unsigned char*>(pPage->getRawData());
-   if (pDst == NULL)
+   ConvertedPageCache::UnitPtr pUnit = mCache.getUnit(startRowNumber, rows,
+      startColumn.getActiveNumber(), cols, startBand.getActiveNumber(), bands);
+   if (pUnit.get() != NULL)
+   {
+      mCounters.addCacheHit();
+      mCounters.addPageLeased();
+      return new ConvertToBipPage(pUnit, startRowNumber, cols, bands, mBytesPerElement);
+   }
+
+   size_t pixelSize = static_cast<size_t>(bands) * mBytesPerElement;
+   size_t rowSize = pixelSize * cols;
+   unsigned int unitRows = ConvertedPageCache::getUnitRowCount(rows,
+      stopRow.getActiveNumber() - startRowNumber + 1, rowSize);
+   pUnit = mCache.createUnit(startRowNumber, unitRows, startColumn.getActiveNumber(), cols,
+      startBand.getActiveNumber(), bands, rowSize);
+   if (pUnit.get() == NULL)
    {
       return NULL;
    }
 
+   mCounters.addCacheMiss();
+   PagerCounters::Timer timer;
+   unsigned char* pDst = pUnit->getRawData();
    if (interleave == BSQ)
    {
       for (unsigned int band = 0; iter <= stopIter; ++iter, ++band)
@@ -109,22 +150,17 @@ RasterPage *ConvertToBipPager::getPage(DataRequest* pOriginalRequest, DimensionD
          pRequest->setBands(*iter, *iter, 1);
 
          DataAccessor da = mpRaster->getDataAccessor(pRequest.release());
-         for (unsigned int row = 0; row < rows; ++row)
+         unsigned char* pRowDst = pDst + band * mBytesPerElement;
+         for (unsigned int row = 0; row < unitRows; ++row)
          {
             if (da.isValid() == false)
             {
                return NULL;
             }
 
-            unsigned int cachePos = (row * cols * bands + band) * mBytesPerElement;
-            unsigned char* pSrc = reinterpret_cast<unsigned char*>(da->getRow());
-            for (unsigned int col = 0; col < cols; ++col)
-            {
-               memcpy(pDst + cachePos, pSrc, mBytesPerElement);
-               cachePos += bands * mBytesPerElement;
-               pSrc += mBytesPerElement;
-            }
-
+            InterleaveConversion::copyElements(da->getRow(), mBytesPerElement, pRowDst, pixelSize, cols,
+               mBytesPerElement);
+            pRowDst += rowSize;
             da->nextRow();
          }
       }
@@ -138,29 +174,23 @@ RasterPage *ConvertToBipPager::getPage(DataRequest* pOriginalRequest, DimensionD
       pRequest->setBands(*iter, DimensionDescriptor());
 
       DataAccessor da = mpRaster->getDataAccessor(pRequest.release());
-      for (unsigned int row = 0; row < rows; ++row)
+      for (unsigned int row = 0; row < unitRows; ++row)
       {
          if (da.isValid() == false)
          {
             return NULL;
          }
 
-         for (unsigned int band = 0; band < bands; ++band)
-         {
-            unsigned char* pSrc = reinterpret_cast<unsigned char*>(da->getRow()) +
-               (band * da->getConcurrentColumns() * mBytesPerElement);
-            unsigned int cachePos = (row * cols * bands + band) * mBytesPerElement;
-            for (unsigned int col = 0; col < cols; ++col)
-            {
-               memcpy(pDst + cachePos, pSrc, mBytesPerElement);
-               cachePos += bands * mBytesPerElement;
-               pSrc += mBytesPerElement;
-            }
-         }
-
+         // A BIL row is a bands x columns matrix, which is transposed into columns x bands.
+         InterleaveConversion::transpose(da->getRow(), da->getConcurrentColumns() * mBytesPerElement,
+            pDst, pixelSize, bands, cols, mBytesPerElement);
+         pDst += rowSize;
          da->nextRow();
       }
    }
 
-   return pPage.release();
+   mCounters.addDecodeTime(timer.getElapsed());
+   mCache.addUnit(pUnit);
+   mCounters.addPageLeased();
+   return new ConvertToBipPage(pUnit, startRowNumber, cols, bands, mBytesPerElement);
 }
@@ -10,6 +10,8 @@
 #ifndef CONVERTTOBIPPAGER_H
 #define CONVERTTOBIPPAGER_H
 
+#include "ConvertedPageCache.h"
+#include "PagerCounters.h"
 #include "RasterPager.h"
 
 class RasterElement;
@@ -26,11 +28,30 @@ public:
 
    void releasePage(RasterPage* pPage);
 
+   void prefetchPage(DataRequest* pOriginalRequest, DimensionDescriptor startRow,
+      DimensionDescriptor startColumn, DimensionDescriptor startBand);
+
    int getSupportedRequestVersion() const;
 
    RasterPage *getPage(DataRequest* pOriginalRequest,  DimensionDescriptor startRow,
       DimensionDescriptor startColumn, DimensionDescriptor startBand);
 
+   /**
+    * Discards the converted data, which is out of date once the source data
+    * has been written.
+    */
+   void clearCache();
+
+   /**
+    * Discards the converted data of the given rows.
+    *
+    * @param startRow
+    *        The active number of the first row which was written.
+    * @param rowCount
+    *        The number of rows.
+    */
+   void clearCache(unsigned int startRow, unsigned int rowCount);
+
 private:
    ConvertToBipPager();
 
@@ -38,6 +59,8 @@ private:
 
    RasterElement* const mpRaster;
    unsigned int mBytesPerElement;
+   ConvertedPageCache mCache;
+   PagerCounters mCounters;
 };
 
 #endif
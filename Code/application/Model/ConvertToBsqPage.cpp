@@ -9,9 +9,11 @@
 
 #include "ConvertToBsqPage.h"
 
-ConvertToBsqPage::ConvertToBsqPage(unsigned int rows, unsigned int columns, unsigned int bytesPerElement) :
-   mCache(rows * columns * bytesPerElement, true),
-   mRows(rows),
+ConvertToBsqPage::ConvertToBsqPage(ConvertedPageCache::UnitPtr pUnit, unsigned int startRow,
+                                   unsigned int columns, unsigned int bytesPerElement) :
+   mpUnit(pUnit),
+   mOffset(static_cast<size_t>(startRow - pUnit->getStartRow()) * columns * bytesPerElement),
+   mRows(pUnit->getStartRow() + pUnit->getRowCount() - startRow),
    mColumns(columns)
 {
 }
@@ -42,5 +44,5 @@ unsigned int ConvertToBsqPage::getInterlineBytes()
 
 void* ConvertToBsqPage::getRawData()
 {
-   return mCache.get();
+   return mpUnit->getRawData() + mOffset;
 }
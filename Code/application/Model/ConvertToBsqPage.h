@@ -10,7 +10,7 @@
 #ifndef CONVERTTOBSQPAGE_H
 #define CONVERTTOBSQPAGE_H
 
-#include "ObjectResource.h"
+#include "ConvertedPageCache.h"
 #include "RasterPage.h"
 
 /**
@@ -20,7 +20,8 @@
 class ConvertToBsqPage : public RasterPage
 {
 public:
-   ConvertToBsqPage(unsigned int rows, unsigned int columns, unsigned int bytesPerElement);
+   ConvertToBsqPage(ConvertedPageCache::UnitPtr pUnit, unsigned int startRow, unsigned int columns,
+      unsigned int bytesPerElement);
    virtual ~ConvertToBsqPage();
 
    // RasterPage methods
@@ -31,7 +32,8 @@ public:
    void* getRawData();
 
 private:
-   ArrayResource<unsigned char> mCache;
+   ConvertedPageCache::UnitPtr mpUnit;
+   size_t mOffset;
 
    unsigned int mRows;
    unsigned int mColumns;
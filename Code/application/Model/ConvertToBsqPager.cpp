@@ -11,15 +11,18 @@
 #include "ConvertToBsqPage.h"
 #include "ConvertToBsqPager.h"
 #include "DataAccessorImpl.h"
+#include "InterleaveConversion.h"
 #include "RasterDataDescriptor.h"
 #include "RasterElement.h"
 
-#include <limits>
-#include <memory>
+#include <algorithm>
+#include <string.h>
 
 ConvertToBsqPager::ConvertToBsqPager(RasterElement* pRaster) :
    mpRaster(pRaster),
-   mBytesPerElement(0)
+   mBytesPerElement(0),
+   mCache(pRaster, RasterElement::getSettingConvertedPageCacheSize()),
+   mCounters("ConvertToBsqPager", pRaster)
 {
    if (mpRaster != NULL)
    {
@@ -37,7 +40,18 @@ ConvertToBsqPager::~ConvertToBsqPager()
 void ConvertToBsqPager::releasePage(RasterPage* pPage)
 {
    // Check that pPage is the correct type before deleting it.
-   delete dynamic_cast<ConvertToBsqPage*>(pPage);
+   ConvertToBsqPage* pConvertedPage = dynamic_cast<ConvertToBsqPage*>(pPage);
+   if (pConvertedPage != NULL)
+   {
+      delete pConvertedPage;
+      mCounters.addPageReleased();
+   }
+}
+
+void ConvertToBsqPager::prefetchPage(DataRequest* pOriginalRequest, DimensionDescriptor startRow,
+   DimensionDescriptor startColumn, DimensionDescriptor startBand)
+{
+   // Pages are converted from accessors on the source data, which read ahead on their own.
 }
 
 int ConvertToBsqPager::getSupportedRequestVersion() const
@@ -45,9 +59,20 @@ int ConvertToBsqPager::getSupportedRequestVersion() const
    return 1;
 }
 
+void ConvertToBsqPager::clearCache()
+{
+   mCache.clear();
+}
+
+void ConvertToBsqPager::clearCache(unsigned int startRow, unsigned int rowCount)
+{
+   mCache.clear(startRow, rowCount);
+}
+
 RasterPage* ConvertToBsqPager::getPage(DataRequest* pOriginalRequest, DimensionDescriptor startRow,
    DimensionDescriptor startColumn, DimensionDescriptor startBand)
 {
+   mCounters.addGetPageCall();
    VERIFYRV(pOriginalRequest != NULL, NULL);
    if (pOriginalRequest->getWritable())
    {
@@ -84,53 +109,63 @@ RasterPage* ConvertToBsqPager::getPage(DataRequest* pOriginalRequest, DimensionD
       return NULL;
    }
 
+   unsigned int startRowNumber = startRow.getActiveNumber();
    unsigned int cols = stopColumn.getActiveNumber() - startColumn.getActiveNumber() + 1;
-   std::auto_ptr<ConvertToBsqPage> pPage(new ConvertToBsqPage(concurrentRows, cols, mBytesPerElement));
-   unsigned char* pDst = reinterpret_cast<unsigned char*>(pPage->getRawData());
-   if (pDst == NULL)
+   ConvertedPageCache::UnitPtr pUnit = mCache.getUnit(startRowNumber, concurrentRows,
+      startColumn.getActiveNumber(), cols, startBand.getActiveNumber(), 1);
+   if (pUnit.get() == NULL)
    {
-      return NULL;
-   }
+      mCounters.addCacheMiss();
+      PagerCounters::Timer timer;
+
+      size_t rowSize = static_cast<size_t>(cols) * mBytesPerElement;
+      unsigned int unitRows = ConvertedPageCache::getUnitRowCount(concurrentRows,
+         stopRow.getActiveNumber() - startRowNumber + 1, rowSize);
+      pUnit = mCache.createUnit(startRowNumber, unitRows, startColumn.getActiveNumber(), cols,
+         startBand.getActiveNumber(), 1, rowSize);
+      if (pUnit.get() == NULL)
+      {
+         return NULL;
+      }
 
-   FactoryResource<DataRequest> pRequest;
-   pRequest->setRows(startRow, stopRow);
-   pRequest->setColumns(startColumn, stopColumn, cols);
-   pRequest->setBands(startBand, startBand, 1);
-   DataAccessor da = mpRaster->getDataAccessor(pRequest.release());
+      FactoryResource<DataRequest> pRequest;
+      pRequest->setRows(startRow, stopRow, unitRows);
+      pRequest->setColumns(startColumn, stopColumn, cols);
+      pRequest->setBands(startBand, startBand, 1);
+      DataAccessor da = mpRaster->getDataAccessor(pRequest.release());
 
-   if (interleave == BIP)
-   {
-      for (unsigned int row = 0; row < concurrentRows; ++row)
+      // Each BIP pixel holds every band, so the band is gathered with a stride of a whole pixel.
+      size_t pixelSize = static_cast<size_t>(numBands) * mBytesPerElement;
+      unsigned char* pDst = pUnit->getRawData();
+      for (unsigned int row = 0; row < unitRows; ++row)
       {
-         for (unsigned int col = 0; col < cols; ++col)
+         if (da.isValid() == false)
          {
-            if (da.isValid() == false)
-            {
-               return NULL;
-            }
-
-            memcpy(pDst, da->getColumn(), mBytesPerElement);
-            pDst += mBytesPerElement;
-            da->nextColumn();
+            return NULL;
          }
 
-         da->nextRow();
-      }
-   }
-   else if (interleave == BIL)
-   {
-      for (unsigned int row = 0; row < concurrentRows; ++row)
-      {
-         if (da.isValid() == false)
+         if (interleave == BIP)
          {
-            return NULL;
+            InterleaveConversion::copyElements(da->getRow(), pixelSize, pDst, mBytesPerElement, cols,
+               mBytesPerElement);
+         }
+         else
+         {
+            memcpy(pDst, da->getRow(), rowSize);
          }
 
-         memcpy(pDst, da->getRow(), mBytesPerElement * cols);
-         pDst += mBytesPerElement * cols;
+         pDst += rowSize;
          da->nextRow();
       }
+
+      mCounters.addDecodeTime(timer.getElapsed());
+      mCache.addUnit(pUnit);
+   }
+   else
+   {
+      mCounters.addCacheHit();
    }
 
-   return pPage.release();
+   mCounters.addPageLeased();
+   return new ConvertToBsqPage(pUnit, startRowNumber, cols, mBytesPerElement);
 }
@@ -0,0 +1,248 @@
+/*
+ * The information in this file is
+ * Copyright(c) 2007 Ball Aerospace & Technologies Corporation
+ * and is subject to the terms and conditions of the
+ * GNU Lesser General Public License Version 2.1
+ * The license text is available from   
+ * http://www.gnu.org/licenses/lgpl.html
+ */
+
+#include "AppVerify.h"
+#include "ConvertedPageCache.h"
+#include "ModelServices.h"
+
+#include <algorithm>
+#include <limits>
+#include <new>
+
+using namespace std;
+
+namespace
+{
+   // The preferred number of bytes to convert at once
+   const size_t UNIT_SIZE = 1024 * 1024;
+}
+
+ConvertedPageCache::Unit::Unit(unsigned int startRow, unsigned int rows, unsigned int startColumn,
+                               unsigned int columns, unsigned int startBand, unsigned int bands, size_t size,
+                               unsigned int generation, boost::shared_ptr<boost::atomic<size_t> > pUsage) :
+   mStartRow(startRow),
+   mRows(rows),
+   mStartColumn(startColumn),
+   mColumns(columns),
+   mStartBand(startBand),
+   mBands(bands),
+   mData(size),
+   mGeneration(generation),
+   mpUsage(pUsage)
+{
+   *mpUsage += mData.size();
+}
+
+ConvertedPageCache::Unit::~Unit()
+{
+   *mpUsage -= mData.size();
+}
+
+unsigned int ConvertedPageCache::Unit::getStartRow() const
+{
+   return mStartRow;
+}
+
+unsigned int ConvertedPageCache::Unit::getRowCount() const
+{
+   return mRows;
+}
+
+size_t ConvertedPageCache::Unit::getSize() const
+{
+   return mData.size();
+}
+
+unsigned char* ConvertedPageCache::Unit::getRawData()
+{
+   return mData.empty() ? NULL : &mData.front();
+}
+
+bool ConvertedPageCache::Unit::contains(unsigned int startRow, unsigned int rows, unsigned int startColumn,
+                                        unsigned int columns, unsigned int startBand, unsigned int bands) const
+{
+   return startColumn == mStartColumn && columns == mColumns &&
+      startBand == mStartBand && bands == mBands &&
+      startRow >= mStartRow && static_cast<uint64_t>(startRow) + rows <= static_cast<uint64_t>(mStartRow) + mRows;
+}
+
+ConvertedPageCache::ConvertedPageCache(const RasterElement* pElement, size_t maxCacheSize) :
+   mpElement(pElement),
+   mMaxCacheSize(maxCacheSize),
+   mpModelServices(Service<ModelServices>().get()),
+   mpUsage(new boost::atomic<size_t>(0)),
+   mCachedSize(0),
+   mGeneration(0)
+{
+   VERIFYNRV(mpModelServices != NULL);
+   mpModelServices->registerRasterCache(this);
+}
+
+ConvertedPageCache::~ConvertedPageCache()
+{
+   mpModelServices->unregisterRasterCache(this);
+}
+
+unsigned int ConvertedPageCache::getUnitRowCount(unsigned int requestedRows, unsigned int availableRows,
+                                                 size_t bytesPerRow)
+{
+   unsigned int rows = requestedRows;
+   if (bytesPerRow > 0)
+   {
+      rows = max(rows, static_cast<unsigned int>(min(UNIT_SIZE / bytesPerRow, static_cast<size_t>(availableRows))));
+   }
+
+   return min(rows, availableRows);
+}
+
+ConvertedPageCache::UnitPtr ConvertedPageCache::createUnit(unsigned int startRow, unsigned int rows,
+                                                           unsigned int startColumn, unsigned int columns,
+                                                           unsigned int startBand, unsigned int bands,
+                                                           size_t bytesPerRow)
+{
+   unsigned int generation = 0;
+   {
+      mta::MutexLock lock(mMutex);
+      generation = mGeneration;
+   }
+
+   UnitPtr pUnit;
+   try
+   {
+      pUnit.reset(new Unit(startRow, rows, startColumn, columns, startBand, bands, rows * bytesPerRow, generation,
+         mpUsage));
+   }
+   catch (const bad_alloc&)
+   {
+      pUnit.reset();
+   }
+
+   return pUnit;
+}
+
+ConvertedPageCache::UnitPtr ConvertedPageCache::getUnit(unsigned int startRow, unsigned int rows,
+                                                        unsigned int startColumn, unsigned int columns,
+                                                        unsigned int startBand, unsigned int bands)
+{
+   mta::MutexLock lock(mMutex);
+   for (EntryList::iterator iter = mEntries.begin(); iter != mEntries.end(); ++iter)
+   {
+      if (iter->mpUnit->contains(startRow, rows, startColumn, columns, startBand, bands))
+      {
+         iter->mLastAccess = mpModelServices->getRasterCacheAccess();
+         mEntries.splice(mEntries.end(), mEntries, iter);
+         return iter->mpUnit;
+      }
+   }
+
+   return UnitPtr();
+}
+
+void ConvertedPageCache::addUnit(UnitPtr pUnit)
+{
+   VERIFYNRV(pUnit.get() != NULL);
+   {
+      mta::MutexLock lock(mMutex);
+
+      // the source data changed while the unit was being filled
+      if (pUnit->mGeneration != mGeneration)
+      {
+         return;
+      }
+
+      Entry entry;
+      entry.mpUnit = pUnit;
+      entry.mLastAccess = mpModelServices->getRasterCacheAccess();
+      mEntries.push_back(entry);
+      mCachedSize += pUnit->getSize();
+
+      // units which are still used by a page stay in memory until the page is destroyed,
+      // so the oldest units are dropped whether or not they are in use
+      while (mCachedSize > mMaxCacheSize && mEntries.size() > 1)
+      {
+         mCachedSize -= mEntries.front().mpUnit->getSize();
+         mEntries.pop_front();
+      }
+   }
+
+   mpModelServices->enforceRasterCacheBudget();
+}
+
+void ConvertedPageCache::clear()
+{
+   mta::MutexLock lock(mMutex);
+   mEntries.clear();
+   mCachedSize = 0;
+   ++mGeneration;
+}
+
+void ConvertedPageCache::clear(unsigned int startRow, unsigned int rowCount)
+{
+   uint64_t stopRow = static_cast<uint64_t>(startRow) + rowCount;
+   mta::MutexLock lock(mMutex);
+   for (EntryList::iterator iter = mEntries.begin(); iter != mEntries.end();)
+   {
+      const Unit& unit = *iter->mpUnit;
+      if (unit.mStartRow < stopRow && static_cast<uint64_t>(unit.mStartRow) + unit.mRows > startRow)
+      {
+         mCachedSize -= unit.getSize();
+         iter = mEntries.erase(iter);
+      }
+      else
+      {
+         ++iter;
+      }
+   }
+   ++mGeneration;
+}
+
+const RasterElement* ConvertedPageCache::getRasterElement() const
+{
+   return mpElement;
+}
+
+size_t ConvertedPageCache::getCacheSize() const
+{
+   return mpUsage->load();
+}
+
+uint64_t ConvertedPageCache::getOldestAccess() const
+{
+   mta::MutexLock lock(mMutex);
+   EntryList::iterator oldest = const_cast<ConvertedPageCache*>(this)->findOldest();
+   return oldest == mEntries.end() ? numeric_limits<uint64_t>::max() : oldest->mLastAccess;
+}
+
+bool ConvertedPageCache::releaseOldest()
+{
+   mta::MutexLock lock(mMutex);
+   EntryList::iterator oldest = findOldest();
+   if (oldest == mEntries.end())
+   {
+      return false;
+   }
+
+   mCachedSize -= oldest->mpUnit->getSize();
+   mEntries.erase(oldest);
+   return true;
+}
+
+ConvertedPageCache::EntryList::iterator ConvertedPageCache::findOldest()
+{
+   // only a unit which is not used by a page releases memory when it is removed
+   for (EntryList::iterator iter = mEntries.begin(); iter != mEntries.end(); ++iter)
+   {
+      if (iter->mpUnit.use_count() == 1)
+      {
+         return iter;
+      }
+   }
+
+   return mEntries.end();
+}
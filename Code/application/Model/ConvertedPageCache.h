@@ -0,0 +1,208 @@
+/*
+ * The information in this file is
+ * Copyright(c) 2007 Ball Aerospace & Technologies Corporation
+ * and is subject to the terms and conditions of the
+ * GNU Lesser General Public License Version 2.1
+ * The license text is available from   
+ * http://www.gnu.org/licenses/lgpl.html
+ */
+
+#ifndef CONVERTEDPAGECACHE_H
+#define CONVERTEDPAGECACHE_H
+
+#include "DMutex.h"
+#include "RasterCache.h"
+
+#include <boost/atomic.hpp>
+#include <boost/shared_ptr.hpp>
+#include <list>
+#include <vector>
+
+class ModelServices;
+
+/**
+ * Holds data which has been converted to a different interleave or byte
+ * order.
+ *
+ * The interleave conversion pagers and the MemoryMappedPager for data of a
+ * different endian type convert a block of rows at a time and keep the most
+ * recently converted blocks, so that a DataAccessor stepping through the
+ * rows of a converted page and other accessors over the same data do not
+ * convert it again.
+ *
+ * The memory of every unit created by the cache counts against the
+ * process-wide raster memory budget.  Units which are only held by the cache
+ * may be released to make room for other data, but units still used by a
+ * page are only released once the page is destroyed.
+ */
+class ConvertedPageCache : public RasterCache
+{
+public:
+   /**
+    * A block of converted data.
+    *
+    * The rows, columns and bands are active numbers.
+    */
+   class Unit
+   {
+   public:
+      unsigned int getStartRow() const;
+      unsigned int getRowCount() const;
+      size_t getSize() const;
+      unsigned char* getRawData();
+
+      /**
+       * Determines whether the unit holds the given data.
+       *
+       * @return True if the unit has the given columns and bands, and
+       *         contains the given rows.
+       */
+      bool contains(unsigned int startRow, unsigned int rows, unsigned int startColumn, unsigned int columns,
+         unsigned int startBand, unsigned int bands) const;
+
+      ~Unit();
+
+   private:
+      friend class ConvertedPageCache;
+
+      Unit(unsigned int startRow, unsigned int rows, unsigned int startColumn, unsigned int columns,
+         unsigned int startBand, unsigned int bands, size_t size, unsigned int generation,
+         boost::shared_ptr<boost::atomic<size_t> > pUsage);
+      Unit(const Unit& rhs);
+      Unit& operator=(const Unit& rhs);
+
+      unsigned int mStartRow;
+      unsigned int mRows;
+      unsigned int mStartColumn;
+      unsigned int mColumns;
+      unsigned int mStartBand;
+      unsigned int mBands;
+      std::vector<unsigned char> mData;
+      unsigned int mGeneration;
+      boost::shared_ptr<boost::atomic<size_t> > mpUsage;
+   };
+
+   typedef boost::shared_ptr<Unit> UnitPtr;
+
+   /**
+    * Creates a cache of converted data.
+    *
+    * @param pElement
+    *        The element whose data is converted.
+    * @param maxCacheSize
+    *        The maximum number of bytes held by units which are only
+    *        referenced by the cache.
+    */
+   ConvertedPageCache(const RasterElement* pElement, size_t maxCacheSize);
+   ~ConvertedPageCache();
+
+   /**
+    * Get the number of rows to convert at once.
+    *
+    * Units hold more rows than are requested when the rows are small, so
+    * that a DataAccessor stepping through the rows is served by a single
+    * unit for a while.
+    *
+    * @param requestedRows
+    *        The number of rows in the requested page.
+    * @param availableRows
+    *        The number of rows up to the end of the request.
+    * @param bytesPerRow
+    *        The number of bytes of converted data in each row.
+    *
+    * @return The number of rows in a new unit, which is at least
+    *         \p requestedRows and no more than \p availableRows.
+    */
+   static unsigned int getUnitRowCount(unsigned int requestedRows, unsigned int availableRows, size_t bytesPerRow);
+
+   /**
+    * Creates an empty unit.
+    *
+    * The unit is not added to the cache until it has been filled and passed
+    * to addUnit().
+    *
+    * @param bytesPerRow
+    *        The number of bytes of converted data in each row.
+    *
+    * @return The new unit, or an empty pointer if the memory could not be
+    *         allocated.
+    */
+   UnitPtr createUnit(unsigned int startRow, unsigned int rows, unsigned int startColumn, unsigned int columns,
+      unsigned int startBand, unsigned int bands, size_t bytesPerRow);
+
+   /**
+    * Finds a unit which contains the given data.
+    *
+    * A unit which is found is marked as the most recently used.
+    *
+    * @return The unit, or an empty pointer if no unit contains the data.
+    */
+   UnitPtr getUnit(unsigned int startRow, unsigned int rows, unsigned int startColumn, unsigned int columns,
+      unsigned int startBand, unsigned int bands);
+
+   /**
+    * Adds a filled unit to the cache.
+    *
+    * The least recently used units are released until the cache fits within
+    * its maximum size and the raster memory budget.  A unit created before
+    * the last call to clear() is not added, since its data may be out of
+    * date.
+    *
+    * @param pUnit
+    *        The unit to add.
+    */
+   void addUnit(UnitPtr pUnit);
+
+   /**
+    * Removes all units from the cache.
+    *
+    * This is called when the source data changes, so that the converted data
+    * is not used again.  Pages which still use a unit keep it until they are
+    * destroyed.
+    */
+   void clear();
+
+   /**
+    * Removes the units which hold any of the given rows.
+    *
+    * This is called when some rows of the source data have been written.
+    * Units which are still being filled are not added to the cache, like
+    * after a call to clear().
+    *
+    * @param startRow
+    *        The active number of the first row which was written.
+    * @param rowCount
+    *        The number of rows.
+    */
+   void clear(unsigned int startRow, unsigned int rowCount);
+
+   // RasterCache
+   const RasterElement* getRasterElement() const;
+   size_t getCacheSize() const;
+   uint64_t getOldestAccess() const;
+   bool releaseOldest();
+
+private:
+   ConvertedPageCache(const ConvertedPageCache& rhs);
+   ConvertedPageCache& operator=(const ConvertedPageCache& rhs);
+
+   struct Entry
+   {
+      UnitPtr mpUnit;
+      uint64_t mLastAccess;
+   };
+   typedef std::list<Entry> EntryList;
+
+   EntryList::iterator findOldest();
+
+   const RasterElement* const mpElement;
+   const size_t mMaxCacheSize;
+   ModelServices* mpModelServices;
+   boost::shared_ptr<boost::atomic<size_t> > mpUsage;
+   mutable mta::DMutex mMutex;
+   EntryList mEntries; // least recently used entries are at the front
+   size_t mCachedSize;
+   unsigned int mGeneration; // incremented by clear()
+};
+
+#endif
@@ -18,7 +18,10 @@ DataRequestImp::DataRequestImp() :
    mConcurrentRows(0),
    mConcurrentColumns(0),
    mConcurrentBands(0),
-   mbWritable(false)
+   mbWritable(false),
+   mbTiled(false),
+   mRowStride(1),
+   mColumnStride(1)
 {
 }
 
@@ -38,7 +41,10 @@ DataRequestImp::DataRequestImp(const DataRequestImp& rhs) :
    mStartBand(rhs.mStartBand),
    mStopBand(rhs.mStopBand),
    mConcurrentBands(rhs.mConcurrentBands),
-   mbWritable(rhs.mbWritable)
+   mbWritable(rhs.mbWritable),
+   mbTiled(rhs.mbTiled),
+   mRowStride(rhs.mRowStride),
+   mColumnStride(rhs.mColumnStride)
 {
 }
 
@@ -84,8 +90,8 @@ bool DataRequestImp::validate(const RasterDataDescriptor *pDescriptor) const
       startBand.getActiveNumber() >= numBands ||
       startBand.getActiveNumber() > stopBand.getActiveNumber() ||
       stopBand.getActiveNumber() >= numBands ||
-      concurrentRows > stopRow.getActiveNumber()-startRow.getActiveNumber()+1 ||
-      concurrentColumns > stopColumn.getActiveNumber()-startColumn.getActiveNumber()+1 ||
+      concurrentRows > (stopRow.getActiveNumber()-startRow.getActiveNumber()) / mRowStride + 1 ||
+      concurrentColumns > (stopColumn.getActiveNumber()-startColumn.getActiveNumber()) / mColumnStride + 1 ||
       concurrentBands > stopBand.getActiveNumber()-startBand.getActiveNumber()+1)
    {
       return false;
@@ -100,6 +106,24 @@ bool DataRequestImp::validate(const RasterDataDescriptor *pDescriptor) const
       }
    }
 
+   if (getTiled())
+   {
+      // A tile of BIL data is not a contiguous block of each row
+      if (getInterleaveFormat() == BIL && concurrentBands != 1)
+      {
+         return false;
+      }
+   }
+
+   if (mRowStride != 1 || mColumnStride != 1)
+   {
+      // Tiles and written pages are addressed in whole rows and columns
+      if (getTiled() || getWritable())
+      {
+         return false;
+      }
+   }
+
    return true;
 }
 
@@ -143,7 +167,7 @@ bool DataRequestImp::polish(const RasterDataDescriptor *pDescriptor)
    }
    if (mConcurrentColumns == 0)
    {
-      mConcurrentColumns = mStopColumn.getActiveNumber() - mStartColumn.getActiveNumber() + 1;
+      mConcurrentColumns = (mStopColumn.getActiveNumber() - mStartColumn.getActiveNumber()) / mColumnStride + 1;
    }
 
    // bands
@@ -172,6 +196,16 @@ bool DataRequestImp::polish(const RasterDataDescriptor *pDescriptor)
 
 int DataRequestImp::getRequestVersion(const RasterDataDescriptor *pDescriptor) const
 {
+   if (mRowStride != 1 || mColumnStride != 1)
+   {
+      return 3;
+   }
+
+   if (mbTiled)
+   {
+      return 2;
+   }
+
    return 1;
 }
 
@@ -262,3 +296,33 @@ void DataRequestImp::setWritable(bool writable)
 {
    mbWritable = writable;
 }
+
+bool DataRequestImp::getTiled() const
+{
+   return mbTiled;
+}
+
+void DataRequestImp::setTiled(bool tiled)
+{
+   mbTiled = tiled;
+}
+
+unsigned int DataRequestImp::getRowStride() const
+{
+   return mRowStride;
+}
+
+void DataRequestImp::setRowStride(unsigned int stride)
+{
+   mRowStride = (stride == 0 ? 1 : stride);
+}
+
+unsigned int DataRequestImp::getColumnStride() const
+{
+   return mColumnStride;
+}
+
+void DataRequestImp::setColumnStride(unsigned int stride)
+{
+   mColumnStride = (stride == 0 ? 1 : stride);
+}
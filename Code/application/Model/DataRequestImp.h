@@ -49,6 +49,15 @@ public:
    bool getWritable() const;
    void setWritable(bool writable);
 
+   bool getTiled() const;
+   void setTiled(bool tiled);
+
+   unsigned int getRowStride() const;
+   void setRowStride(unsigned int stride);
+
+   unsigned int getColumnStride() const;
+   void setColumnStride(unsigned int stride);
+
 private:
    InterleaveFormatType mInterleave;
    bool mInterleaveDefault;
@@ -66,6 +75,10 @@ private:
    unsigned int mConcurrentBands;
 
    bool mbWritable;
+   bool mbTiled;
+
+   unsigned int mRowStride;
+   unsigned int mColumnStride;
 
 };
 
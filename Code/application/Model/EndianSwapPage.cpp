@@ -9,55 +9,55 @@
 
 #include "EndianSwapPage.h"
 #include "Endian.h"
-#include "switchOnEncoding.h"
 #include "RasterUtilities.h"
 
-#include <stdlib.h>
-#include <string.h>
+#include <algorithm>
 
-EndianSwapPage::EndianSwapPage(void* pSrcData, EncodingType encoding, unsigned int rows, unsigned int columns,
-                               unsigned int bytesPerRow, unsigned int interlineBytes, unsigned char* pEndOfSegment) :
-   mData(rows * bytesPerRow), mRows(rows), mColumns(columns)
+EndianSwapPage::EndianSwapPage(ConvertedPageCache::UnitPtr pUnit, unsigned int startRow, unsigned int columns,
+                               unsigned int bytesPerRow) :
+   mpUnit(pUnit),
+   mOffset(0),
+   mRows(0),
+   mColumns(columns)
 {
-   if (interlineBytes == 0)
+   if (mpUnit.get() != NULL)
    {
-      // if there are no interline bytes, then we can do this more efficiently
-      unsigned int count = bytesPerRow * rows;
-      if (pEndOfSegment != NULL)
-      {
-         count = std::min(count, static_cast<unsigned int>(pEndOfSegment - static_cast<unsigned char*>(pSrcData)));
-      }
-      memcpy(&mData.front(), pSrcData, count);
+      mOffset = static_cast<size_t>(startRow - mpUnit->getStartRow()) * bytesPerRow;
+      mRows = mpUnit->getStartRow() + mpUnit->getRowCount() - startRow;
    }
-   else
+}
+
+void EndianSwapPage::swapRows(unsigned char* pDstData, const unsigned char* pSrcData, EncodingType encoding,
+                              unsigned int rows, unsigned int bytesPerRow, unsigned int interlineBytes,
+                              const unsigned char* pEndOfSegment)
+{
+   // complex data is swapped one component at a time
+   size_t dataSize = RasterUtilities::bytesInEncoding(encoding);
+   if (encoding == INT4SCOMPLEX || encoding == FLT8COMPLEX)
    {
-      unsigned int destOffset = 0;
-      unsigned int srcOffset = 0;
-      for (unsigned int row = 0; row < rows; row++)
+      dataSize /= 2;
+   }
+
+   Endian endian;
+   for (unsigned int row = 0; row < rows; row++)
+   {
+      const unsigned char* pStart = pSrcData + static_cast<size_t>(row) * (bytesPerRow + interlineBytes);
+      unsigned int count = bytesPerRow;
+      if (pEndOfSegment != NULL)
       {
-         unsigned char* pStart = static_cast<unsigned char*>(pSrcData) + srcOffset;
-         unsigned int count = bytesPerRow;
-         if (pEndOfSegment != NULL)
-         {
-            if (pStart >= pEndOfSegment)
-            {
-               break;
-            }
-            count = std::min(count, static_cast<unsigned int>(pEndOfSegment - pStart));
-         }
-         memcpy(&mData[destOffset], pStart, count);
-         if (count < bytesPerRow)
+         if (pStart >= pEndOfSegment)
          {
             break;
          }
-         destOffset += count;
-         srcOffset += count + interlineBytes;
+         count = std::min(count, static_cast<unsigned int>(pEndOfSegment - pStart));
       }
-   }
 
-   Endian endian;
-   switchOnComplexEncoding(encoding, endian.swapBuffer, &mData.front(),
-      mData.size() / RasterUtilities::bytesInEncoding(encoding));
+      endian.copyBuffer(pDstData + static_cast<size_t>(row) * bytesPerRow, pStart, dataSize, count / dataSize);
+      if (count < bytesPerRow)
+      {
+         break;
+      }
+   }
 }
 
 EndianSwapPage::~EndianSwapPage()
@@ -66,7 +66,12 @@ EndianSwapPage::~EndianSwapPage()
 
 void* EndianSwapPage::getRawData()
 {
-   return &mData.front();
+   if (mpUnit.get() == NULL || mpUnit->getRawData() == NULL)
+   {
+      return NULL;
+   }
+
+   return mpUnit->getRawData() + mOffset;
 }
 
 unsigned int EndianSwapPage::getNumRows()
@@ -10,26 +10,51 @@
 #ifndef ENDIANSWAPPAGE_H
 #define ENDIANSWAPPAGE_H
 
+#include "ConvertedPageCache.h"
 #include "RasterPage.h"
 #include "TypesFile.h"
-#include <vector>
 
+/**
+ * A page of data whose bytes have been swapped to the endian type of the
+ * system.
+ *
+ * The swapped data is held in a unit of a ConvertedPageCache, so pages over
+ * the same rows share it and it can be reused after the page is released.
+ */
 class EndianSwapPage : public RasterPage
 {
 public:
    /**
-    * Create a new EndianSwapPage.
+    * Create a new EndianSwapPage over swapped data.
     *
-    * This will make a copy of the source data, removing any interline bytes.
+    * @param pUnit
+    *        The unit which holds the swapped data.  The page starts with the
+    *        given row of the unit and ends with the last row of the unit.
+    * @param startRow
+    *        The active number of the first row of the page.
+    * @param columns
+    *        The number of columns in the page.
+    * @param bytesPerRow
+    *        The number of bytes in each row of the swapped data.
+    */
+   EndianSwapPage(ConvertedPageCache::UnitPtr pUnit, unsigned int startRow, unsigned int columns,
+      unsigned int bytesPerRow);
+
+   ~EndianSwapPage();
+
+   /**
+    * Copy source data and endian swap it, removing any interline bytes.
     *
+    * @param pDstData
+    *        The buffer which receives the data.  It must hold at least
+    *        (rows * bytesPerRow) bytes.  Rows which are not available in
+    *        the source are left unchanged.
     * @param pSrcData
     *        Pointer to the source data. This should contain at least (rows * (bytesPerRow + interlineBytes)) bytes of data.
     * @param encoding
     *        Defined the size of individual data points.
     * @param rows
     *        The number of rows in pSrcData.
-    * @param columns
-    *        The number of columns in pSrcData.
     * @param bytesPerRow
     *        The number of bytes per row of real data. This does not include interline bytes.
     * @param interlineBytes
@@ -38,10 +63,8 @@ public:
     *        Pointer to the end of the memory segment containing pSrcData. Do not attempt to access past this point.
     *        This is ignored if NULL.
     */
-   EndianSwapPage(void* pSrcData, EncodingType encoding, unsigned int rows, unsigned int columns,
-      unsigned int bytesPerRow, unsigned int interlineBytes, unsigned char* pEndOfSegment);
-
-   ~EndianSwapPage();
+   static void swapRows(unsigned char* pDstData, const unsigned char* pSrcData, EncodingType encoding,
+      unsigned int rows, unsigned int bytesPerRow, unsigned int interlineBytes, const unsigned char* pEndOfSegment);
 
    void* getRawData();
    unsigned int getNumRows();
@@ -50,7 +73,8 @@ public:
    unsigned int getInterlineBytes();
 
 private:
-   std::vector<char> mData;
+   ConvertedPageCache::UnitPtr mpUnit;
+   size_t mOffset;
    unsigned int mRows;
    unsigned int mColumns;
 };
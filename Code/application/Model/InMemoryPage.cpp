@@ -9,7 +9,20 @@
 
 #include "InMemoryPage.h"
 
-InMemoryPage::InMemoryPage(void *pData, unsigned int numRows) : mpData(pData), mNumRows(numRows)
+InMemoryPage::InMemoryPage(void *pData, unsigned int numRows) :
+   mpData(pData),
+   mNumRows(numRows),
+   mNumColumns(0),
+   mInterlineBytes(0)
+{
+}
+
+InMemoryPage::InMemoryPage(void *pData, unsigned int numRows, unsigned int numColumns,
+                           unsigned int interlineBytes) :
+   mpData(pData),
+   mNumRows(numRows),
+   mNumColumns(numColumns),
+   mInterlineBytes(interlineBytes)
 {
 }
 
@@ -29,7 +42,7 @@ unsigned int InMemoryPage::getNumRows()
 
 unsigned int InMemoryPage::getNumColumns()
 {
-   return 0;
+   return mNumColumns;
 }
 
 unsigned int InMemoryPage::getNumBands()
@@ -39,5 +52,5 @@ unsigned int InMemoryPage::getNumBands()
 
 unsigned int InMemoryPage::getInterlineBytes()
 {
-   return 0;
+   return mInterlineBytes;
 }
@@ -16,6 +16,7 @@ class InMemoryPage : public RasterPage
 {
 public:
    InMemoryPage(void* pData, unsigned int numRows);
+   InMemoryPage(void* pData, unsigned int numRows, unsigned int numColumns, unsigned int interlineBytes);
    ~InMemoryPage();
 
    void* getRawData();
@@ -27,6 +28,8 @@ public:
 private:
    void* mpData;
    unsigned int mNumRows;
+   unsigned int mNumColumns;
+   unsigned int mInterlineBytes;
 };
 
 #endif
@@ -106,6 +106,8 @@ RasterPage* InMemoryPager::getPage(DataRequest* pOriginalRequest, DimensionDescr
 
    char* pData = reinterpret_cast<char*>(mpData);
    char* pStart = NULL;
+   size_t rowSize = 0;
+   size_t columnSize = 0;
    switch (requestedType)
    {
    case BIP:
@@ -114,6 +116,8 @@ RasterPage* InMemoryPager::getPage(DataRequest* pOriginalRequest, DimensionDescr
          size_t middleSize = minorSize * numBands;
          size_t majorSize = middleSize * numColumns;
          pStart = &pData[rowNumber * majorSize + colNumber * middleSize + bandNumber * minorSize];
+         rowSize = majorSize;
+         columnSize = middleSize;
       }
       break;
    case BSQ:
@@ -122,6 +126,8 @@ RasterPage* InMemoryPager::getPage(DataRequest* pOriginalRequest, DimensionDescr
          size_t middleSize = minorSize * numColumns;
          size_t majorSize = middleSize * numRows;
          pStart = &pData[bandNumber * majorSize + rowNumber * middleSize + colNumber * minorSize];
+         rowSize = middleSize;
+         columnSize = minorSize;
       }
       break;
    case BIL:
@@ -130,6 +136,8 @@ RasterPage* InMemoryPager::getPage(DataRequest* pOriginalRequest, DimensionDescr
          size_t middleSize = minorSize * numColumns;
          size_t majorSize = middleSize * numBands;
          pStart = &pData[rowNumber * majorSize + bandNumber * middleSize + colNumber * minorSize];
+         rowSize = majorSize;
+         columnSize = minorSize * numBands; // a BIL page row is accessed as if it holds every band
       }
       break;
    default:
@@ -138,6 +146,15 @@ RasterPage* InMemoryPager::getPage(DataRequest* pOriginalRequest, DimensionDescr
 
    VERIFYRV(pStart != NULL, NULL);
 
+   if (pOriginalRequest->getTiled())
+   {
+      // the page is the tile; the rest of each row is skipped as interline bytes
+      unsigned int stopColumn = pOriginalRequest->getStopColumn().getActiveNumber();
+      unsigned int tileColumns = std::min(pOriginalRequest->getConcurrentColumns(), stopColumn - colNumber + 1);
+      return new InMemoryPage(pStart, numRows - rowNumber, tileColumns,
+         static_cast<unsigned int>(rowSize - tileColumns * columnSize));
+   }
+
    return new InMemoryPage(pStart, numRows - rowNumber);
 }
 
@@ -154,5 +171,5 @@ void InMemoryPager::releasePage(RasterPage *pPage)
 
 int InMemoryPager::getSupportedRequestVersion() const
 {
-   return 1;
+   return 2;
 }
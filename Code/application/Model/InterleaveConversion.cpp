@@ -0,0 +1,177 @@
+/*
+ * The information in this file is
+ * Copyright(c) 2007 Ball Aerospace & Technologies Corporation
+ * and is subject to the terms and conditions of the
+ * GNU Lesser General Public License Version 2.1
+ * The license text is available from   
+ * http://www.gnu.org/licenses/lgpl.html
+ */
+
+#include "AppConfig.h"
+#include "InterleaveConversion.h"
+
+#include <algorithm>
+#include <string.h>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define INTERLEAVE_CONVERSION_SSE
+#include <xmmintrin.h>
+#endif
+
+using namespace std;
+
+namespace
+{
+   // The number of elements along each side of a block of a transposed matrix.
+   // A block of the largest elements from both matrices fits in the L1 cache.
+   const size_t BLOCK_SIZE = 32;
+
+   template<unsigned int SIZE>
+   void copyElements(const unsigned char* pSrc, size_t srcStride, unsigned char* pDst, size_t dstStride,
+      size_t count)
+   {
+      if (srcStride == SIZE && dstStride == SIZE)
+      {
+         memcpy(pDst, pSrc, count * SIZE);
+         return;
+      }
+
+      // a memcpy() of a constant size compiles to a single unaligned move
+      for (size_t i = 0; i < count; ++i)
+      {
+         memcpy(pDst, pSrc, SIZE);
+         pSrc += srcStride;
+         pDst += dstStride;
+      }
+   }
+
+   template<unsigned int SIZE>
+   void transposeBlock(const unsigned char* pSrc, size_t srcRowBytes, unsigned char* pDst, size_t dstRowBytes,
+      size_t rows, size_t columns)
+   {
+      // each source row is scattered into a destination column
+      for (size_t row = 0; row < rows; ++row)
+      {
+         copyElements<SIZE>(pSrc + row * srcRowBytes, SIZE, pDst + row * SIZE, dstRowBytes, columns);
+      }
+   }
+
+#if defined(INTERLEAVE_CONVERSION_SSE)
+   template<>
+   void transposeBlock<4>(const unsigned char* pSrc, size_t srcRowBytes, unsigned char* pDst, size_t dstRowBytes,
+      size_t rows, size_t columns)
+   {
+      // transpose 4x4 sub-blocks in registers, the shuffles do not alter the bits of the elements
+      size_t fullRows = rows - rows % 4;
+      size_t fullColumns = columns - columns % 4;
+      for (size_t row = 0; row < fullRows; row += 4)
+      {
+         const unsigned char* pIn = pSrc + row * srcRowBytes;
+         unsigned char* pOut = pDst + row * 4;
+         for (size_t column = 0; column < fullColumns; column += 4)
+         {
+            __m128 row0 = _mm_loadu_ps(reinterpret_cast<const float*>(pIn));
+            __m128 row1 = _mm_loadu_ps(reinterpret_cast<const float*>(pIn + srcRowBytes));
+            __m128 row2 = _mm_loadu_ps(reinterpret_cast<const float*>(pIn + 2 * srcRowBytes));
+            __m128 row3 = _mm_loadu_ps(reinterpret_cast<const float*>(pIn + 3 * srcRowBytes));
+            _MM_TRANSPOSE4_PS(row0, row1, row2, row3);
+            _mm_storeu_ps(reinterpret_cast<float*>(pOut), row0);
+            _mm_storeu_ps(reinterpret_cast<float*>(pOut + dstRowBytes), row1);
+            _mm_storeu_ps(reinterpret_cast<float*>(pOut + 2 * dstRowBytes), row2);
+            _mm_storeu_ps(reinterpret_cast<float*>(pOut + 3 * dstRowBytes), row3);
+            pIn += 16;
+            pOut += 4 * dstRowBytes;
+         }
+      }
+
+      // the remaining columns of the full rows, then the remaining rows
+      for (size_t row = 0; row < rows; ++row)
+      {
+         size_t column = (row < fullRows) ? fullColumns : 0;
+         copyElements<4>(pSrc + row * srcRowBytes + column * 4, 4, pDst + column * dstRowBytes + row * 4,
+            dstRowBytes, columns - column);
+      }
+   }
+#endif
+
+   template<unsigned int SIZE>
+   void transpose(const unsigned char* pSrc, size_t srcRowBytes, unsigned char* pDst, size_t dstRowBytes,
+      size_t rows, size_t columns)
+   {
+      for (size_t row = 0; row < rows; row += BLOCK_SIZE)
+      {
+         size_t blockRows = min(BLOCK_SIZE, rows - row);
+         for (size_t column = 0; column < columns; column += BLOCK_SIZE)
+         {
+            size_t blockColumns = min(BLOCK_SIZE, columns - column);
+            transposeBlock<SIZE>(pSrc + row * srcRowBytes + column * SIZE, srcRowBytes,
+               pDst + column * dstRowBytes + row * SIZE, dstRowBytes, blockRows, blockColumns);
+         }
+      }
+   }
+}
+
+void InterleaveConversion::copyElements(const void* pSrc, size_t srcStride, void* pDst, size_t dstStride,
+                                        size_t count, unsigned int elementSize)
+{
+   const unsigned char* pIn = static_cast<const unsigned char*>(pSrc);
+   unsigned char* pOut = static_cast<unsigned char*>(pDst);
+   switch (elementSize)
+   {
+   case 1:
+      ::copyElements<1>(pIn, srcStride, pOut, dstStride, count);
+      break;
+   case 2:
+      ::copyElements<2>(pIn, srcStride, pOut, dstStride, count);
+      break;
+   case 4:
+      ::copyElements<4>(pIn, srcStride, pOut, dstStride, count);
+      break;
+   case 8:
+      ::copyElements<8>(pIn, srcStride, pOut, dstStride, count);
+      break;
+   case 16:
+      ::copyElements<16>(pIn, srcStride, pOut, dstStride, count);
+      break;
+   default:
+      for (size_t i = 0; i < count; ++i)
+      {
+         memcpy(pOut, pIn, elementSize);
+         pIn += srcStride;
+         pOut += dstStride;
+      }
+      break;
+   }
+}
+
+void InterleaveConversion::transpose(const void* pSrc, size_t srcRowBytes, void* pDst, size_t dstRowBytes,
+                                     size_t rows, size_t columns, unsigned int elementSize)
+{
+   const unsigned char* pIn = static_cast<const unsigned char*>(pSrc);
+   unsigned char* pOut = static_cast<unsigned char*>(pDst);
+   switch (elementSize)
+   {
+   case 1:
+      ::transpose<1>(pIn, srcRowBytes, pOut, dstRowBytes, rows, columns);
+      break;
+   case 2:
+      ::transpose<2>(pIn, srcRowBytes, pOut, dstRowBytes, rows, columns);
+      break;
+   case 4:
+      ::transpose<4>(pIn, srcRowBytes, pOut, dstRowBytes, rows, columns);
+      break;
+   case 8:
+      ::transpose<8>(pIn, srcRowBytes, pOut, dstRowBytes, rows, columns);
+      break;
+   case 16:
+      ::transpose<16>(pIn, srcRowBytes, pOut, dstRowBytes, rows, columns);
+      break;
+   default:
+      for (size_t row = 0; row < rows; ++row)
+      {
+         copyElements(pIn + row * srcRowBytes, elementSize, pOut + row * elementSize, dstRowBytes, columns,
+            elementSize);
+      }
+      break;
+   }
+}
@@ -0,0 +1,81 @@
+/*
+ * The information in this file is
+ * Copyright(c) 2007 Ball Aerospace & Technologies Corporation
+ * and is subject to the terms and conditions of the
+ * GNU Lesser General Public License Version 2.1
+ * The license text is available from   
+ * http://www.gnu.org/licenses/lgpl.html
+ */
+
+#ifndef INTERLEAVECONVERSION_H
+#define INTERLEAVECONVERSION_H
+
+#include <stddef.h>
+
+/**
+ * Kernels used by the interleave conversion pagers to rearrange data elements.
+ *
+ * Each kernel is specialized for elements of 1, 2, 4, 8 and 16 bytes so that
+ * an element is moved with a single load and store instead of a call to
+ * memcpy().  Other element sizes fall back to memcpy().  Neither the source
+ * nor the destination needs to be aligned.
+ */
+namespace InterleaveConversion
+{
+   /**
+    * Copies elements between two strided sequences.
+    *
+    * This gathers a single band from BIP data when \p srcStride is the size
+    * of a pixel and \p dstStride is the size of an element, or scatters a
+    * band into BIP data when the strides are swapped.
+    *
+    * @param pSrc
+    *        The first source element.
+    * @param srcStride
+    *        The number of bytes between consecutive source elements.
+    * @param pDst
+    *        The first destination element.
+    * @param dstStride
+    *        The number of bytes between consecutive destination elements.
+    * @param count
+    *        The number of elements to copy.
+    * @param elementSize
+    *        The number of bytes in each element.
+    */
+   void copyElements(const void* pSrc, size_t srcStride, void* pDst, size_t dstStride, size_t count,
+      unsigned int elementSize);
+
+   /**
+    * Transposes a matrix of elements.
+    *
+    * Element (row, column) of the source is copied to element (column, row) of
+    * the destination.  The matrix is processed in blocks which fit in the
+    * processor cache, and 4 byte elements are transposed with SSE when it is
+    * available.
+    *
+    * A row of BIP data is a matrix of columns by bands which transposes into
+    * a row of BIL data, and vice versa.
+    *
+    * @param pSrc
+    *        The first element of the source matrix.
+    * @param srcRowBytes
+    *        The number of bytes between the starts of consecutive source rows.
+    *        This may be larger than \p columns elements to transpose a part of
+    *        a larger matrix.
+    * @param pDst
+    *        The first element of the destination matrix, which has \p columns
+    *        rows of \p rows elements.
+    * @param dstRowBytes
+    *        The number of bytes between the starts of consecutive destination rows.
+    * @param rows
+    *        The number of rows in the source matrix.
+    * @param columns
+    *        The number of columns in the source matrix.
+    * @param elementSize
+    *        The number of bytes in each element.
+    */
+   void transpose(const void* pSrc, size_t srcRowBytes, void* pDst, size_t dstRowBytes, size_t rows,
+      size_t columns, unsigned int elementSize);
+}
+
+#endif
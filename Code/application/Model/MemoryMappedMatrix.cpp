@@ -16,6 +16,7 @@
 #include <sys/stat.h>
 #include <stdexcept>
 #include <stdio.h>
+#include <algorithm>
 #include <limits>
 
 #if defined(WIN_API)
@@ -31,6 +32,15 @@
 
 using namespace std;
 
+namespace
+{
+   // Views are mapped over whole windows of this size, rounded to the allocation granularity.
+   const int64_t WINDOW_SIZE = 16 * 1024 * 1024;
+
+   // The number of views kept for reuse after the pages using them have been released.
+   const size_t MAX_CACHED_VIEWS = 8;
+}
+
 MemoryMappedMatrix::MemoryMappedMatrix(const string& fileName, unsigned int headerOffset,
                                        InterleaveFormatType interleave, unsigned int bytesPerElement,
                                        unsigned int rowNum, unsigned int columnNum, unsigned int bandNum,
@@ -46,6 +56,25 @@ MemoryMappedMatrix::MemoryMappedMatrix(const string& fileName, unsigned int head
    mHeaderOffset(headerOffset),
    mReadOnly(readOnly)
 {
+   if (mInterleave == BIP)
+   {
+      mMinorSize = mBytesPerElement;
+      mMiddleSize = mMinorSize * mBandNum;
+      mMajorSize = mMiddleSize * mColumnNum + mInterLineBytes;
+   }
+   else if (mInterleave == BSQ)
+   {
+      mMinorSize = mBytesPerElement;
+      mMiddleSize = mMinorSize * mColumnNum + mInterLineBytes;
+      mMajorSize = static_cast<int64_t>(mMiddleSize) * mRowNum + mInterBandBytes;
+   }
+   else
+   {
+      mMinorSize = mBytesPerElement;
+      mMiddleSize = mMinorSize * mColumnNum;
+      mMajorSize = static_cast<int64_t>(mMiddleSize) * mBandNum + mInterLineBytes;
+   }
+
 #if defined(WIN_API)
    // All addresses must align on a page boundary.
    SYSTEM_INFO info;
@@ -105,6 +134,19 @@ MemoryMappedMatrix::MemoryMappedMatrix(const string& fileName, unsigned int head
       mGranularity = fileStats.st_blksize;
    }
 #endif
+
+   mWindowSize = max(static_cast<int64_t>(mGranularity), (WINDOW_SIZE / mGranularity) * mGranularity);
+
+   // A 64-bit address space can hold any file, so map it once instead of a window at a time.
+   // If this fails, for example due to an address space limit, fall back to windows.
+   if (sizeof(void*) >= 8 && mFileSize > 0)
+   {
+      mpFileView.reset(new MemoryMappedMatrixView(mHandle, 0, static_cast<size_t>(mFileSize), mReadOnly));
+      if (mpFileView->isValid() == false)
+      {
+         mpFileView.reset();
+      }
+   }
 }
 
 MemoryMappedMatrix::~MemoryMappedMatrix()
@@ -117,17 +159,74 @@ MemoryMappedMatrix::~MemoryMappedMatrix()
 #endif
 }
 
-MemoryMappedMatrixView* MemoryMappedMatrix::getView(size_t defaultSegmentSize)
+int64_t MemoryMappedMatrix::getOffset(unsigned int row, unsigned int column, unsigned int band) const
 {
-   MemoryMappedMatrixView* pView = new MemoryMappedMatrixView(mHandle, mHeaderOffset, defaultSegmentSize,
-      mInterleave, mBytesPerElement, mRowNum, mColumnNum, mBandNum, mInterLineBytes, mInterBandBytes, mReadOnly,
-      mGranularity, mFileSize);
+   int64_t offset = mHeaderOffset;
+   if (mInterleave == BIP)
+   {
+      offset += row * mMajorSize;
+      offset += static_cast<int64_t>(column) * mMiddleSize;
+      offset += static_cast<int64_t>(band) * mMinorSize;
+   }
+   else if (mInterleave == BSQ)
+   {
+      offset += band * mMajorSize;
+      offset += static_cast<int64_t>(row) * mMiddleSize;
+      offset += static_cast<int64_t>(column) * mMinorSize;
+   }
+   else if (mInterleave == BIL)
+   {
+      offset += row * mMajorSize;
+      offset += static_cast<int64_t>(band) * mMiddleSize;
+      offset += static_cast<int64_t>(column) * mMinorSize;
+   }
 
-   mViews.insert(pView);
-   return pView;
+   return offset;
 }
 
-void MemoryMappedMatrix::release(MemoryMappedMatrixView* pView)
+MemoryMappedMatrix::ViewPtr MemoryMappedMatrix::getView(int64_t address, size_t size)
 {
-   mViews.erase(pView);
+   if (address < 0 || address >= mFileSize || size == 0)
+   {
+      return ViewPtr();
+   }
+
+   if (mpFileView.get() != NULL)
+   {
+      return mpFileView;
+   }
+
+   size = static_cast<size_t>(min(static_cast<int64_t>(size), mFileSize - address));
+   {
+      mta::MutexLock lock(mMutex);
+      for (list<ViewPtr>::iterator iter = mViews.begin(); iter != mViews.end(); ++iter)
+      {
+         if ((*iter)->contains(address, size))
+         {
+            ViewPtr pView = *iter;
+            mViews.splice(mViews.begin(), mViews, iter);
+            return pView;
+         }
+      }
+   }
+
+   // Map outside of the lock so that other threads can keep using the existing views.
+   // If another thread maps the same window in the meantime, both views are valid.
+   int64_t start = (address / mWindowSize) * mWindowSize;
+   int64_t stop = min(((address + static_cast<int64_t>(size) - 1) / mWindowSize + 1) * mWindowSize, mFileSize);
+   ViewPtr pView(new MemoryMappedMatrixView(mHandle, start, static_cast<size_t>(stop - start), mReadOnly));
+   if (pView->isValid() == false)
+   {
+      return ViewPtr();
+   }
+
+   mta::MutexLock lock(mMutex);
+   mViews.push_front(pView);
+   if (mViews.size() > MAX_CACHED_VIEWS)
+   {
+      // Pages which still use the dropped view keep it mapped until they are released.
+      mViews.pop_back();
+   }
+
+   return pView;
 }
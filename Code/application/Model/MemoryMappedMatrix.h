@@ -19,10 +19,12 @@ typedef struct _iobuf FILE;
 #endif
 
 #include "AppConfig.h"
+#include "DMutex.h"
 #include "TypesFile.h"
 
+#include <boost/shared_ptr.hpp>
+#include <list>
 #include <string>
-#include <set>
 
 class MemoryMappedMatrixView;
 
@@ -36,9 +38,33 @@ public:
 
    ~MemoryMappedMatrix();
 
-   MemoryMappedMatrixView* getView(size_t defaultSegmentSize);
-
-   void release(MemoryMappedMatrixView* pView);
+   typedef boost::shared_ptr<MemoryMappedMatrixView> ViewPtr;
+
+   /**
+    * Gets the offset of an element in the file.
+    */
+   int64_t getOffset(unsigned int row, unsigned int column, unsigned int band) const;
+
+   /**
+    * Gets a view which maps the given bytes of the file.
+    *
+    * On 64-bit systems the whole file is mapped once when the matrix is
+    * created, and every page is a pointer into that view.  Otherwise, views
+    * are mapped over whole windows of the file and the most recently
+    * used views are kept, so a view is usually shared by consecutive pages
+    * and by pages leased to other threads.  A page holds on to its view
+    * until the page is destroyed, so no other bookkeeping is needed to
+    * release it.  This may be called from any thread.
+    *
+    * @param address
+    *        The offset in the file of the first byte to map.
+    * @param size
+    *        The number of bytes to map.  Bytes past the end of the file are
+    *        not mapped.
+    *
+    * @return The view, or an empty pointer if the bytes could not be mapped.
+    */
+   ViewPtr getView(int64_t address, size_t size);
 
 private:
    std::string mFileName;
@@ -54,7 +80,9 @@ private:
    int mHandle;
 #endif
 
-   std::set<MemoryMappedMatrixView*> mViews;
+   ViewPtr mpFileView; // maps the whole file, if there is enough address space
+   mta::DMutex mMutex;
+   std::list<ViewPtr> mViews; // most recently used views are at the front
 
    InterleaveFormatType mInterleave;
    unsigned int mBytesPerElement;
@@ -66,7 +94,12 @@ private:
    unsigned int mInterLineBytes;
    unsigned int mInterBandBytes;
 
+   unsigned int mMinorSize;
+   unsigned int mMiddleSize;
+   int64_t mMajorSize;
+
    unsigned int mGranularity;
+   int64_t mWindowSize;
 
    unsigned int mHeaderOffset;
    bool mReadOnly;
@@ -27,68 +27,48 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <stdio.h>
+#include <algorithm>
 #include <limits>
 
 using namespace std;
 
-MemoryMappedMatrixView::MemoryMappedMatrixView(HANDLE_TYPE handle, unsigned int headerOffset, size_t segmentSize,
-                                               InterleaveFormatType interleave, unsigned int bytesPerElement,
-                                               unsigned int rowNum, unsigned int columnNum, unsigned int bandNum,
-                                               unsigned int interLineBytes, unsigned int interBandBytes, bool readOnly,
-                                               unsigned int granularity, int64_t fileSize) :
-   mReadOnly(readOnly),
-   mHandle(handle),
-   mInterleave(interleave),
-   mBytesPerElement(bytesPerElement),
-   mRowNum(rowNum),
-   mColumnNum(columnNum),
-   mBandNum(bandNum),
-   mInterLineBytes(interLineBytes),
-   mInterBandBytes(interBandBytes),
-   mSegmentSize(0),
-   mRequestedSegmentSize(segmentSize),
-   mGranularity(granularity),
+MemoryMappedMatrixView::MemoryMappedMatrixView(HANDLE_TYPE handle, int64_t address, size_t size, bool readOnly) :
    mpBlock(NULL),
-   mBlockSize(0),
-   mAddressOffset(0),
-   mAddress(0),
-   mHeaderOffset(headerOffset),
-   mFileSize(fileSize)
+   mBlockSize(size),
+   mAddress(address)
 {
-   if (mInterleave == BIP)
-   {
-      mMinorSize = mBytesPerElement;
-      mMiddleSize = mMinorSize * mBandNum;
-      mMajorSize = mMiddleSize * mColumnNum + mInterLineBytes;
-   }
-   else if (mInterleave == BSQ)
-   {
-      mMinorSize = mBytesPerElement;
-      mMiddleSize = mMinorSize * mColumnNum + mInterLineBytes;
-      mMajorSize = mMiddleSize * mRowNum + mInterBandBytes;
-   }
-   else if (mInterleave == BIL)
+   if (mBlockSize == 0)
    {
-      mMinorSize = mBytesPerElement;
-      mMiddleSize = mMinorSize * mColumnNum;
-      mMajorSize = mMiddleSize * mBandNum + mInterLineBytes;
+      return;
    }
 
 #if defined(WIN_API)
-   mAccessPermissions = FILE_MAP_READ | FILE_MAP_WRITE;
+   int accessPermissions = FILE_MAP_READ | FILE_MAP_WRITE;
    if (readOnly)
    {
-      mAccessPermissions = FILE_MAP_READ;
+      accessPermissions = FILE_MAP_READ;
    }
+
+   static const LONG64 MY_INT_MAX = static_cast<LONG64>(UINT_MAX) + 1;
+   unsigned int addressHigh = static_cast<unsigned int>(mAddress / (MY_INT_MAX));
+   unsigned int addressLow = static_cast<unsigned int>(mAddress % (MY_INT_MAX));
+
+   mpBlock = static_cast<unsigned char*>(MapViewOfFile(handle, accessPermissions, addressHigh, addressLow,
+      mBlockSize));
 #else
-   mAccessPermissions = PROT_WRITE | PROT_READ;
+   int accessPermissions = PROT_WRITE | PROT_READ;
    if (readOnly)
    {
-      mAccessPermissions = PROT_READ;
+      accessPermissions = PROT_READ;
    }
-#endif
 
-   mSegmentSize = static_cast<unsigned int>(ensureGranularity(mRequestedSegmentSize));
+   mpBlock = reinterpret_cast<unsigned char*>(mmap(static_cast<caddr_t>(0), mBlockSize,
+                  accessPermissions, MAP_SHARED, handle, mAddress));
+   if (mpBlock == reinterpret_cast<void*>(-1))
+   {
+      mpBlock = NULL;
+   }
+#endif
 }
 
 MemoryMappedMatrixView::~MemoryMappedMatrixView()
@@ -103,153 +83,83 @@ MemoryMappedMatrixView::~MemoryMappedMatrixView()
    }
 }
 
-unsigned char* MemoryMappedMatrixView::getAddress()
-{
-   return mpBlock + mHeaderOffset;
-}
-
-void MemoryMappedMatrixView::setSegmentSize(size_t segmentSize)
+bool MemoryMappedMatrixView::isValid() const
 {
-   mSegmentSize = static_cast<unsigned int>(ensureGranularity(segmentSize));
-   mRequestedSegmentSize = segmentSize;
+   return mpBlock != NULL;
 }
 
-unsigned char* MemoryMappedMatrixView::firstSegment()
+bool MemoryMappedMatrixView::contains(int64_t address, size_t size) const
 {
-   return getSegment(mHeaderOffset);
+   return mpBlock != NULL && address >= mAddress &&
+      address + static_cast<int64_t>(size) <= mAddress + static_cast<int64_t>(mBlockSize);
 }
 
-unsigned char* MemoryMappedMatrixView::getSegment(unsigned int row, unsigned int column, unsigned int band)
+unsigned char* MemoryMappedMatrixView::getSegment(int64_t address) const
 {
-   int64_t start = 0;
-
-   if (mInterleave == BIP)
-   {
-      start = row * mMajorSize;
-      start += column * mMiddleSize;
-      start += band * mMinorSize;
-      start += mHeaderOffset;
-   }
-   else if (mInterleave == BSQ)
-   {
-      start = band * mMajorSize;
-      start += row * mMiddleSize;
-      start += column * mMinorSize;
-      start += mHeaderOffset;
-   }
-   else if (mInterleave == BIL)
+   if (contains(address, 1) == false)
    {
-      start = row * mMajorSize;
-      start += band * mMiddleSize;
-      start += column * mMinorSize;
-      start += mHeaderOffset;
+      return NULL;
    }
 
-   return getSegment(start);
+   return mpBlock + (address - mAddress);
 }
 
-unsigned char* MemoryMappedMatrixView::getSegment(int64_t address)
+unsigned char *MemoryMappedMatrixView::getEndOfSegment() const
+{
+   return (mpBlock == NULL) ? NULL : (mpBlock + mBlockSize);
+}
+
+void MemoryMappedMatrixView::advise(int64_t address, size_t size, AccessHint hint) const
 {
-   if (mpBlock != NULL)
-   {
 #if defined(WIN_API)
-      UnmapViewOfFile(mpBlock);
+   // PrefetchVirtualMemory() is not available on all supported versions of Windows,
+   // so the system's own read ahead is relied on.
 #else
-      munmap(reinterpret_cast<char*>(mpBlock), mBlockSize);
-#endif
-   }
-
-   mAddress = ensureGranularityLower(address);
-   mAddressOffset = address - mAddress;
-
-   mBlockSize = static_cast<size_t>(calculateSize(mAddress, mAddressOffset));
-   if (mBlockSize == 0)
+   if (mpBlock == NULL)
    {
-      mpBlock = NULL;
-      return NULL;
+      return;
    }
 
-#if defined(WIN_API)
-   static const LONG64 MY_INT_MAX = static_cast<LONG64>(UINT_MAX) + 1;
-   unsigned int addressHigh = static_cast<unsigned int>(mAddress / (MY_INT_MAX));
-   unsigned int addressLow = static_cast<unsigned int>(mAddress % (MY_INT_MAX));
+   int64_t start = max(address, mAddress) - mAddress;
+   int64_t stop = min(address + static_cast<int64_t>(size), mAddress + static_cast<int64_t>(mBlockSize)) - mAddress;
 
-   mpBlock = static_cast<unsigned char*>(MapViewOfFile(mHandle, mAccessPermissions, addressHigh, addressLow,
-      mBlockSize));
-   if (mpBlock == NULL)
+   // madvise() requires the start of the region to be aligned to a system page
+   static const int64_t pageSize = sysconf(_SC_PAGESIZE);
+   if (hint == DONT_NEED)
    {
-      LPVOID lpMsgBuf = NULL;
-      FormatMessage(FORMAT_MESSAGE_ALLOCATE_BUFFER | FORMAT_MESSAGE_FROM_SYSTEM | FORMAT_MESSAGE_IGNORE_INSERTS,
-          NULL, GetLastError(), MAKELANGID(LANG_NEUTRAL, SUBLANG_DEFAULT), // Default language
-          reinterpret_cast<LPSTR>(&lpMsgBuf), 0, NULL);
-      LocalFree(lpMsgBuf);
-      return NULL;
+      // only discard pages which do not hold any data outside of the region
+      start = (start + pageSize - 1) / pageSize * pageSize;
+      if (stop != static_cast<int64_t>(mBlockSize))
+      {
+         stop = stop / pageSize * pageSize;
+      }
    }
-#else
-   mpBlock = reinterpret_cast<unsigned char*>(mmap(static_cast<caddr_t>(0), mBlockSize,
-                  mAccessPermissions, MAP_SHARED, mHandle, mAddress));
-   if (mpBlock == reinterpret_cast<void*>(-1))
-   {
-      // FAILURE THROW AN EXCEPTION
-      mpBlock = NULL;
-      return NULL;
-   }
-   if (mpBlock == NULL)
+   else
    {
-      return NULL;
+      start = start / pageSize * pageSize;
    }
-#endif
-   return mpBlock + mAddressOffset;
-}
 
-unsigned char* MemoryMappedMatrixView::nextSegment()
-{
-   return getSegment(mAddress + mRequestedSegmentSize + mAddressOffset);
-}
-
-/**
- * adjusts the size of the memory map to ensure that it aligns with the
- * system granularity.  This function is public for testing purposes only
- */
-int64_t MemoryMappedMatrixView::ensureGranularity(int64_t suggestedValue)
-{
-   return (suggestedValue / mGranularity + 1) * mGranularity;
-}
-
-// mapSize must also be a multiple of the system granularity
-int64_t MemoryMappedMatrixView::ensureGranularityLower(int64_t suggestedValue)
-{
-   return (suggestedValue / mGranularity) * mGranularity;
-}
-
-/**
- * Calculate the size of the segment without going past the end of file.
- *
- * @param   low
- *          The lower part of the 64-bit address.
- * @param   high
- *          The higher part of the 64-bit address.
- * @return  The segment size.
- */
-int64_t MemoryMappedMatrixView::calculateSize(int64_t address, int64_t offset)
-{
-   int64_t difference;
-
-   difference = mFileSize;
-   difference -= address;
-
-   if (difference < 0)
+   if (start >= stop)
    {
-      return 0;
+      return;
    }
-   if (difference < (mRequestedSegmentSize + offset))
+
+   int advice = MADV_NORMAL;
+   switch (hint)
    {
-      return difference;
+   case SEQUENTIAL_ACCESS:
+      advice = MADV_SEQUENTIAL;
+      break;
+   case WILL_NEED:
+      advice = MADV_WILLNEED;
+      break;
+   case DONT_NEED:
+      advice = MADV_DONTNEED;
+      break;
+   default:
+      break;
    }
-   return (mRequestedSegmentSize + offset);
-}
 
-unsigned char *MemoryMappedMatrixView::getEndOfSegment() const
-{
-   return (mpBlock == NULL) ? NULL : (mpBlock + mBlockSize);
+   madvise(reinterpret_cast<caddr_t>(mpBlock + start), static_cast<size_t>(stop - start), advice);
+#endif
 }
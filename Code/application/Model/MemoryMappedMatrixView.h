@@ -30,68 +30,102 @@
 #include <sys/mman.h>
 #endif
 
+/**
+ * A mapping of a fixed region of a file.
+ *
+ * The region is mapped when the view is created and unmapped when it is
+ * destroyed.  The mapping does not change in between, so a view may be
+ * shared by any number of pages and threads.
+ */
 class MemoryMappedMatrixView
 {
 public:
-   MemoryMappedMatrixView(HANDLE_TYPE handle, unsigned int headerOffset, size_t segmentSize,
-                      InterleaveFormatType interleave, unsigned int bytesPerElement,
-                      unsigned int rowNum, unsigned int columnNum, unsigned int bandNum,
-                      unsigned int interLineBytes, unsigned int interBandBytes, bool readOnly, 
-                      unsigned int granularity, int64_t fileSize);
+   /**
+    * Describes how a region of the view is about to be accessed.
+    *
+    * @see advise()
+    */
+   enum AccessHint
+   {
+      SEQUENTIAL_ACCESS,   /**< The region will be read in order. */
+      WILL_NEED,           /**< The region will be accessed soon, so it should be read ahead. */
+      DONT_NEED            /**< The region will not be accessed again soon. */
+   };
+
+   /**
+    * Maps a region of a file.
+    *
+    * @param handle
+    *        The file, or the file mapping object on Windows.
+    * @param address
+    *        The offset of the region in the file.  This must be a multiple of
+    *        the allocation granularity of the system.
+    * @param size
+    *        The number of bytes to map.  The region must not extend past the
+    *        end of the file.
+    * @param readOnly
+    *        True if the region should be mapped read-only.
+    */
+   MemoryMappedMatrixView(HANDLE_TYPE handle, int64_t address, size_t size, bool readOnly);
 
    ~MemoryMappedMatrixView();
 
-   unsigned char* getAddress();
-
-   void setSegmentSize(size_t segmentSize);
-
-   unsigned char* firstSegment();
-
-   unsigned char* getSegment(unsigned int row, unsigned int column, unsigned int band);
-   unsigned char* getSegment(int64_t address);
-
-   unsigned char* nextSegment();
-
-   int64_t ensureGranularity(int64_t suggestedValue);
-
-   int64_t ensureGranularityLower(int64_t suggestedValue);
-
-   int64_t calculateSize(int64_t address, int64_t offset);
+   /**
+    * Determines whether the region was mapped.
+    *
+    * @return True if the region was mapped, false if mapping failed.
+    */
+   bool isValid() const;
+
+   /**
+    * Determines whether the view maps the given bytes of the file.
+    *
+    * @param address
+    *        The offset of the first byte in the file.
+    * @param size
+    *        The number of bytes.
+    *
+    * @return True if all of the bytes are mapped by the view.
+    */
+   bool contains(int64_t address, size_t size) const;
+
+   /**
+    * Gets a pointer to a byte of the file.
+    *
+    * @param address
+    *        The offset of the byte in the file.
+    *
+    * @return A pointer to the mapped byte, or \c NULL if the byte is not
+    *         mapped by the view.
+    */
+   unsigned char* getSegment(int64_t address) const;
 
    unsigned char *getEndOfSegment() const;
 
-private:
-   bool mReadOnly;
-   int mAccessPermissions;
+   /**
+    * Passes an access hint for a region of the view to the operating system.
+    *
+    * The hint only affects performance.  Bytes which are not mapped by the
+    * view are ignored, and for \c DONT_NEED only the system pages which lie
+    * entirely within the region are affected.  Hints are ignored on
+    * platforms which do not support them.
+    *
+    * @param address
+    *        The offset of the region in the file.
+    * @param size
+    *        The number of bytes in the region.
+    * @param hint
+    *        How the region will be accessed.
+    */
+   void advise(int64_t address, size_t size, AccessHint hint) const;
 
-   HANDLE_TYPE mHandle;
-
-   InterleaveFormatType mInterleave;
-   unsigned int mBytesPerElement;
-
-   unsigned int mRowNum;
-   unsigned int mColumnNum;
-   unsigned int mBandNum;
-
-   unsigned int mMinorSize;
-   unsigned int mMiddleSize;
-   int64_t mMajorSize;
-   unsigned int mInterLineBytes;
-   unsigned int mInterBandBytes;
-
-   unsigned int mSegmentSize;
-   unsigned int mRequestedSegmentSize;
-
-   unsigned int mGranularity;
+private:
+   MemoryMappedMatrixView(const MemoryMappedMatrixView& rhs);
+   MemoryMappedMatrixView& operator=(const MemoryMappedMatrixView& rhs);
 
    unsigned char* mpBlock;
    size_t mBlockSize;
-
-   int64_t mAddressOffset;
    int64_t mAddress;
-
-   int64_t mHeaderOffset;
-   int64_t mFileSize;
 };
 
 #endif
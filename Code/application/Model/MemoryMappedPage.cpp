@@ -15,16 +15,14 @@ MemoryMappedPage::MemoryMappedPage() :
    mNumColumns(0),
    mInterlineBytes(0),
    mpRawCubePointer(NULL),
-   mpMatrixView(NULL)
+   mSegmentAddress(0),
+   mSegmentSize(0),
+   mDiscardOnRelease(false)
 {
 }
 
 MemoryMappedPage::~MemoryMappedPage()
 {
-   if (mpMatrixView != NULL)
-   {
-      delete mpMatrixView;
-   }
 }
 
 void* MemoryMappedPage::getRawData()
@@ -72,22 +70,38 @@ unsigned int MemoryMappedPage::getInterlineBytes()
    return mInterlineBytes;
 }
 
-void MemoryMappedPage::setMemoryMappedMatrixView(MemoryMappedMatrixView* pView)
+void MemoryMappedPage::setMemoryMappedMatrixView(MemoryMappedMatrix::ViewPtr pView)
 {
-   if (pView == mpMatrixView)
-   {
-      return;
-   }
-
-   if (mpMatrixView != NULL)
-   {
-      delete mpMatrixView;
-   }
-
    mpMatrixView = pView;
 }
 
 MemoryMappedMatrixView* MemoryMappedPage::getMemoryMappedMatrixView()
 {
-   return mpMatrixView;
+   return mpMatrixView.get();
+}
+
+void MemoryMappedPage::setSegment(int64_t address, size_t size)
+{
+   mSegmentAddress = address;
+   mSegmentSize = size;
+}
+
+int64_t MemoryMappedPage::getSegmentAddress() const
+{
+   return mSegmentAddress;
+}
+
+size_t MemoryMappedPage::getSegmentSize() const
+{
+   return mSegmentSize;
+}
+
+void MemoryMappedPage::setDiscardOnRelease(bool discard)
+{
+   mDiscardOnRelease = discard;
+}
+
+bool MemoryMappedPage::getDiscardOnRelease() const
+{
+   return mDiscardOnRelease;
 }
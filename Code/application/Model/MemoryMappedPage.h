@@ -12,10 +12,9 @@
 #ifndef MEMORYMAPPEDPAGE_H
 #define MEMORYMAPPEDPAGE_H
 
+#include "MemoryMappedMatrix.h"
 #include "RasterPage.h"
 
-class MemoryMappedMatrixView;
-
 class MemoryMappedPage : public RasterPage
 {
 public:
@@ -33,15 +32,24 @@ public:
    unsigned int getNumBands();   
    unsigned int getInterlineBytes();
 
-   void setMemoryMappedMatrixView(MemoryMappedMatrixView* pView);
+   void setMemoryMappedMatrixView(MemoryMappedMatrix::ViewPtr pView);
    MemoryMappedMatrixView* getMemoryMappedMatrixView();
 
+   void setSegment(int64_t address, size_t size);
+   int64_t getSegmentAddress() const;
+   size_t getSegmentSize() const;
+   void setDiscardOnRelease(bool discard);
+   bool getDiscardOnRelease() const;
+
 private:
    unsigned int mNumRows;
    unsigned int mNumColumns;
    unsigned int mInterlineBytes;
    char* mpRawCubePointer;
-   MemoryMappedMatrixView* mpMatrixView;
+   MemoryMappedMatrix::ViewPtr mpMatrixView; // may be shared with other pages
+   int64_t mSegmentAddress;
+   size_t mSegmentSize;
+   bool mDiscardOnRelease;
 };
 
 #endif
@@ -9,6 +9,7 @@
 
 #include "AppVersion.h"
 #include "AppVerify.h"
+#include "ConvertedPageCache.h"
 #include "DataRequest.h"
 #include "DimensionDescriptor.h"
 #include "Endian.h"
@@ -18,7 +19,6 @@
 #include "MemoryMappedPager.h"
 #include "MemoryMappedMatrix.h"
 #include "MemoryMappedMatrixView.h"
-#include "DMutex.h"
 #include "PlugInArg.h"
 #include "PlugInArgList.h"
 #include "PlugInManagerServices.h"
@@ -33,7 +33,8 @@ MemoryMappedPager::MemoryMappedPager() :
    mbUseDataDescriptor(true),
    mpDataDescriptor(NULL),
    mSwapEndian(false),
-   mWritable(false)
+   mWritable(false),
+   mCounters("MemoryMappedPager")
 {
    setName("MemoryMappedPager");
    setCopyright("Copyright (2005) by Ball Aerospace & Technologies Corp.");
@@ -59,31 +60,8 @@ namespace
 
 MemoryMappedPager::~MemoryMappedPager()
 {
-   //destroy and RasterPager objects that we
-   //leased out via the getPage() method
-   //but were not returned to us via the releasePage()
-   //method
-   MemoryMappedPage* pCurPage = NULL;
-   MemoryMappedMatrix* pCurMatrix = NULL;
-   map<MemoryMappedPage*, MemoryMappedMatrix*>::iterator iterPages = mCurrentlyLeasedPages.begin();
-   map<MemoryMappedPage*, MemoryMappedMatrix*>::iterator endPages = mCurrentlyLeasedPages.end();
-
-   while (iterPages != endPages)
-   {
-      pCurPage = iterPages->first;
-      pCurMatrix = iterPages->second;
-      //destroy the memory mapped section of the file
-      //associated with that Page
-      pCurMatrix->release(pCurPage->getMemoryMappedMatrixView());
-
-      //delete the actual page that we allocated earlier
-      //in the getPage() method.
-      delete pCurPage;
-
-      iterPages++;
-   }
-   mCurrentlyLeasedPages.clear();
-
+   // any pages which were not returned via releasePage()
+   // keep their views mapped until they are destroyed
    for_each(mMatrices.begin(), mMatrices.end(), MemoryMappedMatrixDeleter());
 }
 
@@ -165,6 +143,7 @@ bool MemoryMappedPager::execute(PlugInArgList* pInputArgList, PlugInArgList* pOu
    const RasterDataDescriptor* pDescriptor =
       dynamic_cast<const RasterDataDescriptor*>(pArg->getPlugInArgValueUnsafe<DataDescriptor>());
    VERIFY(pRaster != NULL || pDescriptor != NULL);
+   mCounters.setRasterElement(pRaster);
 
    //Get Filename argument
    Filename* pFilename = NULL;
@@ -224,6 +203,10 @@ bool MemoryMappedPager::execute(PlugInArgList* pInputArgList, PlugInArgList* pOu
 
          EndianType srcEndian = pFileDescriptor->getEndian();
          mSwapEndian = (srcEndian != Endian::getSystemEndian() && pDescriptor->getBytesPerElement() > 1);
+         if (mSwapEndian)
+         {
+            mpSwappedPages.reset(new ConvertedPageCache(pRaster, RasterElement::getSettingConvertedPageCacheSize()));
+         }
 
          const std::vector<const Filename*>& bandFiles = pFileDescriptor->getBandFiles();
          if (!mWritable && !bandFiles.empty())
@@ -284,17 +267,182 @@ bool MemoryMappedPager::execute(PlugInArgList* pInputArgList, PlugInArgList* pOu
 RasterPage* MemoryMappedPager::getPage(DataRequest* pOriginalRequest, DimensionDescriptor startRow,
                                        DimensionDescriptor startColumn, DimensionDescriptor startBand)
 {
-   //ensure only one thread enters this code at a time
+   //this may be called from several threads at once, so only the matrices may be modified
+   mCounters.addGetPageCall();
    VERIFYRV((mpDataDescriptor != NULL) && (!mMatrices.empty()) && pOriginalRequest != NULL, NULL);
 
-   unsigned int bandIndex = startBand.getActiveNumber();
-
    if (pOriginalRequest->getWritable() == true && (mWritable == false || mSwapEndian == true))
    {
       return NULL;
    }
 
-   mta::MutexLock mutex(mMutex);
+   Segment segment;
+   if (getSegment(pOriginalRequest, startRow, startColumn, startBand, segment) == false)
+   {
+      return NULL;
+   }
+
+   if (mSwapEndian)
+   {
+      RasterPage* pSwappedPage = getSwappedPage(pOriginalRequest, startRow, startColumn, startBand, segment);
+      if (pSwappedPage != NULL)
+      {
+         mCounters.addPageLeased();
+      }
+
+      return pSwappedPage;
+   }
+
+   //get a MemoryMappedMatrixView which maps at least the segment
+   MemoryMappedMatrix::ViewPtr pView = segment.mpMatrix->getView(segment.mAddress, segment.mSize);
+   if (pView.get() == NULL)
+   {
+      return NULL;
+   }
+
+   //ask the MemoryMappedMatrixView for a pointer starting
+   //at the given location
+   char* pRawCubePointer = reinterpret_cast<char*>(pView->getSegment(segment.mAddress));
+   if (pRawCubePointer == NULL)
+   {
+      return NULL;
+   }
+
+   //start reading the whole page instead of faulting it in one system page at a time,
+   //and let the system read further ahead if the accessor will step through the rows in order
+   bool sequential = isSequential(pOriginalRequest, startRow);
+   if (sequential)
+   {
+      pView->advise(segment.mAddress, segment.mSize, MemoryMappedMatrixView::SEQUENTIAL_ACCESS);
+   }
+   advise(pView.get(), segment, MemoryMappedMatrixView::WILL_NEED);
+
+   //we know have a pointer in raw memory that has
+   //been memory mapped, so now create a RasterPage
+   //and return it.
+   MemoryMappedPage* pPage = new MemoryMappedPage;
+   pPage->setRawData(pRawCubePointer);
+   pPage->setMemoryMappedMatrixView(pView);
+   pPage->setSegment(segment.mAddress, segment.mSize);
+   pPage->setDiscardOnRelease(sequential && pOriginalRequest->getWritable() == false);
+   pPage->setNumRows(segment.mNumRows);
+   pPage->setNumColumns(segment.mNumColumns);
+   pPage->setInterlineBytes(segment.mInterlineBytes);
+   mCounters.addPageLeased();
+
+   return pPage;
+}
+
+void MemoryMappedPager::releasePage(RasterPage* pPage)
+{
+   VERIFYNRV(pPage != NULL);
+   mCounters.addPageReleased();
+
+   //the page releases its view when it is deleted
+   if (mSwapEndian)
+   {
+      delete static_cast<EndianSwapPage*>(pPage);
+   }
+   else
+   {
+      MemoryMappedPage* pOurPage = static_cast<MemoryMappedPage*>(pPage);
+      if (pOurPage->getDiscardOnRelease())
+      {
+         //the accessor has moved past these rows, so keep them from adding to the resident set
+         pOurPage->getMemoryMappedMatrixView()->advise(pOurPage->getSegmentAddress(), pOurPage->getSegmentSize(),
+            MemoryMappedMatrixView::DONT_NEED);
+      }
+
+      delete pOurPage;
+   }
+}
+
+void MemoryMappedPager::prefetchPage(DataRequest* pOriginalRequest, DimensionDescriptor startRow,
+                                     DimensionDescriptor startColumn, DimensionDescriptor startBand)
+{
+   if ((mpDataDescriptor == NULL) || mMatrices.empty() || pOriginalRequest == NULL)
+   {
+      return;
+   }
+
+   Segment segment;
+   if (getSegment(pOriginalRequest, startRow, startColumn, startBand, segment))
+   {
+      MemoryMappedMatrix::ViewPtr pView = segment.mpMatrix->getView(segment.mAddress, segment.mSize);
+      if (pView.get() != NULL)
+      {
+         advise(pView.get(), segment, MemoryMappedMatrixView::WILL_NEED);
+      }
+   }
+}
+
+RasterPage* MemoryMappedPager::getSwappedPage(DataRequest* pOriginalRequest, DimensionDescriptor startRow,
+                                             DimensionDescriptor startColumn, DimensionDescriptor startBand,
+                                             const Segment& segment)
+{
+   VERIFYRV(mpSwappedPages.get() != NULL, NULL);
+
+   //the layout of a page only depends on where it starts, so the start band identifies the bands
+   unsigned int bytesPerRow = segment.mRowSize - segment.mInterlineBytes;
+   unsigned int startRowNumber = startRow.getActiveNumber();
+   ConvertedPageCache::UnitPtr pUnit = mpSwappedPages->getUnit(startRowNumber, segment.mNumRows,
+      startColumn.getActiveNumber(), segment.mNumColumns, startBand.getActiveNumber(), 1);
+   if (pUnit.get() == NULL)
+   {
+      mCounters.addCacheMiss();
+
+      //swap a block of rows at once so that an accessor stepping through the rows reuses it
+      unsigned int availableRows = std::max(segment.mNumRows,
+         pOriginalRequest->getStopRow().getActiveNumber() - startRowNumber + 1);
+      unsigned int unitRows = ConvertedPageCache::getUnitRowCount(segment.mNumRows, availableRows, bytesPerRow);
+      unsigned long unitSize = (unitRows - 1) * segment.mRowSize + bytesPerRow;
+
+      MemoryMappedMatrix::ViewPtr pView = segment.mpMatrix->getView(segment.mAddress, unitSize);
+      if (pView.get() == NULL)
+      {
+         return NULL;
+      }
+
+      const unsigned char* pSrc = pView->getSegment(segment.mAddress);
+      if (pSrc == NULL)
+      {
+         return NULL;
+      }
+
+      pUnit = mpSwappedPages->createUnit(startRowNumber, unitRows, startColumn.getActiveNumber(),
+         segment.mNumColumns, startBand.getActiveNumber(), 1, bytesPerRow);
+      if (pUnit.get() == NULL)
+      {
+         return NULL;
+      }
+
+      PagerCounters::Timer timer;
+      pView->advise(segment.mAddress, unitSize, MemoryMappedMatrixView::WILL_NEED);
+      EndianSwapPage::swapRows(pUnit->getRawData(), pSrc, mpDataDescriptor->getDataType(), unitRows, bytesPerRow,
+         segment.mInterlineBytes, pView->getEndOfSegment());
+      mCounters.addDecodeTime(timer.getElapsed());
+      mCounters.addBytesFetched(unitSize);
+      if (isSequential(pOriginalRequest, startRow))
+      {
+         //the data has been copied, so the mapped pages are not needed again
+         pView->advise(segment.mAddress, unitSize, MemoryMappedMatrixView::DONT_NEED);
+      }
+
+      mpSwappedPages->addUnit(pUnit);
+   }
+   else
+   {
+      mCounters.addCacheHit();
+   }
+
+   return new EndianSwapPage(pUnit, startRowNumber, segment.mNumColumns, bytesPerRow);
+}
+
+bool MemoryMappedPager::getSegment(DataRequest* pOriginalRequest, DimensionDescriptor startRow,
+                                   DimensionDescriptor startColumn, DimensionDescriptor startBand,
+                                   Segment& segment) const
+{
+   unsigned int bandIndex = startBand.getActiveNumber();
 
    InterleaveFormatType interleave;
    unsigned int numBands = 0;
@@ -313,10 +461,7 @@ RasterPage* MemoryMappedPager::getPage(DataRequest* pOriginalRequest, DimensionD
    {
       const RasterFileDescriptor* pFileDescriptor =
          dynamic_cast<const RasterFileDescriptor*>(mpDataDescriptor->getFileDescriptor());
-      if (pFileDescriptor == NULL)
-      {
-         return false;
-      }
+      VERIFY(pFileDescriptor != NULL);
 
       interleave = pFileDescriptor->getInterleaveFormat();
       numBands = pFileDescriptor->getBandCount();
@@ -389,95 +534,84 @@ RasterPage* MemoryMappedPager::getPage(DataRequest* pOriginalRequest, DimensionD
    segmentSize = concurrentRows * rowSize;
    numRows = concurrentRows;
 
-   //get the MemoryMappedMatrixView of a let segmentSize large
-   MemoryMappedMatrixView* pView = NULL;
-   MemoryMappedMatrix* pMatrix = mMatrices.front();
-   if (mMatrices.size() > 1)
-   {
-      VERIFYRV(bandIndex < mMatrices.size(), NULL);
-      pMatrix = mMatrices[bandIndex];
-   }
-   VERIFYRV(pMatrix != NULL, NULL);
-   pView = pMatrix->getView(segmentSize);
-   VERIFYRV(pView != NULL, NULL);
-
-   //ask the MemoryMappedMatrixView for a pointer starting
-   //at the given location
-   if (mMatrices.size() > 1)
+   unsigned int pageColumns = numColumns;
+   unsigned int pageInterlineBytes = interlineBytes;
+   unsigned int rowStride = pOriginalRequest->getRowStride();
+   unsigned long strideSize = rowSize;
+   if (rowStride > 1)
    {
-      bandIndex = 0;
+      // the rows between the requested rows are stepped over as interline bytes, so they are never read
+      // a BIL page row is accessed as if it holds every band
+      unsigned long rowBytes = numColumns * bytesPerElement * (interleave == BSQ ? 1 : numBands);
+      unsigned int stopRow = pOriginalRequest->getStopRow().getActiveNumber();
+      numRows = min(concurrentRows, (stopRow - startRow.getActiveNumber()) / rowStride + 1);
+      strideSize = rowStride * (rowBytes + interlineBytes);
+      pageInterlineBytes = strideSize - rowBytes;
+      segmentSize = (numRows - 1) * strideSize + rowBytes;
    }
-   char* pRawCubePointer = reinterpret_cast<char*>(pView->getSegment(startRow.getActiveNumber() + offsetRow,
-                                                   startColumn.getActiveNumber() + offsetCol, bandIndex));
-   if (pRawCubePointer == NULL)
+   if (pOriginalRequest->getTiled())
    {
-      return NULL;
+      // only map the columns of the tile, the rest of each row is skipped as interline bytes
+      // a BIL page row is accessed as if it holds every band
+      unsigned long columnSize = bytesPerElement * (interleave == BSQ ? 1 : numBands);
+      unsigned int stopColumn = pOriginalRequest->getStopColumn().getActiveNumber();
+      pageColumns = min(pOriginalRequest->getConcurrentColumns(), stopColumn - startColumn.getActiveNumber() + 1);
+      pageInterlineBytes = rowSize - pageColumns * columnSize;
+      segmentSize = (concurrentRows - 1) * rowSize + pageColumns * columnSize;
    }
 
-   //we know have a pointer in raw memory that has
-   //been memory mapped, so now create a RasterPage
-   //and return it.
-   MemoryMappedPage* pPage = new MemoryMappedPage;
-   pPage->setRawData(pRawCubePointer);
-   pPage->setMemoryMappedMatrixView(pView);
-   pPage->setNumRows(numRows);
-   pPage->setNumColumns(numColumns);
-   pPage->setInterlineBytes(interlineBytes);
-
-   if (mSwapEndian)
+   //find the matrix which holds the band
+   MemoryMappedMatrix* pMatrix = mMatrices.front();
+   if (mMatrices.size() > 1)
    {
-      EndianSwapPage* pEndianPage = new EndianSwapPage(pPage->getRawData(), mpDataDescriptor->getDataType(),
-                                                       numRows, numColumns, rowSize - interlineBytes, interlineBytes,
-                                                       pPage->getMemoryMappedMatrixView()->getEndOfSegment());
-
-      pMatrix->release(pView);
-      delete pPage;
-
-      return pEndianPage;
+      VERIFY(bandIndex < mMatrices.size());
+      pMatrix = mMatrices[bandIndex];
+      bandIndex = 0;
    }
-
-   mCurrentlyLeasedPages[pPage] = pMatrix;
-
-   return pPage;
+   VERIFY(pMatrix != NULL);
+
+   segment.mpMatrix = pMatrix;
+   segment.mAddress = pMatrix->getOffset(startRow.getActiveNumber() + offsetRow,
+                                         startColumn.getActiveNumber() + offsetCol, bandIndex);
+   segment.mSize = segmentSize;
+   segment.mRowSize = rowSize;
+   segment.mNumRows = numRows;
+   segment.mNumColumns = pageColumns;
+   segment.mInterlineBytes = pageInterlineBytes;
+   segment.mRowStride = rowStride;
+   segment.mStrideSize = strideSize;
+   return true;
 }
 
-void MemoryMappedPager::releasePage(RasterPage* pPage)
+int MemoryMappedPager::getSupportedRequestVersion() const
 {
-   VERIFYNRV(pPage != NULL);
+   //swapped pages are converted in blocks of whole rows, so the core skips the rows of a strided request
+   return mSwapEndian ? 2 : 3;
+}
 
-   //ensure only one thread enters this code at a time
-   mta::MutexLock mutex(mMutex);
+bool MemoryMappedPager::isSequential(DataRequest* pOriginalRequest, DimensionDescriptor startRow)
+{
+   //an untiled accessor which spans more rows than a page steps through the pages in order,
+   //but the system would read the skipped rows of a strided accessor along with the requested ones
+   return pOriginalRequest->getTiled() == false && pOriginalRequest->getRowStride() == 1 &&
+      pOriginalRequest->getStopRow().getActiveNumber() - startRow.getActiveNumber() + 1 >
+      pOriginalRequest->getConcurrentRows();
+}
 
-   if (mSwapEndian)
+void MemoryMappedPager::advise(const MemoryMappedMatrixView* pView, const Segment& segment,
+                               MemoryMappedMatrixView::AccessHint hint)
+{
+   if (segment.mRowStride > 1)
    {
-      delete static_cast<EndianSwapPage*>(pPage);
+      //only advise the rows of the page, since the rows between them are not read
+      unsigned long rowBytes = segment.mStrideSize - segment.mInterlineBytes;
+      for (unsigned int row = 0; row < segment.mNumRows; ++row)
+      {
+         pView->advise(segment.mAddress + static_cast<int64_t>(row) * segment.mStrideSize, rowBytes, hint);
+      }
    }
    else
    {
-      MemoryMappedPage* pOurPage = static_cast<MemoryMappedPage*>(pPage);
-
-      map<MemoryMappedPage*, MemoryMappedMatrix*>::iterator foundIter;
-      foundIter = mCurrentlyLeasedPages.find(pOurPage);
-      if (foundIter != mCurrentlyLeasedPages.end())
-      {
-         //we leased the page out from this instance,
-         //so now we can release the resources used for it.
-         
-         //destroy the memory mapped section of the file
-         //associated with that page
-         foundIter->second->release(pOurPage->getMemoryMappedMatrixView());
-
-         //remove the page from the vector
-         mCurrentlyLeasedPages.erase(foundIter);
-         
-         //delete the actual page that we allocated earlier
-         //in the getPage() method.
-         delete pOurPage;
-      }
+      pView->advise(segment.mAddress, segment.mSize, hint);
    }
 }
-
-int MemoryMappedPager::getSupportedRequestVersion() const
-{
-   return 1;
-}
@@ -12,14 +12,15 @@
 #ifndef MEMORYMAPPEDPAGER_H
 #define MEMORYMAPPEDPAGER_H
 
+#include "MemoryMappedMatrixView.h"
+#include "PagerCounters.h"
 #include "RasterPagerShell.h"
-#include "DMutex.h"
 
+#include <memory>
 #include <vector>
-#include <map>
 
+class ConvertedPageCache;
 class RasterDataDescriptor;
-class MemoryMappedPage;
 class MemoryMappedMatrix;
 
 class MemoryMappedPager : public RasterPagerShell
@@ -40,22 +41,55 @@ public:
       DimensionDescriptor startColumn,
       DimensionDescriptor startBand);
    void releasePage(RasterPage *pPage);
+   void prefetchPage(DataRequest *pOriginalRequest,
+      DimensionDescriptor startRow,
+      DimensionDescriptor startColumn,
+      DimensionDescriptor startBand);
    int getSupportedRequestVersion() const;
 
 
 private:
+   // The part of the file which holds a page.
+   struct Segment
+   {
+      MemoryMappedMatrix* mpMatrix;
+      int64_t mAddress;
+      unsigned long mSize;
+      unsigned long mRowSize;
+      unsigned int mNumRows;
+      unsigned int mNumColumns;
+      unsigned int mInterlineBytes;
+      unsigned int mRowStride;      // rows of the file between consecutive rows of the page
+      unsigned long mStrideSize;    // bytes between consecutive rows of the page
+   };
+
+   bool getSegment(DataRequest *pOriginalRequest,
+      DimensionDescriptor startRow,
+      DimensionDescriptor startColumn,
+      DimensionDescriptor startBand,
+      Segment& segment) const;
+   static bool isSequential(DataRequest *pOriginalRequest, DimensionDescriptor startRow);
+   static void advise(const MemoryMappedMatrixView* pView, const Segment& segment,
+      MemoryMappedMatrixView::AccessHint hint);
+   RasterPage* getSwappedPage(DataRequest *pOriginalRequest,
+      DimensionDescriptor startRow,
+      DimensionDescriptor startColumn,
+      DimensionDescriptor startBand,
+      const Segment& segment);
+
    bool mbUseDataDescriptor;
    const RasterDataDescriptor* mpDataDescriptor;
    bool mSwapEndian;
+   std::auto_ptr<ConvertedPageCache> mpSwappedPages; // only created if mSwapEndian is true
 
-   // All leased blocks, and the matrices that they came from.
-   // Not all matrices will be represented here at any given time.
-   std::map<MemoryMappedPage*, MemoryMappedMatrix*> mCurrentlyLeasedPages;
+   // Leased pages share the views of the matrices, so pages are leased and
+   // released without any locking in the pager.
    std::vector<MemoryMappedMatrix*>      mMatrices;
-   
-   mta::DMutex                           mMutex;
 
    bool mWritable;
+
+   // Pages which are mapped directly are read by the system, so only swapped data is counted as fetched.
+   PagerCounters mCounters;
 };
 
 #endif
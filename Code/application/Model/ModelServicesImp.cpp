@@ -13,17 +13,19 @@
 #include "AoiElementAdapter.h"
 #include "AppAssert.h"
 #include "AppVerify.h"
+#include "ConfigurationSettings.h"
 #include "DataDescriptorAdapter.h"
 #include "DataElementAdapter.h"
 #include "DataElementGroupAdapter.h"
 #include "FileDescriptorImp.h"
 #include "GcpListAdapter.h"
 #include "ImportDescriptorImp.h"
-#include "MessageLog.h"
+#include "MessageLogResource.h"
 #include "PlugInManagerServices.h"
 #include "PointCloudDataDescriptorAdapter.h"
 #include "PointCloudElementAdapter.h"
 #include "PointCloudFileDescriptorImp.h"
+#include "RasterCache.h"
 #include "RasterDataDescriptorAdapter.h"
 #include "RasterElementAdapter.h"
 #include "RasterFileDescriptorImp.h"
@@ -42,6 +44,8 @@
 #include "xmlwriter.h"
 
 #include <boost/bind.hpp>
+#include <algorithm>
+#include <limits>
 #include <queue>
 
 using namespace std;
@@ -77,7 +81,8 @@ void ModelServicesImp::destroy()
 }
 
 ModelServicesImp::ModelServicesImp() : 
-   SettableSessionItemAdapter("{543BF9C3-2861-4240-ADD7-6748C3BF4F90}")
+   SettableSessionItemAdapter("{543BF9C3-2861-4240-ADD7-6748C3BF4F90}"),
+   mRasterCacheAccess(0)
 {
    mElementTypes.push_back("AnnotationElement");
    mElementTypes.push_back("Any");
@@ -821,6 +826,170 @@ void ModelServicesImp::deleteMemoryBlock(char* memory)
    delete [] memory;
 }
 
+void ModelServicesImp::registerRasterCache(RasterCache* pCache)
+{
+   VERIFYNRV(pCache != NULL);
+
+   mta::MutexLock lock(mRasterCacheMutex);
+   if (find(mRasterCaches.begin(), mRasterCaches.end(), pCache) == mRasterCaches.end())
+   {
+      mRasterCaches.push_back(pCache);
+   }
+}
+
+void ModelServicesImp::unregisterRasterCache(RasterCache* pCache)
+{
+   mta::MutexLock lock(mRasterCacheMutex);
+   mRasterCaches.erase(remove(mRasterCaches.begin(), mRasterCaches.end(), pCache), mRasterCaches.end());
+}
+
+uint64_t ModelServicesImp::getRasterCacheAccess()
+{
+   return ++mRasterCacheAccess;
+}
+
+void ModelServicesImp::enforceRasterCacheBudget()
+{
+   // A budget of 0 MB means the raster caches are only limited by their own sizes
+   size_t budget = static_cast<size_t>(ConfigurationSettings::getSettingRasterCacheSize()) * 1024 * 1024;
+   if (budget == 0)
+   {
+      return;
+   }
+
+   mta::MutexLock lock(mRasterCacheMutex);
+   for (;;)
+   {
+      size_t totalSize = 0;
+      RasterCache* pOldestCache = NULL;
+      uint64_t oldestAccess = numeric_limits<uint64_t>::max();
+      for (vector<RasterCache*>::const_iterator iter = mRasterCaches.begin(); iter != mRasterCaches.end(); ++iter)
+      {
+         RasterCache* pCache = *iter;
+         totalSize += pCache->getCacheSize();
+
+         uint64_t access = pCache->getOldestAccess();
+         if (access < oldestAccess)
+         {
+            oldestAccess = access;
+            pOldestCache = pCache;
+         }
+      }
+
+      if (totalSize <= budget || pOldestCache == NULL || pOldestCache->releaseOldest() == false)
+      {
+         break;
+      }
+   }
+}
+
+size_t ModelServicesImp::getRasterCacheSize(const RasterElement* pElement) const
+{
+   size_t cacheSize = 0;
+
+   mta::MutexLock lock(mRasterCacheMutex);
+   for (vector<RasterCache*>::const_iterator iter = mRasterCaches.begin(); iter != mRasterCaches.end(); ++iter)
+   {
+      const RasterCache* pCache = *iter;
+      if (pElement == NULL || pCache->getRasterElement() == pElement)
+      {
+         cacheSize += pCache->getCacheSize();
+      }
+   }
+
+   return cacheSize;
+}
+
+void ModelServicesImp::registerRasterPagerCounters(RasterPagerCounters* pCounters)
+{
+   VERIFYNRV(pCounters != NULL);
+
+   mta::MutexLock lock(mRasterPagerCountersMutex);
+   if (find(mRasterPagerCounters.begin(), mRasterPagerCounters.end(), pCounters) == mRasterPagerCounters.end())
+   {
+      mRasterPagerCounters.push_back(pCounters);
+   }
+}
+
+void ModelServicesImp::unregisterRasterPagerCounters(RasterPagerCounters* pCounters)
+{
+   mta::MutexLock lock(mRasterPagerCountersMutex);
+   mRasterPagerCounters.erase(remove(mRasterPagerCounters.begin(), mRasterPagerCounters.end(), pCounters),
+      mRasterPagerCounters.end());
+}
+
+RasterPagerCounters::Values ModelServicesImp::getRasterPagerCounters(const RasterElement* pElement) const
+{
+   RasterPagerCounters::Values total;
+
+   mta::MutexLock lock(mRasterPagerCountersMutex);
+   for (vector<RasterPagerCounters*>::const_iterator iter = mRasterPagerCounters.begin();
+      iter != mRasterPagerCounters.end(); ++iter)
+   {
+      const RasterPagerCounters* pCounters = *iter;
+      if (pElement == NULL || pCounters->getRasterElement() == pElement)
+      {
+         RasterPagerCounters::Values values = pCounters->getValues();
+         total.mGetPageCalls += values.mGetPageCalls;
+         total.mCacheHits += values.mCacheHits;
+         total.mCacheMisses += values.mCacheMisses;
+         total.mBytesFetched += values.mBytesFetched;
+         total.mDecodeTime += values.mDecodeTime;
+         total.mLockWaitTime += values.mLockWaitTime;
+         total.mPagesLeased += values.mPagesLeased;
+         total.mPagesReleased += values.mPagesReleased;
+      }
+   }
+
+   return total;
+}
+
+void ModelServicesImp::logRasterPagerCounters() const
+{
+   // Take a snapshot so that the message log is not written while holding the lock
+   vector<pair<string, RasterPagerCounters::Values> > snapshot;
+   {
+      mta::MutexLock lock(mRasterPagerCountersMutex);
+      for (vector<RasterPagerCounters*>::const_iterator iter = mRasterPagerCounters.begin();
+         iter != mRasterPagerCounters.end(); ++iter)
+      {
+         const RasterPagerCounters* pCounters = *iter;
+         string name = pCounters->getPagerName();
+         const RasterElement* pElement = pCounters->getRasterElement();
+         if (pElement != NULL)
+         {
+            name += " (" + pElement->getName() + ")";
+         }
+
+         snapshot.push_back(make_pair(name, pCounters->getValues()));
+      }
+   }
+
+   if (snapshot.empty())
+   {
+      return;
+   }
+
+   StepResource pStep("Raster Pager Counters", "app", "5E1F6A0C-7D3B-4C8E-9A62-2B4D8F17C0E3");
+   for (vector<pair<string, RasterPagerCounters::Values> >::const_iterator iter = snapshot.begin();
+      iter != snapshot.end(); ++iter)
+   {
+      const RasterPagerCounters::Values& values = iter->second;
+      MessageResource pMsg("Raster Pager", "app", "B0C2E9D4-31A7-4F65-8E1B-6C9D0A2F7E58");
+      pMsg->addProperty("Pager", iter->first);
+      pMsg->addProperty("Get Page Calls", UInt64(values.mGetPageCalls));
+      pMsg->addProperty("Cache Hits", UInt64(values.mCacheHits));
+      pMsg->addProperty("Cache Misses", UInt64(values.mCacheMisses));
+      pMsg->addProperty("Bytes Fetched", UInt64(values.mBytesFetched));
+      pMsg->addProperty("Decode Time (us)", UInt64(values.mDecodeTime));
+      pMsg->addProperty("Lock Wait Time (us)", UInt64(values.mLockWaitTime));
+      pMsg->addProperty("Pages Leased", UInt64(values.mPagesLeased));
+      pMsg->addProperty("Pages Released", UInt64(values.mPagesReleased));
+   }
+
+   pStep->finalize(Message::Success);
+}
+
 bool ModelServicesImp::isKindOfElement(const string& className, const string& elementName) const
 {
    bool bSuccess = false;
@@ -13,12 +13,14 @@
 #include <xercesc/dom/DOM.hpp>
 
 #include "DataElement.h"
+#include "DMutex.h"
 #include "ModelServices.h"
 #include "SettableSessionItemAdapter.h"
 #include "StringUtilities.h"
 #include "SubjectImp.h"
 #include "XercesIncludes.h"
 
+#include <boost/atomic.hpp>
 #include <vector>
 
 using XERCES_CPP_NAMESPACE_QUALIFIER DOMElement;
@@ -72,6 +74,16 @@ public:
    char* getMemoryBlock(size_t size);
    void deleteMemoryBlock(char* memory); 
 
+   void registerRasterCache(RasterCache* pCache);
+   void unregisterRasterCache(RasterCache* pCache);
+   uint64_t getRasterCacheAccess();
+   void enforceRasterCacheBudget();
+   size_t getRasterCacheSize(const RasterElement* pElement = NULL) const;
+   void registerRasterPagerCounters(RasterPagerCounters* pCounters);
+   void unregisterRasterPagerCounters(RasterPagerCounters* pCounters);
+   RasterPagerCounters::Values getRasterPagerCounters(const RasterElement* pElement = NULL) const;
+   void logRasterPagerCounters() const;
+
    bool isKindOfElement(const std::string& className, const std::string& elementName) const;
    void getElementTypes(const std::string& className, std::vector<std::string>& classList) const;
    bool isKindOfDataDescriptor(const std::string& className, const std::string& descriptorName) const;
@@ -152,6 +164,13 @@ private:
    std::vector<std::string> mElementTypes;
    std::multimap<Key, DataElement*> mElements;
 
+   std::vector<RasterCache*> mRasterCaches;
+   mutable mta::DMutex mRasterCacheMutex;
+   boost::atomic<uint64_t> mRasterCacheAccess;
+
+   std::vector<RasterPagerCounters*> mRasterPagerCounters;
+   mutable mta::DMutex mRasterPagerCountersMutex;
+
    std::multimap<Key, DataElement*>::iterator findElement(const DataElement* pElement);
    std::multimap<Key, DataElement*>::iterator findElement(const Key& key, const std::string& type);
    std::multimap<Key, DataElement*>::const_iterator findElement(const Key& key, const std::string& type) const;
@@ -10,6 +10,9 @@
 #include "AppConfig.h"
 #include "AppVerify.h"
 #include "BadValues.h"
+#include "ChipCopy.h"
+#include "ChipViewPager.h"
+#include "CompressedInMemoryPager.h"
 #include "ConfigurationSettings.h"
 #include "ConvertToBilPager.h"
 #include "ConvertToBipPager.h"
@@ -43,6 +46,7 @@
 #include "StatisticsImp.h"
 #include "xmlwriter.h"
 
+#include <algorithm>
 #include <fstream>
 #include <limits>
 #include <boost/bind.hpp>
@@ -152,6 +156,66 @@ namespace
       return *(reinterpret_cast<const double*>(pValue) + iIndex);
    }
 
+   template<typename T, typename Out>
+   void convert_row(const void* pValue, size_t stride, Out* pValues, size_t count, ComplexComponent component)
+   {
+      if (stride == sizeof(T))
+      {
+         // contiguous values are converted in a plain loop so that the compiler can vectorize it
+         const T* pData = reinterpret_cast<const T*>(pValue);
+         for (size_t i = 0; i < count; ++i)
+         {
+            pValues[i] = static_cast<Out>(pData[i]);
+         }
+      }
+      else
+      {
+         const char* pData = reinterpret_cast<const char*>(pValue);
+         for (size_t i = 0; i < count; ++i, pData += stride)
+         {
+            pValues[i] = static_cast<Out>(*reinterpret_cast<const T*>(pData));
+         }
+      }
+   }
+
+   template<typename T, typename Out>
+   void convert_complex_row(const void* pValue, size_t stride, Out* pValues, size_t count,
+      ComplexComponent component)
+   {
+      // select the component once for the whole row instead of once per value
+      const char* pData = reinterpret_cast<const char*>(pValue);
+      switch (component)
+      {
+      case COMPLEX_MAGNITUDE:
+         for (size_t i = 0; i < count; ++i, pData += stride)
+         {
+            pValues[i] = static_cast<Out>(reinterpret_cast<const T*>(pData)->getMagnitude());
+         }
+         break;
+      case COMPLEX_PHASE:
+         for (size_t i = 0; i < count; ++i, pData += stride)
+         {
+            pValues[i] = static_cast<Out>(reinterpret_cast<const T*>(pData)->getPhase());
+         }
+         break;
+      case COMPLEX_INPHASE:
+         for (size_t i = 0; i < count; ++i, pData += stride)
+         {
+            pValues[i] = static_cast<Out>(reinterpret_cast<const T*>(pData)->mReal);
+         }
+         break;
+      case COMPLEX_QUADRATURE:
+         for (size_t i = 0; i < count; ++i, pData += stride)
+         {
+            pValues[i] = static_cast<Out>(reinterpret_cast<const T*>(pData)->mImaginary);
+         }
+         break;
+      default:
+         fill(pValues, pValues + count, static_cast<Out>(0));
+         break;
+      }
+   }
+
 };
 RasterElementImp::RasterElementImp(const DataDescriptorImp& descriptor, const string& id) :
    DataElementImp(descriptor, id),
@@ -160,8 +224,11 @@ RasterElementImp::RasterElementImp(const DataDescriptorImp& descriptor, const st
    mpBipConverterPager(NULL),
    mpBilConverterPager(NULL),
    mpBsqConverterPager(NULL),
+   mpChipViewSource(SIGNAL_NAME(Subject, Deleted), Slot(this, &RasterElementImp::chipViewSourceDeleted)),
+   mpChipViewPager(NULL),
    mCubePointerAccessor(NULL, NULL),
    mModified(false),
+   mDataUpdated(false),
    mpGeoPlugin(NULL)
 {
    RasterDataDescriptorImp* pDescriptor = dynamic_cast<RasterDataDescriptorImp*>(getDataDescriptor());
@@ -273,6 +340,14 @@ RasterElementImp::RasterElementImp(const DataDescriptorImp& descriptor, const st
 
 RasterElementImp::~RasterElementImp()
 {
+   // The statistics stop their background calculations, which read the data, before the pagers are destroyed
+   for (map<DimensionDescriptor, StatisticsImp*>::iterator iter = mStatistics.begin();
+      iter != mStatistics.end(); ++iter)
+   {
+      delete iter->second;
+   }
+   mStatistics.clear();
+
    if (mpTerrain.get() != NULL)
    {
       RasterElement* pTerrain = mpTerrain.get();
@@ -285,12 +360,19 @@ RasterElementImp::~RasterElementImp()
    delete mpBilConverterPager;
    delete mpBsqConverterPager;
 
+   mpChipViewSource.reset(NULL);
+
    Service<PlugInManagerServices> pPluginManager;
    if (mpPager != NULL)
    {
       pPluginManager->destroyPlugIn(dynamic_cast<PlugIn*>(mpPager));
    }
 
+   if (mpChipViewPager != NULL)
+   {
+      pPluginManager->destroyPlugIn(dynamic_cast<PlugIn*>(mpChipViewPager));
+   }
+
    if (mTempFilename.empty() == false)
    {
       remove(mTempFilename.c_str());
@@ -300,12 +382,6 @@ RasterElementImp::~RasterElementImp()
    {
       pPluginManager->destroyPlugIn(dynamic_cast<PlugIn*>(mpGeoPlugin));
    }
-
-   for (map<DimensionDescriptor, StatisticsImp*>::iterator iter = mStatistics.begin();
-      iter != mStatistics.end(); ++iter)
-   {
-      delete iter->second;
-   }
 }
 
 double RasterElementImp::getPixelValue(DimensionDescriptor columnDim, DimensionDescriptor rowDim,
@@ -356,10 +432,18 @@ void RasterElementImp::updateData()
       }
    }
 
+   clearConvertedPages();
+
    mModified = true;
+   mDataUpdated = true;
    notify(SIGNAL_NAME(RasterElement, DataModified));
 }
 
+bool RasterElementImp::isDataUpdated() const
+{
+   return mDataUpdated;
+}
+
 uint64_t RasterElementImp::sanitizeData(double value)
 {
    uint64_t badValueCount = 0;
@@ -459,6 +543,21 @@ Statistics* RasterElementImp::getStatistics(DimensionDescriptor band) const
    return NULL;
 }
 
+void RasterElementImp::calculateStatistics(const vector<DimensionDescriptor>& bands, ComplexComponent component) const
+{
+   vector<StatisticsImp*> statistics;
+   for (vector<DimensionDescriptor>::const_iterator iter = bands.begin(); iter != bands.end(); ++iter)
+   {
+      map<DimensionDescriptor, StatisticsImp*>::const_iterator statIter = mStatistics.find(*iter);
+      if (statIter != mStatistics.end())
+      {
+         statistics.push_back(statIter->second);
+      }
+   }
+
+   StatisticsImp::calculateStatistics(statistics, component);
+}
+
 
 bool RasterElementImp::toXml(XMLWriter* pXml) const
 {
@@ -504,8 +603,18 @@ void RasterElementImp::getElementTypes(vector<string>& classList)
    DataElementImp::getElementTypes(classList);
 }
 
+RasterElementImp::Deleter::Deleter(RasterElementImp* pElement, bool writable) :
+   mpElement(pElement),
+   mWritable(writable)
+{}
+
 void RasterElementImp::Deleter::operator()(DataAccessorImpl* pDataAccessor)
 {
+   if (mWritable && pDataAccessor != NULL)
+   {
+      mpElement->clearConvertedPages(*pDataAccessor);
+   }
+
    delete pDataAccessor;
    delete this;
 }
@@ -559,11 +668,23 @@ RasterElement *RasterElementImp::createChip(DataElement *pParent, const string &
    return createChipInternal(pParent, name, selectedRows, selectedColumns, selectedBands);
 }
 
+RasterElement* RasterElementImp::createChipView(DataElement* pParent, const string& appendName,
+                                                const vector<DimensionDescriptor>& selectedRows,
+                                                const vector<DimensionDescriptor>& selectedColumns,
+                                                const vector<DimensionDescriptor>& selectedBands) const
+{
+   // the chip pages are taken from the pager of this element
+   VERIFYRV(const_cast<RasterElementImp*>(this)->createDefaultPager(), NULL);
+
+   string name = appendToBasename(getName(), appendName);
+   return createChipInternal(pParent, name, selectedRows, selectedColumns, selectedBands, false, true);
+}
+
 RasterElement* RasterElementImp::createChipInternal(DataElement* pParent, const string& name,
                                                     const vector<DimensionDescriptor>& selectedRows,
                                                     const vector<DimensionDescriptor>& selectedColumns,
                                                     const vector<DimensionDescriptor>& selectedBands,
-                                                    bool copyRasterData) const
+                                                    bool copyRasterData, bool shareRasterData) const
 {
    const RasterDataDescriptorImp* pDescriptor = dynamic_cast<const RasterDataDescriptorImp*>(getDataDescriptor());
    VERIFYRV(pDescriptor != NULL, NULL);
@@ -670,7 +791,17 @@ RasterElement* RasterElementImp::createChipInternal(DataElement* pParent, const
       pRasterChip->getDataDescriptor());
    VERIFYRV(pChipDescriptor != NULL, NULL);
 
-   pRasterChip->createDefaultPager();
+   if (shareRasterData)
+   {
+      RasterElementImp* pChipImp = dynamic_cast<RasterElementImp*>(pRasterChip.get());
+      VERIFYRV(pChipImp != NULL, NULL);
+      VERIFYRV(pChipImp->createChipViewPager(dynamic_cast<const RasterElement*>(this),
+         *pSelectedRows, *pSelectedCols, *pSelectedBands), NULL);
+   }
+   else
+   {
+      pRasterChip->createDefaultPager();
+   }
 
    bool abort = false;
    VERIFYRV(RasterUtilities::chipMetadata(pRasterChip->getMetadata(), *pSelectedRows, *pSelectedCols,
@@ -715,470 +846,34 @@ bool RasterElementImp::copyDataToChip(RasterElement *pRasterChip,
    VERIFY(pRasterChip != NULL);
    RasterDataDescriptor* pDescriptorChip = dynamic_cast<RasterDataDescriptor*>(pRasterChip->getDataDescriptor());
    VERIFY(pDescriptorChip != NULL);
-
-   bool success = false;
-
-   switch (pDescriptorChip->getInterleaveFormat())
-   {
-   case BIP:
-      success = copyDataBip(pRasterChip, selectedRows, selectedColumns, selectedBands, abort, pProgress);
-      break;
-   case BSQ:
-      success = copyDataBsq(pRasterChip, selectedRows, selectedColumns, selectedBands, abort, pProgress);
-      break;
-   case BIL:
-      success = copyDataBil(pRasterChip, selectedRows, selectedColumns, selectedBands, abort, pProgress);
-      break;
-   default:
-      break;
-   }
-
-   return success;
-}
-
-
-bool RasterElementImp::copyDataBip(RasterElement* pChipElement, const vector<DimensionDescriptor>& selectedRows,
-                                   const vector<DimensionDescriptor>& selectedColumns,
-                                   const vector<DimensionDescriptor>& selectedBands, bool& abort,
-                                   Progress* pProgress) const
-{
-   VERIFY(pProgress != NULL);
-   string progressText = "Copying data";
-   pProgress->updateProgress(progressText, 0, NORMAL);
-
-   const RasterDataDescriptor* pSrcDd = dynamic_cast<const RasterDataDescriptor*>(getDataDescriptor());
-   VERIFY(pSrcDd != NULL);
-
-   const vector<DimensionDescriptor>& srcActiveBands = pSrcDd->getBands();
-
-   int bytesPerElement = pSrcDd->getBytesPerElement();
-
-   bool copyCompleted = false;
-
-   int rowIndex = 0;
-   if (selectedBands.size() == srcActiveBands.size())
-   {
-      // all bands
-      if (selectedColumns.size() == 
-         selectedColumns.back().getActiveNumber() - selectedColumns.front().getActiveNumber() + 1)
-      {
-         unsigned int startCol = selectedColumns.front().getActiveNumber();
-
-         // full contiguous row at a time
-         FactoryResource<DataRequest> pSrcRequest;
-         pSrcRequest->setInterleaveFormat(BIP);
-         pSrcRequest->setRows(selectedRows.front(), selectedRows.back());
-         pSrcRequest->setColumns(selectedColumns.front(), selectedColumns.back());
-         DataAccessor srcDa = getDataAccessor(pSrcRequest.release());
-
-         FactoryResource<DataRequest> pChipRequest;
-         pChipRequest->setWritable(true);
-         pChipRequest->setInterleaveFormat(BIP);
-         DataAccessor chipDa = pChipElement->getDataAccessor(pChipRequest.release());
-
-         VERIFY(chipDa.isValid() && srcDa.isValid());
-         for (vector<DimensionDescriptor>::const_iterator rowIter = selectedRows.begin();
-            rowIter != selectedRows.end();
-            ++rowIter)
-         {
-            DimensionDescriptor rowDim = *rowIter;
-            srcDa->toPixel(rowDim.getActiveNumber(), startCol);
-            VERIFY(srcDa.isValid() && chipDa.isValid());
-            char* pChip = reinterpret_cast<char*>(chipDa->getRow());
-            char* pSrc = reinterpret_cast<char*>(srcDa->getRow());
-            memcpy(pChip, pSrc, bytesPerElement * selectedBands.size() * selectedColumns.size());
-            chipDa->nextRow();
-
-            pProgress->updateProgress(progressText, (rowIndex++ * 100) / selectedRows.size(), NORMAL);
-            if (abort)
-            {
-               return false;
-            }
-         }
-         copyCompleted = true;
-      }
-      else
-      {
-         // one full pixel at a time
-         FactoryResource<DataRequest> pSrcRequest;
-         pSrcRequest->setInterleaveFormat(BIP);
-         DataAccessor srcDa = getDataAccessor(pSrcRequest.release());
-         
-         FactoryResource<DataRequest> pChipRequest;
-         pChipRequest->setWritable(true);
-         pChipRequest->setInterleaveFormat(BIP);
-         DataAccessor chipDa = pChipElement->getDataAccessor(pChipRequest.release());
-
-         VERIFY(chipDa.isValid() && srcDa.isValid());
-         for (vector<DimensionDescriptor>::const_iterator rowIter = selectedRows.begin();
-            rowIter != selectedRows.end();
-            ++rowIter)
-         {
-            VERIFY(chipDa.isValid());
-            char* pChip = reinterpret_cast<char*>(chipDa->getRow());
-            unsigned int rowOffsetChip = 0;
-            for (vector<DimensionDescriptor>::const_iterator colIter = selectedColumns.begin();
-               colIter != selectedColumns.end();
-               ++colIter)
-            {
-               DimensionDescriptor rowDim = *rowIter;
-               DimensionDescriptor colDim = *colIter;
-
-               srcDa->toPixel(rowDim.getActiveNumber(), colDim.getActiveNumber());
-               VERIFY(srcDa.isValid());
-               char* pSrc = reinterpret_cast<char*>(srcDa->getColumn());
-               memcpy(pChip + rowOffsetChip, pSrc, bytesPerElement * selectedBands.size());
-               rowOffsetChip += bytesPerElement * selectedBands.size();
-            }
-            chipDa->nextRow();
-            pProgress->updateProgress(progressText, (rowIndex++ * 100)/selectedRows.size(), NORMAL);
-            if (abort)
-            {
-               return false;
-            }
-         }
-         copyCompleted = true;
-      }
-   }
-
-   if (!copyCompleted)
-   {
-      // slowest possible copy, per pixel, but it works for any BIP data
-      FactoryResource<DataRequest> pSrcRequest;
-      pSrcRequest->setInterleaveFormat(BIP);
-      DataAccessor srcDa = getDataAccessor(pSrcRequest.release());
-
-      FactoryResource<DataRequest> pChipRequest;
-      pChipRequest->setWritable(true);
-      pChipRequest->setInterleaveFormat(BIP);
-      DataAccessor chipDa = pChipElement->getDataAccessor(pChipRequest.release());
-
-      for (vector<DimensionDescriptor>::const_iterator rowIter = selectedRows.begin();
-         rowIter != selectedRows.end();
-         ++rowIter)
-      {
-         VERIFY(chipDa.isValid());
-         char* pChip = reinterpret_cast<char*>(chipDa->getRow());
-         unsigned int chipOffset = 0;
-         for (vector<DimensionDescriptor>::const_iterator colIter = selectedColumns.begin();
-            colIter != selectedColumns.end();
-            ++colIter)
-         {
-            DimensionDescriptor rowDim = *rowIter;
-            DimensionDescriptor colDim = *colIter;
-
-            srcDa->toPixel(rowDim.getActiveNumber(), colDim.getActiveNumber());
-            VERIFY(srcDa.isValid());
-            char* pSrc = reinterpret_cast<char*>(srcDa->getColumn());
-            for (vector<DimensionDescriptor>::const_iterator bandIter = selectedBands.begin();
-               bandIter != selectedBands.end();
-               ++bandIter)
-            {
-               DimensionDescriptor bandDim = *bandIter;
-
-               memcpy(pChip+chipOffset, pSrc + bytesPerElement * (bandDim.getActiveNumber()), 
-                  bytesPerElement);
-               chipOffset += bytesPerElement;
-            }
-
-         }
-         chipDa->nextRow();
-         pProgress->updateProgress(progressText, (rowIndex++ * 100)/selectedRows.size(), NORMAL);
-         if (abort)
-         {
-            return false;
-         }
-      }
-      copyCompleted = true;
-
-   }
-   VERIFY(copyCompleted);
-
-   return true;
-}
-
-bool RasterElementImp::copyDataBil(RasterElement* pChipElement, const vector<DimensionDescriptor>& selectedRows,
-                                   const vector<DimensionDescriptor>& selectedColumns,
-                                   const vector<DimensionDescriptor>& selectedBands, bool& abort,
-                                   Progress* pProgress) const
-{
-   VERIFY(pChipElement != NULL);
-   VERIFY(pProgress != NULL);
-   string progressText = "Copying data";
-   pProgress->updateProgress(progressText, 0, NORMAL);
-
-   const RasterDataDescriptor* pSrcDd = dynamic_cast<const RasterDataDescriptor*>(getDataDescriptor());
-   VERIFY(pSrcDd != NULL);
-   const RasterDataDescriptor* pChipDd = dynamic_cast<const RasterDataDescriptor*>(pChipElement->getDataDescriptor());
-   VERIFY(pChipDd != NULL);
-
-   const vector<DimensionDescriptor>& srcActiveCols = pSrcDd->getColumns();
-
-   unsigned int bytesPerElement = pSrcDd->getBytesPerElement();
-
-   if (selectedColumns.size() == srcActiveCols.size() && selectedBands.size() ==
-      selectedBands.back().getActiveNumber() - selectedBands.front().getActiveNumber() + 1)
-   {
-      // copy a full row at a time
-      unsigned int step = 0;
-      unsigned int steps = selectedRows.size();
-
-      FactoryResource<DataRequest> pSrcRequest;
-      pSrcRequest->setInterleaveFormat(BIL);
-      pSrcRequest->setRows(selectedRows.front(), selectedRows.back());
-      pSrcRequest->setBands(selectedBands.front(), selectedBands.back(), selectedBands.size());
-      DataAccessor srcDa = getDataAccessor(pSrcRequest.release());
-
-      FactoryResource<DataRequest> pChipRequest;
-      pChipRequest->setInterleaveFormat(BIL);
-      pChipRequest->setWritable(true);
-      DataAccessor chipDa = pChipElement->getDataAccessor(pChipRequest.release());
-
-      VERIFY(chipDa.isValid() && srcDa.isValid());
-      for (vector<DimensionDescriptor>::const_iterator rowIter = selectedRows.begin();
-         rowIter != selectedRows.end();
-         ++rowIter)
-      {
-         srcDa->toPixel(rowIter->getActiveNumber(), selectedColumns.front().getActiveNumber());
-         VERIFY(chipDa.isValid());
-         VERIFY(srcDa.isValid());
-         char* pChip = reinterpret_cast<char*>(chipDa->getRow());
-         char* pSrc = reinterpret_cast<char*>(srcDa->getRow());
-         memcpy(pChip, pSrc, selectedColumns.size() * selectedBands.size() * bytesPerElement);
-         chipDa->nextRow();
-         pProgress->updateProgress(progressText, (step++ * 100)/steps, NORMAL);
-         if (abort)
-         {
-            return false;
-         }
-      }
-   }
-   else if (selectedColumns.size() ==
-      selectedColumns.back().getActiveNumber() - selectedColumns.front().getActiveNumber() + 1)
-   {
-      // copy a full row one band at a time
-      unsigned int step = 0;
-      unsigned int steps = selectedBands.size() * selectedRows.size();
-
-      FactoryResource<DataRequest> pChipRequest;
-      pChipRequest->setInterleaveFormat(BIL);
-      pChipRequest->setWritable(true);
-      DataAccessor chipDa = pChipElement->getDataAccessor(pChipRequest.release());
-
-      for (vector<DimensionDescriptor>::const_iterator rowIter = selectedRows.begin();
-         rowIter != selectedRows.end();
-         ++rowIter)
-      {
-         VERIFY(chipDa.isValid());
-         char* pChip = reinterpret_cast<char*>(chipDa->getRow());
-
-         for (vector<DimensionDescriptor>::const_iterator bandIter = selectedBands.begin();
-            bandIter != selectedBands.end();
-            ++bandIter)
-         {
-            FactoryResource<DataRequest> pSrcRequest;
-            pSrcRequest->setInterleaveFormat(BIL);
-            pSrcRequest->setRows(*rowIter, *rowIter, 1);
-            pSrcRequest->setBands(*bandIter, *bandIter, 1);
-            pSrcRequest->setColumns(selectedColumns.front(), selectedColumns.back(), selectedColumns.size());
-            DataAccessor srcDa = getDataAccessor(pSrcRequest.release());
-            srcDa->toPixel(rowIter->getActiveNumber(), selectedColumns.front().getActiveNumber());
-            VERIFY(srcDa.isValid());
-
-            char* pSrc = reinterpret_cast<char*>(srcDa->getRow());
-            memcpy(pChip, pSrc, selectedColumns.size() * bytesPerElement);
-            pChip += selectedColumns.size() * bytesPerElement;
-            pProgress->updateProgress(progressText, (step++ * 100)/steps, NORMAL);
-            if (abort)
-            {
-               return false;
-            }
-         }
-
-         chipDa->nextRow();
-      }
-   }
-   else
-   {
-      // slowest possible copy, per pixel, but it works for any BIL data
-      unsigned int step = 0;
-      unsigned int steps = selectedBands.size() * selectedRows.size();
-
-      FactoryResource<DataRequest> pChipRequest;
-      pChipRequest->setInterleaveFormat(BIL);
-      pChipRequest->setWritable(true);
-      DataAccessor chipDa = pChipElement->getDataAccessor(pChipRequest.release());
-
-      for (vector<DimensionDescriptor>::const_iterator rowIter = selectedRows.begin();
-         rowIter != selectedRows.end();
-         ++rowIter)
-      {
-         unsigned int chipOffset = 0;
-         VERIFY(chipDa.isValid());
-         char* pChip = reinterpret_cast<char*>(chipDa->getRow());
-
-         for (vector<DimensionDescriptor>::const_iterator bandIter = selectedBands.begin();
-            bandIter != selectedBands.end();
-            ++bandIter)
-         {
-            FactoryResource<DataRequest> pSrcRequest;
-            pSrcRequest->setInterleaveFormat(BIL);
-            pSrcRequest->setRows(*rowIter, *rowIter, 1);
-            pSrcRequest->setBands(*bandIter, *bandIter, 1);
-            pSrcRequest->setColumns(selectedColumns.front(), selectedColumns.back(), 1);
-            DataAccessor srcDa = getDataAccessor(pSrcRequest.release());
-            VERIFY(srcDa.isValid());
-
-            for (vector<DimensionDescriptor>::const_iterator columnIter = selectedColumns.begin();
-               columnIter != selectedColumns.end();
-               ++columnIter)
-            {
-               srcDa->toPixel(rowIter->getActiveNumber(), columnIter->getActiveNumber());
-               VERIFY(srcDa.isValid());
-               char* pSrc = reinterpret_cast<char*>(srcDa->getColumn());
-
-               memcpy(pChip + chipOffset, pSrc, bytesPerElement);
-               chipOffset += bytesPerElement;
-            }
-
-            pProgress->updateProgress(progressText, (step++ * 100)/steps, NORMAL);
-            if (abort)
-            {
-               return false;
-            }
-         }
-
-         chipDa->nextRow();
-      }
-   }
-
-   return true;
-}
-
-bool RasterElementImp::copyDataBsq(RasterElement* pChipElement, const vector<DimensionDescriptor>& selectedRows,
-                                   const vector<DimensionDescriptor>& selectedColumns,
-                                   const vector<DimensionDescriptor>& selectedBands, bool& abort,
-                                   Progress* pProgress) const
-{
-   VERIFY(pChipElement != NULL);
-   VERIFY(pProgress != NULL);
-   string progressText = "Copying data";
-   pProgress->updateProgress(progressText, 0, NORMAL);
-
-   const RasterDataDescriptor* pSrcDd = dynamic_cast<const RasterDataDescriptor*>(getDataDescriptor());
-   VERIFY(pSrcDd != NULL);
-   const RasterDataDescriptor* pChipDd = dynamic_cast<const RasterDataDescriptor*>(pChipElement->getDataDescriptor());
-   VERIFY(pChipDd != NULL);
-
-   int bytesPerElement = pSrcDd->getBytesPerElement();
-
-   bool copyCompleted = false;
-
-   if (selectedColumns.size() == 
-      selectedColumns.back().getActiveNumber() - selectedColumns.front().getActiveNumber() + 1)
-   {
-      unsigned int chipBand = 0;
-      unsigned int step = 0;
-      unsigned int steps = selectedRows.size() * selectedBands.size();
-      for (vector<DimensionDescriptor>::const_iterator bandItr = selectedBands.begin();
-         bandItr != selectedBands.end(); ++bandItr)
-      {
-         DimensionDescriptor bandDim = *bandItr;
-         DimensionDescriptor startRowDim = selectedRows.front();
-         DimensionDescriptor stopRowDim = selectedRows.back();
-         DimensionDescriptor startColDim = selectedColumns.front();
-         DimensionDescriptor stopColDim = selectedColumns.back();
-
-         // copy a full row at a time
-         FactoryResource<DataRequest> pSrcRequest;
-         pSrcRequest->setInterleaveFormat(BSQ);
-         pSrcRequest->setRows(startRowDim, stopRowDim);
-         pSrcRequest->setColumns(startColDim, stopColDim);
-         pSrcRequest->setBands(bandDim, bandDim);
-         DataAccessor srcDa = getDataAccessor(pSrcRequest.release());
-
-         FactoryResource<DataRequest> pChipRequest;
-         pChipRequest->setInterleaveFormat(BSQ);
-         pChipRequest->setWritable(true);
-         pChipRequest->setBands(pChipDd->getActiveBand(chipBand), pChipDd->getActiveBand(chipBand));
-         DataAccessor chipDa = pChipElement->getDataAccessor(pChipRequest.release());
-
-         VERIFY(chipDa.isValid() && srcDa.isValid());
-         for (vector<DimensionDescriptor>::const_iterator rowItr = selectedRows.begin();
-            rowItr != selectedRows.end(); ++rowItr)
-         {
-            srcDa->toPixel(rowItr->getActiveNumber(), 0);
-            VERIFY(chipDa.isValid());
-            VERIFY(srcDa.isValid());
-            char* pChip = reinterpret_cast<char*>(chipDa->getRow());
-            char* pSrc = reinterpret_cast<char*>(srcDa->getRow());
-            memcpy(pChip, pSrc, selectedColumns.size() * bytesPerElement);
-            chipDa->nextRow();
-            pProgress->updateProgress(progressText, (step++ * 100)/steps, NORMAL);
-            if (abort)
-            {
-               return false;
-            }
-         }
-         ++chipBand;
-      }
-      copyCompleted = true;
-   }
-   else
-   {
-      unsigned int chipBand = 0;
-      unsigned int step = 0;
-      unsigned int steps = selectedBands.size() * selectedRows.size();
-      for (vector<DimensionDescriptor>::const_iterator bandItr = selectedBands.begin();
-         bandItr != selectedBands.end(); ++bandItr)
-      {
-         DimensionDescriptor bandDim = *bandItr;
-
-         // slowest copy, one pixel at a time
-         FactoryResource<DataRequest> pSrcRequest;
-         pSrcRequest->setInterleaveFormat(BSQ);
-         pSrcRequest->setBands(bandDim, bandDim);
-         DataAccessor srcDa = getDataAccessor(pSrcRequest.release());
-
-         FactoryResource<DataRequest> pChipRequest;
-         pChipRequest->setInterleaveFormat(BSQ);
-         pChipRequest->setWritable(true);
-         pChipRequest->setBands(pChipDd->getActiveBand(chipBand), pChipDd->getActiveBand(chipBand));
-         DataAccessor chipDa = pChipElement->getDataAccessor(pChipRequest.release());
-
-         VERIFY(chipDa.isValid() && srcDa.isValid());
-         for (vector<DimensionDescriptor>::const_iterator rowItr = selectedRows.begin();
-            rowItr != selectedRows.end(); ++rowItr)
-         {
-            DimensionDescriptor rowDim = *rowItr;
-
-            VERIFY(chipDa.isValid());
-            char* pChip = reinterpret_cast<char*>(chipDa->getRow());
-            unsigned int chipOffset = 0;
-            for (vector<DimensionDescriptor>::const_iterator colItr = selectedColumns.begin();
-               colItr != selectedColumns.end(); ++colItr)
-            {
-               DimensionDescriptor colDim = *colItr;
-
-               srcDa->toPixel(rowDim.getActiveNumber(), colDim.getActiveNumber());
-               VERIFY(srcDa.isValid());
-               char* pOrig = reinterpret_cast<char*>(srcDa->getColumn());
-               memcpy(pChip + chipOffset, pOrig, bytesPerElement);
-               chipOffset += bytesPerElement;
-            }
-            chipDa->nextRow();
-            pProgress->updateProgress(progressText, (step++ * 100)/steps, NORMAL);
-            if (abort)
-            {
-               return false;
-            }
-         }
-         ++chipBand;
-      }
-      copyCompleted = true;
-   }
-
-   return copyCompleted;
+   VERIFY(selectedRows.empty() == false && selectedColumns.empty() == false && selectedBands.empty() == false);
+
+   InterleaveFormatType interleave = pDescriptorChip->getInterleaveFormat();
+   pProgress->updateProgress("Copying data", 0, NORMAL);
+
+   // The pager of the chip and any conversion pager of this element are created on first access,
+   // so access both elements once before the copy threads share them.
+   FactoryResource<DataRequest> pSourceRequest;
+   pSourceRequest->setInterleaveFormat(interleave);
+   pSourceRequest->setRows(selectedRows.front(), selectedRows.front(), 1);
+   pSourceRequest->setBands(selectedBands.front(), selectedBands.front(), 1);
+   VERIFY(getDataAccessor(pSourceRequest.release()).isValid());
+
+   FactoryResource<DataRequest> pChipRequest;
+   pChipRequest->setInterleaveFormat(interleave);
+   pChipRequest->setWritable(true);
+   pChipRequest->setRows(pDescriptorChip->getActiveRow(0), pDescriptorChip->getActiveRow(0), 1);
+   pChipRequest->setBands(pDescriptorChip->getActiveBand(0), pDescriptorChip->getActiveBand(0), 1);
+   VERIFY(pRasterChip->getDataAccessor(pChipRequest.release()).isValid());
+
+   ChipCopyInput copyInput(dynamic_cast<const RasterElement*>(this), pRasterChip, selectedRows, selectedColumns,
+      selectedBands, abort);
+   ChipCopyOutput copyOutput;
+   mta::ProgressObjectReporter reporter("Copying data", pProgress);
+   mta::MultiThreadedAlgorithm<ChipCopyInput, ChipCopyOutput, ChipCopyThread> copyAlgorithm(
+      mta::getNumRequiredThreads(selectedRows.size()), copyInput, copyOutput, &reporter, mta::POLLED_REPORTS);
+
+   return copyAlgorithm.run() == mta::SUCCESS;
 }
 
 DataElement* RasterElementImp::copy(const string& name, DataElement* pParent) const
@@ -1299,6 +994,7 @@ bool RasterElementImp::setPager(RasterPager* pPager)
 
    //re-assign the pointers to hold onto the new plug-ins.
    mpPager = pPager;
+   clearConvertedPages();
 
    return true;
 }
@@ -1558,17 +1254,24 @@ void RasterElementImp::incrementDataAccessor(DataAccessorImpl& da)
    if (da.mpRasterPage != NULL)
    {
       da.mpRasterPager->releasePage(da.mpRasterPage);
+      if (da.mpRequest->getWritable())
+      {
+         clearConvertedPages(da);
+      }
    }
 
    //update the DataAccessor properties
-   da.mAccessorRow += da.mCurrentRow;
+   da.mAccessorRow += da.mCurrentRow * da.mRowStride;
    da.mCurrentRow = 0;
-   da.mAccessorColumn = da.mpRequest->getStartColumn().getActiveNumber();
+   if (da.mpRequest->getTiled() == false)
+   {
+      da.mAccessorColumn = da.mpRequest->getStartColumn().getActiveNumber();
+   }
    da.mAccessorBand = da.mpRequest->getStartBand().getActiveNumber();
 
    //get a new raster page loaded into memory,
    //the only thing different from the previous page that we requested
-   //should be the startRow.
+   //should be the startRow, or the startColumn for a tiled request.
 
    //request the same number of concurrentRows, cols, and bands
    //that we originally requested in the getDataAccessor()
@@ -1623,6 +1326,104 @@ void RasterElementImp::incrementDataAccessor(DataAccessorImpl& da)
    }
 
    da.mpRasterPage = pPage;
+   resetReadAhead(da);
+}
+
+void RasterElementImp::prefetchDataAccessor(DataAccessorImpl& da)
+{
+   // only read ahead once per page
+   da.mReadAheadRow = da.mConcurrentRows;
+   VERIFYNRV(da.mpRasterPager != NULL);
+
+   const RasterDataDescriptor* pDescriptor = dynamic_cast<const RasterDataDescriptor*>(getDataDescriptor());
+   VERIFYNRV(pDescriptor != NULL);
+
+   size_t nextRow = da.mAccessorRow + da.mConcurrentRows * da.mRowStride;
+   size_t nextColumn = da.mAccessorColumn;
+   if (da.mpRequest->getTiled())
+   {
+      // tiles are visited across the columns before moving down
+      da.getNextTile(nextRow, nextColumn);
+   }
+
+   // the pagers are only asked for rows of the request
+   if (nextRow > da.mpRequest->getStopRow().getActiveNumber())
+   {
+      return;
+   }
+
+   if (nextRow < pDescriptor->getRowCount() &&
+      nextColumn < pDescriptor->getColumnCount() &&
+      da.mAccessorBand < pDescriptor->getBandCount())
+   {
+      da.mpRasterPager->prefetchPage(da.mpRequest.get(),
+         pDescriptor->getActiveRow(nextRow),
+         pDescriptor->getActiveColumn(nextColumn),
+         pDescriptor->getActiveBand(da.mAccessorBand));
+   }
+}
+
+void RasterElementImp::clearConvertedPages()
+{
+   if (mpBipConverterPager != NULL)
+   {
+      mpBipConverterPager->clearCache();
+   }
+
+   if (mpBilConverterPager != NULL)
+   {
+      mpBilConverterPager->clearCache();
+   }
+
+   if (mpBsqConverterPager != NULL)
+   {
+      mpBsqConverterPager->clearCache();
+   }
+}
+
+void RasterElementImp::clearConvertedPages(const DataAccessorImpl& da)
+{
+   if (da.mpRasterPage == NULL)
+   {
+      return;
+   }
+
+   // the page may hold the rows between the requested rows
+   unsigned int startRow = static_cast<unsigned int>(da.mAccessorRow);
+   unsigned int rowCount = static_cast<unsigned int>(da.mConcurrentRows * da.mRowStride);
+   if (mpBipConverterPager != NULL)
+   {
+      mpBipConverterPager->clearCache(startRow, rowCount);
+   }
+
+   if (mpBilConverterPager != NULL)
+   {
+      mpBilConverterPager->clearCache(startRow, rowCount);
+   }
+
+   if (mpBsqConverterPager != NULL)
+   {
+      mpBsqConverterPager->clearCache(startRow, rowCount);
+   }
+}
+
+void RasterElementImp::resetReadAhead(DataAccessorImpl& da) const
+{
+   da.mReadAheadRow = da.mConcurrentRows;
+   if (da.isValid())
+   {
+      double threshold = RasterElement::getSettingReadAheadThreshold();
+      if (threshold >= 0.0 && threshold < 1.0)
+      {
+         // a tile may end before the rows of its page do
+         size_t rows = da.mConcurrentRows;
+         if (da.mpRequest->getTiled())
+         {
+            rows = std::min(rows, da.getTileRowCount());
+         }
+         da.mReadAheadRow = static_cast<size_t>(threshold * rows);
+      }
+   }
 }
 
 DataAccessor RasterElementImp::getDataAccessor(DataRequest *pRequestIn) const
@@ -1669,6 +1470,12 @@ DataAccessor RasterElementImp::getDataAccessor(DataRequest* pRequestIn)
       return DataAccessor(NULL, NULL);
    }
 
+   // a chip which shares the data of its source gets a copy of its own before the data is written
+   if (pRequest->getWritable() && copyChipViewData() == false)
+   {
+      return DataAccessor(NULL, NULL);
+   }
+
    unsigned int numColumns = pDescriptor->getColumnCount();
    unsigned int numBands = pDescriptor->getBandCount();
    unsigned int bytesPerElement = pDescriptor->getBytesPerElement();
@@ -1711,6 +1518,28 @@ DataAccessor RasterElementImp::getDataAccessor(DataRequest* pRequestIn)
       return DataAccessor(NULL, NULL);
    }
 
+   // a pager which cannot skip the rows of a strided request provides every row, and the accessor steps over
+   // the rows and columns between the requested ones
+   size_t rowStep = 1;
+   size_t columnStep = pRequest->getColumnStride();
+   if (pPager->getSupportedRequestVersion() < pRequest->getRequestVersion(pDescriptor) &&
+      (pRequest->getRowStride() != 1 || pRequest->getColumnStride() != 1))
+   {
+      rowStep = pRequest->getRowStride();
+      unsigned int rowSpan = pRequest->getStopRow().getActiveNumber() - pRequest->getStartRow().getActiveNumber() + 1;
+      unsigned int columnSpan =
+         pRequest->getStopColumn().getActiveNumber() - pRequest->getStartColumn().getActiveNumber() + 1;
+
+      FactoryResource<DataRequest> pUnstridedRequest(pRequest->copy());
+      pUnstridedRequest->setRowStride(1);
+      pUnstridedRequest->setColumnStride(1);
+      pUnstridedRequest->setRows(pRequest->getStartRow(), pRequest->getStopRow(),
+         std::min((pRequest->getConcurrentRows() - 1) * pRequest->getRowStride() + 1, rowSpan));
+      pUnstridedRequest->setColumns(pRequest->getStartColumn(), pRequest->getStopColumn(),
+         std::min((pRequest->getConcurrentColumns() - 1) * pRequest->getColumnStride() + 1, columnSpan));
+      pRequest = pUnstridedRequest;
+   }
+
    if (pPager->getSupportedRequestVersion() < pRequest->getRequestVersion(pDescriptor))
    {
       return DataAccessor(NULL, NULL);
@@ -1756,52 +1585,73 @@ DataAccessor RasterElementImp::getDataAccessor(DataRequest* pRequestIn)
             numPageRows, numPageInterlineBytes,
             numPageColumns, 
             numPageBands,
-            bytesPerElement, dynamic_cast<RasterElement*>(this));
+            bytesPerElement, dynamic_cast<RasterElement*>(this), rowStep, columnStep);
 
          pImpl->mpRasterPage = pPage;
          pImpl->mpRasterPager = pPager;
+         resetReadAhead(*pImpl);
 
          switch (pDescriptor->getDataType())
          {
          case INT1SBYTE:
             pImpl->mConvertToDoubleFunc = convert_s1byte_to_double;
             pImpl->mConvertToIntegerFunc = convert_s1byte_to_integer;
+            pImpl->mConvertRowToDoubleFunc = convert_row<signed char, double>;
+            pImpl->mConvertRowToFloatFunc = convert_row<signed char, float>;
             break;
          case INT1UBYTE:
             pImpl->mConvertToDoubleFunc = convert_u1byte_to_double;
             pImpl->mConvertToIntegerFunc = convert_u1byte_to_integer;
+            pImpl->mConvertRowToDoubleFunc = convert_row<unsigned char, double>;
+            pImpl->mConvertRowToFloatFunc = convert_row<unsigned char, float>;
             break;
          case INT2SBYTES:
             pImpl->mConvertToDoubleFunc = convert_s2byte_to_double;
             pImpl->mConvertToIntegerFunc = convert_s2byte_to_integer;
+            pImpl->mConvertRowToDoubleFunc = convert_row<signed short, double>;
+            pImpl->mConvertRowToFloatFunc = convert_row<signed short, float>;
             break;
          case INT2UBYTES:
             pImpl->mConvertToDoubleFunc = convert_u2byte_to_double;
             pImpl->mConvertToIntegerFunc = convert_u2byte_to_integer;
+            pImpl->mConvertRowToDoubleFunc = convert_row<unsigned short, double>;
+            pImpl->mConvertRowToFloatFunc = convert_row<unsigned short, float>;
             break;
          case INT4SBYTES:
             pImpl->mConvertToDoubleFunc = convert_s4byte_to_double;
             pImpl->mConvertToIntegerFunc = convert_s4byte_to_integer;
+            pImpl->mConvertRowToDoubleFunc = convert_row<signed int, double>;
+            pImpl->mConvertRowToFloatFunc = convert_row<signed int, float>;
             break;
          case INT4UBYTES:
             pImpl->mConvertToDoubleFunc = convert_u4byte_to_double;
             pImpl->mConvertToIntegerFunc = convert_u4byte_to_integer;
+            pImpl->mConvertRowToDoubleFunc = convert_row<unsigned int, double>;
+            pImpl->mConvertRowToFloatFunc = convert_row<unsigned int, float>;
             break;
          case INT4SCOMPLEX:
             pImpl->mConvertToDoubleFunc = convert_4complex_to_double;
             pImpl->mConvertToIntegerFunc = convert_4complex_to_integer;
+            pImpl->mConvertRowToDoubleFunc = convert_complex_row<IntegerComplex, double>;
+            pImpl->mConvertRowToFloatFunc = convert_complex_row<IntegerComplex, float>;
             break;
          case FLT8COMPLEX:
             pImpl->mConvertToDoubleFunc = convert_8complex_to_double;
             pImpl->mConvertToIntegerFunc = convert_8complex_to_integer;
+            pImpl->mConvertRowToDoubleFunc = convert_complex_row<FloatComplex, double>;
+            pImpl->mConvertRowToFloatFunc = convert_complex_row<FloatComplex, float>;
             break;
          case FLT4BYTES:
             pImpl->mConvertToDoubleFunc = convert_float_to_double;
             pImpl->mConvertToIntegerFunc = convert_float_to_integer;
+            pImpl->mConvertRowToDoubleFunc = convert_row<float, double>;
+            pImpl->mConvertRowToFloatFunc = convert_row<float, float>;
             break;
          case FLT8BYTES:
             pImpl->mConvertToDoubleFunc = convert_double_to_double;
             pImpl->mConvertToIntegerFunc = convert_double_to_integer;
+            pImpl->mConvertRowToDoubleFunc = convert_row<double, double>;
+            pImpl->mConvertRowToFloatFunc = convert_row<double, float>;
             break;
          default:
             delete pImpl;
@@ -1814,7 +1664,7 @@ DataAccessor RasterElementImp::getDataAccessor(DataRequest* pRequestIn)
    DataAccessorDeleter* pDeleter = NULL;
    if (pImpl != NULL)
    {
-      pDeleter = new RasterElementImp::Deleter;
+      pDeleter = new RasterElementImp::Deleter(this, pImpl->mpRequest->getWritable());
    }
 
    //return the DataAccessor
@@ -1939,6 +1789,142 @@ bool RasterElementImp::createInMemoryPager(void* pData, bool bOwner)
    return true;
 }
 
+bool RasterElementImp::createCompressedInMemoryPager()
+{
+   ExecutableResource pPlugin("Compressed In Memory Pager");
+   VERIFY(pPlugin->getPlugIn() != NULL);
+
+   RasterPager* pPager = dynamic_cast<RasterPager*>(pPlugin->getPlugIn());
+   VERIFY(pPager != NULL);
+
+   VERIFY(pPlugin->getInArgList().setPlugInArgValue("Raster Element", dynamic_cast<RasterElement*>(this)));
+
+   VERIFY(pPlugin->execute());
+
+   VERIFY(setPager(pPager));
+
+   pPlugin->releasePlugIn();
+
+   return true;
+}
+
+namespace
+{
+   bool getActiveNumbers(const vector<DimensionDescriptor>& dims, vector<unsigned int>& numbers)
+   {
+      numbers.clear();
+      numbers.reserve(dims.size());
+      for (vector<DimensionDescriptor>::const_iterator iter = dims.begin(); iter != dims.end(); ++iter)
+      {
+         if (iter->isActiveNumberValid() == false)
+         {
+            return false;
+         }
+         numbers.push_back(iter->getActiveNumber());
+      }
+
+      return true;
+   }
+}
+
+bool RasterElementImp::createChipViewPager(const RasterElement* pSource,
+                                           const vector<DimensionDescriptor>& selectedRows,
+                                           const vector<DimensionDescriptor>& selectedColumns,
+                                           const vector<DimensionDescriptor>& selectedBands)
+{
+   VERIFY(pSource != NULL);
+
+   vector<unsigned int> rows;
+   vector<unsigned int> columns;
+   vector<unsigned int> bands;
+   VERIFY(getActiveNumbers(selectedRows, rows));
+   VERIFY(getActiveNumbers(selectedColumns, columns));
+   VERIFY(getActiveNumbers(selectedBands, bands));
+
+   ExecutableResource pPlugin("Chip View Pager");
+   VERIFY(pPlugin->getPlugIn() != NULL);
+
+   RasterPager* pPager = dynamic_cast<RasterPager*>(pPlugin->getPlugIn());
+   VERIFY(pPager != NULL);
+
+   VERIFY(pPlugin->getInArgList().setPlugInArgValue("Raster Element", dynamic_cast<RasterElement*>(this)));
+   VERIFY(pPlugin->getInArgList().setPlugInArgValue("Source Element", const_cast<RasterElement*>(pSource)));
+   VERIFY(pPlugin->getInArgList().setPlugInArgValue("Rows", &rows));
+   VERIFY(pPlugin->getInArgList().setPlugInArgValue("Columns", &columns));
+   VERIFY(pPlugin->getInArgList().setPlugInArgValue("Bands", &bands));
+
+   VERIFY(pPlugin->execute());
+
+   VERIFY(setPager(pPager));
+
+   pPlugin->releasePlugIn();
+
+   // the data must be copied before the source goes away
+   mpChipViewSource.reset(const_cast<RasterElement*>(pSource));
+
+   return true;
+}
+
+bool RasterElementImp::copyChipViewData()
+{
+   ChipViewPager* pViewPager = dynamic_cast<ChipViewPager*>(mpPager);
+   if (pViewPager == NULL)
+   {
+      return true;
+   }
+
+   const RasterElement* pSource = pViewPager->getSource();
+   VERIFY(pSource != NULL);
+   const RasterDataDescriptor* pSourceDescriptor =
+      dynamic_cast<const RasterDataDescriptor*>(pSource->getDataDescriptor());
+   VERIFY(pSourceDescriptor != NULL);
+
+   vector<DimensionDescriptor> rows;
+   vector<DimensionDescriptor> columns;
+   vector<DimensionDescriptor> bands;
+   for (vector<unsigned int>::const_iterator iter = pViewPager->getRows().begin();
+      iter != pViewPager->getRows().end(); ++iter)
+   {
+      rows.push_back(pSourceDescriptor->getActiveRow(*iter));
+   }
+   for (vector<unsigned int>::const_iterator iter = pViewPager->getColumns().begin();
+      iter != pViewPager->getColumns().end(); ++iter)
+   {
+      columns.push_back(pSourceDescriptor->getActiveColumn(*iter));
+   }
+   for (vector<unsigned int>::const_iterator iter = pViewPager->getBands().begin();
+      iter != pViewPager->getBands().end(); ++iter)
+   {
+      bands.push_back(pSourceDescriptor->getActiveBand(*iter));
+   }
+
+   // The view pager is not destroyed, since accessors created before the copy may still use its pages.
+   mCubePointerAccessor = DataAccessor(NULL, NULL);
+   mpPager = NULL;
+
+   bool abort = false;
+   if (createDefaultPager() == false ||
+      pSource->copyDataToChip(dynamic_cast<RasterElement*>(this), rows, columns, bands, abort) == false)
+   {
+      if (mpPager != NULL)
+      {
+         Service<PlugInManagerServices>()->destroyPlugIn(dynamic_cast<PlugIn*>(mpPager));
+      }
+
+      mpPager = pViewPager;
+      return false;
+   }
+
+   mpChipViewPager = pViewPager;
+   mpChipViewSource.reset(NULL);
+   return true;
+}
+
+void RasterElementImp::chipViewSourceDeleted(Subject& subject, const string& signal, const boost::any& value)
+{
+   VERIFYNRV(copyChipViewData());
+}
+
 bool RasterElementImp::createDefaultPager()
 {
    if (mpPager != NULL)
@@ -1953,6 +1939,11 @@ bool RasterElementImp::createDefaultPager()
    {
    case IN_MEMORY:
       {
+         if (RasterElement::getSettingCompressInMemoryData())
+         {
+            return createCompressedInMemoryPager();
+         }
+
          uint64_t numRows = pDescriptor->getRowCount();
          uint64_t numColumns = pDescriptor->getColumnCount();
          uint64_t numBands = pDescriptor->getBandCount();
@@ -1991,7 +1982,10 @@ void *RasterElementImp::getRawData()
       const RasterDataDescriptor* pDescriptor = dynamic_cast<const RasterDataDescriptor*>(getDataDescriptor());
       VERIFYRV(pDescriptor != NULL, NULL);
 
-      if (pDescriptor->getProcessingLocation() == IN_MEMORY)
+      // The raw data can be written, so a chip which shares the data of its source gets a copy first.
+      // The blocks of compressed data are only decompressed while they are accessed.
+      if (pDescriptor->getProcessingLocation() == IN_MEMORY && copyChipViewData() &&
+         dynamic_cast<CompressedInMemoryPager*>(mpPager) == NULL)
       {
          unsigned int numRows = pDescriptor->getRowCount();
          mCubePointerAccessor = getDataAccessor();
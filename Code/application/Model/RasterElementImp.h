@@ -10,6 +10,7 @@
 #ifndef RASTERELEMENTIMP_H
 #define RASTERELEMENTIMP_H
 
+#include "AttachmentPtr.h"
 #include "ComplexData.h"
 #include "DataAccessor.h"
 #include "DataElementImp.h"
@@ -22,6 +23,10 @@
 #include <boost/any.hpp>
 #include <vector>
 
+class ConvertToBilPager;
+class ConvertToBipPager;
+class ConvertToBsqPager;
+
 class RasterElementImp : public DataElementImp
 {
 public:
@@ -35,7 +40,16 @@ public:
    virtual DataAccessor getDataAccessor(DataRequest* pRequestIn = NULL) const;
 
    virtual void incrementDataAccessor(DataAccessorImpl &da);
+   virtual void prefetchDataAccessor(DataAccessorImpl &da);
    virtual void updateData();
+
+   /**
+    * Get whether the data has been updated since the element was created.
+    *
+    * @return True if updateData() has been called, in which case the data may
+    *         no longer match the file from which it was loaded.
+    */
+   bool isDataUpdated() const;
    virtual uint64_t sanitizeData(double value = 0.0);
 
 
@@ -43,11 +57,16 @@ public:
    const RasterElement* getTerrain() const;
 
    Statistics* getStatistics(DimensionDescriptor band) const;
+   void calculateStatistics(const std::vector<DimensionDescriptor>& bands, ComplexComponent component) const;
 
    RasterElement *createChip(DataElement *pParent, const std::string &appendName,
       const std::vector<DimensionDescriptor>& selectedRows,
       const std::vector<DimensionDescriptor>& selectedColumns,
       const std::vector<DimensionDescriptor>& selectedBands = std::vector<DimensionDescriptor>()) const;
+   RasterElement* createChipView(DataElement* pParent, const std::string& appendName,
+      const std::vector<DimensionDescriptor>& selectedRows,
+      const std::vector<DimensionDescriptor>& selectedColumns,
+      const std::vector<DimensionDescriptor>& selectedBands = std::vector<DimensionDescriptor>()) const;
    DataElement *copy(const std::string &name, DataElement *pParent) const;
    virtual RasterElement* copyShallow(const std::string& name, DataElement* pParent) const;
 
@@ -72,7 +91,13 @@ public:
 
    class Deleter : public DataAccessorDeleter
    {
+   public:
+      Deleter(RasterElementImp* pElement, bool writable);
       void operator()(DataAccessorImpl* pDataAccessor);
+
+   private:
+      RasterElementImp* mpElement;
+      bool mWritable;
    };
 
    const void *getRawData() const;
@@ -97,14 +122,19 @@ public:
 protected:
    void updateStatisticsBadValues(Subject& subject, const std::string& signal, const boost::any& value);
    void updateDescriptorBadValues(Subject& subject, const std::string& signal, const boost::any& value);
+   void chipViewSourceDeleted(Subject& subject, const std::string& signal, const boost::any& value);
 
    RasterElement* createChipInternal(DataElement* pParent, const std::string& name,
       const std::vector<DimensionDescriptor>& selectedRows,
       const std::vector<DimensionDescriptor>& selectedColumns,
       const std::vector<DimensionDescriptor>& selectedBands = std::vector<DimensionDescriptor>(),
-      bool copyRasterData = true) const;
+      bool copyRasterData = true, bool shareRasterData = false) const;
 
    bool createMemoryMappedPager(bool bUseDataDescriptor);
+   bool createChipViewPager(const RasterElement* pSource, const std::vector<DimensionDescriptor>& selectedRows,
+      const std::vector<DimensionDescriptor>& selectedColumns, const std::vector<DimensionDescriptor>& selectedBands);
+   bool copyChipViewData();
+   bool createCompressedInMemoryPager();
 
    bool copyDataToChip(RasterElement *pRasterChip, 
       const std::vector<DimensionDescriptor> &selectedRows,
@@ -112,18 +142,6 @@ protected:
       const std::vector<DimensionDescriptor> &selectedBands,
       bool &abort, Progress *pProgress = NULL) const;
 
-   bool copyDataBip(RasterElement* pChipElement, const std::vector<DimensionDescriptor>& selectedRows,
-      const std::vector<DimensionDescriptor>& selectedColumns, const std::vector<DimensionDescriptor>& selectedBands,
-      bool& abort, Progress* pProgress) const;
-
-   bool copyDataBil(RasterElement* pChipElement, const std::vector<DimensionDescriptor>& selectedRows,
-      const std::vector<DimensionDescriptor>& selectedColumns, const std::vector<DimensionDescriptor>& selectedBands,
-      bool& abort, Progress* pProgress) const;
-
-   bool copyDataBsq(RasterElement* pChipElement, const std::vector<DimensionDescriptor>& selectedRows,
-      const std::vector<DimensionDescriptor>& selectedColumns, const std::vector<DimensionDescriptor>& selectedBands,
-      bool& abort, Progress* pProgress) const;
-
    /**
     * Appends to the basename of name.
     *
@@ -175,19 +193,41 @@ protected:
 private:
    RasterElementImp(const RasterElementImp& rhs);
    RasterElementImp& operator=(const RasterElementImp& rhs);
+   void resetReadAhead(DataAccessorImpl& da) const;
+
+   /**
+    * Discards the data held by the interleave conversion pagers.
+    *
+    * This is called whenever the data may have been written, since the
+    * converted data is then out of date.
+    */
+   void clearConvertedPages();
+
+   /**
+    * Discards the converted data of the rows of the current page of a
+    * writable DataAccessor, once the page has been written.
+    */
+   void clearConvertedPages(const DataAccessorImpl& da);
+
    SafePtr<RasterElement> mpTerrain;
    std::map<DimensionDescriptor, StatisticsImp*> mStatistics;
 
    std::string mTempFilename;
 
    RasterPager* mpPager;
-   RasterPager* mpBipConverterPager;
-   RasterPager* mpBilConverterPager;
-   RasterPager* mpBsqConverterPager;
+   ConvertToBipPager* mpBipConverterPager;
+   ConvertToBilPager* mpBilConverterPager;
+   ConvertToBsqPager* mpBsqConverterPager;
+
+   // The source of a chip which shares its data, and the pager which shared it
+   // once the data has been copied, kept for the accessors still using its pages.
+   AttachmentPtr<RasterElement> mpChipViewSource;
+   RasterPager* mpChipViewPager;
 
    DataAccessor mCubePointerAccessor;
 
    mutable bool mModified;
+   bool mDataUpdated;
 
    Georeference* mpGeoPlugin;
 };
@@ -214,6 +254,10 @@ private:
    { \
       return impClass::incrementDataAccessor(accessor); \
    } \
+   void prefetchDataAccessor(DataAccessorImpl& accessor) \
+   { \
+      return impClass::prefetchDataAccessor(accessor); \
+   } \
    void updateData() \
    { \
       return impClass::updateData(); \
@@ -238,6 +282,11 @@ private:
    { \
       return impClass::getStatistics(pBand); \
    } \
+   void calculateStatistics(const std::vector<DimensionDescriptor>& bands, \
+      ComplexComponent component = COMPLEX_MAGNITUDE) const \
+   { \
+      return impClass::calculateStatistics(bands, component); \
+   } \
    RasterElement *createChip(DataElement *pParent, \
       const std::string &appendName, \
       const std::vector<DimensionDescriptor> &selectedRows, \
@@ -246,6 +295,14 @@ private:
    { \
       return impClass::createChip(pParent, appendName, selectedRows, selectedColumns, selectedBands); \
    } \
+   RasterElement* createChipView(DataElement* pParent, \
+      const std::string& appendName, \
+      const std::vector<DimensionDescriptor>& selectedRows, \
+      const std::vector<DimensionDescriptor>& selectedColumns, \
+      const std::vector<DimensionDescriptor>& selectedBands = std::vector<DimensionDescriptor>()) const \
+   { \
+      return impClass::createChipView(pParent, appendName, selectedRows, selectedColumns, selectedBands); \
+   } \
    bool createTemporaryFile() \
    { \
       return impClass::createTemporaryFile(); \
@@ -0,0 +1,290 @@
+/*
+ * The information in this file is
+ * Copyright(c) 2007 Ball Aerospace & Technologies Corporation
+ * and is subject to the terms and conditions of the
+ * GNU Lesser General Public License Version 2.1
+ * The license text is available from   
+ * http://www.gnu.org/licenses/lgpl.html
+ */
+
+#include <QtCore/QByteArray>
+#include <QtCore/QCryptographicHash>
+#include <QtCore/QDateTime>
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QStringList>
+
+#include "AppVerify.h"
+#include "BadValues.h"
+#include "ConfigurationSettings.h"
+#include "FileDescriptor.h"
+#include "Filename.h"
+#include "FileResource.h"
+#include "RasterDataDescriptor.h"
+#include "RasterElementImp.h"
+#include "RasterFileDescriptor.h"
+#include "Statistics.h"
+#include "StatisticsCache.h"
+#include "StringUtilities.h"
+#include "XercesIncludes.h"
+#include "xmlreader.h"
+#include "xmlwriter.h"
+
+#include <sstream>
+
+XERCES_CPP_NAMESPACE_USE
+
+StatisticsCache::Entry::Entry() :
+   mMinimum(0.0),
+   mMaximum(0.0),
+   mAverage(0.0),
+   mStandardDeviation(0.0)
+{}
+
+StatisticsCache::StatisticsCache(const RasterElementImp* pElement, const std::vector<DimensionDescriptor>& bands,
+                                 ComplexComponent component, const BadValues* pBadValues, int resolution)
+{
+   if (pElement == NULL || pElement->isDataUpdated())
+   {
+      return;
+   }
+
+   const Filename* pCachePath = ConfigurationSettings::getSettingStatisticsCachePath();
+   if (pCachePath == NULL || pCachePath->getFullPathAndName().empty())
+   {
+      return;
+   }
+
+   const RasterDataDescriptor* pDescriptor = dynamic_cast<const RasterDataDescriptor*>(pElement->getDataDescriptor());
+   if (pDescriptor == NULL)
+   {
+      return;
+   }
+
+   const RasterFileDescriptor* pFileDescriptor =
+      dynamic_cast<const RasterFileDescriptor*>(pDescriptor->getFileDescriptor());
+   if (pFileDescriptor == NULL)
+   {
+      return;
+   }
+
+   QFileInfo fileInfo(QString::fromStdString(pFileDescriptor->getFilename().getFullPathAndName()));
+   if (fileInfo.isFile() == false)
+   {
+      return;
+   }
+
+   // The statistics are only cached when every row, column and band of the data is in the file
+   std::string rows;
+   std::string columns;
+   std::string bandNumbers;
+   if (getNumbers(pDescriptor->getRows(), rows) == false || getNumbers(pDescriptor->getColumns(), columns) == false ||
+      getNumbers(bands, bandNumbers) == false)
+   {
+      return;
+   }
+
+   // The file layout is part of the key so that re-importing the same file with different
+   // byte order, interleave or header sizes does not pick up the statistics of the other import
+   std::ostringstream key;
+   key << fileInfo.absoluteFilePath().toStdString() << "|" << pFileDescriptor->getDatasetLocation() << "|" <<
+      fileInfo.size() << "|" << fileInfo.lastModified().toTime_t() << "|" <<
+      StringUtilities::toXmlString(pDescriptor->getDataType()) << "|endian=" <<
+      StringUtilities::toXmlString(pFileDescriptor->getEndian()) << "|interleave=" <<
+      StringUtilities::toXmlString(pFileDescriptor->getInterleaveFormat()) << "|header=" <<
+      pFileDescriptor->getHeaderBytes() << "|trailer=" << pFileDescriptor->getTrailerBytes() << "|preline=" <<
+      pFileDescriptor->getPrelineBytes() << "|postline=" << pFileDescriptor->getPostlineBytes() << "|preband=" <<
+      pFileDescriptor->getPrebandBytes() << "|postband=" << pFileDescriptor->getPostbandBytes() << "|rows=" <<
+      rows << "|columns=" << columns << "|bands=" << bandNumbers << "|component=" <<
+      StringUtilities::toXmlString(component) << "|badValues=" <<
+      (pBadValues == NULL ? std::string() : pBadValues->getBadValuesString()) << "|resolution=" << resolution;
+   mKey = key.str();
+
+   QDir directory(QString::fromStdString(pCachePath->getFullPathAndName()));
+   QByteArray hash = QCryptographicHash::hash(QByteArray(mKey.c_str(), static_cast<int>(mKey.size())),
+      QCryptographicHash::Sha1).toHex();
+   mDirectory = directory.absolutePath().toStdString();
+   mFilename = directory.absoluteFilePath(QString::fromLatin1(hash) + ".xml").toStdString();
+}
+
+bool StatisticsCache::isValid() const
+{
+   return mFilename.empty() == false;
+}
+
+bool StatisticsCache::read(Entry& entry) const
+{
+   // Check for the file first so that a missing entry is not reported as a parse error
+   if (isValid() == false || QFileInfo(QString::fromStdString(mFilename)).isFile() == false)
+   {
+      return false;
+   }
+
+   XmlReader xmlReader(NULL, false);
+   DOMDocument* pDocument = xmlReader.parse(mFilename);
+   if (pDocument == NULL)
+   {
+      return false;
+   }
+
+   DOMElement* pRootElement = pDocument->getDocumentElement();
+   if (pRootElement == NULL || A(pRootElement->getAttribute(X("key"))) != mKey)
+   {
+      return false;
+   }
+
+   Entry values;
+   for (DOMNode* pNode = pRootElement->getFirstChild(); pNode != NULL; pNode = pNode->getNextSibling())
+   {
+      if (pNode->getNodeType() != DOMNode::ELEMENT_NODE)
+      {
+         continue;
+      }
+
+      DOMElement* pElement = static_cast<DOMElement*>(pNode);
+      if (XMLString::equals(pNode->getNodeName(), X("minimum")))
+      {
+         values.mMinimum = StringUtilities::fromXmlString<double>(A(pElement->getAttribute(X("value"))));
+      }
+      else if (XMLString::equals(pNode->getNodeName(), X("maximum")))
+      {
+         values.mMaximum = StringUtilities::fromXmlString<double>(A(pElement->getAttribute(X("value"))));
+      }
+      else if (XMLString::equals(pNode->getNodeName(), X("average")))
+      {
+         values.mAverage = StringUtilities::fromXmlString<double>(A(pElement->getAttribute(X("value"))));
+      }
+      else if (XMLString::equals(pNode->getNodeName(), X("stddev")))
+      {
+         values.mStandardDeviation = StringUtilities::fromXmlString<double>(A(pElement->getAttribute(X("value"))));
+      }
+      else if (XMLString::equals(pNode->getNodeName(), X("percentile")))
+      {
+         XmlReader::StrToVector<double, XmlReader::StringStreamAssigner<double> >(values.mPercentiles,
+            pElement->getTextContent());
+      }
+      else if (XMLString::equals(pNode->getNodeName(), X("center")))
+      {
+         XmlReader::StrToVector<double, XmlReader::StringStreamAssigner<double> >(values.mBinCenters,
+            pElement->getTextContent());
+      }
+      else if (XMLString::equals(pNode->getNodeName(), X("histogram")))
+      {
+         XmlReader::StrToVector<unsigned int, XmlReader::StringStreamAssigner<unsigned int> >(values.mBinCounts,
+            pElement->getTextContent());
+      }
+   }
+
+   if (values.mPercentiles.size() != 1001 || values.mBinCenters.size() != 256 || values.mBinCounts.size() != 256)
+   {
+      return false;
+   }
+
+   entry = values;
+   return true;
+}
+
+bool StatisticsCache::write(const Entry& entry) const
+{
+   if (isValid() == false || QDir().mkpath(QString::fromStdString(mDirectory)) == false)
+   {
+      return false;
+   }
+
+   {
+      FileResource pFile(mFilename.c_str(), "wt");
+      if (pFile.get() == NULL)
+      {
+         return false;
+      }
+
+      try
+      {
+         XMLWriter xmlWriter("StatisticsCacheEntry");
+         xmlWriter.addAttr("key", mKey);
+
+         xmlWriter.pushAddPoint(xmlWriter.addElement("minimum"));
+         xmlWriter.addAttr("value", entry.mMinimum);
+         xmlWriter.popAddPoint();
+         xmlWriter.pushAddPoint(xmlWriter.addElement("maximum"));
+         xmlWriter.addAttr("value", entry.mMaximum);
+         xmlWriter.popAddPoint();
+         xmlWriter.pushAddPoint(xmlWriter.addElement("average"));
+         xmlWriter.addAttr("value", entry.mAverage);
+         xmlWriter.popAddPoint();
+         xmlWriter.pushAddPoint(xmlWriter.addElement("stddev"));
+         xmlWriter.addAttr("value", entry.mStandardDeviation);
+         xmlWriter.popAddPoint();
+         xmlWriter.pushAddPoint(xmlWriter.addElement("percentile"));
+         xmlWriter.addText(entry.mPercentiles);
+         xmlWriter.popAddPoint();
+         xmlWriter.pushAddPoint(xmlWriter.addElement("center"));
+         xmlWriter.addText(entry.mBinCenters);
+         xmlWriter.popAddPoint();
+         xmlWriter.pushAddPoint(xmlWriter.addElement("histogram"));
+         xmlWriter.addText(entry.mBinCounts);
+         xmlWriter.popAddPoint();
+
+         xmlWriter.writeToFile(pFile);
+      }
+      catch (const XmlBase::XmlException&)
+      {
+         pFile.setDeleteOnClose(true);
+         return false;
+      }
+   }
+
+   removeOldEntries();
+   return true;
+}
+
+bool StatisticsCache::getNumbers(const std::vector<DimensionDescriptor>& dimensions, std::string& numbers)
+{
+   // Write the on-disk numbers as runs of consecutive numbers, e.g. "0-99,200-299"
+   std::ostringstream stream;
+   for (std::vector<DimensionDescriptor>::size_type i = 0; i < dimensions.size(); )
+   {
+      if (dimensions[i].isOnDiskNumberValid() == false)
+      {
+         return false;
+      }
+
+      unsigned int start = dimensions[i].getOnDiskNumber();
+      unsigned int stop = start;
+      for (++i; i < dimensions.size() && dimensions[i].isOnDiskNumberValid() &&
+         dimensions[i].getOnDiskNumber() == stop + 1; ++i)
+      {
+         ++stop;
+      }
+
+      stream << (stream.tellp() > 0 ? "," : "") << start << "-" << stop;
+   }
+
+   numbers = stream.str();
+   return true;
+}
+
+void StatisticsCache::removeOldEntries() const
+{
+   unsigned int cacheSize = Statistics::getSettingCacheSize();
+   if (cacheSize == 0)
+   {
+      return;
+   }
+
+   const qint64 maxBytes = static_cast<qint64>(cacheSize) * 1024 * 1024;
+   qint64 totalBytes = 0;
+
+   // The entries are sorted from the most recently written
+   QDir directory(QString::fromStdString(mDirectory));
+   QFileInfoList entries = directory.entryInfoList(QStringList("*.xml"), QDir::Files, QDir::Time);
+   for (QFileInfoList::const_iterator iter = entries.begin(); iter != entries.end(); ++iter)
+   {
+      totalBytes += iter->size();
+      if (totalBytes > maxBytes)
+      {
+         QFile::remove(iter->absoluteFilePath());
+      }
+   }
+}
@@ -0,0 +1,75 @@
+/*
+ * The information in this file is
+ * Copyright(c) 2007 Ball Aerospace & Technologies Corporation
+ * and is subject to the terms and conditions of the
+ * GNU Lesser General Public License Version 2.1
+ * The license text is available from   
+ * http://www.gnu.org/licenses/lgpl.html
+ */
+
+#ifndef STATISTICSCACHE_H
+#define STATISTICSCACHE_H
+
+#include "ComplexData.h"
+#include "DimensionDescriptor.h"
+
+#include <string>
+#include <vector>
+
+class BadValues;
+class RasterElementImp;
+
+/**
+ * Keeps the statistics of raster data read from a file between sessions.
+ *
+ * Each entry is stored in its own file in the directory given by
+ * ConfigurationSettings::getSettingStatisticsCachePath().  Entries are keyed
+ * on the path, size and modification time of the file, the dataset within the
+ * file, the rows and columns of the element in the file, and the bands,
+ * component, bad values and resolution of the statistics.  The statistics of
+ * an element which is not backed by a file, or whose data has been updated
+ * since it was loaded, are not cached.
+ *
+ * The oldest entries are removed once the directory holds more than
+ * Statistics::getSettingCacheSize() megabytes.
+ */
+class StatisticsCache
+{
+public:
+   struct Entry
+   {
+      Entry();
+
+      double mMinimum;
+      double mMaximum;
+      double mAverage;
+      double mStandardDeviation;
+      std::vector<double> mPercentiles;      // 1001 values
+      std::vector<double> mBinCenters;       // 256 values
+      std::vector<unsigned int> mBinCounts;  // 256 values
+   };
+
+   StatisticsCache(const RasterElementImp* pElement, const std::vector<DimensionDescriptor>& bands,
+      ComplexComponent component, const BadValues* pBadValues, int resolution);
+
+   /**
+    * Get whether the statistics can be cached.
+    *
+    * @return True if the element is backed by an unmodified file and the cache
+    *         directory is set.
+    */
+   bool isValid() const;
+
+   bool read(Entry& entry) const;
+   bool write(const Entry& entry) const;
+
+private:
+   static bool getNumbers(const std::vector<DimensionDescriptor>& dimensions, std::string& numbers);
+   void removeOldEntries() const;
+
+   std::string mKey;
+   std::string mDirectory;
+   std::string mFilename;
+};
+
+#endif
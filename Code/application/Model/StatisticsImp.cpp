@@ -8,7 +8,9 @@
  */
 
 #include "AoiElement.h"
+#include "ApplicationServices.h"
 #include "AppVerify.h"
+#include "BackgroundStatistics.h"
 #include "BitMaskIterator.h"
 #include "DataAccessor.h"
 #include "DataAccessorImpl.h"
@@ -19,6 +21,7 @@
 #include "RasterElement.h"
 #include "RasterElementImp.h"
 #include "RasterDataDescriptor.h"
+#include "StatisticsCache.h"
 #include "StatisticsImp.h"
 #include "switchOnEncoding.h"
 #include "UtilityServicesImp.h"
@@ -29,9 +32,273 @@
 #include <algorithm>
 #include <limits>
 #include <numeric>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define STATISTICS_SSE2
+#include <emmintrin.h>
+#endif
 using namespace mta;
 XERCES_CPP_NAMESPACE_USE
 
+namespace
+{
+   bool isIntegerData(EncodingType encoding, ComplexComponent component)
+   {
+      if ((encoding == FLT4BYTES) || (encoding == FLT8COMPLEX) || (encoding == FLT8BYTES) ||
+         ((encoding == INT4SCOMPLEX) && (component == COMPLEX_MAGNITUDE)) ||
+         ((encoding == INT4SCOMPLEX) && (component == COMPLEX_PHASE)))
+      {
+         return false;
+      }
+
+      return true;
+   }
+
+   double getHistogramBinFactor(double maximum, double minimum)
+   {
+      if (maximum != minimum)
+      {
+         return 0.999999999 * (HISTOGRAM_SIZE) / (maximum - minimum);
+      }
+
+      return 0.0;
+   }
+
+   void computeMoments(double sum, double sumSquared, unsigned int count, double& average,
+      double& standardDeviation)
+   {
+      average = 0.0;
+      standardDeviation = 0.0;
+      if (count > 0)
+      {
+         average = sum / count;
+      }
+
+      if (count > 1)
+      {
+         // the fabs() on the next line prevents roundoff error from giving sqrt a negative
+         // when every pixel has the same value
+         double numerator = fabs(count * sumSquared - sum * sum);
+         standardDeviation = sqrt((numerator / count) / (count - 1));
+      }
+   }
+
+   void setResolutionMask(BitMask* pMask, int rowCount, int columnCount, int resolution)
+   {
+      if (resolution == 1)
+      {
+         pMask->setRegion(0, 0, columnCount - 1, rowCount - 1, DRAW);
+         return;
+      }
+
+      // Increase the size of the bitmask bounding box to the full size so that the bitmask does
+      // not need to resize itself for every pixel that is set
+      pMask->setPixel(0, 0, true);
+      pMask->setPixel(columnCount - 1, rowCount - 1, true);
+      pMask->setPixel(0, 0, false);
+      pMask->setPixel(columnCount - 1, rowCount - 1, false);
+
+      for (int i = 0; i < rowCount * columnCount; i += resolution)
+      {
+         int col = i % columnCount;
+         int row = (i - col) / columnCount;
+         pMask->setPixel(col, row, true);
+      }
+   }
+
+   /**
+    * Adds every step-th value of a span to the moments, except for the values inside (lower, upper)
+    * when MASKED.  Masked values are replaced with neutral values instead of being skipped, so the
+    * loop has no branches on the data and runs over two values at a time with SSE2.
+    */
+   template<bool MASKED>
+   void accumulateSpan(const double* pValues, size_t count, size_t step, double lower, double upper,
+      double& minimum, double& maximum, double& sum, double& sumSquared, unsigned int& valueCount)
+   {
+      size_t i = 0;
+#if defined(STATISTICS_SSE2)
+      if (step == 1 && count >= 2)
+      {
+         const __m128d vLower = _mm_set1_pd(lower);
+         const __m128d vUpper = _mm_set1_pd(upper);
+         const __m128d vOne = _mm_set1_pd(1.0);
+         const __m128d vLargest = _mm_set1_pd(std::numeric_limits<double>::max());
+         const __m128d vSmallest = _mm_set1_pd(-std::numeric_limits<double>::max());
+         __m128d vMinimum = _mm_set1_pd(minimum);
+         __m128d vMaximum = _mm_set1_pd(maximum);
+         __m128d vSum = _mm_setzero_pd();
+         __m128d vSumSquared = _mm_setzero_pd();
+         __m128d vCount = _mm_setzero_pd();
+         for (; i + 1 < count; i += 2)
+         {
+            __m128d vValues = _mm_loadu_pd(pValues + i);
+            __m128d vGood = vValues;
+            __m128d vLow = vValues;
+            __m128d vHigh = vValues;
+            __m128d vWeight = vOne;
+            if (MASKED)
+            {
+               __m128d vBad = _mm_and_pd(_mm_cmpgt_pd(vValues, vLower), _mm_cmplt_pd(vValues, vUpper));
+               vGood = _mm_andnot_pd(vBad, vValues);
+               vLow = _mm_or_pd(vGood, _mm_and_pd(vBad, vLargest));
+               vHigh = _mm_or_pd(vGood, _mm_and_pd(vBad, vSmallest));
+               vWeight = _mm_andnot_pd(vBad, vOne);
+            }
+
+            // the new values are the first operand so that NaN values leave the extremes unchanged
+            vMinimum = _mm_min_pd(vLow, vMinimum);
+            vMaximum = _mm_max_pd(vHigh, vMaximum);
+            vSum = _mm_add_pd(vSum, vGood);
+            vSumSquared = _mm_add_pd(vSumSquared, _mm_mul_pd(vGood, vGood));
+            vCount = _mm_add_pd(vCount, vWeight);
+         }
+
+         double lanes[2];
+         _mm_storeu_pd(lanes, vMinimum);
+         minimum = std::min(lanes[0], lanes[1]);
+         _mm_storeu_pd(lanes, vMaximum);
+         maximum = std::max(lanes[0], lanes[1]);
+         _mm_storeu_pd(lanes, vSum);
+         sum += lanes[0] + lanes[1];
+         _mm_storeu_pd(lanes, vSumSquared);
+         sumSquared += lanes[0] + lanes[1];
+         _mm_storeu_pd(lanes, vCount);
+         valueCount += static_cast<unsigned int>(lanes[0] + lanes[1]);
+      }
+#endif
+
+      for (; i < count; ++i)
+      {
+         double value = pValues[i * step];
+         bool bad = MASKED && ((value > lower) & (value < upper));
+         double good = bad ? 0.0 : value;
+         minimum = std::min(minimum, bad ? minimum : value);
+         maximum = std::max(maximum, bad ? maximum : value);
+         sum += good;
+         sumSquared += good * good;
+         valueCount += bad ? 0 : 1;
+      }
+   }
+
+   /**
+    * Adds every step-th value of a span to the moments.  pBadValues is NULL when there are no bad values,
+    * and the bad values are the single range (lower, upper) when singleRange is true.
+    */
+   void accumulateSpan(const double* pValues, size_t count, size_t step, const BadValues* pBadValues,
+      bool singleRange, double lower, double upper, double& minimum, double& maximum, double& sum,
+      double& sumSquared, unsigned int& valueCount)
+   {
+      if (pBadValues == NULL)
+      {
+         accumulateSpan<false>(pValues, count, step, lower, upper, minimum, maximum, sum, sumSquared, valueCount);
+      }
+      else if (singleRange)
+      {
+         accumulateSpan<true>(pValues, count, step, lower, upper, minimum, maximum, sum, sumSquared, valueCount);
+      }
+      else
+      {
+         for (size_t i = 0; i < count; ++i)
+         {
+            const double* pValue = pValues + i * step;
+            if (!pBadValues->isBadValue(*pValue))
+            {
+               accumulateSpan<false>(pValue, 1, 1, lower, upper, minimum, maximum, sum, sumSquared, valueCount);
+            }
+         }
+      }
+   }
+
+   void addToHistogram(const double* pValues, size_t count, size_t step, const BadValues* pBadValues,
+      bool singleRange, double lower, double upper, AdaptiveHistogram& histogram)
+   {
+      for (size_t i = 0; i < count; ++i)
+      {
+         double value = pValues[i * step];
+         if (pBadValues == NULL || (singleRange ? !(value > lower && value < upper) : !pBadValues->isBadValue(value)))
+         {
+            histogram.add(value);
+         }
+      }
+   }
+
+   /**
+    * Counts every step-th value of a span in the bins which start at minimum, except for the values inside
+    * (lower, upper) when MASKED, and returns the number of values counted.  Masked values add zero to their
+    * bin instead of being skipped.
+    */
+   template<bool MASKED>
+   unsigned int binSpan(const double* pValues, size_t count, size_t step, double lower, double upper,
+      double minimum, double toBin, unsigned int* pBinCounts)
+   {
+      unsigned int binned = 0;
+      for (size_t i = 0; i < count; ++i)
+      {
+         double value = pValues[i * step];
+         unsigned int good = (MASKED && ((value > lower) & (value < upper))) ? 0 : 1;
+         int bin = static_cast<int>((value - minimum) * toBin);
+         bin = std::max(0, std::min(bin, HISTOGRAM_SIZE - 1));
+         pBinCounts[bin] += good;
+         binned += good;
+      }
+
+      return binned;
+   }
+
+   unsigned int binSpan(const double* pValues, size_t count, size_t step, const BadValues* pBadValues,
+      bool singleRange, double lower, double upper, double minimum, double toBin, unsigned int* pBinCounts)
+   {
+      if (pBadValues == NULL)
+      {
+         return binSpan<false>(pValues, count, step, lower, upper, minimum, toBin, pBinCounts);
+      }
+      else if (singleRange)
+      {
+         return binSpan<true>(pValues, count, step, lower, upper, minimum, toBin, pBinCounts);
+      }
+
+      unsigned int binned = 0;
+      for (size_t i = 0; i < count; ++i)
+      {
+         const double* pValue = pValues + i * step;
+         if (!pBadValues->isBadValue(*pValue))
+         {
+            binned += binSpan<false>(pValue, 1, 1, lower, upper, minimum, toBin, pBinCounts);
+         }
+      }
+
+      return binned;
+   }
+
+   /**
+    * Returns the first column of a row which is selected by a statistics resolution, or columnCount if
+    * there is none.  The resolution selects every resolution-th pixel in row-major order, so the
+    * selected columns of the row follow from it every resolution columns.
+    */
+   int getFirstResolutionColumn(int row, int columnCount, int resolution)
+   {
+      if (resolution <= 1)
+      {
+         return 0;
+      }
+
+      int offset = static_cast<int>((static_cast<int64_t>(row) * columnCount) % resolution);
+      return std::min((resolution - offset) % resolution, columnCount);
+   }
+
+   size_t getSpanLength(int firstColumn, int columnCount, int step)
+   {
+      return firstColumn < columnCount ? (columnCount - 1 - firstColumn) / step + 1 : 0;
+   }
+
+   // The bands of a bulk calculation share the bins of this many histogram values in each thread
+   const int BAND_HISTOGRAM_BUDGET = 1024 * 1024;
+   const int MINIMUM_BAND_HISTOGRAM_SIZE = 1024;
+
+   // A progressive calculation publishes values from about this many pixels before it refines them
+   const int COARSE_STATISTICS_SAMPLES = 256 * 1024;
+}
+
 StatisticsImp::StatisticsImp(const RasterElementImp* pRasterElement,
                              DimensionDescriptor band,
                              AoiElement* pAoi) :
@@ -58,7 +325,31 @@ StatisticsImp::StatisticsImp(const RasterElementImp* pRasterElement,
 }
 
 StatisticsImp::~StatisticsImp()
-{}
+{
+   // The background calculations read the data, so they are stopped before the element is destroyed
+   while (mBackgroundCalculations.empty() == false)
+   {
+      cancelBackgroundCalculation(mBackgroundCalculations.begin()->first);
+   }
+
+   notify(SIGNAL_NAME(Subject, Deleted));
+}
+
+const std::string& StatisticsImp::getObjectType() const
+{
+   static std::string sType("StatisticsImp");
+   return sType;
+}
+
+bool StatisticsImp::isKindOf(const std::string& className) const
+{
+   if ((className == getObjectType()) || (className == "Statistics"))
+   {
+      return true;
+   }
+
+   return SubjectImp::isKindOf(className);
+}
 
 void StatisticsImp::setMin(double dMin)
 {
@@ -393,6 +684,12 @@ bool StatisticsImp::areStatisticsCalculated() const
 
 bool StatisticsImp::areStatisticsCalculated(ComplexComponent component) const
 {
+   // The coarse values of a progressive calculation are set while the statistics are refined
+   if (mBackgroundCalculations.find(component) != mBackgroundCalculations.end())
+   {
+      return false;
+   }
+
    // Min
    std::map<ComplexComponent, double>::const_iterator iter;
    iter = mMinValues.find(component);
@@ -447,8 +744,70 @@ bool StatisticsImp::areStatisticsCalculated(ComplexComponent component) const
    return true;
 }
 
+void StatisticsImp::calculateProgressively(ComplexComponent component)
+{
+   if (areStatisticsCalculated(component) ||
+      mBackgroundCalculations.find(component) != mBackgroundCalculations.end())
+   {
+      return;
+   }
+
+   // Only the statistics of a whole band are refined in the background, and only while the
+   // application is running an event loop to receive the refined values
+   if (Statistics::getSettingProgressive() == false || mpRasterElement == NULL || mBands.size() != 1 ||
+      mpAoi.get() != NULL || Service<ApplicationServices>()->isBatch())
+   {
+      calculateStatistics(component);
+      return;
+   }
+
+   const RasterDataDescriptor* pDescriptor =
+      dynamic_cast<const RasterDataDescriptor*>(mpRasterElement->getDataDescriptor());
+   VERIFYNRV(pDescriptor);
+
+   int rowNum = pDescriptor->getRowCount();
+   int colNum = pDescriptor->getColumnCount();
+   VERIFYNRV(rowNum > 0 && colNum > 0);
+
+   updateStatisticsResolution(rowNum, colNum);
+
+   StatisticsCache cache(mpRasterElement, mBands, component, &mBadValues, mStatisticsResolution);
+   StatisticsCache::Entry values;
+   if (cache.read(values))
+   {
+      setStatistics(values, component);
+      return;
+   }
+
+   // Data with few pixels at the statistics resolution is calculated about as quickly as it is subsampled
+   double pixelCount = static_cast<double>(rowNum) * colNum;
+   if (pixelCount / mStatisticsResolution <= 4.0 * COARSE_STATISTICS_SAMPLES)
+   {
+      calculateStatistics(component);
+      return;
+   }
+
+   // The coarse values are read from a grid of pixels with a strided request
+   int stride = std::max(2, static_cast<int>(sqrt(pixelCount / COARSE_STATISTICS_SAMPLES)));
+   mta::StatusBarReporter barReporter("Computing statistics", "app", "CF884AA2-A1BF-468d-9609-795DE0F7B7A4");
+   if (calculateBandStatistics(dynamic_cast<const RasterElement*>(mpRasterElement), mBands.front(), &mBadValues,
+      component, mStatisticsResolution, stride, &barReporter, NULL, values) == false)
+   {
+      calculateStatistics(component);
+      return;
+   }
+
+   setStatistics(values, component);
+
+   BackgroundStatistics* pCalculation = new BackgroundStatistics(this, component);
+   mBackgroundCalculations[component] = pCalculation;
+   pCalculation->start();
+}
+
 void StatisticsImp::reset(ComplexComponent component)
 {
+   cancelBackgroundCalculation(component);
+
    mMinValues.erase(component);
    mMaxValues.erase(component);
    mAverageValues.erase(component);
@@ -460,6 +819,11 @@ void StatisticsImp::reset(ComplexComponent component)
 
 void StatisticsImp::resetAll()
 {
+   while (mBackgroundCalculations.empty() == false)
+   {
+      cancelBackgroundCalculation(mBackgroundCalculations.begin()->first);
+   }
+
    mMinValues.clear();
    mMaxValues.clear();
    mAverageValues.clear();
@@ -494,8 +858,15 @@ bool StatisticsImp::toXml(XMLWriter* pXml) const
    }
 
    pXml->addAttr("resolution", mStatisticsResolution);
+
+   // The coarse values of a component which is being refined are not saved
    for (std::map<ComplexComponent, double>::const_iterator it = mMinValues.begin(); it != mMinValues.end(); ++it)
    {
+      if (mBackgroundCalculations.find(it->first) != mBackgroundCalculations.end())
+      {
+         continue;
+      }
+
       pXml->pushAddPoint(pXml->addElement("minimum"));
       pXml->addAttr("component", it->first);
       pXml->addAttr("value", it->second);
@@ -503,6 +874,11 @@ bool StatisticsImp::toXml(XMLWriter* pXml) const
    }
    for (std::map<ComplexComponent, double>::const_iterator it = mMaxValues.begin(); it != mMaxValues.end(); ++it)
    {
+      if (mBackgroundCalculations.find(it->first) != mBackgroundCalculations.end())
+      {
+         continue;
+      }
+
       pXml->pushAddPoint(pXml->addElement("maximum"));
       pXml->addAttr("component", it->first);
       pXml->addAttr("value", it->second);
@@ -510,6 +886,11 @@ bool StatisticsImp::toXml(XMLWriter* pXml) const
    }
    for (std::map<ComplexComponent, double>::const_iterator it = mAverageValues.begin(); it != mAverageValues.end(); ++it)
    {
+      if (mBackgroundCalculations.find(it->first) != mBackgroundCalculations.end())
+      {
+         continue;
+      }
+
       pXml->pushAddPoint(pXml->addElement("average"));
       pXml->addAttr("component", it->first);
       pXml->addAttr("value", it->second);
@@ -518,6 +899,11 @@ bool StatisticsImp::toXml(XMLWriter* pXml) const
    for (std::map<ComplexComponent, double>::const_iterator it = mStandardDeviationValues.begin();
       it != mStandardDeviationValues.end(); ++it)
    {
+      if (mBackgroundCalculations.find(it->first) != mBackgroundCalculations.end())
+      {
+         continue;
+      }
+
       pXml->pushAddPoint(pXml->addElement("stddev"));
       pXml->addAttr("component", it->first);
       pXml->addAttr("value", it->second);
@@ -526,6 +912,11 @@ bool StatisticsImp::toXml(XMLWriter* pXml) const
    for (std::map<ComplexComponent, std::vector<double> >::const_iterator it = mPercentileValues.begin();
       it != mPercentileValues.end(); ++it)
    {
+      if (mBackgroundCalculations.find(it->first) != mBackgroundCalculations.end())
+      {
+         continue;
+      }
+
       pXml->pushAddPoint(pXml->addElement("percentile"));
       pXml->addAttr("component", it->first);
       pXml->addText(it->second);
@@ -534,6 +925,11 @@ bool StatisticsImp::toXml(XMLWriter* pXml) const
    for (std::map<ComplexComponent, std::vector<double> >::const_iterator it = mBinCenterValues.begin();
       it != mBinCenterValues.end(); ++it)
    {
+      if (mBackgroundCalculations.find(it->first) != mBackgroundCalculations.end())
+      {
+         continue;
+      }
+
       pXml->pushAddPoint(pXml->addElement("center"));
       pXml->addAttr("component", it->first);
       pXml->addText(it->second);
@@ -542,6 +938,11 @@ bool StatisticsImp::toXml(XMLWriter* pXml) const
    for (std::map<ComplexComponent, std::vector<unsigned int> >::const_iterator it = mHistogramValues.begin();
       it != mHistogramValues.end(); ++it)
    {
+      if (mBackgroundCalculations.find(it->first) != mBackgroundCalculations.end())
+      {
+         continue;
+      }
+
       pXml->pushAddPoint(pXml->addElement("histogram"));
       pXml->addAttr("component", it->first);
       pXml->addText(it->second);
@@ -685,85 +1086,79 @@ void StatisticsImp::calculateStatistics(ComplexComponent component)
    int colNum = pDescriptor->getColumnCount();
    VERIFYNRV(rowNum > 0 && colNum > 0);
 
-   if (mStatisticsResolution < 1)
-   {
-      if (rowNum < colNum)
-      {
-         mStatisticsResolution = rowNum / 500;
-      }
-      else
-      {
-         mStatisticsResolution = colNum / 500;
-      }
-
-      if (mStatisticsResolution < 1)
-      {
-         mStatisticsResolution = 1;
-      }
-   }
+   updateStatisticsResolution(rowNum, colNum);
 
-   // Create a bitmask for all pixels based on the statistics resolution
-   FactoryResource<BitMask> pMask;
-   if (mStatisticsResolution == 1)
-   {
-      pMask->setRegion(0, 0, colNum - 1, rowNum - 1, DRAW);
-   }
-   else
+   // Statistics of the whole of a file are kept between sessions, so they are only calculated once
+   StatisticsCache cache(mpAoi.get() == NULL ? mpRasterElement : NULL, mBands, component, &mBadValues,
+      mStatisticsResolution);
+   StatisticsCache::Entry cachedValues;
+   if (cache.read(cachedValues))
    {
-      // Increase the size of the bitmask bounding box to the full size so that the bitmask does
-      // not need to resize itself for every pixel that is set
-      pMask->setPixel(0, 0, true);
-      pMask->setPixel(colNum - 1, rowNum - 1, true);
-      pMask->setPixel(0, 0, false);
-      pMask->setPixel(colNum - 1, rowNum - 1, false);
-
-      for (int i = 0; i < rowNum * colNum; i += mStatisticsResolution)
-      {
-         int col = i % colNum;
-         int row = (i - col) / colNum;
-         pMask->setPixel(col, row, true);
-      }
+      setStatistics(cachedValues, component);
+      return;
    }
 
-   // Intersect bitmask pixels based on the AOI
+   // Create a bitmask of the AOI pixels based on the statistics resolution.  Without an AOI, the threads
+   // select the pixels of the resolution from each row themselves.
+   FactoryResource<BitMask> pMask;
+   const BitMask* pSelectedPixels = NULL;
    if (mpAoi.get() != NULL)
    {
+      setResolutionMask(pMask.get(), rowNum, colNum, mStatisticsResolution);
       pMask->intersect(*(mpAoi->getSelectedPoints()));
+      pSelectedPixels = pMask.get();
    }
 
+   // a single pass accumulates the histogram along with the other statistics, so the data is only read once
+   bool singlePass = Statistics::getSettingSinglePass();
    StatisticsInput statInput(mBands, dynamic_cast<const RasterElement*>(mpRasterElement),
-      component, mStatisticsResolution, &mBadValues, pMask.get());
-   StatisticsOutput statOutput;
+      component, mStatisticsResolution, &mBadValues, pSelectedPixels, singlePass);
+   StatisticsOutput statOutput(singlePass);
 
    mta::StatusBarReporter barReporter("Computing statistics", "app", "CF884AA2-A1BF-468d-9609-795DE0F7B7A4");
 
    std::vector<int> phaseWeights;
-   phaseWeights.push_back(20);
-   phaseWeights.push_back(80);
+   if (singlePass)
+   {
+      phaseWeights.push_back(100);
+   }
+   else
+   {
+      phaseWeights.push_back(20);
+      phaseWeights.push_back(80);
+   }
    mta::MultiPhaseProgressReporter progressReporter(barReporter, phaseWeights);
 
    mta::MultiThreadedAlgorithm<StatisticsInput, StatisticsOutput, StatisticsThread> statisticsAlgorithm
-      (getNumRequiredThreads(pDescriptor->getRowCount()), statInput, statOutput, &progressReporter);
-   statisticsAlgorithm.run();
+      (getNumRequiredThreads(pDescriptor->getRowCount()), statInput, statOutput, &progressReporter,
+      mta::POLLED_REPORTS);
+   mta::Result statisticsResult = statisticsAlgorithm.run();
+
+   bool bInteger = isIntegerData(pDescriptor->getDataType(), component);
 
-   bool bInteger = true;
-   EncodingType encoding = pDescriptor->getDataType();
-   if ((encoding == FLT4BYTES) || (encoding == FLT8COMPLEX) || (encoding == FLT8BYTES) ||
-      ((encoding == INT4SCOMPLEX) && (component == COMPLEX_MAGNITUDE)) ||
-      ((encoding == INT4SCOMPLEX) && (component == COMPLEX_PHASE)))
+   if (singlePass && statOutput.mMaxMinSet)
    {
-      bInteger = false;
+      HistogramOutput histOutput(bInteger, statOutput.mMaximum, statOutput.mMinimum);
+      if (statisticsResult == mta::SUCCESS && histOutput.compileResults(statOutput.mHistogram))
+      {
+         setMin(statOutput.mMinimum, component);
+         setMax(statOutput.mMaximum, component);
+         setAverage(statOutput.mAverage, component);
+         setStandardDeviation(statOutput.mStandardDeviation, component);
+         setPercentiles(histOutput.getPercentiles(), component);
+         setHistogram(histOutput.getBinCenters(), histOutput.getBinCounts(), component);
+      }
    }
-
-   progressReporter.setCurrentPhase(1);
-
-   if (statOutput.mMaxMinSet)
+   else if (statOutput.mMaxMinSet)
    {
+      progressReporter.setCurrentPhase(1);
+
       HistogramInput histInput(statInput, statOutput);
       HistogramOutput histOutput(bInteger, statOutput.mMaximum, statOutput.mMinimum);
 
       mta::MultiThreadedAlgorithm<HistogramInput, HistogramOutput, HistogramThread> histogramAlgorithm
-         (getNumRequiredThreads(pDescriptor->getRowCount()), histInput, histOutput, &progressReporter);
+         (getNumRequiredThreads(pDescriptor->getRowCount()), histInput, histOutput, &progressReporter,
+         mta::POLLED_REPORTS);
 
       if (histogramAlgorithm.run() == mta::SUCCESS)
       {
@@ -786,47 +1181,284 @@ void StatisticsImp::calculateStatistics(ComplexComponent component)
       setPercentiles(&dzeroes.front(), component);
       setHistogram(&dzeroes.front(), &uizeroes.front(), component);
    }
-}
 
-StatisticsThread::StatisticsThread(const StatisticsInput& input, int threadCount, int threadIndex,
-                                   ThreadReporter& reporter) :
-   AlgorithmThread(threadIndex, reporter),
-   mInput(input),
-   mRowRange(getThreadRange(threadCount, static_cast<const RasterDataDescriptor*>(
-                                 input.mpRasterElement->getDataDescriptor())->getRowCount())),
-   mMaxMinSet(false),
-   mMaximum(-std::numeric_limits<double>::max()),
-   mMinimum(std::numeric_limits<double>::max()),
-   mSum(0.0),
-   mSumSquared(0.0),
-   mCount(0)
-{}
+   if (cache.isValid() && statisticsResult == mta::SUCCESS && areStatisticsCalculated(component))
+   {
+      getStatistics(cachedValues, component);
+      cache.write(cachedValues);
+   }
+}
 
-void StatisticsThread::run()
+void StatisticsImp::calculateStatistics(const std::vector<StatisticsImp*>& statistics, ComplexComponent component)
 {
-   const RasterDataDescriptor* pDescriptor = static_cast<const RasterDataDescriptor*>(
-      mInput.mpRasterElement->getDataDescriptor());
-   VERIFYNRV(pDescriptor != NULL);
+   // Only the single band statistics of the whole of the first element are calculated together
+   const RasterElementImp* pRasterElement = NULL;
+   std::vector<StatisticsImp*> bandStatistics;
+   for (std::vector<StatisticsImp*>::const_iterator iter = statistics.begin(); iter != statistics.end(); ++iter)
+   {
+      StatisticsImp* pStatistics = *iter;
+      if (pStatistics == NULL || pStatistics->areStatisticsCalculated(component))
+      {
+         continue;
+      }
 
-   BitMaskIterator diter(mInput.mpAoi, 0, mRowRange.mFirst, pDescriptor->getColumnCount() - 1, mRowRange.mLast);
+      if (pRasterElement == NULL)
+      {
+         pRasterElement = pStatistics->mpRasterElement;
+      }
+
+      if (pStatistics->mpRasterElement == pRasterElement && pStatistics->mpRasterElement != NULL &&
+         pStatistics->mBands.size() == 1 && pStatistics->mpAoi.get() == NULL)
+      {
+         bandStatistics.push_back(pStatistics);
+      }
+      else
+      {
+         pStatistics->calculateStatistics(component);
+      }
+   }
+
+   if (bandStatistics.empty())
+   {
+      return;
+   }
+
+   const RasterDataDescriptor* pDescriptor =
+      dynamic_cast<const RasterDataDescriptor*>(pRasterElement->getDataDescriptor());
+   VERIFYNRV(pDescriptor);
+
+   int rowNum = pDescriptor->getRowCount();
+   int colNum = pDescriptor->getColumnCount();
+   VERIFYNRV(rowNum > 0 && colNum > 0);
+
+   // The bands are read together for each resolution, after those kept between sessions are set
+   std::map<int, std::vector<StatisticsImp*> > resolutionStatistics;
+   for (std::vector<StatisticsImp*>::iterator iter = bandStatistics.begin(); iter != bandStatistics.end(); ++iter)
+   {
+      StatisticsImp* pStatistics = *iter;
+      pStatistics->updateStatisticsResolution(rowNum, colNum);
+
+      StatisticsCache cache(pRasterElement, pStatistics->mBands, component, &pStatistics->mBadValues,
+         pStatistics->mStatisticsResolution);
+      StatisticsCache::Entry cachedValues;
+      if (cache.read(cachedValues))
+      {
+         pStatistics->setStatistics(cachedValues, component);
+      }
+      else
+      {
+         resolutionStatistics[pStatistics->mStatisticsResolution].push_back(pStatistics);
+      }
+   }
+
+   bool bInteger = isIntegerData(pDescriptor->getDataType(), component);
+   for (std::map<int, std::vector<StatisticsImp*> >::iterator iter = resolutionStatistics.begin();
+      iter != resolutionStatistics.end(); ++iter)
+   {
+      const std::vector<StatisticsImp*>& statisticsToCalculate = iter->second;
+
+      std::vector<DimensionDescriptor> bands;
+      std::vector<const BadValues*> badValues;
+      for (std::vector<StatisticsImp*>::const_iterator statIter = statisticsToCalculate.begin();
+         statIter != statisticsToCalculate.end(); ++statIter)
+      {
+         bands.push_back((*statIter)->mBands.front());
+         badValues.push_back(&(*statIter)->mBadValues);
+      }
+
+      BandStatisticsInput statInput(bands, badValues, dynamic_cast<const RasterElement*>(pRasterElement),
+         component, iter->first);
+      BandStatisticsOutput statOutput(bInteger);
+
+      // Each thread holds the histograms of every band, so there is only one thread for each worker
+      mta::StatusBarReporter barReporter("Computing statistics", "app", "CF884AA2-A1BF-468d-9609-795DE0F7B7A4");
+      mta::MultiThreadedAlgorithm<BandStatisticsInput, BandStatisticsOutput, BandStatisticsThread>
+         statisticsAlgorithm(getNumRequiredThreads(rowNum, 1), statInput, statOutput, &barReporter,
+         mta::POLLED_REPORTS);
+      if (statisticsAlgorithm.run() != mta::SUCCESS)
+      {
+         return;
+      }
+
+      for (std::vector<StatisticsImp*>::size_type i = 0; i < statisticsToCalculate.size(); ++i)
+      {
+         StatisticsImp* pStatistics = statisticsToCalculate[i];
+         pStatistics->setStatistics(statOutput.mBands[i], component);
+
+         StatisticsCache cache(pRasterElement, pStatistics->mBands, component, &pStatistics->mBadValues,
+            pStatistics->mStatisticsResolution);
+         cache.write(statOutput.mBands[i]);
+      }
+   }
+}
+
+bool StatisticsImp::calculateBandStatistics(const RasterElement* pRaster, DimensionDescriptor band,
+   const BadValues* pBadValues, ComplexComponent component, int resolution, int stride,
+   mta::ProgressReporter* pReporter, const boost::atomic<bool>* pAbort, StatisticsCache::Entry& values)
+{
+   VERIFY(pRaster != NULL);
+
+   const RasterDataDescriptor* pDescriptor = dynamic_cast<const RasterDataDescriptor*>(pRaster->getDataDescriptor());
+   VERIFY(pDescriptor != NULL);
+
+   int rowNum = pDescriptor->getRowCount();
+   int colNum = pDescriptor->getColumnCount();
+   VERIFY(rowNum > 0 && colNum > 0);
+
+   // A stride reads a grid of every stride-th row and column in place of the resolution
+   if (stride > 1)
+   {
+      resolution = 1;
+   }
+   else
+   {
+      stride = 1;
+      resolution = std::max(resolution, 1);
+   }
+
+   std::vector<DimensionDescriptor> bands(1, band);
+   std::vector<const BadValues*> badValues(1, pBadValues);
+   BandStatisticsInput statInput(bands, badValues, pRaster, component, resolution, stride, pAbort);
+   BandStatisticsOutput statOutput(isIntegerData(pDescriptor->getDataType(), component));
+
+   mta::MultiThreadedAlgorithm<BandStatisticsInput, BandStatisticsOutput, BandStatisticsThread>
+      statisticsAlgorithm(getNumRequiredThreads(rowNum, 1), statInput, statOutput, pReporter, mta::POLLED_REPORTS);
+   if (statisticsAlgorithm.run() != mta::SUCCESS || (pAbort != NULL && *pAbort) || statOutput.mBands.empty())
+   {
+      return false;
+   }
+
+   values = statOutput.mBands.front();
+   return true;
+}
+
+void StatisticsImp::updateStatisticsResolution(int rowCount, int columnCount)
+{
+   if (mStatisticsResolution < 1)
+   {
+      if (rowCount < columnCount)
+      {
+         mStatisticsResolution = rowCount / 500;
+      }
+      else
+      {
+         mStatisticsResolution = columnCount / 500;
+      }
+
+      if (mStatisticsResolution < 1)
+      {
+         mStatisticsResolution = 1;
+      }
+   }
+}
+
+void StatisticsImp::setStatistics(const StatisticsCache::Entry& values, ComplexComponent component)
+{
+   setMin(values.mMinimum, component);
+   setMax(values.mMaximum, component);
+   setAverage(values.mAverage, component);
+   setStandardDeviation(values.mStandardDeviation, component);
+   setPercentiles(&values.mPercentiles.front(), component);
+   setHistogram(&values.mBinCenters.front(), &values.mBinCounts.front(), component);
+}
+
+void StatisticsImp::getStatistics(StatisticsCache::Entry& values, ComplexComponent component)
+{
+   values.mMinimum = mMinValues[component];
+   values.mMaximum = mMaxValues[component];
+   values.mAverage = mAverageValues[component];
+   values.mStandardDeviation = mStandardDeviationValues[component];
+   values.mPercentiles = mPercentileValues[component];
+   values.mBinCenters = mBinCenterValues[component];
+   values.mBinCounts = mHistogramValues[component];
+}
+
+void StatisticsImp::cancelBackgroundCalculation(ComplexComponent component)
+{
+   std::map<ComplexComponent, BackgroundStatistics*>::iterator iter = mBackgroundCalculations.find(component);
+   if (iter != mBackgroundCalculations.end())
+   {
+      BackgroundStatistics* pCalculation = iter->second;
+      mBackgroundCalculations.erase(iter);
+
+      // Stops the calculation and waits for its thread to finish
+      delete pCalculation;
+   }
+}
+
+void StatisticsImp::backgroundCalculationFinished(ComplexComponent component, const StatisticsCache::Entry* pValues)
+{
+   // The calculation deletes itself once it has reported its values
+   mBackgroundCalculations.erase(component);
+   if (pValues == NULL)
+   {
+      // The coarse values are discarded so that the statistics are calculated again when they are needed
+      reset(component);
+      return;
+   }
+
+   setStatistics(*pValues, component);
+
+   StatisticsCache cache(mpRasterElement, mBands, component, &mBadValues, mStatisticsResolution);
+   cache.write(*pValues);
+
+   notify(SIGNAL_NAME(Statistics, Calculated), boost::any(component));
+}
+
+StatisticsThread::StatisticsThread(const StatisticsInput& input, int threadCount, int threadIndex,
+                                   ThreadReporter& reporter) :
+   AlgorithmThread(threadIndex, reporter),
+   mInput(input),
+   mRowRange(getThreadRange(threadCount, static_cast<const RasterDataDescriptor*>(
+                                 input.mpRasterElement->getDataDescriptor())->getRowCount())),
+   mMaxMinSet(false),
+   mMaximum(-std::numeric_limits<double>::max()),
+   mMinimum(std::numeric_limits<double>::max()),
+   mSum(0.0),
+   mSumSquared(0.0),
+   mCount(0),
+   mHistogram(isIntegerData(static_cast<const RasterDataDescriptor*>(
+      input.mpRasterElement->getDataDescriptor())->getDataType(), input.mComplexComponent))
+{}
+
+void StatisticsThread::run()
+{
+   const RasterDataDescriptor* pDescriptor = static_cast<const RasterDataDescriptor*>(
+      mInput.mpRasterElement->getDataDescriptor());
+   VERIFYNRV(pDescriptor != NULL);
 
    mMaxMinSet = false;
+   mMaximum = -std::numeric_limits<double>::max();
+   mMinimum = std::numeric_limits<double>::max();
    mSum = 0.0;
    mSumSquared = 0.0;
    mCount = 0;
 
-   EncodingType encoding = pDescriptor->getDataType();
+   // Without an AOI, only the pixels of the resolution are converted from each row, as one span
+   BitMaskIterator diter(mInput.mpAoi, 0, mRowRange.mFirst, pDescriptor->getColumnCount() - 1, mRowRange.mLast);
+   bool spans = mInput.mpAoi == NULL;
+   int startRow = spans ? mRowRange.mFirst : diter.getBoundingBoxStartRow();
+   int endRow = spans ? mRowRange.mLast : diter.getBoundingBoxEndRow();
+   int startColumn = spans ? 0 : diter.getBoundingBoxStartColumn();
+   int endColumn = spans ? pDescriptor->getColumnCount() - 1 : diter.getBoundingBoxEndColumn();
+   if (spans ? startRow > endRow : diter == diter.end())
+   {
+      return;
+   }
+
    ComplexComponent component = mInput.mComplexComponent;
+   int resolution = std::max(mInput.mResolution, 1);
 
    int oldPercentDone = -1;
 
-   bool hasBadValues = mInput.mpBadValues != NULL && mInput.mpBadValues->empty() == false;
+   const BadValues* pBadValues = NULL;
    bool hasSingleBadValueRange = false;
    double badValueLower = 0.0;
    double badValueUpper = 0.0;
-   if (hasBadValues)
+   if (mInput.mpBadValues != NULL && mInput.mpBadValues->empty() == false)
    {
-      hasSingleBadValueRange = mInput.mpBadValues->getSingleBadValueRange(badValueLower, badValueUpper);
+      pBadValues = mInput.mpBadValues;
+      hasSingleBadValueRange = pBadValues->getSingleBadValueRange(badValueLower, badValueUpper);
    }
 
    bool isBip = pDescriptor->getInterleaveFormat() == BIP;
@@ -835,10 +1467,8 @@ void StatisticsThread::run()
         bandIt != mInput.mBandsToCalculate.end(); ++bandIt)
    {
       FactoryResource<DataRequest> pRequest;
-      pRequest->setRows(pDescriptor->getActiveRow(diter.getBoundingBoxStartRow()),
-                        pDescriptor->getActiveRow(diter.getBoundingBoxEndRow()), 0);
-      pRequest->setColumns(pDescriptor->getActiveColumn(diter.getBoundingBoxStartColumn()),
-                           pDescriptor->getActiveColumn(diter.getBoundingBoxEndColumn()), 0);
+      pRequest->setRows(pDescriptor->getActiveRow(startRow), pDescriptor->getActiveRow(endRow), 0);
+      pRequest->setColumns(pDescriptor->getActiveColumn(startColumn), pDescriptor->getActiveColumn(endColumn), 0);
       if (isBip)
       {
          // request native accessor for efficiency
@@ -856,74 +1486,79 @@ void StatisticsThread::run()
          return;
       }
 
-      // Iterate the band over the AOI or all bands in the case of BIP
-//#pragma message(__FILE__ "(" STRING(__LINE__) ") : warning : This should be changed to for (; fiter != diter.end(); diter += mInput.mResolution)  if/when BitMaskIterator is modified to be an STL iterator (tclarke)")
-      while (diter != diter.end())
+      diter.firstPixel();
+
+      // Each row is converted once for all of its pixels, one span per band in the case of BIP
+      size_t columnCount = endColumn - startColumn + 1;
+      size_t bandCount = isBip ? mInput.mBandsToCalculate.size() : 1;
+      std::vector<double> rowValues(columnCount * bandCount);
+      int currentRow = -1;
+
+      // Iterate the rows of the band or all bands in the case of BIP
+      for (int row = startRow; row <= endRow; ++row)
       {
-         LocationType loc;
-         diter.getPixelLocation(loc);
-         int percentDone = mRowRange.computePercent(static_cast<int>(loc.mY));
+         int percentDone = mRowRange.computePercent(row);
          if (percentDone >= oldPercentDone + 25)
          {
             oldPercentDone = percentDone;
             getReporter().reportProgress(getThreadIndex(), percentDone);
          }
 
-         da->toPixel(static_cast<int>(loc.mY), static_cast<int>(loc.mX));
-         VERIFYNRV(da.isValid());
-
-         // Inner band loop for BIP, will break for other interleaves
-         for (std::vector<DimensionDescriptor>::const_iterator bipBandIt = mInput.mBandsToCalculate.begin();
-              bipBandIt != mInput.mBandsToCalculate.end(); ++bipBandIt)
+         if (spans)
          {
-            double temp = ModelServices::getDataValue(encoding,
-               da->getColumn(), component, isBip ? bipBandIt->getActiveNumber() : 0);
+            int firstColumn = getFirstResolutionColumn(row, static_cast<int>(columnCount), resolution);
+            size_t spanLength = getSpanLength(firstColumn, static_cast<int>(columnCount), resolution);
+            if (spanLength == 0)
+            {
+               continue;
+            }
 
-            bool badValue = false;
-            if (hasBadValues)
+            // Only the columns selected by the resolution are converted
+            da->toPixel(row, firstColumn);
+            VERIFYNRV(da.isValid());
+            for (size_t band = 0; band < bandCount; ++band)
             {
-               if (hasSingleBadValueRange)
-               {
-                  badValue = temp > badValueLower && temp < badValueUpper;
-               }
-               else
+               double* pValues = &rowValues[band * columnCount];
+               da->getRowAs(pValues, spanLength,
+                  isBip ? mInput.mBandsToCalculate[band].getActiveNumber() : 0, component, resolution);
+               accumulateSpan(pValues, spanLength, 1, pBadValues, hasSingleBadValueRange,
+                  badValueLower, badValueUpper, mMinimum, mMaximum, mSum, mSumSquared, mCount);
+               if (mInput.mSinglePass)
                {
-                  badValue = mInput.mpBadValues->isBadValue(temp);
+                  addToHistogram(pValues, spanLength, 1, pBadValues, hasSingleBadValueRange,
+                     badValueLower, badValueUpper, mHistogram);
                }
             }
 
-            if (!badValue)
+            continue;
+         }
+
+         // The AOI selects the pixels of the row one at a time
+//#pragma message(__FILE__ "(" STRING(__LINE__) ") : warning : This should be changed to for (; fiter != diter.end(); diter += mInput.mResolution)  if/when BitMaskIterator is modified to be an STL iterator (tclarke)")
+         for (; diter != diter.end() && diter.getPixelRowLocation() == row; diter.nextPixel())
+         {
+            if (row != currentRow)
             {
-               if (!mMaxMinSet)
-               {
-                  mMinimum = mMaximum = temp;
-                  mMaxMinSet = true;
-               }
-               else
+               currentRow = row;
+               da->toPixel(currentRow, startColumn);
+               VERIFYNRV(da.isValid());
+               for (size_t band = 0; band < bandCount; ++band)
                {
-                  if (temp < mMinimum)
-                  {
-                     mMinimum = temp;
-                  }
-
-                  if (temp > mMaximum)
-                  {
-                     mMaximum = temp;
-                  }
+                  da->getRowAs(&rowValues[band * columnCount], columnCount,
+                     isBip ? mInput.mBandsToCalculate[band].getActiveNumber() : 0, component);
                }
+            }
 
-               mSumSquared += temp*temp;
-               mSum += temp;
-               mCount++;
-               if (!isBip)
-               {
-                  // this inner band loop is only for BIP
-                  break;
-               }
+            // Inner band loop for BIP, a single band for other interleaves
+            const double* pValues = &rowValues[diter.getPixelColumnLocation() - startColumn];
+            accumulateSpan(pValues, bandCount, columnCount, pBadValues, hasSingleBadValueRange, badValueLower,
+               badValueUpper, mMinimum, mMaximum, mSum, mSumSquared, mCount);
+            if (mInput.mSinglePass)
+            {
+               addToHistogram(pValues, bandCount, columnCount, pBadValues, hasSingleBadValueRange, badValueLower,
+                  badValueUpper, mHistogram);
             }
          }
-
-         diter.nextPixel();
       }
       if (isBip)
       {
@@ -931,6 +1566,8 @@ void StatisticsThread::run()
          break;
       }
    }
+
+   mMaxMinSet = mCount > 0;
 }
 
 bool StatisticsThread::isMaxMinSet() const
@@ -963,12 +1600,166 @@ unsigned int StatisticsThread::getCount() const
    return mCount;
 }
 
-StatisticsOutput::StatisticsOutput() :
+const AdaptiveHistogram& StatisticsThread::getHistogram() const
+{
+   return mHistogram;
+}
+
+AdaptiveHistogram::AdaptiveHistogram(bool isInteger, int binCount) :
+   mIsInteger(isInteger),
+   mBinCount(binCount),
+   mLower(0.0),
+   mWidth(0.0),
+   mFirstValue(0.0),
+   mFirstCount(0)
+{}
+
+void AdaptiveHistogram::add(double value)
+{
+   // NaN and infinite values cannot be placed in a bin
+   if (!(value - value == 0.0))
+   {
+      return;
+   }
+
+   if (mBins.empty())
+   {
+      mBins.resize(mBinCount, 0);
+      if (mIsInteger)
+      {
+         mLower = value;
+         mWidth = 1.0;
+      }
+   }
+
+   if (mWidth == 0.0)
+   {
+      if (mFirstCount == 0 || value == mFirstValue)
+      {
+         mFirstValue = value;
+         ++mFirstCount;
+         return;
+      }
+
+      // size the bins so that both values fit in the first half of the histogram
+      double difference = fabs(value - mFirstValue);
+      mWidth = difference * 2.0 / mBinCount;
+      if (mWidth == 0.0)
+      {
+         mWidth = difference;
+      }
+      mLower = std::min(value, mFirstValue);
+      mBins[static_cast<int>((mFirstValue - mLower) / mWidth)] += mFirstCount;
+      mFirstCount = 0;
+   }
+
+   double offset = (value - mLower) / mWidth;
+   while (offset < 0.0 || offset >= mBinCount)
+   {
+      grow(value);
+      offset = (value - mLower) / mWidth;
+   }
+
+   mBins[std::min(static_cast<int>(offset), mBinCount - 1)]++;
+}
+
+void AdaptiveHistogram::grow(double value)
+{
+   int first = 0;
+   while (first < mBinCount - 1 && mBins[first] == 0)
+   {
+      ++first;
+   }
+
+   int last = mBinCount - 1;
+   while (last > first && mBins[last] == 0)
+   {
+      --last;
+   }
+
+   // if the counted bins and the value fit at the current width, move the bins and keep their resolution
+   double offset = floor((value - mLower) / mWidth);
+   if (offset < 0.0)
+   {
+      double room = mBinCount - 1 - last;
+      if (-offset <= room)
+      {
+         int shift = static_cast<int>(-offset + (room + offset) / 2.0);
+         std::copy_backward(mBins.begin() + first, mBins.begin() + last + 1, mBins.begin() + last + 1 + shift);
+         std::fill(mBins.begin(), mBins.begin() + first + shift, 0);
+         mLower -= shift * mWidth;
+         return;
+      }
+   }
+   else
+   {
+      double needed = offset - (mBinCount - 1);
+      if (needed <= first)
+      {
+         int shift = static_cast<int>(needed + (first - needed) / 2.0);
+         std::copy(mBins.begin() + first, mBins.begin() + last + 1, mBins.begin() + first - shift);
+         std::fill(mBins.begin() + last + 1 - shift, mBins.end(), 0);
+         mLower += shift * mWidth;
+         return;
+      }
+   }
+
+   const int half = mBinCount / 2;
+   if (value < mLower)
+   {
+      // the current range becomes the upper half of the histogram
+      for (int bin = mBinCount - 1; bin >= half; --bin)
+      {
+         int source = 2 * (bin - half);
+         mBins[bin] = mBins[source] + mBins[source + 1];
+      }
+      std::fill(mBins.begin(), mBins.begin() + half, 0);
+      mLower -= mBinCount * mWidth;
+   }
+   else
+   {
+      // the current range becomes the lower half of the histogram
+      for (int bin = 0; bin < half; ++bin)
+      {
+         mBins[bin] = mBins[2 * bin] + mBins[2 * bin + 1];
+      }
+      std::fill(mBins.begin() + half, mBins.end(), 0);
+   }
+
+   mWidth *= 2.0;
+}
+
+void AdaptiveHistogram::addTo(double minimum, double toBin, std::vector<unsigned int>& binCounts) const
+{
+   if (mWidth == 0.0)
+   {
+      if (mFirstCount > 0)
+      {
+         int bin = static_cast<int>((mFirstValue - minimum) * toBin);
+         binCounts[std::max(0, std::min(bin, HISTOGRAM_SIZE - 1))] += mFirstCount;
+      }
+
+      return;
+   }
+
+   for (int bin = 0; bin < mBinCount; ++bin)
+   {
+      if (mBins[bin] > 0)
+      {
+         double value = std::max(mLower + bin * mWidth, minimum);
+         int totalBin = static_cast<int>((value - minimum) * toBin);
+         binCounts[std::min(totalBin, HISTOGRAM_SIZE - 1)] += mBins[bin];
+      }
+   }
+}
+
+StatisticsOutput::StatisticsOutput(bool singlePass) :
    mMaxMinSet(false),
    mMaximum(-std::numeric_limits<double>::max()),
    mMinimum(std::numeric_limits<double>::max()),
    mAverage(0.0),
-   mStandardDeviation(0.0)
+   mStandardDeviation(0.0),
+   mSinglePass(singlePass)
 {}
 
 bool StatisticsOutput::compileOverallResults(const std::vector<StatisticsThread*>& threads)
@@ -1005,17 +1796,21 @@ bool StatisticsOutput::compileOverallResults(const std::vector<StatisticsThread*
       }
    }
 
-   if (pointCount > 0)
-   {
-      mAverage = totalSum / pointCount;
-   }
+   computeMoments(totalSum, totalSquaredSum, pointCount, mAverage, mStandardDeviation);
 
-   if (pointCount > 1)
+   // the thread histograms cover different ranges, so they are combined over the overall range
+   mHistogram.clear();
+   if (mSinglePass && mMaxMinSet)
    {
-      // the fabs() on the next line prevents roundoff error from giving sqrt a negative
-      // when every pixel has the same value
-      double numerator = fabs(pointCount * totalSquaredSum - totalSum * totalSum);
-      mStandardDeviation = sqrt((numerator / pointCount) / (pointCount - 1));
+      mHistogram.resize(HISTOGRAM_SIZE, 0);
+      double toBin = getHistogramBinFactor(mMaximum, mMinimum);
+      for (std::vector<StatisticsThread*>::const_iterator iter = threads.begin(); iter != threads.end(); ++iter)
+      {
+         if (*iter != NULL)
+         {
+            (*iter)->getHistogram().addTo(mMinimum, toBin, mHistogram);
+         }
+      }
    }
 
    return true;
@@ -1035,34 +1830,49 @@ HistogramThread::HistogramThread(const HistogramInput& input,
 
 void HistogramThread::run()
 {
-   double range = 1.0;
-   double toBin = 0.0;
-   
-   if (mInput.mStatistics.mMaximum != mInput.mStatistics.mMinimum)
-   {
-      range = mInput.mStatistics.mMaximum - mInput.mStatistics.mMinimum;
-      toBin = 0.999999999 * (HISTOGRAM_SIZE)/range;
-   }
+   double minimum = mInput.mStatistics.mMinimum;
+   double toBin = getHistogramBinFactor(mInput.mStatistics.mMaximum, minimum);
 
    std::vector<unsigned int>& binCounts = getBinCounts();
 
+   const StatisticsInput& statInput = mInput.mStatInput;
    const RasterDataDescriptor* pDescriptor = static_cast<const RasterDataDescriptor*>(
-      mInput.mStatInput.mpRasterElement->getDataDescriptor());
+      statInput.mpRasterElement->getDataDescriptor());
    VERIFYNRV(pDescriptor != NULL);
 
-   BitMaskIterator diter(mInput.mStatInput.mpAoi, 0, mRowRange.mFirst,
-      pDescriptor->getColumnCount() - 1, mRowRange.mLast);
+   // Without an AOI, only the pixels of the resolution are converted from each row, as one span
+   BitMaskIterator diter(statInput.mpAoi, 0, mRowRange.mFirst, pDescriptor->getColumnCount() - 1, mRowRange.mLast);
+   bool spans = statInput.mpAoi == NULL;
+   int startRow = spans ? mRowRange.mFirst : diter.getBoundingBoxStartRow();
+   int endRow = spans ? mRowRange.mLast : diter.getBoundingBoxEndRow();
+   int startColumn = spans ? 0 : diter.getBoundingBoxStartColumn();
+   int endColumn = spans ? pDescriptor->getColumnCount() - 1 : diter.getBoundingBoxEndColumn();
+   if (spans ? startRow > endRow : diter == diter.end())
+   {
+      return;
+   }
+
+   ComplexComponent component = statInput.mComplexComponent;
+   int resolution = std::max(statInput.mResolution, 1);
+
+   const BadValues* pBadValues = NULL;
+   bool hasSingleBadValueRange = false;
+   double badValueLower = 0.0;
+   double badValueUpper = 0.0;
+   if (statInput.mpBadValues != NULL && statInput.mpBadValues->empty() == false)
+   {
+      pBadValues = statInput.mpBadValues;
+      hasSingleBadValueRange = pBadValues->getSingleBadValueRange(badValueLower, badValueUpper);
+   }
 
    bool isBip = pDescriptor->getInterleaveFormat() == BIP;
    // Outer band loop not for BIP, will break if BIP
-   for (std::vector<DimensionDescriptor>::const_iterator bandIt = mInput.mStatInput.mBandsToCalculate.begin();
-      bandIt != mInput.mStatInput.mBandsToCalculate.end(); ++bandIt)
+   for (std::vector<DimensionDescriptor>::const_iterator bandIt = statInput.mBandsToCalculate.begin();
+      bandIt != statInput.mBandsToCalculate.end(); ++bandIt)
    {
       FactoryResource<DataRequest> pRequest;
-      pRequest->setRows(pDescriptor->getActiveRow(diter.getBoundingBoxStartRow()),
-         pDescriptor->getActiveRow(diter.getBoundingBoxEndRow()), 0);
-      pRequest->setColumns(pDescriptor->getActiveColumn(diter.getBoundingBoxStartColumn()),
-         pDescriptor->getActiveColumn(diter.getBoundingBoxEndColumn()), 0);
+      pRequest->setRows(pDescriptor->getActiveRow(startRow), pDescriptor->getActiveRow(endRow), 0);
+      pRequest->setColumns(pDescriptor->getActiveColumn(startColumn), pDescriptor->getActiveColumn(endColumn), 0);
       if (isBip)
       {
          // request native accessor for efficiency
@@ -1074,85 +1884,75 @@ void HistogramThread::run()
       {
          pRequest->setBands(*bandIt, *bandIt, 1);
       }
-      DataAccessor da(mInput.mStatInput.mpRasterElement->getDataAccessor(pRequest.release()));
+      DataAccessor da(statInput.mpRasterElement->getDataAccessor(pRequest.release()));
       if (!da.isValid())
       {
          return;
       }
 
-      EncodingType encoding = pDescriptor->getDataType();
-      ComplexComponent component = mInput.mStatInput.mComplexComponent;
+      diter.firstPixel();
 
-      bool hasBadValues = mInput.mStatInput.mpBadValues != NULL && mInput.mStatInput.mpBadValues->empty() == false;
-      bool hasSingleBadValueRange = false;
-      double badValueLower = 0.0;
-      double badValueUpper = 0.0;
-      if (hasBadValues)
-      {
-         hasSingleBadValueRange = mInput.mStatInput.mpBadValues->getSingleBadValueRange(badValueLower, badValueUpper);
-      }
+      // Each row is converted once for all of its pixels, one span per band in the case of BIP
+      size_t columnCount = endColumn - startColumn + 1;
+      size_t bandCount = isBip ? statInput.mBandsToCalculate.size() : 1;
+      std::vector<double> rowValues(columnCount * bandCount);
+      int currentRow = -1;
 
       int oldPercentDone = -1;
-      // Iterate the band over the AOI or all bands in the case of BIP
-//#pragma message(__FILE__ "(" STRING(__LINE__) ") : warning : This should be changed to for (; fiter != diter.end(); diter += mInput.mResolution)  if/when BitMaskIterator is modified to be an STL iterator (tclarke)")
-      while (diter != diter.end())
+      // Iterate the rows of the band or all bands in the case of BIP
+      for (int row = startRow; row <= endRow; ++row)
       {
-         LocationType loc;
-         diter.getPixelLocation(loc);
-         int percentDone = mRowRange.computePercent(static_cast<int>(loc.mY));
+         int percentDone = mRowRange.computePercent(row);
          if (percentDone >= oldPercentDone + 25)
          {
             oldPercentDone = percentDone;
             getReporter().reportProgress(getThreadIndex(), percentDone);
          }
 
-         da->toPixel(static_cast<int>(loc.mY), static_cast<int>(loc.mX));
-         VERIFYNRV(da.isValid());
-
-         // Inner band loop for BIP, will break for other interleaves
-         for (std::vector<DimensionDescriptor>::const_iterator bipBandIt = mInput.mStatInput.mBandsToCalculate.begin();
-              bipBandIt != mInput.mStatInput.mBandsToCalculate.end(); ++bipBandIt)
+         if (spans)
          {
-            double temp = ModelServices::getDataValue(encoding,
-               da->getColumn(), mInput.mStatInput.mComplexComponent,
-               isBip ? bipBandIt->getActiveNumber() : 0);
+            int firstColumn = getFirstResolutionColumn(row, static_cast<int>(columnCount), resolution);
+            size_t spanLength = getSpanLength(firstColumn, static_cast<int>(columnCount), resolution);
+            if (spanLength == 0)
+            {
+               continue;
+            }
 
-            bool badValue = false;
-            if (hasBadValues)
+            // Only the columns selected by the resolution are converted
+            da->toPixel(row, firstColumn);
+            VERIFYNRV(da.isValid());
+            for (size_t band = 0; band < bandCount; ++band)
             {
-               if (hasSingleBadValueRange)
-               {
-                  badValue = temp > badValueLower && temp < badValueUpper;
-               }
-               else
-               {
-                  badValue = mInput.mStatInput.mpBadValues->isBadValue(temp);
-               }
+               double* pValues = &rowValues[band * columnCount];
+               da->getRowAs(pValues, spanLength,
+                  isBip ? statInput.mBandsToCalculate[band].getActiveNumber() : 0, component, resolution);
+               mCount += binSpan(pValues, spanLength, 1, pBadValues, hasSingleBadValueRange,
+                  badValueLower, badValueUpper, minimum, toBin, &binCounts.front());
             }
 
-            if (!badValue)
+            continue;
+         }
+
+         // The AOI selects the pixels of the row one at a time
+         for (; diter != diter.end() && diter.getPixelRowLocation() == row; diter.nextPixel())
+         {
+            if (row != currentRow)
             {
-               int bin = static_cast<int>((temp-mInput.mStatistics.mMinimum) * toBin);
-               if (bin >= HISTOGRAM_SIZE)
+               currentRow = row;
+               da->toPixel(currentRow, startColumn);
+               VERIFYNRV(da.isValid());
+               for (size_t band = 0; band < bandCount; ++band)
                {
-                  bin = HISTOGRAM_SIZE - 1;
+                  da->getRowAs(&rowValues[band * columnCount], columnCount,
+                     isBip ? statInput.mBandsToCalculate[band].getActiveNumber() : 0, component);
                }
-               else if (bin < 0)
-               {
-                  bin = 0;
-               }
-
-               binCounts[bin]++;
-               mCount++;
             }
-            if (!isBip)
-            {
-               // this inner band loop is only for BIP
-               break;
-            }
-         }
 
-         diter.nextPixel();
+            // Inner band loop for BIP, a single band for other interleaves
+            const double* pValues = &rowValues[diter.getPixelColumnLocation() - startColumn];
+            mCount += binSpan(pValues, bandCount, columnCount, pBadValues, hasSingleBadValueRange, badValueLower,
+               badValueUpper, minimum, toBin, &binCounts.front());
+         }
       }
       if (isBip)
       {
@@ -1172,6 +1972,16 @@ bool HistogramOutput::compileOverallResults(const std::vector<HistogramThread*>&
    std::vector<unsigned int> totalBinCounts(HISTOGRAM_SIZE);
 
    sumAllThreads(threads, totalBinCounts);
+   return compileResults(totalBinCounts);
+}
+
+bool HistogramOutput::compileResults(const std::vector<unsigned int>& totalBinCounts)
+{
+   if (totalBinCounts.size() != HISTOGRAM_SIZE)
+   {
+      return false;
+   }
+
    computeBinCenters();
    computeResultHistogram(totalBinCounts);
    computePercentiles(totalBinCounts);
@@ -1194,6 +2004,13 @@ const double* HistogramOutput::getPercentiles() const
    return mPercentiles;
 }
 
+void HistogramOutput::getResults(StatisticsCache::Entry& values) const
+{
+   values.mPercentiles.assign(mPercentiles, mPercentiles + 1001);
+   values.mBinCenters.assign(mBinCenters, mBinCenters + 256);
+   values.mBinCounts.assign(mBinCounts, mBinCounts + 256);
+}
+
 void HistogramOutput::sumAllThreads(const std::vector<HistogramThread*>& threads,
                                     std::vector<unsigned int>& totalBinCounts)
 {
@@ -1324,3 +2141,247 @@ void StatisticsImp::badValuesChanged(Subject& subject, const std::string& signal
 {
    resetAll();
 }
+
+BandStatistics::BandStatistics(bool isInteger, int histogramSize, const BadValues* pBadValues) :
+   mMaxMinSet(false),
+   mMaximum(-std::numeric_limits<double>::max()),
+   mMinimum(std::numeric_limits<double>::max()),
+   mSum(0.0),
+   mSumSquared(0.0),
+   mCount(0),
+   mHistogram(isInteger, histogramSize),
+   mpBadValues(pBadValues),
+   mHasBadValues(pBadValues != NULL && pBadValues->empty() == false),
+   mHasSingleBadValueRange(false),
+   mBadValueLower(0.0),
+   mBadValueUpper(0.0)
+{
+   if (mHasBadValues)
+   {
+      mHasSingleBadValueRange = mpBadValues->getSingleBadValueRange(mBadValueLower, mBadValueUpper);
+   }
+}
+
+void BandStatistics::addSpan(const double* pValues, size_t count, size_t step)
+{
+   const BadValues* pBadValues = mHasBadValues ? mpBadValues : NULL;
+   accumulateSpan(pValues, count, step, pBadValues, mHasSingleBadValueRange, mBadValueLower, mBadValueUpper,
+      mMinimum, mMaximum, mSum, mSumSquared, mCount);
+   addToHistogram(pValues, count, step, pBadValues, mHasSingleBadValueRange, mBadValueLower, mBadValueUpper,
+      mHistogram);
+   mMaxMinSet = mCount > 0;
+}
+
+BandStatisticsOutput::BandStatisticsOutput(bool isInteger) :
+   mIsInteger(isInteger)
+{}
+
+bool BandStatisticsOutput::compileOverallResults(const std::vector<BandStatisticsThread*>& threads)
+{
+   mBands.clear();
+   if (threads.empty() || threads.front() == NULL)
+   {
+      return false;
+   }
+
+   unsigned int bandCount = threads.front()->getBandCount();
+   mBands.resize(bandCount);
+
+   std::vector<unsigned int> totalBinCounts(HISTOGRAM_SIZE);
+   for (unsigned int band = 0; band < bandCount; ++band)
+   {
+      bool maxMinSet = false;
+      double maximum = -std::numeric_limits<double>::max();
+      double minimum = std::numeric_limits<double>::max();
+      double totalSum = 0.0;
+      double totalSquaredSum = 0.0;
+      unsigned int pointCount = 0;
+      for (std::vector<BandStatisticsThread*>::const_iterator iter = threads.begin(); iter != threads.end(); ++iter)
+      {
+         if (*iter != NULL)
+         {
+            const BandStatistics& statistics = (*iter)->getBandStatistics(band);
+            if (statistics.mMaxMinSet)
+            {
+               maxMinSet = true;
+               maximum = std::max(maximum, statistics.mMaximum);
+               minimum = std::min(minimum, statistics.mMinimum);
+            }
+            totalSum += statistics.mSum;
+            totalSquaredSum += statistics.mSumSquared;
+            pointCount += statistics.mCount;
+         }
+      }
+
+      StatisticsCache::Entry& values = mBands[band];
+      computeMoments(totalSum, totalSquaredSum, pointCount, values.mAverage, values.mStandardDeviation);
+      if (maxMinSet)
+      {
+         // the thread histograms cover different ranges, so they are combined over the overall range
+         std::fill(totalBinCounts.begin(), totalBinCounts.end(), 0);
+         double toBin = getHistogramBinFactor(maximum, minimum);
+         for (std::vector<BandStatisticsThread*>::const_iterator iter = threads.begin();
+            iter != threads.end(); ++iter)
+         {
+            if (*iter != NULL)
+            {
+               (*iter)->getBandStatistics(band).mHistogram.addTo(minimum, toBin, totalBinCounts);
+            }
+         }
+
+         HistogramOutput histOutput(mIsInteger, maximum, minimum);
+         VERIFY(histOutput.compileResults(totalBinCounts));
+         values.mMinimum = minimum;
+         values.mMaximum = maximum;
+         histOutput.getResults(values);
+      }
+      else
+      {
+         values.mMinimum = 0.0;
+         values.mMaximum = 0.0;
+         values.mPercentiles.assign(1001, 0.0);
+         values.mBinCenters.assign(256, 0.0);
+         values.mBinCounts.assign(256, 0);
+      }
+   }
+
+   return true;
+}
+
+BandStatisticsThread::BandStatisticsThread(const BandStatisticsInput& input, int threadCount, int threadIndex,
+                                           ThreadReporter& reporter) :
+   AlgorithmThread(threadIndex, reporter),
+   mInput(input),
+   mRowRange(getThreadRange(threadCount, static_cast<const RasterDataDescriptor*>(
+                                 input.mpRasterElement->getDataDescriptor())->getRowCount()))
+{
+   const RasterDataDescriptor* pDescriptor = static_cast<const RasterDataDescriptor*>(
+      mInput.mpRasterElement->getDataDescriptor());
+   bool isInteger = isIntegerData(pDescriptor->getDataType(), mInput.mComplexComponent);
+
+   // The histograms of the bands share a fixed number of bins, which must be even
+   int histogramSize = BAND_HISTOGRAM_BUDGET / std::max(static_cast<int>(mInput.mBands.size()), 1);
+   histogramSize = std::max(MINIMUM_BAND_HISTOGRAM_SIZE, std::min(histogramSize, HISTOGRAM_SIZE));
+   histogramSize -= histogramSize % 2;
+
+   mBands.reserve(mInput.mBands.size());
+   for (std::vector<const BadValues*>::size_type band = 0; band < mInput.mBands.size(); ++band)
+   {
+      mBands.push_back(BandStatistics(isInteger, histogramSize, mInput.mBadValues[band]));
+   }
+}
+
+void BandStatisticsThread::run()
+{
+   const RasterDataDescriptor* pDescriptor = static_cast<const RasterDataDescriptor*>(
+      mInput.mpRasterElement->getDataDescriptor());
+   VERIFYNRV(pDescriptor != NULL);
+
+   const std::vector<DimensionDescriptor>& bands = mInput.mBands;
+   if (bands.empty())
+   {
+      return;
+   }
+
+   // BIP and BIL data hold all of the bands of a row together, so every band is read in one sweep
+   // over the rows.  BSQ data is read one band at a time.
+   bool allBands = pDescriptor->getInterleaveFormat() != BSQ;
+   unsigned int firstBand = bands.front().getActiveNumber();
+   unsigned int lastBand = firstBand;
+   for (std::vector<DimensionDescriptor>::const_iterator bandIt = bands.begin(); bandIt != bands.end(); ++bandIt)
+   {
+      firstBand = std::min(firstBand, bandIt->getActiveNumber());
+      lastBand = std::max(lastBand, bandIt->getActiveNumber());
+   }
+
+   size_t passCount = allBands ? 1 : bands.size();
+   size_t passBandCount = allBands ? bands.size() : 1;
+   ComplexComponent component = mInput.mComplexComponent;
+   int stride = std::max(mInput.mStride, 1);
+   int oldPercentDone = -1;
+
+   // A stride reads a grid of the rows and columns which are multiples of it, and a resolution reads a span of
+   // every resolution-th pixel from each row
+   int startRow = (mRowRange.mFirst + stride - 1) / stride * stride;
+   int endRow = mRowRange.mLast;
+   int resolution = stride > 1 ? 1 : std::max(mInput.mResolution, 1);
+   if (startRow > endRow)
+   {
+      return;
+   }
+
+   for (size_t pass = 0; pass < passCount; ++pass)
+   {
+      FactoryResource<DataRequest> pRequest;
+      pRequest->setRows(pDescriptor->getActiveRow(startRow), pDescriptor->getActiveRow(endRow), 0);
+      pRequest->setColumns(pDescriptor->getActiveColumn(0),
+                           pDescriptor->getActiveColumn(pDescriptor->getColumnCount() - 1), 0);
+      if (stride > 1)
+      {
+         pRequest->setRowStride(stride);
+         pRequest->setColumnStride(stride);
+      }
+      if (allBands)
+      {
+         pRequest->setBands(pDescriptor->getActiveBand(firstBand), pDescriptor->getActiveBand(lastBand),
+                            lastBand - firstBand + 1);
+      }
+      else
+      {
+         pRequest->setBands(bands[pass], bands[pass], 1);
+      }
+      DataAccessor da(mInput.mpRasterElement->getDataAccessor(pRequest.release()));
+      if (!da.isValid())
+      {
+         return;
+      }
+
+      // Each row is converted once for all of its pixels, one span per band
+      size_t columnCount = (pDescriptor->getColumnCount() - 1) / stride + 1;
+      std::vector<double> rowValues(columnCount * passBandCount);
+
+      for (int row = startRow; row <= endRow; row += stride)
+      {
+         int percentDone = static_cast<int>((pass * 100 + mRowRange.computePercent(row)) / passCount);
+         if (percentDone >= oldPercentDone + 25)
+         {
+            oldPercentDone = percentDone;
+            getReporter().reportProgress(getThreadIndex(), percentDone);
+         }
+
+         if (mInput.mpAbort != NULL && *mInput.mpAbort)
+         {
+            return;
+         }
+
+         int firstColumn = getFirstResolutionColumn(row, static_cast<int>(columnCount), resolution);
+         size_t spanLength = getSpanLength(firstColumn, static_cast<int>(columnCount), resolution);
+         if (spanLength == 0)
+         {
+            continue;
+         }
+
+         // Only the columns selected by the resolution are converted, and a stride has already skipped the
+         // other columns in the accessor
+         da->toPixel(row, firstColumn * stride);
+         VERIFYNRV(da.isValid());
+         for (size_t band = 0; band < passBandCount; ++band)
+         {
+            double* pValues = &rowValues[band * columnCount];
+            da->getRowAs(pValues, spanLength, allBands ? bands[band].getActiveNumber() - firstBand : 0, component,
+               resolution);
+            mBands[allBands ? band : pass].addSpan(pValues, spanLength, 1);
+         }
+      }
+   }
+}
+
+unsigned int BandStatisticsThread::getBandCount() const
+{
+   return static_cast<unsigned int>(mBands.size());
+}
+
+const BandStatistics& BandStatisticsThread::getBandStatistics(unsigned int band) const
+{
+   return mBands[band];
+}
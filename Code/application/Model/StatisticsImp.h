@@ -19,15 +19,19 @@
 #include "ObjectResource.h"
 #include "SafePtr.h"
 #include "Statistics.h"
+#include "StatisticsCache.h"
+#include "SubjectImp.h"
 
 #include <boost/any.hpp>
+#include <boost/atomic.hpp>
 #include <map>
 #include <vector>
 
+class BackgroundStatistics;
 class RasterElement;
 class RasterElementImp;
 
-class StatisticsImp : public Statistics
+class StatisticsImp : public Statistics, public SubjectImp
 {
 public:
    StatisticsImp(const RasterElementImp* pRasterElement, DimensionDescriptor band, AoiElement* pAoi = NULL);
@@ -36,6 +40,11 @@ public:
                  AoiElement* pAoi = NULL);
    virtual ~StatisticsImp();
 
+   SUBJECTADAPTER_METHODS(SubjectImp)
+
+   const std::string& getObjectType() const;
+   bool isKindOf(const std::string& className) const;
+
    void setMin(double dMin);
    void setMin(double dMin, ComplexComponent component);
    double getMin();
@@ -77,20 +86,78 @@ public:
 
    bool areStatisticsCalculated() const;
    bool areStatisticsCalculated(ComplexComponent component) const;
+   void calculateProgressively(ComplexComponent component);
    void reset(ComplexComponent component);
    void resetAll();
 
    bool toXml(XMLWriter* pXml) const;
    bool fromXml(DOMNode* pDocument, unsigned int version);
 
+   /**
+    * Calculates the statistics of several bands with one pass over the data.
+    *
+    * The statistics which are not yet calculated for the component are
+    * computed together, with a single read of the data for BIP and BIL data
+    * and one read per band for BSQ data.  Statistics over more than one band
+    * or over an AOI, and those of another raster element than the first, are
+    * calculated individually.  The histograms are always accumulated in the
+    * same pass as the other statistics.
+    *
+    * @param statistics
+    *        The statistics of the bands to calculate.
+    * @param component
+    *        The complex component for which to calculate the statistics.
+    */
+   static void calculateStatistics(const std::vector<StatisticsImp*>& statistics, ComplexComponent component);
+
+   /**
+    * Calculates the statistics of one band with the bulk band algorithm.
+    *
+    * @param pRaster
+    *        The raster element containing the band.
+    * @param band
+    *        The band for which to calculate the statistics.
+    * @param pBadValues
+    *        The values to exclude from the statistics.  May be \c NULL.
+    * @param component
+    *        The complex component for which to calculate the statistics.
+    * @param resolution
+    *        The statistics resolution, which is used if \p stride is 1.
+    * @param stride
+    *        The number of rows and columns between the pixels which are read.
+    *        A stride greater than 1 reads a regular grid of pixels with a
+    *        strided DataRequest instead of every \p resolution-th pixel.
+    * @param pReporter
+    *        The progress reporter.  May be \c NULL.
+    * @param pAbort
+    *        Stops the calculation when it becomes \c true.  May be \c NULL.
+    * @param values
+    *        Populated with the statistics.
+    *
+    * @return \c True if the statistics were calculated, or \c false if the
+    *         calculation failed or was aborted.
+    */
+   static bool calculateBandStatistics(const RasterElement* pRaster, DimensionDescriptor band,
+      const BadValues* pBadValues, ComplexComponent component, int resolution, int stride,
+      mta::ProgressReporter* pReporter, const boost::atomic<bool>* pAbort, StatisticsCache::Entry& values);
+
 protected:
    void calculateStatistics(ComplexComponent component);
    void badValuesChanged(Subject& subject, const std::string& signal, const boost::any& value);
 
 private:
+   friend class BackgroundStatistics;
+
    StatisticsImp(const StatisticsImp& rhs);
    StatisticsImp& operator=(const StatisticsImp& rhs);
 
+   void cancelBackgroundCalculation(ComplexComponent component);
+   void backgroundCalculationFinished(ComplexComponent component, const StatisticsCache::Entry* pValues);
+
+   void updateStatisticsResolution(int rowCount, int columnCount);
+   void setStatistics(const StatisticsCache::Entry& values, ComplexComponent component);
+   void getStatistics(StatisticsCache::Entry& values, ComplexComponent component);
+
    // NOTE: this has to be a RasterElementImp instead of RasterElement as it is populated
    // in the RasterElementImp constructor. At that point, a dynamic_cast to RasterElement
    // is not possible.
@@ -108,21 +175,26 @@ private:
 
    int mStatisticsResolution;
    BadValuesAdapter mBadValues;
+   std::map<ComplexComponent, BackgroundStatistics*> mBackgroundCalculations;
 };
 
+const int HISTOGRAM_SIZE = 128 * 1024;
+
 class StatisticsInput
 {
 public:
    StatisticsInput(const std::vector<DimensionDescriptor>& bandsToCalculate, const RasterElement* pRaster,
                    ComplexComponent component, int resolution = 1,
                    const BadValues* pBadValues = NULL,
-                   const BitMask* pAoi = NULL) :
+                   const BitMask* pAoi = NULL,
+                   bool singlePass = false) :
       mBandsToCalculate(bandsToCalculate),
       mpRasterElement(pRaster),
       mComplexComponent(component),
       mResolution(resolution),
       mpBadValues(pBadValues),
-      mpAoi(pAoi)
+      mpAoi(pAoi),
+      mSinglePass(singlePass)
    {
    }
 
@@ -131,24 +203,82 @@ public:
    ComplexComponent mComplexComponent;
    int mResolution;
    const BadValues* mpBadValues;
-   const BitMask* mpAoi;
+   const BitMask* mpAoi;   // the pixels of the AOI at the resolution, or NULL for every pixel at the resolution
+   bool mSinglePass;    // accumulate the histogram while the other statistics are computed
 
 private:
    StatisticsInput& operator=(const StatisticsInput& rhs);
 };
 
+/**
+ * A histogram of HISTOGRAM_SIZE bins over a range which grows to hold the values added to it.
+ *
+ * The bins start one unit wide for integer data, or as wide as needed to hold the first two
+ * distinct values otherwise.  When a value falls outside of the range, the counted bins are
+ * moved to make room for it if they can be, or else the bin width is doubled and adjacent bins
+ * are combined until it fits.  The histogram can therefore be accumulated before the minimum
+ * and maximum of the data are known.
+ */
+class AdaptiveHistogram
+{
+public:
+   /**
+    * Creates an empty histogram.
+    *
+    * @param isInteger
+    *        Whether the values added to the histogram are integers.
+    * @param binCount
+    *        The number of bins, which must be even.  Fewer bins than HISTOGRAM_SIZE
+    *        save memory when many histograms are accumulated at once, but the
+    *        bins may then be wider than one unit for integer data.
+    */
+   explicit AdaptiveHistogram(bool isInteger, int binCount = HISTOGRAM_SIZE);
+
+   void add(double value);
+
+   /**
+    * Adds the counts of this histogram to one over a known range.
+    *
+    * Each count is placed at the lower edge of its bin, which is exact for integer
+    * data as long as the bins are one unit wide.
+    *
+    * @param minimum
+    *        The lower bound of the range of \p binCounts.
+    * @param toBin
+    *        The factor which converts an offset from \p minimum to a bin of \p binCounts.
+    * @param binCounts
+    *        The HISTOGRAM_SIZE bins to add to.
+    */
+   void addTo(double minimum, double toBin, std::vector<unsigned int>& binCounts) const;
+
+private:
+   void grow(double value);
+
+   bool mIsInteger;
+   int mBinCount;
+   std::vector<unsigned int> mBins;     // allocated by the first value added
+   double mLower;
+   double mWidth;          // 0 until two distinct values have been added to a floating point histogram
+   double mFirstValue;
+   unsigned int mFirstCount;
+};
+
 class StatisticsThread;
 class StatisticsOutput
 {
 public:
-   StatisticsOutput();
+   explicit StatisticsOutput(bool singlePass = false);
 
    bool mMaxMinSet;
    double mMaximum;
    double mMinimum;
    double mAverage;
    double mStandardDeviation;
+   std::vector<unsigned int> mHistogram;   // HISTOGRAM_SIZE bins over [mMinimum, mMaximum] for a single pass
    bool compileOverallResults(const std::vector<StatisticsThread*>& threads);
+
+private:
+   bool mSinglePass;
 };
 
 class StatisticsThread : public mta::AlgorithmThread
@@ -165,6 +295,7 @@ public:
    double getSum() const;
    double getSumSquared() const;
    unsigned int getCount() const;
+   const AdaptiveHistogram& getHistogram() const;
 
 private:
    StatisticsThread& operator=(const StatisticsThread& rhs);
@@ -178,6 +309,7 @@ private:
    double mSum;
    double mSumSquared;
    unsigned int mCount;
+   AdaptiveHistogram mHistogram;
 };
 
 class HistogramInput
@@ -193,7 +325,6 @@ private:
 };
 
 class HistogramThread;
-const int HISTOGRAM_SIZE = 128 * 1024;
 class HistogramOutput
 {
 public:
@@ -201,9 +332,11 @@ public:
       mIsInteger(isInteger), mMaximum(maximum), mMinimum(minimum) {}
 
    bool compileOverallResults(const std::vector<HistogramThread*>& threads);
+   bool compileResults(const std::vector<unsigned int>& totalBinCounts);
    const double* getBinCenters() const;
    const unsigned int* getBinCounts() const;
    const double* getPercentiles() const;
+   void getResults(StatisticsCache::Entry& values) const;
 
 private:
    void sumAllThreads(const std::vector<HistogramThread*>& threads, std::vector<unsigned int>& totalBinCounts);
@@ -239,4 +372,100 @@ private:
    std::vector<unsigned int> mBinCounts;
 };
 
+/**
+ * The statistics of one band accumulated by a BandStatisticsThread.
+ */
+class BandStatistics
+{
+public:
+   BandStatistics(bool isInteger, int histogramSize, const BadValues* pBadValues);
+
+   /**
+    * Adds every step-th value of a span of count values, except for the bad values.
+    */
+   void addSpan(const double* pValues, size_t count, size_t step);
+
+   bool mMaxMinSet;
+   double mMaximum;
+   double mMinimum;
+   double mSum;
+   double mSumSquared;
+   unsigned int mCount;
+   AdaptiveHistogram mHistogram;
+
+private:
+   const BadValues* mpBadValues;
+   bool mHasBadValues;
+   bool mHasSingleBadValueRange;
+   double mBadValueLower;
+   double mBadValueUpper;
+};
+
+class BandStatisticsInput
+{
+public:
+   BandStatisticsInput(const std::vector<DimensionDescriptor>& bands,
+                       const std::vector<const BadValues*>& badValues,
+                       const RasterElement* pRaster,
+                       ComplexComponent component,
+                       int resolution,
+                       int stride = 1,
+                       const boost::atomic<bool>* pAbort = NULL) :
+      mBands(bands),
+      mBadValues(badValues),
+      mpRasterElement(pRaster),
+      mComplexComponent(component),
+      mResolution(resolution),
+      mStride(stride),
+      mpAbort(pAbort)
+   {
+   }
+
+   const std::vector<DimensionDescriptor>& mBands;
+   const std::vector<const BadValues*>& mBadValues;     // one for each band
+   const RasterElement* mpRasterElement;
+   ComplexComponent mComplexComponent;
+   int mResolution;                     // every mResolution-th pixel in row-major order is read
+   int mStride;                         // every mStride-th row and column is read instead, from 0
+   const boost::atomic<bool>* mpAbort;  // stops the threads when set
+
+private:
+   BandStatisticsInput& operator=(const BandStatisticsInput& rhs);
+};
+
+class BandStatisticsThread;
+class BandStatisticsOutput
+{
+public:
+   explicit BandStatisticsOutput(bool isInteger);
+
+   bool compileOverallResults(const std::vector<BandStatisticsThread*>& threads);
+
+   std::vector<StatisticsCache::Entry> mBands;
+
+private:
+   bool mIsInteger;
+};
+
+class BandStatisticsThread : public mta::AlgorithmThread
+{
+public:
+   BandStatisticsThread(const BandStatisticsInput& input, int threadCount, int threadIndex,
+      mta::ThreadReporter& reporter);
+   virtual ~BandStatisticsThread() {};
+
+   virtual void run();
+
+   unsigned int getBandCount() const;
+   const BandStatistics& getBandStatistics(unsigned int band) const;
+
+private:
+   BandStatisticsThread& operator=(const BandStatisticsThread& rhs);
+
+   const BandStatisticsInput& mInput;
+
+   Range mRowRange;
+   std::vector<BandStatistics> mBands;
+};
+
 #endif
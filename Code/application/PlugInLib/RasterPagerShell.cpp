@@ -31,6 +31,11 @@ bool RasterPagerShell::getOutputSpecification(PlugInArgList*& pArgList)
    return true;
 }
 
+void RasterPagerShell::prefetchPage(DataRequest* pOriginalRequest, DimensionDescriptor startRow,
+   DimensionDescriptor startColumn, DimensionDescriptor startBand)
+{
+}
+
 bool RasterPagerShell::serialize(SessionItemSerializer& serializer) const
 {
    return true;
@@ -43,6 +43,14 @@ public:
     */
    bool getOutputSpecification(PlugInArgList*& pArgList);
 
+   /**
+    *  @copydoc RasterPager::prefetchPage()
+    *
+    *  @default The default implementation ignores the hint.
+    */
+   void prefetchPage(DataRequest* pOriginalRequest, DimensionDescriptor startRow,
+      DimensionDescriptor startColumn, DimensionDescriptor startBand);
+
    /**
     *  The default pager session serialization method.
     *
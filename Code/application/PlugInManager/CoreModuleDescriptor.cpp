@@ -9,6 +9,8 @@
 
 #include "AppVersion.h"
 #include "AppVerify.h"
+#include "ChipViewPager.h"
+#include "CompressedInMemoryPager.h"
 #include "CopyrightInformation.h"
 #include "CoreModuleDescriptor.h"
 #include "InMemoryPager.h"
@@ -101,6 +103,8 @@ void CoreModuleDescriptor::unload()
 
 GENERATE_FACTORY(OpticksCore);
 
+REGISTER_PLUGIN_BASIC(OpticksCore, ChipViewPager);
+REGISTER_PLUGIN_BASIC(OpticksCore, CompressedInMemoryPager);
 REGISTER_PLUGIN_BASIC(OpticksCore, CopyrightInformation);
 REGISTER_PLUGIN_BASIC(OpticksCore, InMemoryPager);
 REGISTER_PLUGIN_BASIC(OpticksCore, MemoryMappedPager);
@@ -18,7 +18,8 @@ CachedPage::CacheUnit::CacheUnit(char* pData, DimensionDescriptor startRow, int
    mConcurrentRows(concurrentRows),
    mBand(band),
    mSize(size),
-   mInterlineBytes(interlineBytes)
+   mInterlineBytes(interlineBytes),
+   mDirty(false)
 {
 }
 
@@ -68,10 +69,36 @@ unsigned int CachedPage::CacheUnit::getInterlineBytes()
    return mInterlineBytes;
 }
 
+void CachedPage::CacheUnit::setDirty(bool dirty)
+{
+   mDirty = dirty;
+}
+
+bool CachedPage::CacheUnit::isDirty() const
+{
+   return mDirty.load();
+}
+
 CachedPage::CachedPage(UnitPtr pCacheUnit, size_t offset, DimensionDescriptor startRow) :
    mpCacheUnit(pCacheUnit),
    mOffset(offset),
-   mStartRow(startRow)
+   mStartRow(startRow),
+   mNumColumns(0),
+   mSkipBytes(0),
+   mRowStride(1),
+   mWritable(false)
+{
+}
+
+CachedPage::CachedPage(UnitPtr pCacheUnit, size_t offset, DimensionDescriptor startRow, unsigned int numColumns,
+                       unsigned int skipBytes, unsigned int rowStride) :
+   mpCacheUnit(pCacheUnit),
+   mOffset(offset),
+   mStartRow(startRow),
+   mNumColumns(numColumns),
+   mSkipBytes(skipBytes),
+   mRowStride(rowStride),
+   mWritable(false)
 {
 }
 
@@ -87,12 +114,12 @@ void* CachedPage::getRawData()
 unsigned int CachedPage::getNumRows()
 {
    unsigned int rowOffset = mStartRow.getActiveNumber() - mpCacheUnit->getStartRow().getActiveNumber();
-   return mpCacheUnit->getConcurrentRows() - rowOffset;
+   return (mpCacheUnit->getConcurrentRows() - rowOffset + mRowStride - 1) / mRowStride;
 }
 
 unsigned int CachedPage::getNumColumns()
 {
-   return 0;
+   return mNumColumns;
 }
 
 unsigned int CachedPage::getNumBands()
@@ -102,5 +129,20 @@ unsigned int CachedPage::getNumBands()
 
 unsigned int CachedPage::getInterlineBytes()
 {
-   return mpCacheUnit->getInterlineBytes();
+   return mpCacheUnit->getInterlineBytes() + mSkipBytes;
+}
+
+CachedPage::UnitPtr CachedPage::getCacheUnit() const
+{
+   return mpCacheUnit;
+}
+
+void CachedPage::setWritable(bool writable)
+{
+   mWritable = writable;
+}
+
+bool CachedPage::isWritable() const
+{
+   return mWritable;
 }
@@ -8,10 +8,12 @@
  */
 
 #include "AppVerify.h"
+#include "bthread.h"
 #include "CachedPager.h"
 #include "DataDescriptor.h"
 #include "DataRequest.h"
 #include "DMutex.h"
+#include "FileResource.h"
 #include "Filename.h"
 #include "ModelServices.h"
 #include "ObjectResource.h"
@@ -21,34 +23,92 @@
 #include "RasterDataDescriptor.h"
 #include "RasterElement.h"
 
+#include <limits>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
 using namespace std;
 
+namespace
+{
+   // The number of read-ahead requests which may be waiting for the background
+   // thread.  The oldest requests are the least likely to still be useful, so
+   // they are discarded first.
+   const size_t MAX_READ_AHEAD_REQUESTS = 8;
+
+   unsigned int getOverlayBand(CachedPage::UnitPtr pUnit)
+   {
+      DimensionDescriptor band = pUnit->getBand();
+      return band.isActiveNumberValid() ? band.getActiveNumber() : numeric_limits<unsigned int>::max();
+   }
+}
+
 CachedPager::CachedPager() :
-   mCache(10 * 1024 * 1024),
+   mCache(CachedPager::getSettingCacheSize()),
+   mCounters("CachedPager"),
    mpMutex(new mta::DMutex),
+   mpReadAheadMutex(new mta::DMutex),
+   mpReadAheadSignal(new mta::DThreadSignal),
+   mReadAheadGeneration(0),
+   mOutstandingPages(0),
+   mStopReadAhead(false),
    mpDescriptor(NULL),
    mpRaster(NULL),
    mBytesPerBand(0),
    mColumnCount(0),
    mBandCount(0),
-   mRowCount(0)
+   mRowCount(0),
+   mUnitRowCount(1),
+   mOverlaySize(0)
 {
+   mCache.setWriteBack(this);
 }
 
 CachedPager::CachedPager(const size_t cacheSize) :
    mCache(cacheSize),
+   mCounters("CachedPager"),
    mpMutex(new mta::DMutex),
+   mpReadAheadMutex(new mta::DMutex),
+   mpReadAheadSignal(new mta::DThreadSignal),
+   mReadAheadGeneration(0),
+   mOutstandingPages(0),
+   mStopReadAhead(false),
    mpDescriptor(NULL),
    mpRaster(NULL),
    mBytesPerBand(0),
    mColumnCount(0),
    mBandCount(0),
-   mRowCount(0)
+   mRowCount(0),
+   mUnitRowCount(1),
+   mOverlaySize(0)
 {
+   mCache.setWriteBack(this);
 }
 
 CachedPager::~CachedPager()
 {
+   {
+      mta::MutexLock lock(*mpReadAheadMutex);
+      mStopReadAhead = true;
+      clearReadAheadQueue();
+      mpReadAheadSignal->ThreadSignalActivate();
+   }
+
+   if (mpReadAheadThread.get() != NULL)
+   {
+      mpReadAheadThread->ThreadWait();
+   }
+
+   // The overrides of flushUnit() have already been destroyed, so pagers which override it flush their units
+   // from their own destructor.  Other modified units would only go to the overlay, which is deleted here.
+   mCache.setWriteBack(NULL);
+
+   if (mpOverlayFile.get() != NULL)
+   {
+      mpOverlayFile->close();
+      remove(mOverlayFilename.c_str());
+   }
 }
 
 bool CachedPager::getInputSpecification(PlugInArgList *&pArgList)
@@ -107,7 +167,22 @@ bool CachedPager::parseInputArgs(PlugInArgList *pInputArgList)
    }
    mFilename = pFilename->getFullPathAndName();
 
-   mCache.initialize(mBytesPerBand, mColumnCount, mBandCount);
+   // Units hold a chunk of whole rows (and all bands unless BSQ)
+   unsigned int bandsPerUnit = (mpDescriptor->getInterleaveFormat() == BSQ) ? 1 : mBandCount;
+   double rowSize = static_cast<double>(bandsPerUnit) * mColumnCount * mBytesPerBand;
+   mUnitRowCount = 1;
+   if (rowSize > 0.0)
+   {
+      mUnitRowCount = std::max(1U, static_cast<unsigned int>(getChunkSize() / rowSize));
+   }
+
+   mCache.initialize(mBytesPerBand, mColumnCount, mBandCount, mUnitRowCount);
+   mCache.setRasterElement(mpRaster);
+   mCounters.setRasterElement(mpRaster);
+   if (getName().empty() == false)
+   {
+      mCounters.setPagerName(getName());
+   }
 
    return true;
 }
@@ -117,74 +192,156 @@ RasterPage* CachedPager::getPage(DataRequest *pOriginalRequest,
       DimensionDescriptor startColumn, 
       DimensionDescriptor startBand)
 {
-   if (pOriginalRequest == NULL)
+   mCounters.addGetPageCall();
+   VERIFYRV(pOriginalRequest != NULL, NULL);
+
+   InterleaveFormatType requestedFormat = pOriginalRequest->getInterleaveFormat();
+   if (requestedFormat != mpDescriptor->getInterleaveFormat())
    {
       return NULL;
    }
-   if (pOriginalRequest->getWritable())
+
+   CachedPage::UnitPtr pUnit = mCache.getUnit(pOriginalRequest, startRow, startBand);
+   if (pUnit.get() == NULL) // cache miss
    {
-      return NULL;
+      PagerCounters::TimedLock lock(*mpMutex, mCounters);
+
+      // another thread may have fetched the unit while waiting on the lock
+      pUnit = mCache.getUnit(pOriginalRequest, startRow, startBand);
+      if (pUnit.get() == NULL)
+      {
+         mCounters.addCacheMiss();
+         pUnit = fetchAlignedUnit(pOriginalRequest, startRow, startBand);
+      }
+      else
+      {
+         mCounters.addCacheHit();
+      }
+   }
+   else
+   {
+      mCounters.addCacheHit();
    }
 
-   VERIFYRV(pOriginalRequest != NULL, NULL);
+   // units always hold whole rows, so a tile is a page over some of the columns of a unit
+   unsigned int numColumns = 0;
+   if (pOriginalRequest->getTiled())
+   {
+      unsigned int stopColumn = pOriginalRequest->getStopColumn().getActiveNumber();
+      numColumns = std::min(pOriginalRequest->getConcurrentColumns(), stopColumn - startColumn.getActiveNumber() + 1);
+   }
 
-   mta::MutexLock lock(*mpMutex);
+   CachedPage* pPage = mCache.createPage(pUnit, requestedFormat, startRow, startColumn, startBand, numColumns,
+      pOriginalRequest->getRowStride());
+   if (pPage != NULL)
+   {
+      if (pOriginalRequest->getWritable())
+      {
+         pPage->setWritable(true);
+         pUnit->setDirty(true);
+      }
 
+      mCounters.addPageLeased();
 
-   InterleaveFormatType requestedFormat = pOriginalRequest->getInterleaveFormat();
-   DimensionDescriptor stopRow = pOriginalRequest->getStopRow();
-   DimensionDescriptor stopBand = pOriginalRequest->getStopBand();
-   unsigned int concurrentBands = pOriginalRequest->getConcurrentBands();
+      mta::MutexLock lock(*mpReadAheadMutex);
+      ++mOutstandingPages;
+   }
 
-   if (requestedFormat != mpDescriptor->getInterleaveFormat())
+   return pPage;
+}
+
+void CachedPager::releasePage(RasterPage *pPage)
+{
+   CachedPage* pCachedPage = dynamic_cast<CachedPage*>(pPage);
+   if (pCachedPage == NULL)
    {
-      return NULL;
+      return;
    }
 
-   CachedPage::UnitPtr pUnit = mCache.getUnit(pOriginalRequest, startRow, startBand);
-
-   DimensionDescriptor cacheStartBand = startBand;
-   DimensionDescriptor cacheStopBand = stopBand;
-   if (pUnit.get() == NULL) // cache miss
+   CachedPage::UnitPtr pWrittenUnit;
+   if (pCachedPage->isWritable())
    {
-      if (requestedFormat != BSQ)
-      {
-         cacheStartBand = DimensionDescriptor();
-         cacheStopBand = DimensionDescriptor();
-         concurrentBands = mBandCount;
-      }
+      pWrittenUnit = pCachedPage->getCacheUnit();
+   }
 
-      // get a bunch more rows if you can to prevent a cache miss
-      unsigned int concurrentRows = std::max(pOriginalRequest->getConcurrentRows(),
-         static_cast<unsigned int>(getChunkSize() / (concurrentBands * mColumnCount * mBytesPerBand)));
-      concurrentRows = std::min(concurrentRows, stopRow.getActiveNumber() - startRow.getActiveNumber() + 1);
+   delete pCachedPage;
+   mCounters.addPageReleased();
 
-      FactoryResource<DataRequest> pNewRequest;
-      pNewRequest->setInterleaveFormat(requestedFormat);
-      pNewRequest->setRows(startRow, stopRow, concurrentRows);
-      // Get full columns
-      pNewRequest->setBands(cacheStartBand, cacheStopBand);
+   if (pWrittenUnit.get() != NULL)
+   {
+      // The unit may have been written back or removed from the cache while the page was in use, so mark
+      // it again and return it to the cache in place of any duplicate which was read from the file.
+      pWrittenUnit->setDirty(true);
+      mCache.addUnit(pWrittenUnit);
+   }
 
-      pNewRequest->polish(mpDescriptor);
-      if (pNewRequest->validate(mpDescriptor) == true)
+   bool idle = false;
+   {
+      mta::MutexLock lock(*mpReadAheadMutex);
+      if (mOutstandingPages > 0 && --mOutstandingPages == 0)
       {
-         pUnit = fetchUnit(pNewRequest.get());
+         // nobody is reading sequentially any more, so drop the pending reads
+         ++mReadAheadGeneration;
+         clearReadAheadQueue();
+         idle = true;
       }
    }
 
-   return mCache.createPage(pUnit, requestedFormat, startRow, startColumn, startBand);
+   if (idle)
+   {
+      // wait for a read which is already in progress, so that no unit is fetched
+      // after the last page is released
+      mta::MutexLock lock(*mpMutex);
+   }
 }
 
-void CachedPager::releasePage(RasterPage *pPage)
+void CachedPager::prefetchPage(DataRequest *pOriginalRequest,
+      DimensionDescriptor startRow, 
+      DimensionDescriptor startColumn, 
+      DimensionDescriptor startBand)
 {
-   mta::MutexLock lock(*mpMutex);
+   if (pOriginalRequest == NULL || pOriginalRequest->getInterleaveFormat() != mpDescriptor->getInterleaveFormat())
+   {
+      return;
+   }
 
-   delete dynamic_cast<CachedPage*>(pPage);
+   if (mCache.getUnit(pOriginalRequest, startRow, startBand).get() != NULL)
+   {
+      return;
+   }
+
+   mta::MutexLock lock(*mpReadAheadMutex);
+   if (mOutstandingPages == 0 || mStopReadAhead)
+   {
+      return;
+   }
+
+   if (mReadAheadQueue.size() >= MAX_READ_AHEAD_REQUESTS)
+   {
+      FactoryResource<DataRequest> pOldRequest(mReadAheadQueue.front().mpRequest);
+      mReadAheadQueue.pop_front();
+   }
+
+   ReadAheadRequest request;
+   request.mpRequest = pOriginalRequest->copy();
+   request.mStartRow = startRow;
+   request.mStartBand = startBand;
+   request.mGeneration = mReadAheadGeneration;
+   mReadAheadQueue.push_back(request);
+
+   if (mpReadAheadThread.get() == NULL)
+   {
+      mpReadAheadThread.reset(new BThread(static_cast<void*>(this),
+         reinterpret_cast<void*>(CachedPager::readAheadThread)));
+      mpReadAheadThread->ThreadLaunch();
+   }
+
+   mpReadAheadSignal->ThreadSignalActivate();
 }
 
 int CachedPager::getSupportedRequestVersion() const
 {
-   return 1;
+   return 3;
 }
 
 const int CachedPager::getBytesPerBand() const
@@ -211,3 +368,275 @@ double CachedPager::getChunkSize() const
 {
    return 1 * 1024 * 1024;
 }
+
+bool CachedPager::flushDirtyUnits()
+{
+   return mCache.flushDirtyUnits();
+}
+
+bool CachedPager::flushUnit(CachedPage::UnitPtr pUnit)
+{
+   return false;
+}
+
+bool CachedPager::writeUnit(CachedPage::UnitPtr pUnit)
+{
+   VERIFY(pUnit.get() != NULL);
+
+   mta::MutexLock lock(*mpMutex);
+   if (flushUnit(pUnit))
+   {
+      return true;
+   }
+
+   return writeOverlay(pUnit);
+}
+
+size_t CachedPager::getUnitRowSize() const
+{
+   unsigned int bandsPerUnit = (mpDescriptor->getInterleaveFormat() == BSQ) ? 1 : mBandCount;
+   return static_cast<size_t>(bandsPerUnit) * mColumnCount * mBytesPerBand;
+}
+
+bool CachedPager::writeOverlay(CachedPage::UnitPtr pUnit)
+{
+   VERIFY(mpDescriptor != NULL);
+   if (mpOverlayFile.get() == NULL)
+   {
+      const Filename* pTempPath = ConfigurationSettings::getSettingTempPath();
+      string tempPath;
+      if (pTempPath != NULL)
+      {
+         tempPath = pTempPath->getFullPathAndName();
+      }
+
+      char* pTempFilename = tempnam(tempPath.c_str(), "CP");
+      if (pTempFilename == NULL)
+      {
+         return false;
+      }
+      string overlayFilename = pTempFilename;
+      free(pTempFilename);
+
+      auto_ptr<LargeFileResource> pOverlayFile(new LargeFileResource);
+      if (pOverlayFile->open(overlayFilename, O_RDWR | O_CREAT | O_BINARY | O_TRUNC, S_IREAD | S_IWRITE) == false)
+      {
+         return false;
+      }
+
+      mOverlayFilename = overlayFilename;
+      mpOverlayFile = pOverlayFile;
+   }
+
+   size_t rowSize = getUnitRowSize();
+   size_t rowStride = rowSize + pUnit->getInterlineBytes();
+   unsigned int band = getOverlayBand(pUnit);
+   unsigned int startRow = pUnit->getStartRow().getActiveNumber();
+   const char* pData = pUnit->getRawData();
+   for (unsigned int row = 0; row < pUnit->getConcurrentRows() && row * rowStride + rowSize <= pUnit->getSize(); ++row)
+   {
+      pair<OverlayRows::iterator, bool> inserted =
+         mOverlayRows.insert(make_pair(make_pair(band, startRow + row), mOverlaySize));
+      if (mpOverlayFile->seek(inserted.first->second, SEEK_SET) < 0 ||
+         mpOverlayFile->write(pData + row * rowStride, rowSize) != static_cast<int64_t>(rowSize))
+      {
+         if (inserted.second)
+         {
+            mOverlayRows.erase(inserted.first);
+         }
+         return false;
+      }
+
+      if (inserted.second)
+      {
+         mOverlaySize += rowSize;
+      }
+   }
+
+   return true;
+}
+
+bool CachedPager::readOverlay(CachedPage::UnitPtr pUnit)
+{
+   size_t rowSize = getUnitRowSize();
+   size_t rowStride = rowSize + pUnit->getInterlineBytes();
+   unsigned int band = getOverlayBand(pUnit);
+   unsigned int startRow = pUnit->getStartRow().getActiveNumber();
+   unsigned int stopRow = startRow + pUnit->getConcurrentRows();
+   char* pData = pUnit->getRawData();
+   for (OverlayRows::const_iterator iter = mOverlayRows.lower_bound(make_pair(band, startRow));
+      iter != mOverlayRows.end() && iter->first.first == band && iter->first.second < stopRow; ++iter)
+   {
+      size_t offset = (iter->first.second - startRow) * rowStride;
+      if (offset + rowSize > pUnit->getSize() ||
+         mpOverlayFile->seek(iter->second, SEEK_SET) < 0 ||
+         mpOverlayFile->read(pData + offset, rowSize) != static_cast<int64_t>(rowSize))
+      {
+         return false;
+      }
+   }
+
+   return true;
+}
+
+CachedPage::UnitPtr CachedPager::fetchAlignedUnit(DataRequest *pOriginalRequest,
+   DimensionDescriptor startRow, DimensionDescriptor startBand)
+{
+   InterleaveFormatType requestedFormat = pOriginalRequest->getInterleaveFormat();
+   DimensionDescriptor stopRow = pOriginalRequest->getStopRow();
+   DimensionDescriptor cacheStartBand = startBand;
+   DimensionDescriptor cacheStopBand = pOriginalRequest->getStopBand();
+   if (requestedFormat != BSQ)
+   {
+      cacheStartBand = DimensionDescriptor();
+      cacheStopBand = DimensionDescriptor();
+   }
+
+   // get a bunch more rows if you can to prevent a cache miss, starting on a
+   // unit boundary so that units fetched for different requests line up
+   unsigned int startRowNumber = startRow.getActiveNumber();
+   unsigned int stopRowNumber = stopRow.getActiveNumber();
+   unsigned int requestedRows = pOriginalRequest->getConcurrentRows();
+   unsigned int rowStride = pOriginalRequest->getRowStride();
+   unsigned int unitStartRowNumber = startRowNumber - startRowNumber % mUnitRowCount;
+   unsigned int concurrentRows = mUnitRowCount;
+   if (rowStride > 1 && rowStride >= mUnitRowCount)
+   {
+      // no other requested row is in the block, so only read the one which is needed
+      unitStartRowNumber = startRowNumber;
+      concurrentRows = 1;
+   }
+   else if (rowStride == 1 && unitStartRowNumber + mUnitRowCount < startRowNumber + requestedRows)
+   {
+      // a strided page is served from the block which holds its first row, so only unstrided
+      // requests need a unit which holds all of their concurrent rows
+      unitStartRowNumber = startRowNumber;
+      concurrentRows = std::max(requestedRows, mUnitRowCount);
+   }
+   concurrentRows = std::min(concurrentRows, stopRowNumber - unitStartRowNumber + 1);
+
+   FactoryResource<DataRequest> pNewRequest;
+   pNewRequest->setInterleaveFormat(requestedFormat);
+   pNewRequest->setRows(mpDescriptor->getActiveRow(unitStartRowNumber), stopRow, concurrentRows);
+   // Get full columns
+   pNewRequest->setBands(cacheStartBand, cacheStopBand);
+
+   CachedPage::UnitPtr pUnit;
+   pNewRequest->polish(mpDescriptor);
+   if (pNewRequest->validate(mpDescriptor) == true)
+   {
+      PagerCounters::Timer timer;
+      pUnit = fetchUnit(pNewRequest.get());
+      mCounters.addDecodeTime(timer.getElapsed());
+      if (pUnit.get() != NULL)
+      {
+         mCounters.addBytesFetched(pUnit->getSize());
+      }
+   }
+
+   // rows which were modified by a pager which cannot write are read from the overlay
+   if (pUnit.get() != NULL && mOverlayRows.empty() == false && readOverlay(pUnit) == false)
+   {
+      pUnit.reset();
+   }
+
+   if (pUnit.get() != NULL)
+   {
+      copyDirtyRows(pUnit);
+   }
+
+   return pUnit;
+}
+
+void CachedPager::copyDirtyRows(CachedPage::UnitPtr pUnit)
+{
+   // Cached units over other rows may hold modifications which have not been written back yet.  The writes
+   // take the pager mutex, which is held here, so the modified rows are copied instead.
+   unsigned int startRow = pUnit->getStartRow().getActiveNumber();
+   unsigned int stopRow = startRow + pUnit->getConcurrentRows();
+   vector<CachedPage::UnitPtr> dirtyUnits;
+   mCache.getDirtyUnits(pUnit->getBand(), startRow, pUnit->getConcurrentRows(), dirtyUnits);
+
+   size_t rowSize = getUnitRowSize();
+   size_t rowStride = rowSize + pUnit->getInterlineBytes();
+   for (vector<CachedPage::UnitPtr>::iterator iter = dirtyUnits.begin(); iter != dirtyUnits.end(); ++iter)
+   {
+      CachedPage::UnitPtr pDirtyUnit = *iter;
+      unsigned int dirtyStartRow = pDirtyUnit->getStartRow().getActiveNumber();
+      unsigned int dirtyStopRow = dirtyStartRow + pDirtyUnit->getConcurrentRows();
+      size_t dirtyRowStride = rowSize + pDirtyUnit->getInterlineBytes();
+      for (unsigned int row = std::max(startRow, dirtyStartRow); row < std::min(stopRow, dirtyStopRow); ++row)
+      {
+         size_t offset = (row - startRow) * rowStride;
+         size_t dirtyOffset = (row - dirtyStartRow) * dirtyRowStride;
+         if (offset + rowSize <= pUnit->getSize() && dirtyOffset + rowSize <= pDirtyUnit->getSize())
+         {
+            memcpy(pUnit->getRawData() + offset, pDirtyUnit->getRawData() + dirtyOffset, rowSize);
+         }
+      }
+   }
+}
+
+void CachedPager::readAheadThread(CachedPager* pPager)
+{
+   if (pPager != NULL)
+   {
+      pPager->readAhead();
+   }
+}
+
+void CachedPager::readAhead()
+{
+   for (;;)
+   {
+      ReadAheadRequest request;
+      {
+         mta::MutexLock lock(*mpReadAheadMutex);
+         while (mReadAheadQueue.empty() && !mStopReadAhead)
+         {
+            mpReadAheadSignal->ThreadSignalWait(mpReadAheadMutex.get());
+         }
+         if (mStopReadAhead)
+         {
+            return;
+         }
+
+         request = mReadAheadQueue.front();
+         mReadAheadQueue.pop_front();
+      }
+
+      FactoryResource<DataRequest> pRequest(request.mpRequest);
+      CachedPage::UnitPtr pUnit;
+      {
+         mta::MutexLock lock(*mpMutex);
+         {
+            // the request is stale if all pages were released since it was queued
+            mta::MutexLock readAheadLock(*mpReadAheadMutex);
+            if (request.mGeneration != mReadAheadGeneration || mStopReadAhead)
+            {
+               continue;
+            }
+         }
+
+         if (mCache.getUnit(pRequest.get(), request.mStartRow, request.mStartBand).get() == NULL)
+         {
+            pUnit = fetchAlignedUnit(pRequest.get(), request.mStartRow, request.mStartBand);
+         }
+      }
+
+      // adding the unit may write back a dirty unit, which takes the pager mutex
+      if (pUnit.get() != NULL)
+      {
+         mCache.addUnit(pUnit);
+      }
+   }
+}
+
+void CachedPager::clearReadAheadQueue()
+{
+   for (deque<ReadAheadRequest>::iterator iter = mReadAheadQueue.begin(); iter != mReadAheadQueue.end(); ++iter)
+   {
+      FactoryResource<DataRequest> pRequest(iter->mpRequest);
+   }
+   mReadAheadQueue.clear();
+}
@@ -10,6 +10,49 @@
 #include "Endian.h"
 #include "AppConfig.h"
 
+#include <string.h>
+
+namespace
+{
+   // Each kernel loads a whole element, swaps it with shifts and masks and stores it again.  The
+   // loads and stores are memcpy() calls of a fixed size so that unaligned data is handled on
+   // every platform, and compilers turn the loops into byte swap or shuffle instructions.
+   void swap2(unsigned char* pDestination, const unsigned char* pSource, size_t count)
+   {
+      for (size_t i = 0; i < count; ++i)
+      {
+         uint16_t value;
+         memcpy(&value, pSource + i * 2, 2);
+         value = static_cast<uint16_t>((value >> 8) | (value << 8));
+         memcpy(pDestination + i * 2, &value, 2);
+      }
+   }
+
+   void swap4(unsigned char* pDestination, const unsigned char* pSource, size_t count)
+   {
+      for (size_t i = 0; i < count; ++i)
+      {
+         uint32_t value;
+         memcpy(&value, pSource + i * 4, 4);
+         value = (value >> 24) | ((value >> 8) & 0x0000ff00u) | ((value << 8) & 0x00ff0000u) | (value << 24);
+         memcpy(pDestination + i * 4, &value, 4);
+      }
+   }
+
+   void swap8(unsigned char* pDestination, const unsigned char* pSource, size_t count)
+   {
+      for (size_t i = 0; i < count; ++i)
+      {
+         uint64_t value;
+         memcpy(&value, pSource + i * 8, 8);
+         value = ((value >> 8) & 0x00ff00ff00ff00ffULL) | ((value & 0x00ff00ff00ff00ffULL) << 8);
+         value = ((value >> 16) & 0x0000ffff0000ffffULL) | ((value & 0x0000ffff0000ffffULL) << 16);
+         value = (value >> 32) | (value << 32);
+         memcpy(pDestination + i * 8, &value, 8);
+      }
+   }
+}
+
 Endian::Endian(EndianType endian) :
    mType(endian),
    mSystemType(getSystemEndian())
@@ -50,3 +93,59 @@ EndianType Endian::getSystemEndian()
 
    return BIG_ENDIAN_ORDER;
 }
+
+bool Endian::copyBuffer(void* pDestination, const void* pSource, size_t dataSize, size_t count) const
+{
+   if ((pDestination == NULL) || (pSource == NULL))
+   {
+      return false;
+   }
+
+   if (mSystemType == mType)
+   {
+      memcpy(pDestination, pSource, dataSize * count);
+      return false;
+   }
+
+   swapBytes(pDestination, pSource, dataSize, count);
+   return true;
+}
+
+void Endian::swapBytes(void* pDestination, const void* pSource, size_t dataSize, size_t count)
+{
+   unsigned char* pDst = reinterpret_cast<unsigned char*>(pDestination);
+   const unsigned char* pSrc = reinterpret_cast<const unsigned char*>(pSource);
+   switch (dataSize)
+   {
+   case 1:
+      if (pDst != pSrc)
+      {
+         memcpy(pDst, pSrc, count);
+      }
+      break;
+   case 2:
+      swap2(pDst, pSrc, count);
+      break;
+   case 4:
+      swap4(pDst, pSrc, count);
+      break;
+   case 8:
+      swap8(pDst, pSrc, count);
+      break;
+   default:
+      for (size_t i = 0; i < count; ++i)
+      {
+         unsigned char* pData = pDst + (i * dataSize);
+         const unsigned char* pSrcData = pSrc + (i * dataSize);
+         for (size_t j = 0; j < (dataSize + 1) / 2; ++j)
+         {
+            size_t index = dataSize - j - 1;
+
+            unsigned char byteData = pSrcData[j];
+            pData[j] = pSrcData[index];
+            pData[index] = byteData;
+         }
+      }
+      break;
+   }
+}
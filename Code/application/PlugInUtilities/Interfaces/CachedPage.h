@@ -13,14 +13,19 @@
 #include "DimensionDescriptor.h"
 #include "RasterPage.h"
 
+#include <boost/atomic.hpp>
 #include <boost/shared_ptr.hpp>
 
 /**
  * Provides means of using page sharing with the DataAccessor class.
  *
- * Page sharing/caching allows multiple data accessors to have read-only
+ * Page sharing/caching allows multiple data accessors to have
  * access to the same page. The CachedPage and RasterPage
  * are thread-safe classes.
+ *
+ * A writable page modifies its cache unit in place.  The unit is marked as
+ * dirty, and the CachedPager writes it back before the unit is removed
+ * from the PageCache.
  */
 class CachedPage : public RasterPage
 {
@@ -115,6 +120,25 @@ public:
        */
       unsigned int getInterlineBytes();
 
+      /**
+       * Marks whether the data in the cache unit has been modified since it
+       * was read or last written back.
+       *
+       * @param dirty
+       *        True if the cache unit has been modified.
+       */
+      void setDirty(bool dirty);
+
+      /**
+       * Get whether the data in the cache unit needs to be written back.
+       *
+       * @return True if the cache unit has been modified since it was read or
+       *         last written back.
+       *
+       * @see PageCache::WriteBack
+       */
+      bool isDirty() const;
+
    private:
       char* mpData;
       DimensionDescriptor mStartRow;
@@ -122,6 +146,7 @@ public:
       DimensionDescriptor mBand; // for BSQ
       size_t mSize;
       unsigned int mInterlineBytes;
+      boost::atomic<bool> mDirty;
    };
 
    typedef boost::shared_ptr<CacheUnit> UnitPtr;
@@ -139,6 +164,29 @@ public:
     */
    CachedPage(UnitPtr pCacheUnit, size_t offset, DimensionDescriptor startRow);
 
+   /**
+    * Creates a CachedPage which only provides some of the columns or rows in the cache unit.
+    *
+    * @param pCacheUnit
+    *        The CacheUnit for this page
+    * @param offset
+    *        The number of bytes to offset into the block. This does not account for size of the
+    *        data type.
+    * @param startRow
+    *        The start row for this page.
+    * @param numColumns
+    *        The number of columns in this page.
+    * @param skipBytes
+    *        The number of bytes in each row of the cache unit which follow the columns
+    *        of this page and precede the columns of the next row.  These are reported as
+    *        interline bytes in addition to those of the cache unit.  This includes the
+    *        rows which are skipped if \p rowStride is greater than 1.
+    * @param rowStride
+    *        The number of rows of the cache unit between consecutive rows of this page.
+    */
+   CachedPage(UnitPtr pCacheUnit, size_t offset, DimensionDescriptor startRow, unsigned int numColumns,
+      unsigned int skipBytes, unsigned int rowStride = 1);
+
    /**
     * Virtual destructor to ensure proper deletion of inherited classes.
     */
@@ -160,9 +208,10 @@ public:
 
 
    /**
-    * Inherited obligations that return 0.
+    * Accessor to private data.
     *
-    * @return Returns 0.
+    * @return The number of columns in this page, or 0 if the page
+    *         contains every column.
     */
    unsigned int getNumColumns();
    
@@ -180,6 +229,28 @@ public:
     */
    unsigned int getInterlineBytes();
 
+   /**
+    * Get the CacheUnit for this page.
+    *
+    * @return The CacheUnit which holds the data of this page.
+    */
+   UnitPtr getCacheUnit() const;
+
+   /**
+    * Sets whether the data of this page may be modified.
+    *
+    * @param writable
+    *        True if the page was created for a writable DataRequest.
+    */
+   void setWritable(bool writable);
+
+   /**
+    * Get whether the data of this page may be modified.
+    *
+    * @return True if the page was created for a writable DataRequest.
+    */
+   bool isWritable() const;
+
 private:
    UnitPtr mpCacheUnit;
 
@@ -193,6 +264,10 @@ private:
    size_t mOffset;
 
    DimensionDescriptor mStartRow;
+   unsigned int mNumColumns;
+   unsigned int mSkipBytes;
+   unsigned int mRowStride;
+   bool mWritable;
 };
 
 #endif
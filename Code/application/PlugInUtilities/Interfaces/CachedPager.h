@@ -13,17 +13,25 @@
 #include <string>
 
 #include "CachedPage.h"
+#include "ConfigurationSettings.h"
 #include "PageCache.h"
+#include "PagerCounters.h"
 #include "RasterPagerShell.h"
 #include "RasterPage.h"
 
+#include <deque>
+#include <map>
 #include <memory>
+#include <utility>
 
+class BThread;
+class LargeFileResource;
 class RasterDataDescriptor;
 class RasterElement;
 namespace mta
 {
    class DMutex;
+   class DThreadSignal;
 }
 
 /**
@@ -35,10 +43,28 @@ namespace mta
  *  to function with 2 threads, each reading odd and even rows).
  *  developers would take this class and extend it to support their 
  *  algorithm specific code.
+ *
+ *  Writable requests modify the cached units in place, so data can be edited
+ *  without first copying it into memory or a temporary file.  Modified units
+ *  are written back when they are removed from the cache.  Pagers which can
+ *  write to their file override flushUnit().  Units of other pagers are
+ *  written to a scratch overlay file, which takes precedence over the
+ *  original file when the rows are read again and is deleted with the pager.
+ *
+ *  Requests with a row stride are served a page over the requested rows of
+ *  a unit.  If the stride spans a whole unit, only the requested rows are
+ *  fetched, one row per unit, so decimated passes read proportionally less
+ *  of the file.
+ *
+ *  The pager registers PagerCounters with ModelServices, which count the
+ *  pages served from the cache, the data fetched from the file and the time
+ *  spent in fetchUnit() and waiting for the pager lock.
  */
-class CachedPager : public RasterPagerShell
+class CachedPager : public RasterPagerShell, private PageCache::WriteBack
 {
 public:
+   SETTING(CacheSize, CachedPager, unsigned int, 10 * 1024 * 1024)
+
    /**
     * The name to use for the raster element argument.
     *
@@ -66,7 +92,8 @@ public:
    /**
     * Creates a CachedPager PlugIn.
     *
-    * Sets cache size to 10 MB. Sets writable flag to false.
+    * Sets cache size to the value of getSettingCacheSize(), which defaults
+    * to 10 MB.
     *
     * Subclasses need to override private pure virtual methods to
     * open the file and get a block from that file.
@@ -76,7 +103,7 @@ public:
    /**
     * Creates a CachedPager PlugIn.
     *
-    * Sets cache size to cacheSize bytes. Sets writable flag to false.
+    * Sets cache size to cacheSize bytes.
     *
     * Subclasses need to override private pure virtual methods to
     * open the file and get a block from that file.
@@ -190,8 +217,13 @@ public:
     *         that is directly acccessible in memory.
     *         </li>
     *       </ul>
-    *  This method may be called simultaneously by multiple threads and is up to
-    *  the implementer of this method to guarantee thread-safety in that case.
+    *  This method may be called simultaneously by multiple threads.  Requests
+    *  which are satisfied by the cache do not block one another, while calls to
+    *  fetchUnit() are serialized.  A page for a writable request marks its unit
+    *  as dirty, and the unit is written back with flushUnit() before it leaves
+    *  the cache.  Units are read from the file in blocks of
+    *  whole rows aligned to multiples of the chunk size, so that neighboring
+    *  requests share units in the cache.
     *
     *  @param pOriginalRequest
     *         The request as originally made.  The fields on this object
@@ -238,6 +270,30 @@ public:
     */
    void releasePage(RasterPage *pPage);
 
+   /**
+    *  Reads the requested unit into the cache in the background.
+    *
+    *  If the unit containing the requested page is not already cached, it is
+    *  queued for a background thread which fetches it with fetchUnit() and
+    *  adds it to the cache.  The thread is started the first time a page is
+    *  read ahead.  Requests are only queued while pages from this pager are
+    *  in use, and all queued requests are discarded once the last page has
+    *  been released.
+    *
+    *  @param pOriginalRequest
+    *         The request as originally made.
+    *  @param startRow
+    *         the start row of the page which will be requested.
+    *  @param startColumn
+    *         the start column of the page which will be requested.
+    *  @param startBand
+    *         the start band of the page which will be requested.
+    */
+   void prefetchPage(DataRequest *pOriginalRequest,
+      DimensionDescriptor startRow, 
+      DimensionDescriptor startColumn, 
+      DimensionDescriptor startBand);
+
    /**
     * Get the highest version of DataRequest that this pager supports.
     *
@@ -304,11 +360,64 @@ protected:
     */
    virtual double getChunkSize() const;
 
+   /**
+    *  Writes every modified unit in the cache back.
+    *
+    *  Units are otherwise only written back when they are removed from the
+    *  cache.  Pagers which override flushUnit() should call this from their
+    *  destructor, since the cache can no longer call the override once the
+    *  subclass has been destroyed.
+    *
+    *  @return  FALSE if any unit could not be written.
+    */
+   bool flushDirtyUnits();
+
 private:
    CachedPager& operator=(const CachedPager& rhs);
 
+   /**
+    *  Writes a dirty unit with flushUnit(), or to the overlay file if the
+    *  pager cannot write.
+    */
+   bool writeUnit(CachedPage::UnitPtr pUnit);
+
+   size_t getUnitRowSize() const;
+   bool writeOverlay(CachedPage::UnitPtr pUnit);
+   bool readOverlay(CachedPage::UnitPtr pUnit);
+   void copyDirtyRows(CachedPage::UnitPtr pUnit);
+
+   /**
+    *  Fetches the unit containing the requested rows from the file.
+    *
+    *  The unit is aligned to the row blocks of the cache when possible.  For
+    *  a request with a row stride of at least a whole unit, only the start row
+    *  is fetched.  The caller must hold the pager mutex.
+    */
+   CachedPage::UnitPtr fetchAlignedUnit(DataRequest *pOriginalRequest,
+      DimensionDescriptor startRow, DimensionDescriptor startBand);
+
+   static void readAheadThread(CachedPager* pPager);
+   void readAhead();
+   void clearReadAheadQueue();
+
+   struct ReadAheadRequest
+   {
+      DataRequest* mpRequest;
+      DimensionDescriptor mStartRow;
+      DimensionDescriptor mStartBand;
+      unsigned int mGeneration;
+   };
+
    PageCache mCache;
+   PagerCounters mCounters;
    std::auto_ptr<mta::DMutex> mpMutex;
+   std::auto_ptr<mta::DMutex> mpReadAheadMutex;
+   std::auto_ptr<mta::DThreadSignal> mpReadAheadSignal;
+   std::auto_ptr<BThread> mpReadAheadThread;
+   std::deque<ReadAheadRequest> mReadAheadQueue;
+   unsigned int mReadAheadGeneration;
+   unsigned int mOutstandingPages;
+   bool mStopReadAhead;
    std::string mFilename;
    RasterDataDescriptor* mpDescriptor;
    RasterElement* mpRaster;
@@ -316,6 +425,15 @@ private:
    int mColumnCount;
    int mBandCount;
    int mRowCount;
+   unsigned int mUnitRowCount;
+
+   // The rows written to the overlay file, keyed by band (or all bands unless BSQ) and row.
+   // The overlay is guarded by the pager mutex.
+   typedef std::map<std::pair<unsigned int, unsigned int>, int64_t> OverlayRows;
+   std::string mOverlayFilename;
+   std::auto_ptr<LargeFileResource> mpOverlayFile;
+   OverlayRows mOverlayRows;
+   int64_t mOverlaySize;
 
    /**
     *  This method should be implemented to open the file and store a file handle to be
@@ -339,10 +457,31 @@ private:
     *  and two separate DataAccessors wish to access different parts of the same
     *  page.
     *
+    *  Calls to this method are serialized by the CachedPager, so implementations
+    *  do not need to protect their file handles.
+    *
     *  @param pOriginalRequest
     *         The request to fulfill.
     */
    virtual CachedPage::UnitPtr fetchUnit(DataRequest *pOriginalRequest) = 0;
+
+   /**
+    *  Writes a modified CacheUnit back to the file.
+    *
+    *  This is called before a dirty unit is removed from the cache.  The unit
+    *  holds whole rows, laid out as they were returned by fetchUnit().  Calls
+    *  to this method are serialized with fetchUnit() by the CachedPager.
+    *
+    *  The default implementation returns false, so the unit is written to a
+    *  scratch overlay file instead and the original file is never modified.
+    *
+    *  @param pUnit
+    *         The unit to write.
+    *
+    *  @return  TRUE if the unit was written to the file, FALSE if the pager
+    *           cannot write to the file.
+    */
+   virtual bool flushUnit(CachedPage::UnitPtr pUnit);
 };
 
 #endif
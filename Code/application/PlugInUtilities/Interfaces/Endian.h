@@ -217,22 +217,37 @@ public:
          return false;
       }
 
-      for (size_t i = 0; i < count; ++i)
-      {
-         unsigned char* pData = reinterpret_cast<unsigned char*>(pBuffer) + (i * dataSize);
-         for (size_t j = 0; j < dataSize / 2; ++j)
-         {
-            size_t index = dataSize - j - 1;
-
-            unsigned char byteData = pData[j];
-            pData[j] = pData[index];
-            pData[index] = byteData;
-         }
-      }
-
+      swapBytes(pBuffer, pBuffer, dataSize, count);
       return true;
    }
 
+   /**
+    *  Copies data elements from one array to another, swapping their bytes.
+    *
+    *  This is equivalent to copying the array and then calling swapBuffer()
+    *  on the copy, but it only passes over the data once.  If the endian
+    *  type of the system is the same as the endian type of <em>this</em>,
+    *  the data is copied without swapping.
+    *
+    *  @param   pDestination
+    *           The array which receives the data.  It must not overlap
+    *           \em pSource.
+    *  @param   pSource
+    *           The data to copy.
+    *  @param   dataSize
+    *           The size of each element in the array.  For complex data,
+    *           this is the size of one component.
+    *  @param   count
+    *           The number of items in the array to copy.
+    *
+    *  @return  Returns true if byte swapping was actually performed.  Returns
+    *           false if the data was only copied or if either array is
+    *           \c NULL.
+    *
+    *  @see     swapBuffer(void *,size_t,size_t)
+    */
+   bool copyBuffer(void* pDestination, const void* pSource, size_t dataSize, size_t count) const;
+
    /**
     *  Returns the endian type of the system.
     *
@@ -246,6 +261,8 @@ public:
    static EndianType getSystemEndian();
 
 private:
+   static void swapBytes(void* pDestination, const void* pSource, size_t dataSize, size_t count);
+
    EndianType mType;
    EndianType mSystemType;
 };
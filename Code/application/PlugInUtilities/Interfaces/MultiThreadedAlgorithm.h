@@ -19,7 +19,11 @@
 #include "DMutex.h"
 #include "EnumWrapper.h"
 #include "MessageLogResource.h"
+#include "ThreadPool.h"
+#include "UtilityServices.h"
 
+#include <boost/atomic.hpp>
+#include <boost/scoped_array.hpp>
 #include <numeric>
 #include <algorithm>
 #include <sstream>
@@ -38,12 +42,28 @@ namespace mta // Multi-Threaded Algorithm
 * Calculate the required number of threads for the data to be processed.
 * Using this prevents some oddities involving empty worker threads.
 *
+* The threads of an algorithm are run by the workers of the application's ThreadPool,
+* so the data is split into several threads for each worker.  A worker which finishes
+* its threads early takes threads from the other workers.
+*
 * @param dataSize
 *        Size of the data to be processed by multiple threads.
 * @return The number of threads required to process the data.
 */
 unsigned int getNumRequiredThreads(unsigned int dataSize);
 
+/**
+* Calculate the required number of threads for the data to be processed.
+*
+* @param dataSize
+*        Size of the data to be processed by multiple threads.
+* @param chunksPerThread
+*        The number of threads for each thread in ConfigurationSettings::getSettingThreadCount().
+*        Algorithms whose threads each hold large buffers can pass 1 to use one thread per worker.
+* @return The number of threads required to process the data.
+*/
+unsigned int getNumRequiredThreads(unsigned int dataSize, unsigned int chunksPerThread);
+
 /**
  * Represents the result of algorithm execution.
  */
@@ -54,6 +74,21 @@ enum ResultEnum { SUCCESS, FAILURE, ABORT };
  */
 typedef EnumWrapper<ResultEnum> Result;
 
+/**
+ * How the threads of an algorithm report their progress and errors to the main thread.
+ */
+enum ReportModeEnum
+{
+   BLOCKING_REPORTS, /**< Each report waits until the main thread has processed it. */
+   POLLED_REPORTS    /**< Reports are stored for the main thread, which checks them periodically.
+                          Threads only wait for the main thread in ThreadReporter::runInMainThread(). */
+};
+
+/**
+ * @EnumWrapper mta::ReportModeEnum.
+ */
+typedef EnumWrapper<ReportModeEnum> ReportMode;
+
 /**
  * An action that can be run.
  */
@@ -117,9 +152,21 @@ public:
     */
    virtual int getProgress(int threadIndex) const = 0;
 
+   /**
+    * Query whether the algorithm should stop.
+    *
+    * This is set when a thread reports an error or when the algorithm is aborted.
+    * Threads can check it between units of work without waiting for the main thread.
+    *
+    * @return True if the threads should stop processing, otherwise false.
+    */
+   virtual bool isAborted() const = 0;
+
    /**
     * Perform an action in the main thread.
     *
+    * This waits for the main thread to run the action, even when progress is polled.
+    *
     * @param command
     *        The action to run in the main thread.
     */
@@ -164,9 +211,11 @@ public:
     *        The second mutex used to coordinate the threads.
     * @param signalB
     *        The second signal used to coordinate the threads.
+    * @param reportMode
+    *        Whether reports wait for the main thread or are polled by it.
     */
    MultiThreadReporter(int threadCount, Result* pResult, BMutex& mutexA, BThreadSignal& signalA, BMutex& mutexB,
-      BThreadSignal& signalB);
+      BThreadSignal& signalB, ReportMode reportMode = BLOCKING_REPORTS);
 
    /**
     * Destructor.
@@ -213,11 +262,49 @@ public:
     */
    std::string getErrorText() const;
    
+   /**
+    * @copydoc ThreadReporter::isAborted()
+    */
+   bool isAborted() const;
+
    /**
     * @copydoc ThreadReporter::runInMainThread()
     */
    void runInMainThread(ThreadCommand& command);
 
+   /**
+    * Stop the threads.
+    *
+    * The threads are told to stop through isAborted() and the result of their reports.
+    * This does not wait for the main thread, so it can be called from any thread.
+    */
+   void abort();
+
+   /**
+    * Access the mode of the reports.
+    *
+    * @return The report mode.
+    */
+   ReportMode getReportMode() const;
+
+   /**
+    * Wait for polled reports from the threads.
+    *
+    * This is called by the main thread with mutex A unlocked.  It returns when a thread
+    * reports an error, completes or has work for the main thread, or after a short interval
+    * so that the progress of the threads can be polled.  The pending report types are cleared.
+    *
+    * @return The types of the reports which were pending.
+    */
+   unsigned int waitForPolledReports();
+
+   /**
+    * Run the pending thread command and release the thread which is waiting for it.
+    *
+    * This is called by the main thread after waitForPolledReports() returns THREAD_WORK.
+    */
+   void runPolledThreadCommand();
+
    /**
     * Set the type of report.
     *
@@ -248,14 +335,18 @@ private:
    BMutex& mMutexB;
    BThreadSignal& mSignalB;
    Result* mpResult;
-   std::vector<int> mThreadProgress;
+   int mThreadCount;
+   boost::scoped_array<boost::atomic<int> > mThreadProgress;
    std::string mErrorMessage;
    unsigned int mReportType;
    ThreadCommand* mpThreadCommand;
    mutable DMutex mReporterMutex;
    mutable DMutex mSignalMutex;
+   ReportMode mReportMode;
+   boost::atomic<int> mStatus;  // the ResultEnum seen by the threads without waiting for the main thread
 
    Result signalMainThread(ThreadCommand& reportStatus, ReportType type);
+   void wakeMainThread(ReportType type);
 };
 
 // this pragma shushes a compiler warning regarding the initialization
@@ -429,6 +520,34 @@ private:
 #pragma warning (pop)
 #endif
 
+/**
+ * Runs an algorithm thread as a task of the application's ThreadPool.
+ */
+class AlgorithmThreadTask : public ThreadPool::Task
+{
+public:
+   /**
+    * Constructor.
+    *
+    * @param pThread
+    *        The thread to run.
+    */
+   explicit AlgorithmThreadTask(AlgorithmThread* pThread) :
+      mpThread(pThread)
+   {}
+
+   /**
+    * Run the thread in the calling worker.
+    */
+   void run()
+   {
+      AlgorithmThread::threadFunction(mpThread);
+   }
+
+private:
+   AlgorithmThread* mpThread;
+};
+
 /** \page multithreadedhowto Writing a multi-threaded algorithm
  * Use this template to make a thread class.
  * @code
@@ -631,6 +750,13 @@ private:
 
 /**
  * An algorithm which distributes work between multiply threads. (SIMD)
+ *
+ * The threads are run as tasks of the application's ThreadPool, so algorithms which run
+ * at the same time share its workers.
+ *
+ * By default, each progress report and error waits until the main thread has processed it.
+ * Algorithms whose threads do not need to run work in the main thread should use
+ * POLLED_REPORTS, so that the threads never wait for the progress to be displayed.
  */
 template<class AlgInput, class AlgOutput, class AlgThread>
 class MultiThreadedAlgorithm
@@ -647,8 +773,11 @@ public:
     *        Algorithm output.
     * @param pProgress
     *        Used to report progress and errors.
+    * @param reportMode
+    *        Whether the reports of the threads wait for the main thread or are polled by it.
     */
-   MultiThreadedAlgorithm(int threadCount, const AlgInput& input, AlgOutput& output, ProgressReporter* pProgress);
+   MultiThreadedAlgorithm(int threadCount, const AlgInput& input, AlgOutput& output, ProgressReporter* pProgress,
+      ReportMode reportMode = BLOCKING_REPORTS);
 
    /**
     * Destructor.
@@ -673,12 +802,26 @@ public:
       return mErrorText;
    }
 
+   /**
+    * Stop the algorithm.
+    *
+    * This can be called from any thread while run() executes, including from the
+    * ProgressReporter.  The threads stop when they next check ThreadReporter::isAborted()
+    * or report progress, and run() returns ABORT.
+    */
+   void abort()
+   {
+      mpThreadReporter->abort();
+   }
+
 private:
    MultiThreadedAlgorithm& operator=(const MultiThreadedAlgorithm& rhs);
 
    Result createThreads(int threadCount);
    Result startAllThreads();
    Result waitForThreadsToComplete();
+   Result waitForPolledThreadsToComplete();
+   void waitForThreads();
    int processCurrentReports(int percentDone);
    int processReport(unsigned int currentType, int percentDone);
    Result compileResults();
@@ -687,6 +830,8 @@ private:
    const AlgInput& mInput;
    AlgOutput& mOutput;
    std::vector<AlgThread*> mThreads;
+   std::vector<AlgorithmThreadTask> mTasks;
+   ThreadPool::TaskGroup* mpTaskGroup;
    MultiThreadReporter* mpThreadReporter;
    ProgressReporter* mpProgressReporter;
    DMutex mMutexA;
@@ -698,20 +843,28 @@ private:
 
 template<class AlgInput, class AlgOutput, class AlgThread>
 MultiThreadedAlgorithm<AlgInput, AlgOutput, AlgThread>::MultiThreadedAlgorithm(int threadCount,
-   const AlgInput& algInput, AlgOutput& algOutput, ProgressReporter* pReporter) :
+   const AlgInput& algInput, AlgOutput& algOutput, ProgressReporter* pReporter, ReportMode reportMode) :
    mCurrentStatus(SUCCESS),
    mInput(algInput),
    mOutput(algOutput),
+   mpTaskGroup(NULL),
    mpThreadReporter(NULL),
    mpProgressReporter(pReporter)
 {
-   mpThreadReporter = new MultiThreadReporter(threadCount, &mCurrentStatus, mMutexA, mSignalA, mMutexB, mSignalB);
+   mpThreadReporter = new MultiThreadReporter(threadCount, &mCurrentStatus, mMutexA, mSignalA, mMutexB, mSignalB,
+      reportMode);
    createThreads(threadCount);
 }
 
 template<class AlgInput, class AlgOutput, class AlgThread>
 MultiThreadedAlgorithm<AlgInput, AlgOutput, AlgThread>::~MultiThreadedAlgorithm()
 {
+   if (mpTaskGroup != NULL)
+   {
+      Service<UtilityServices>()->getThreadPool()->waitForTasks(mpTaskGroup);
+      mpTaskGroup = NULL;
+   }
+
    typename std::vector<AlgThread*>::iterator iter;
    for (iter = mThreads.begin(); iter != mThreads.end(); ++iter)
    {
@@ -751,6 +904,27 @@ Result MultiThreadedAlgorithm<AlgInput, AlgOutput, AlgThread>::startAllThreads()
    mMutexA.MutexLock();
    mMutexB.MutexLock();
 
+   // A worker of the pool which runs an algorithm of its own launches separate threads for it, since the
+   // worker cannot take the threads from the pool while it processes their reports
+   ThreadPool* pPool = Service<UtilityServices>()->getThreadPool();
+   if (pPool != NULL && pPool->isWorkerThread() == false && mThreads.empty() == false)
+   {
+      mTasks.reserve(mThreads.size());
+      for (iter = mThreads.begin(); iter != mThreads.end(); ++iter)
+      {
+         mTasks.push_back(AlgorithmThreadTask(*iter));
+      }
+
+      std::vector<ThreadPool::Task*> tasks;
+      for (std::vector<AlgorithmThreadTask>::iterator taskIter = mTasks.begin(); taskIter != mTasks.end(); ++taskIter)
+      {
+         tasks.push_back(&*taskIter);
+      }
+
+      mpTaskGroup = pPool->startTasks(tasks);
+      return SUCCESS;
+   }
+
    for (iter = mThreads.begin(); iter != mThreads.end(); ++iter)
    {
       (*iter)->launch();
@@ -766,6 +940,11 @@ Result MultiThreadedAlgorithm<AlgInput, AlgOutput, AlgThread>::waitForThreadsToC
       // sanity check: there weren't actually any threads to run so we'll return success
       return SUCCESS;
    }
+   if (mpThreadReporter->getReportMode() == POLLED_REPORTS)
+   {
+      return waitForPolledThreadsToComplete();
+   }
+
    bool doneProcessing = false;
    int percentDone = 0;
 
@@ -779,18 +958,73 @@ Result MultiThreadedAlgorithm<AlgInput, AlgOutput, AlgThread>::waitForThreadsToC
       if (doneProcessing)
       {
          mMutexA.MutexUnlock();
+         waitForThreads();
+      }
+   }
 
-         typename std::vector<AlgThread*>::iterator iter;
-         for (iter = mThreads.begin(); iter != mThreads.end(); ++iter)
-         {
-            (*iter)->wait();
-         }
+   if (mCurrentStatus == SUCCESS && mpThreadReporter->isAborted())
+   {
+      mCurrentStatus = ABORT;
+   }
+
+   return mCurrentStatus;
+}
+
+template<class AlgInput, class AlgOutput, class AlgThread>
+Result MultiThreadedAlgorithm<AlgInput, AlgOutput, AlgThread>::waitForPolledThreadsToComplete()
+{
+   int percentDone = 0;
+
+   // The main thread only locks mutex A while it checks for reports, so that
+   // the threads never wait for it while it reports progress
+   mMutexB.MutexUnlock();
+   mMutexA.MutexUnlock();
+   while (percentDone != 100 && mCurrentStatus == SUCCESS)
+   {
+      unsigned int type = mpThreadReporter->waitForPolledReports();
+      if (type & MultiThreadReporter::THREAD_WORK)
+      {
+         mpThreadReporter->runPolledThreadCommand();
+      }
+
+      if (type & MultiThreadReporter::THREAD_ERROR)
+      {
+         percentDone = processReport(MultiThreadReporter::THREAD_ERROR, percentDone);
+      }
+      else if (mpThreadReporter->getProgress() != percentDone)
+      {
+         percentDone = processReport(MultiThreadReporter::THREAD_PROGRESS, percentDone);
       }
    }
 
+   waitForThreads();
+
+   if (mCurrentStatus == SUCCESS && mpThreadReporter->isAborted())
+   {
+      mCurrentStatus = ABORT;
+   }
+
    return mCurrentStatus;
 }
 
+template<class AlgInput, class AlgOutput, class AlgThread>
+void MultiThreadedAlgorithm<AlgInput, AlgOutput, AlgThread>::waitForThreads()
+{
+   if (mpTaskGroup != NULL)
+   {
+      Service<UtilityServices>()->getThreadPool()->waitForTasks(mpTaskGroup);
+      mpTaskGroup = NULL;
+   }
+   else
+   {
+      typename std::vector<AlgThread*>::iterator iter;
+      for (iter = mThreads.begin(); iter != mThreads.end(); ++iter)
+      {
+         (*iter)->wait();
+      }
+   }
+}
+
 template<class AlgInput, class AlgOutput, class AlgThread>
 int MultiThreadedAlgorithm<AlgInput, AlgOutput, AlgThread>::processCurrentReports(int percentDone)
 {
@@ -11,16 +11,28 @@
 #define PAGECACHE_H
 
 #include <list>
+#include <map>
+#include <memory>
+#include <vector>
 
+#include <boost/atomic.hpp>
 #include <boost/shared_array.hpp>
 #include <boost/shared_ptr.hpp>
+#include "AppConfig.h"
 #include "CachedPage.h"
 #include "DimensionDescriptor.h"
 #include "LocationType.h"
+#include "RasterCache.h"
 
 #include "TypesFile.h"
 
 class DataRequest;
+class ModelServices;
+namespace mta
+{
+   class DMutex;
+   class DThreadSignal;
+}
 
 /**
  * Provides an LRU cache designed to provide faster access to pages if such
@@ -29,16 +41,55 @@ class DataRequest;
  * For example, a multi-threaded algorithm could get a DataAccessor to odd
  * and even rows. These two threads would be able to share the same page.
  *
- * When clearing units from the cache, it simply removed the oldest units
- * from the cache.  It is possible that a CachedPage still holds a reference
- * to the released unit.  Since the units are consistently referred to with
- * shared_ptrs, the actual memory will not be released until the last page
- * is destroyed.  This does, however, allow duplicate units -- one that the cache
- * knows about, and one that a lingering CachedPage references.
+ * Units are indexed by (band, start row, concurrent rows) so a lookup does not
+ * need to scan every unit in the cache.  The index is split into lock-striped
+ * shards which are selected by band and by row block so that threads working
+ * on different parts of the cube do not contend for the same lock.  Each
+ * shard keeps its own LRU list and the oldest unit across all shards is
+ * removed when the cache grows beyond its maximum size.
+ *
+ * The cache is registered with ModelServices as a RasterCache, so its units
+ * also count against the process-wide raster memory budget and may be
+ * removed to make room for data of other elements.
+ *
+ * It is possible that a CachedPage still holds a reference to a removed unit.
+ * Since the units are consistently referred to with shared_ptrs, the actual
+ * memory will not be released until the last page is destroyed.  This does,
+ * however, allow duplicate units -- one that the cache knows about, and one
+ * that a lingering CachedPage references.
+ *
+ * Units which have been modified through writable pages are marked as
+ * dirty.  A dirty unit is passed to the WriteBack of the cache before it is
+ * removed, and it stays in the cache if it cannot be written.
  */
-class PageCache
+class PageCache : public RasterCache
 {
 public:
+   /**
+    * Writes modified units back to the source of their data.
+    */
+   class WriteBack
+   {
+   public:
+      /**
+       * Writes a dirty unit back to the source of its data.
+       *
+       * This is called from the thread which removes the unit from the cache
+       * or calls flushDirtyUnits(), without any lock of the cache held.  The
+       * unit is no longer marked as dirty when this is called, so that
+       * modifications made while it is written mark it again.
+       *
+       * @param  pUnit
+       *         The unit to write.
+       *
+       * @return True if the unit was written.
+       */
+      virtual bool writeUnit(CachedPage::UnitPtr pUnit) = 0;
+
+   protected:
+      virtual ~WriteBack() {}
+   };
+
    /**
     * Creates a thread-safe LRU PageCache.
     *
@@ -55,7 +106,10 @@ public:
    /**
     * Fetches a unit from the cache.
     *
-    * See RasterPager::getPage() for details on the parameters.
+    * See RasterPager::getPage() for details on the parameters.  A unit which is
+    * found is marked as the most recently used unit in the cache.
+    *
+    * This method may be called simultaneously by multiple threads.
     *
     * @return A CacheUnit object containing the startRow, startColumn, and startBand,
     *         and containing and least concurrentRows number of rows, concurrentColumns number
@@ -89,9 +143,32 @@ public:
     */
    void initialize(int bytesPerBand, int columnCount, int bandCount);
 
+   /**
+    * Initializes member variables of the cache & resets hit/miss counts.
+    *
+    * This must be done after construction of the cache.
+    *
+    * @param  bytesPerBand
+    *         The number of bytes each element takes up. Requires the value
+    *         contained by RasterDataDescriptor::getBytesPerElement().
+    * @param  columnCount
+    *         The number of columns in file on disk.
+    * @param  bandCount
+    *         The number of bands in the file on disk.
+    * @param  blockRowCount
+    *         The number of rows in a row block.  Units are assigned to a shard
+    *         based on the row block containing their start row, so this should
+    *         be the number of rows a pager normally reads into a single unit.
+    */
+   void initialize(int bytesPerBand, int columnCount, int bandCount, unsigned int blockRowCount);
+
    /**
     * Create a CachedPage for the given cache unit.
     *
+    * If the unit is not already in the cache, it is added to the cache and the
+    * least recently used units are removed until the cache fits within its
+    * maximum size.
+    *
     * @param  pUnit
     *         The unit to create the page for.
     * @param  requestedFormat
@@ -102,18 +179,115 @@ public:
     *         The desired column.
     * @param  startBand
     *         The desired band.
+    * @param  numColumns
+    *         The number of columns in the page, or 0 for a page which
+    *         provides the rest of each row of the unit.  A page with fewer
+    *         columns skips the remainder of each row with interline bytes.
+    * @param  rowStride
+    *         The number of unit rows between consecutive rows of the page.
+    *         A page with a stride greater than 1 skips the intervening rows
+    *         with interline bytes.
     *
     * @return The created page, or NULL if pUnit is NULL.  The caller
     *         takes ownership over the created page.
     */
    CachedPage *createPage(CachedPage::UnitPtr pUnit, InterleaveFormatType requestedFormat,
-      DimensionDescriptor startRow, DimensionDescriptor startColumn, DimensionDescriptor startBand);
+      DimensionDescriptor startRow, DimensionDescriptor startColumn, DimensionDescriptor startBand,
+      unsigned int numColumns = 0, unsigned int rowStride = 1);
+
+   /**
+    * Adds a unit to the cache without creating a page for it.
+    *
+    * This is used to populate the cache with units which are expected to be
+    * requested soon.  The least recently used units are removed until the
+    * cache fits within its maximum size.
+    *
+    * @param  pUnit
+    *         The unit to add.  If it is already in the cache, it is marked as
+    *         the most recently used unit.
+    */
+   void addUnit(CachedPage::UnitPtr pUnit);
+
+   /**
+    * Sets the object which writes dirty units back.
+    *
+    * This waits for the units which the previous object is writing, so the
+    * previous object may be destroyed once this returns.
+    *
+    * @param  pWriteBack
+    *         The object which writes dirty units back, or \c NULL if the
+    *         units of the cache are never modified.
+    */
+   void setWriteBack(WriteBack* pWriteBack);
+
+   /**
+    * Writes every dirty unit in the cache back.
+    *
+    * The units stay in the cache.
+    *
+    * @return False if any dirty unit could not be written.
+    */
+   bool flushDirtyUnits();
+
+   /**
+    * Finds the dirty units which hold any of the given rows.
+    *
+    * @param  band
+    *         The band of the units, or an invalid band for units which hold
+    *         all bands.
+    * @param  startRow
+    *         The active number of the first row.
+    * @param  concurrentRows
+    *         The number of rows.
+    * @param  units
+    *         Receives the dirty units.
+    */
+   void getDirtyUnits(DimensionDescriptor band, unsigned int startRow, unsigned int concurrentRows,
+      std::vector<CachedPage::UnitPtr>& units) const;
+
+   /**
+    * Get the number of rows in a row block.
+    *
+    * @return The number of rows used to assign units to shards.
+    *
+    * @see initialize()
+    */
+   unsigned int getBlockRowCount() const;
+
+   /**
+    * Get the maximum size of the cache.
+    *
+    * @return The maximum size of the cache in bytes.
+    */
+   size_t getMaxCacheSize() const;
+
+   /**
+    * Get the current size of the cache.
+    *
+    * @return The number of bytes held by units which are in the cache.
+    */
+   size_t getCacheSize() const;
+
+   /**
+    * Removes all units from the cache without writing dirty units back.
+    */
+   void clear();
+
+   /**
+    * Sets the element whose data is held by the cache.
+    *
+    * @param  pElement
+    *         The element reported by getRasterElement().
+    */
+   void setRasterElement(const RasterElement* pElement);
+
+   // RasterCache
+   const RasterElement* getRasterElement() const;
+   uint64_t getOldestAccess() const;
+   bool releaseOldest();
 
 protected:
    const size_t MAX_CACHE_SIZE;
-   UnitList mUnits;
-   std::string mFilename;
-   size_t mCacheSize;
    int mBytesPerBand;
    int mColumnCount;
    int mBandCount;
@@ -122,6 +296,29 @@ protected:
 
 private:
    PageCache& operator=(const PageCache& rhs);
+
+   class Shard;
+
+   Shard& getShard(unsigned int band, unsigned int row) const;
+   Shard* getOldestShard(uint64_t& oldestAccess) const;
+   bool findUnit(Shard& shard, unsigned int bandKey, DimensionDescriptor startRow, unsigned int concurrentRows,
+      DimensionDescriptor band, CachedPage::UnitPtr& pUnit);
+   bool insertUnit(CachedPage::UnitPtr pUnit);
+   bool hasWriteBack() const;
+   bool writeUnit(CachedPage::UnitPtr pUnit);
+
+   std::vector<Shard*> mShards;
+   unsigned int mBlockRowCount;
+   boost::atomic<size_t> mCacheSize;
+   boost::atomic<unsigned int> mMaxConcurrentRows;    // the most rows in any unit of the cache
+   ModelServices* mpModelServices;
+   const RasterElement* mpRasterElement;
+
+   // The write back is guarded by its mutex, and is not replaced while one of its writes is in progress.
+   std::auto_ptr<mta::DMutex> mpWriteBackMutex;
+   std::auto_ptr<mta::DThreadSignal> mpWriteBackSignal;
+   WriteBack* mpWriteBack;
+   unsigned int mWritesInProgress;
 };
 
 #endif
@@ -0,0 +1,138 @@
+/*
+ * The information in this file is
+ * Copyright(c) 2007 Ball Aerospace & Technologies Corporation
+ * and is subject to the terms and conditions of the
+ * GNU Lesser General Public License Version 2.1
+ * The license text is available from   
+ * http://www.gnu.org/licenses/lgpl.html
+ */
+
+#ifndef PAGERCOUNTERS_H
+#define PAGERCOUNTERS_H
+
+#include "DMutex.h"
+#include "RasterPagerCounters.h"
+
+#include <boost/atomic.hpp>
+#include <string>
+
+/**
+ *  Counters which a RasterPager updates as it is used.
+ *
+ *  The counters register themselves with ModelServices when they are created
+ *  and unregister when they are destroyed, so a pager only needs to hold an
+ *  instance and update it.  All of the methods may be called simultaneously
+ *  by multiple threads.
+ *
+ *  @see ModelServices::getRasterPagerCounters()
+ */
+class PagerCounters : public RasterPagerCounters
+{
+public:
+   /**
+    *  Measures elapsed time for the counters.
+    */
+   class Timer
+   {
+   public:
+      /**
+       *  Starts the timer.
+       */
+      Timer();
+
+      /**
+       *  Returns the time since the timer was started.
+       *
+       *  @return The number of elapsed microseconds.
+       */
+      uint64_t getElapsed() const;
+
+   private:
+      uint64_t mStart;
+   };
+
+   /**
+    *  Locks a mutex and adds the time spent waiting for it to the lock wait
+    *  time of the counters.
+    */
+   class TimedLock
+   {
+   public:
+      TimedLock(BMutex& mutex, PagerCounters& counters);
+
+   private:
+      TimedLock(const TimedLock& rhs);
+      TimedLock& operator=(const TimedLock& rhs);
+
+      Timer mTimer;
+      mta::MutexLock mLock;
+   };
+
+   /**
+    *  Creates the counters and registers them with ModelServices.
+    *
+    *  @param pagerName
+    *         The name of the pager.
+    *  @param pElement
+    *         The element whose data is paged, if already known.
+    */
+   explicit PagerCounters(const std::string& pagerName, const RasterElement* pElement = NULL);
+
+   /**
+    *  Unregisters the counters from ModelServices.
+    */
+   ~PagerCounters();
+
+   /**
+    *  Sets the name of the pager.
+    *
+    *  This should be called before the pager is used by multiple threads.
+    */
+   void setPagerName(const std::string& pagerName);
+
+   /**
+    *  Sets the element whose data is paged.
+    *
+    *  This should be called before the pager is used by multiple threads.
+    */
+   void setRasterElement(const RasterElement* pElement);
+
+   void addGetPageCall();
+   void addCacheHit();
+   void addCacheMiss();
+   void addBytesFetched(uint64_t bytes);
+   void addDecodeTime(uint64_t microseconds);
+   void addLockWaitTime(uint64_t microseconds);
+   void addPageLeased();
+   void addPageReleased();
+
+   /**
+    *  Returns a monotonic time for the counters.
+    *
+    *  @return The current time in microseconds from an arbitrary start.
+    */
+   static uint64_t getMicroseconds();
+
+   // RasterPagerCounters
+   std::string getPagerName() const;
+   const RasterElement* getRasterElement() const;
+   Values getValues() const;
+   void reset();
+
+private:
+   PagerCounters(const PagerCounters& rhs);
+   PagerCounters& operator=(const PagerCounters& rhs);
+
+   std::string mPagerName;
+   const RasterElement* mpElement;
+   boost::atomic<uint64_t> mGetPageCalls;
+   boost::atomic<uint64_t> mCacheHits;
+   boost::atomic<uint64_t> mCacheMisses;
+   boost::atomic<uint64_t> mBytesFetched;
+   boost::atomic<uint64_t> mDecodeTime;
+   boost::atomic<uint64_t> mLockWaitTime;
+   boost::atomic<uint64_t> mPagesLeased;
+   boost::atomic<uint64_t> mPagesReleased;
+};
+
+#endif
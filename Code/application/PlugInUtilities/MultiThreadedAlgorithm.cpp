@@ -14,9 +14,24 @@
 
 using namespace mta;
 
+namespace
+{
+   // Each worker of the thread pool gets several threads of an algorithm, so that workers which finish
+   // early can take threads from the others
+   const unsigned int CHUNKS_PER_THREAD = 4;
+
+   // How often the main thread polls the progress of the threads when the reports are polled
+   const unsigned int POLLED_REPORT_INTERVAL = 100;
+}
+
 unsigned int mta::getNumRequiredThreads(unsigned int dataSize)
 {
-   unsigned int threadCount = ConfigurationSettings::getSettingThreadCount();
+   return getNumRequiredThreads(dataSize, CHUNKS_PER_THREAD);
+}
+
+unsigned int mta::getNumRequiredThreads(unsigned int dataSize, unsigned int chunksPerThread)
+{
+   unsigned int threadCount = ConfigurationSettings::getSettingThreadCount() * std::max(chunksPerThread, 1U);
    // if there are more threads than rows in the data set, we need to clamp
    // the number of threads so we don't have idle threads.
    threadCount = std::min(threadCount, dataSize);
@@ -64,11 +79,19 @@ unsigned int mta::getNumRequiredThreads(unsigned int dataSize)
    Unlock mutex b                      Wake up (locks mutex b)
                                        Unlock mutex b
    Loop
+
+   When the reports are polled, the threads store their progress in atomic
+   values and do not wait for the main thread.  The main thread only holds
+   mutex A while it checks for reports, and waits on signal A with a timeout
+   so that it can display the progress.  A thread locks mutex A to wake the
+   main thread when it reports an error or completes, which never waits for
+   the progress to be displayed.  Work for the main thread still waits for it
+   on signal B.
 */
 
 struct ProgressFunctor : public ThreadCommand
 {
-   ProgressFunctor(int *pProgressValue, int percent) : 
+   ProgressFunctor(boost::atomic<int> *pProgressValue, int percent) : 
       mpProgressValue(pProgressValue), mPercent(percent) {}
    virtual ~ProgressFunctor() {};
    virtual void run()
@@ -76,30 +99,30 @@ struct ProgressFunctor : public ThreadCommand
       *mpProgressValue = mPercent;
    }
 private:
-   int* mpProgressValue;
+   boost::atomic<int>* mpProgressValue;
    int mPercent;
 };
 struct CompletionFunctor : public ProgressFunctor
 {
-   CompletionFunctor(int *pProgressValue) : ProgressFunctor(pProgressValue, 100) {}
+   CompletionFunctor(boost::atomic<int> *pProgressValue) : ProgressFunctor(pProgressValue, 100) {}
    virtual ~CompletionFunctor() {};
 };
+// The result is set to FAILURE by the main thread when it processes the error, since the main
+// thread stops waiting for reports as soon as it sees the failure
 struct ErrorFunctor : public ThreadCommand
 {
-   ErrorFunctor(std::string errorText, std::string& errorMessage, Result *pResult) : 
-      mErrorText(errorText), mMessage(errorMessage), mpResult(pResult) {}
+   ErrorFunctor(std::string errorText, std::string& errorMessage) : 
+      mErrorText(errorText), mMessage(errorMessage) {}
    virtual ~ErrorFunctor() {};
    virtual void run()
    {
       mMessage = mErrorText;
-      *mpResult = FAILURE;
    }
 private:
    ErrorFunctor& operator=(const ErrorFunctor& rhs);
 
    std::string mErrorText;
    std::string& mMessage;
-   Result* mpResult;
 };
 struct WorkFunctor : public ThreadCommand
 {
@@ -118,11 +141,15 @@ private:
 };
 
 MultiThreadReporter::MultiThreadReporter(int threadCount, Result* pResult, 
-        BMutex &mutexA, BThreadSignal& signalA, BMutex &mutexB, BThreadSignal& signalB) : 
+        BMutex &mutexA, BThreadSignal& signalA, BMutex &mutexB, BThreadSignal& signalB, ReportMode reportMode) : 
    mMutexA(mutexA), mSignalA(signalA), mMutexB(mutexB), mSignalB(signalB), 
-   mpResult(pResult), mThreadProgress(threadCount), 
-   mReportType(THREAD_NO_REPORT), mpThreadCommand(NULL)
+   mpResult(pResult), mThreadCount(threadCount), mThreadProgress(new boost::atomic<int>[threadCount]), 
+   mReportType(THREAD_NO_REPORT), mpThreadCommand(NULL), mReportMode(reportMode), mStatus(SUCCESS)
 {
+   for (int i = 0; i < mThreadCount; ++i)
+   {
+      mThreadProgress[i] = 0;
+   }
    if (threadCount == 0 && pResult != NULL)
    {
       *mpResult = FAILURE;
@@ -132,41 +159,159 @@ MultiThreadReporter::MultiThreadReporter(int threadCount, Result* pResult,
 
 MultiThreadReporter::MultiThreadReporter(MultiThreadReporter &reporter) :
    mMutexA(reporter.mMutexA), mSignalA(reporter.mSignalA), mMutexB(reporter.mMutexB), mSignalB(reporter.mSignalB), 
-   mpResult(reporter.mpResult), mThreadProgress(reporter.mThreadProgress), mErrorMessage(reporter.mErrorMessage),
-   mReportType(reporter.mReportType), mpThreadCommand(NULL)
+   mpResult(reporter.mpResult), mThreadCount(reporter.mThreadCount),
+   mThreadProgress(new boost::atomic<int>[reporter.mThreadCount]), mErrorMessage(reporter.mErrorMessage),
+   mReportType(reporter.mReportType), mpThreadCommand(NULL), mReportMode(reporter.mReportMode),
+   mStatus(reporter.mStatus.load())
 {
-   Result result = *mpResult;
+   for (int i = 0; i < mThreadCount; ++i)
+   {
+      mThreadProgress[i] = reporter.mThreadProgress[i].load();
+   }
 }
 
 Result MultiThreadReporter::reportProgress(int threadIndex, int percentDone)
 {
    Result result = SUCCESS;
+   if (mReportMode == POLLED_REPORTS)
+   {
+      if (mThreadProgress[threadIndex].exchange(percentDone) != percentDone && percentDone == 100)
+      {
+         wakeMainThread(THREAD_COMPLETE);
+      }
+      return static_cast<ResultEnum>(mStatus.load());
+   }
+
    if (percentDone != mThreadProgress[threadIndex])
    {
       ProgressFunctor cmd(&mThreadProgress[threadIndex], percentDone);
       result = signalMainThread(cmd, THREAD_PROGRESS);
    }
+   if (result == SUCCESS)
+   {
+      result = static_cast<ResultEnum>(mStatus.load());
+   }
    return result;
 }
 
 Result MultiThreadReporter::reportError(std::string errorText)
 {
-   ErrorFunctor cmd(errorText, mErrorMessage, mpResult);
+   if (mReportMode == POLLED_REPORTS)
+   {
+      // The error is only stored if the algorithm has not already stopped, like a blocking report
+      MutexLock lock(mMutexA);
+      int status = mStatus.load();
+      if (status == SUCCESS)
+      {
+         mStatus = FAILURE;
+         {
+            MutexLock reporterLock(mReporterMutex);
+            mErrorMessage = errorText;
+         }
+         mReportType |= THREAD_ERROR;
+         mSignalA.ThreadSignalActivate();
+         return FAILURE;
+      }
+      return static_cast<ResultEnum>(status);
+   }
+
+   int status = SUCCESS;
+   mStatus.compare_exchange_strong(status, FAILURE);
+   ErrorFunctor cmd(errorText, mErrorMessage);
    return signalMainThread(cmd, THREAD_ERROR);
 }
 
 Result MultiThreadReporter::reportCompletion(int threadIndex)
 {
+   if (mReportMode == POLLED_REPORTS)
+   {
+      mThreadProgress[threadIndex] = 100;
+      wakeMainThread(THREAD_COMPLETE);
+      return static_cast<ResultEnum>(mStatus.load());
+   }
+
    CompletionFunctor cmd(&mThreadProgress[threadIndex]);
    return signalMainThread(cmd, THREAD_COMPLETE);
 }
 
+bool MultiThreadReporter::isAborted() const
+{
+   return mStatus != SUCCESS;
+}
+
 void MultiThreadReporter::runInMainThread(ThreadCommand &command)
 {
+   if (mReportMode == POLLED_REPORTS)
+   {
+      // Only one thread at a time can have work for the main thread
+      MutexLock lock(mSignalMutex);
+      {
+         // The main thread stops checking for work once the algorithm has stopped
+         MutexLock lockA(mMutexA);
+         if (mStatus != SUCCESS)
+         {
+            return;
+         }
+         mpThreadCommand = &command;
+         mReportType |= THREAD_WORK;
+         mSignalA.ThreadSignalActivate();
+      }
+
+      MutexLock lockB(mMutexB);
+      while (mpThreadCommand != NULL)
+      {
+         mSignalB.ThreadSignalWait(&mMutexB);
+      }
+      return;
+   }
+
    WorkFunctor cmd(mpThreadCommand, command);
    signalMainThread(cmd, THREAD_WORK);
 }
 
+void MultiThreadReporter::abort()
+{
+   int status = SUCCESS;
+   mStatus.compare_exchange_strong(status, ABORT);
+}
+
+ReportMode MultiThreadReporter::getReportMode() const
+{
+   return mReportMode;
+}
+
+unsigned int MultiThreadReporter::waitForPolledReports()
+{
+   MutexLock lock(mMutexA);
+   if (mReportType == THREAD_NO_REPORT)
+   {
+      mSignalA.ThreadSignalTimedWait(&mMutexA, POLLED_REPORT_INTERVAL);
+   }
+
+   unsigned int type = mReportType;
+   mReportType = THREAD_NO_REPORT;
+   return type;
+}
+
+void MultiThreadReporter::runPolledThreadCommand()
+{
+   if (mpThreadCommand != NULL)
+   {
+      mpThreadCommand->run();
+   }
+
+   MutexLock lock(mMutexB);
+   mpThreadCommand = NULL;
+   mSignalB.ThreadSignalActivate();
+}
+
+void MultiThreadReporter::wakeMainThread(ReportType type)
+{
+   MutexLock lock(mMutexA);
+   mReportType |= type;
+   mSignalA.ThreadSignalActivate();
+}
+
 void MultiThreadReporter::setReportType(ReportType type)
 {
    mReportType = type;
@@ -184,14 +329,16 @@ ThreadCommand* MultiThreadReporter::getThreadCommand()
 
 int MultiThreadReporter::getProgress() const 
 { 
-   MutexLock lock(mReporterMutex);
-   int total = std::accumulate(mThreadProgress.begin(), mThreadProgress.end(), 0) / mThreadProgress.size(); 
-   return total;
+   int total = 0;
+   for (int i = 0; i < mThreadCount; ++i)
+   {
+      total += mThreadProgress[i];
+   }
+   return mThreadCount == 0 ? 0 : total / mThreadCount;
 }
 
 int MultiThreadReporter::getProgress(int threadIndex) const 
 { 
-   MutexLock lock(mReporterMutex);
    return mThreadProgress[threadIndex];
 }
 
@@ -218,9 +365,9 @@ Result MultiThreadReporter::signalMainThread(ThreadCommand& reportStatus, Report
          reportStatus.run();
       }
       mReportType |= type;
-      if (mpResult != NULL)
+      if (type == THREAD_ERROR)
       {
-         currentResult = *mpResult;
+         currentResult = FAILURE;
       }
 
       { // scope the lock
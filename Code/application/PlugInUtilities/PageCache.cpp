@@ -9,23 +9,128 @@
 
 #include "AppVerify.h"
 #include "DataRequest.h"
+#include "DMutex.h"
+#include "ModelServices.h"
 #include "PageCache.h"
 #include "TypesFile.h"
 
 #include <algorithm>
-#include <boost/bind.hpp>
-#include <sstream>
+#include <limits>
 using namespace std;
 
+namespace
+{
+   // The number of lock stripes.  Sequential row blocks are assigned to
+   // consecutive shards, so this bounds the number of threads which can
+   // work in the cache without contending for the same lock.
+   const unsigned int SHARD_COUNT = 16;
+
+   const unsigned int ALL_BANDS_KEY = numeric_limits<unsigned int>::max();
+
+   unsigned int getBandKey(DimensionDescriptor band)
+   {
+      return band.isActiveNumberValid() ? band.getActiveNumber() : ALL_BANDS_KEY;
+   }
+}
+
+class PageCache::Shard
+{
+public:
+   class Key
+   {
+   public:
+      Key(unsigned int band, unsigned int startRow, unsigned int concurrentRows) :
+         mBand(band),
+         mStartRow(startRow),
+         mConcurrentRows(concurrentRows)
+      {
+      }
+
+      bool operator<(const Key& rhs) const
+      {
+         if (mBand != rhs.mBand)
+         {
+            return mBand < rhs.mBand;
+         }
+         if (mStartRow != rhs.mStartRow)
+         {
+            return mStartRow < rhs.mStartRow;
+         }
+         return mConcurrentRows < rhs.mConcurrentRows;
+      }
+
+      unsigned int mBand;
+      unsigned int mStartRow;
+      unsigned int mConcurrentRows;
+   };
+
+   class Entry
+   {
+   public:
+      Entry(const Key& key, CachedPage::UnitPtr pUnit, uint64_t lastAccess) :
+         mKey(key),
+         mpUnit(pUnit),
+         mLastAccess(lastAccess)
+      {
+      }
+
+      Key mKey;
+      CachedPage::UnitPtr mpUnit;
+      uint64_t mLastAccess;
+   };
+
+   typedef list<Entry> EntryList;
+   typedef map<Key, EntryList::iterator> Index;
+
+   Shard() :
+      mMaxConcurrentRows(0)
+   {
+   }
+
+   void touch(EntryList::iterator entry, uint64_t access)
+   {
+      entry->mLastAccess = access;
+      mEntries.splice(mEntries.end(), mEntries, entry);
+   }
+
+   mta::DMutex mMutex;
+   EntryList mEntries; // least recently used entries are at the front
+   Index mIndex;
+   unsigned int mMaxConcurrentRows;
+};
+
 PageCache::PageCache(const size_t maxCacheSize) :
    MAX_CACHE_SIZE(maxCacheSize),
-   mCacheSize(0)
+   mBlockRowCount(numeric_limits<unsigned int>::max()),
+   mCacheSize(0),
+   mMaxConcurrentRows(0),
+   mpModelServices(Service<ModelServices>().get()),
+   mpRasterElement(NULL),
+   mpWriteBackMutex(new mta::DMutex),
+   mpWriteBackSignal(new mta::DThreadSignal),
+   mpWriteBack(NULL),
+   mWritesInProgress(0)
 {
+   for (unsigned int i = 0; i < SHARD_COUNT; ++i)
+   {
+      mShards.push_back(new Shard);
+   }
    initialize(0, 0, 0);
+
+   // Every cache takes part in the global raster cache budget, so the
+   // remaining methods rely on the model services being available
+   VERIFYNRV(mpModelServices != NULL);
+   mpModelServices->registerRasterCache(this);
 }
 
 PageCache::~PageCache()
 {
+   mpModelServices->unregisterRasterCache(this);
+
+   for (vector<Shard*>::iterator iter = mShards.begin(); iter != mShards.end(); ++iter)
+   {
+      delete *iter;
+   }
 }
 
 CachedPage::UnitPtr PageCache::getUnit(DataRequest *pOriginalRequest,
@@ -38,38 +143,85 @@ CachedPage::UnitPtr PageCache::getUnit(DataRequest *pOriginalRequest,
 
    InterleaveFormatType requestedFormat = pOriginalRequest->getInterleaveFormat();
    unsigned int concurrentRows = pOriginalRequest->getConcurrentRows();
+   if (pOriginalRequest->getRowStride() != 1)
+   {
+      // a page of a strided request only needs the unit which holds its first row
+      concurrentRows = 1;
+   }
 
    DimensionDescriptor band = CachedPage::CacheUnit::ALL_BANDS; // default to all bands
    if (requestedFormat == BSQ)
    {
       band = startBand;
    }
-   UnitList ::iterator ppMatchingUnit = find_if (mUnits.begin(), mUnits.end(), 
-      boost::bind(&CachedPage::CacheUnit::matches, _1, startRow, concurrentRows, band));
 
-   if (ppMatchingUnit != mUnits.end()) // cache hit
+   unsigned int bandKey = getBandKey(band);
+   unsigned int row = startRow.getActiveNumber();
+
+   // A unit is filed under the block of its first row, so a unit which crosses into
+   // the block of the row is found in the shard of an earlier block
+   uint64_t maxConcurrentRows = mMaxConcurrentRows.load();
+   for (unsigned int block = row / mBlockRowCount; ; --block)
    {
-      pUnit = (*ppMatchingUnit);
+      Shard& shard = getShard(bandKey, block * mBlockRowCount);
+      if (findUnit(shard, bandKey, startRow, concurrentRows, band, pUnit))
+      {
+         break;
+      }
 
-      // Remove from the list -- it will be re-added to the end in createPage()
-      mUnits.erase(ppMatchingUnit);
-      mCacheSize -= pUnit->getSize();
+      if (block == 0 || static_cast<uint64_t>(block) * mBlockRowCount - 1 + maxConcurrentRows <= row)
+      {
+         break;
+      }
    }
 
    return pUnit;
 }
 
+bool PageCache::findUnit(Shard& shard, unsigned int bandKey, DimensionDescriptor startRow,
+   unsigned int concurrentRows, DimensionDescriptor band, CachedPage::UnitPtr& pUnit)
+{
+   unsigned int row = startRow.getActiveNumber();
+   mta::MutexLock lock(shard.mMutex);
+
+   // Walk backwards from the last unit starting at or before the row until no
+   // unit of this shard could possibly contain the row
+   Shard::Index::iterator iter =
+      shard.mIndex.upper_bound(Shard::Key(bandKey, row, numeric_limits<unsigned int>::max()));
+   while (iter != shard.mIndex.begin())
+   {
+      --iter;
+      const Shard::Key& key = iter->first;
+      if (key.mBand != bandKey || static_cast<uint64_t>(key.mStartRow) + shard.mMaxConcurrentRows <= row)
+      {
+         break;
+      }
+
+      Shard::EntryList::iterator entry = iter->second;
+      if (entry->mpUnit->matches(startRow, concurrentRows, band)) // cache hit
+      {
+         pUnit = entry->mpUnit;
+         shard.touch(entry, mpModelServices->getRasterCacheAccess());
+         return true;
+      }
+   }
+
+   return false;
+}
+
 CachedPage *PageCache::createPage(CachedPage::UnitPtr pUnit, InterleaveFormatType requestedFormat,
-   DimensionDescriptor startRow, DimensionDescriptor startColumn, DimensionDescriptor startBand)
+   DimensionDescriptor startRow, DimensionDescriptor startColumn, DimensionDescriptor startBand,
+   unsigned int numColumns, unsigned int rowStride)
 {
    if (pUnit.get() == NULL)
    {
       return NULL;
    }
 
-   mUnits.push_back(pUnit);
-   mCacheSize += pUnit->getSize();
-   enforceCacheSize();
+   if (insertUnit(pUnit))
+   {
+      enforceCacheSize();
+   }
 
    int columnOffset = mColumnCount*(startRow.getActiveNumber()-pUnit->getStartRow().getActiveNumber());
    unsigned int offset = 0;
@@ -95,21 +247,316 @@ CachedPage *PageCache::createPage(CachedPage::UnitPtr pUnit, InterleaveFormatTyp
       return NULL;
    }
 
+   // a BIL page row is accessed as if it holds every band
+   unsigned int columnSize = mBytesPerBand * (requestedFormat == BSQ ? 1 : mBandCount);
+   if (numColumns == 0 || static_cast<int>(numColumns) > mColumnCount)
+   {
+      numColumns = mColumnCount;
+   }
+
+   if (static_cast<int>(numColumns) < mColumnCount || rowStride > 1)
+   {
+      unsigned int skipBytes = (mColumnCount - numColumns) * columnSize;
+      if (rowStride > 1)
+      {
+         // the rows between those of the page are skipped along with their interline bytes
+         skipBytes += (rowStride - 1) * (mColumnCount * columnSize + pUnit->getInterlineBytes());
+      }
+
+      return new CachedPage(pUnit, offset, startRow, numColumns, skipBytes, rowStride);
+   }
+
    return new CachedPage(pUnit, offset, startRow);
 }
 
+void PageCache::addUnit(CachedPage::UnitPtr pUnit)
+{
+   VERIFYNRV(pUnit.get() != NULL);
+   if (insertUnit(pUnit))
+   {
+      enforceCacheSize();
+   }
+}
+
 void PageCache::enforceCacheSize()
 {
-   while (mCacheSize > MAX_CACHE_SIZE && !mUnits.empty())
+   while (mCacheSize.load() > MAX_CACHE_SIZE)
+   {
+      if (releaseOldest() == false)
+      {
+         break;
+      }
+   }
+
+   mpModelServices->enforceRasterCacheBudget();
+}
+
+void PageCache::setRasterElement(const RasterElement* pElement)
+{
+   mpRasterElement = pElement;
+}
+
+const RasterElement* PageCache::getRasterElement() const
+{
+   return mpRasterElement;
+}
+
+uint64_t PageCache::getOldestAccess() const
+{
+   uint64_t oldestAccess = numeric_limits<uint64_t>::max();
+   getOldestShard(oldestAccess);
+   return oldestAccess;
+}
+
+bool PageCache::releaseOldest()
+{
+   for (;;)
    {
-      mCacheSize -= mUnits.front()->getSize();
-      mUnits.pop_front();
+      uint64_t oldestAccess = numeric_limits<uint64_t>::max();
+      Shard* pOldestShard = getOldestShard(oldestAccess);
+      if (pOldestShard == NULL)
+      {
+         return false;
+      }
+
+      CachedPage::UnitPtr pDirtyUnit;
+      {
+         mta::MutexLock lock(pOldestShard->mMutex);
+         if (pOldestShard->mEntries.empty() || pOldestShard->mEntries.front().mLastAccess != oldestAccess)
+         {
+            // another thread used or removed the unit since it was found, so look again
+            continue;
+         }
+
+         Shard::Entry& oldest = pOldestShard->mEntries.front();
+         if (oldest.mpUnit->isDirty() == false || hasWriteBack() == false)
+         {
+            mCacheSize -= oldest.mpUnit->getSize();
+            pOldestShard->mIndex.erase(oldest.mKey);
+            pOldestShard->mEntries.pop_front();
+            return true;
+         }
+
+         pDirtyUnit = oldest.mpUnit;
+      }
+
+      // The unit stays in the cache while it is written, so that its rows are not
+      // read again from the source before the source is up to date.
+      if (writeUnit(pDirtyUnit) == false)
+      {
+         return false;
+      }
    }
 }
 
+void PageCache::setWriteBack(WriteBack* pWriteBack)
+{
+   mta::MutexLock lock(*mpWriteBackMutex);
+   mpWriteBack = pWriteBack;
+   while (mWritesInProgress > 0)
+   {
+      mpWriteBackSignal->ThreadSignalWait(mpWriteBackMutex.get());
+   }
+}
+
+bool PageCache::flushDirtyUnits()
+{
+   if (hasWriteBack() == false)
+   {
+      return true;
+   }
+
+   vector<CachedPage::UnitPtr> dirtyUnits;
+   for (vector<Shard*>::iterator iter = mShards.begin(); iter != mShards.end(); ++iter)
+   {
+      Shard* pShard = *iter;
+      mta::MutexLock lock(pShard->mMutex);
+      for (Shard::EntryList::iterator entry = pShard->mEntries.begin(); entry != pShard->mEntries.end(); ++entry)
+      {
+         if (entry->mpUnit->isDirty())
+         {
+            dirtyUnits.push_back(entry->mpUnit);
+         }
+      }
+   }
+
+   bool success = true;
+   for (vector<CachedPage::UnitPtr>::iterator iter = dirtyUnits.begin(); iter != dirtyUnits.end(); ++iter)
+   {
+      if ((*iter)->isDirty() && writeUnit(*iter) == false)
+      {
+         success = false;
+      }
+   }
+
+   return success;
+}
+
+void PageCache::getDirtyUnits(DimensionDescriptor band, unsigned int startRow, unsigned int concurrentRows,
+                              vector<CachedPage::UnitPtr>& units) const
+{
+   unsigned int bandKey = getBandKey(band);
+   uint64_t stopRow = static_cast<uint64_t>(startRow) + concurrentRows;
+   for (vector<Shard*>::const_iterator iter = mShards.begin(); iter != mShards.end(); ++iter)
+   {
+      Shard* pShard = *iter;
+      mta::MutexLock lock(pShard->mMutex);
+      for (Shard::EntryList::const_iterator entry = pShard->mEntries.begin(); entry != pShard->mEntries.end();
+         ++entry)
+      {
+         const Shard::Key& key = entry->mKey;
+         if (key.mBand == bandKey && key.mStartRow < stopRow &&
+            static_cast<uint64_t>(key.mStartRow) + key.mConcurrentRows > startRow && entry->mpUnit->isDirty())
+         {
+            units.push_back(entry->mpUnit);
+         }
+      }
+   }
+}
+
+bool PageCache::hasWriteBack() const
+{
+   mta::MutexLock lock(*mpWriteBackMutex);
+   return mpWriteBack != NULL;
+}
+
+bool PageCache::writeUnit(CachedPage::UnitPtr pUnit)
+{
+   WriteBack* pWriteBack = NULL;
+   {
+      mta::MutexLock lock(*mpWriteBackMutex);
+      pWriteBack = mpWriteBack;
+      if (pWriteBack == NULL)
+      {
+         return false;
+      }
+
+      ++mWritesInProgress;
+   }
+
+   // the lock is not held while the unit is written, since the write back takes locks of its own
+   pUnit->setDirty(false);
+   bool written = pWriteBack->writeUnit(pUnit);
+   if (written == false)
+   {
+      pUnit->setDirty(true);
+   }
+
+   {
+      mta::MutexLock lock(*mpWriteBackMutex);
+      if (--mWritesInProgress == 0)
+      {
+         mpWriteBackSignal->ThreadSignalActivate();
+      }
+   }
+
+   return written;
+}
+
+PageCache::Shard* PageCache::getOldestShard(uint64_t& oldestAccess) const
+{
+   // Find the shard holding the least recently used unit in the cache
+   Shard* pOldestShard = NULL;
+   oldestAccess = numeric_limits<uint64_t>::max();
+   for (vector<Shard*>::const_iterator iter = mShards.begin(); iter != mShards.end(); ++iter)
+   {
+      Shard* pShard = *iter;
+      mta::MutexLock lock(pShard->mMutex);
+      if (!pShard->mEntries.empty() && pShard->mEntries.front().mLastAccess < oldestAccess)
+      {
+         oldestAccess = pShard->mEntries.front().mLastAccess;
+         pOldestShard = pShard;
+      }
+   }
+
+   return pOldestShard;
+}
+
+bool PageCache::insertUnit(CachedPage::UnitPtr pUnit)
+{
+   Shard::Key key(getBandKey(pUnit->getBand()), pUnit->getStartRow().getActiveNumber(),
+      pUnit->getConcurrentRows());
+   Shard& shard = getShard(key.mBand, key.mStartRow);
+   mta::MutexLock lock(shard.mMutex);
+
+   Shard::Index::iterator found = shard.mIndex.find(key);
+   if (found != shard.mIndex.end())
+   {
+      if (found->second->mpUnit == pUnit)
+      {
+         shard.touch(found->second, mpModelServices->getRasterCacheAccess());
+         return false;
+      }
+
+      // a different thread fetched the same unit, so replace the one the cache knows about
+      mCacheSize -= found->second->mpUnit->getSize();
+      shard.mEntries.erase(found->second);
+      shard.mIndex.erase(found);
+   }
+
+   shard.mIndex.insert(make_pair(key,
+      shard.mEntries.insert(shard.mEntries.end(), Shard::Entry(key, pUnit, mpModelServices->getRasterCacheAccess()))));
+   shard.mMaxConcurrentRows = max(shard.mMaxConcurrentRows, key.mConcurrentRows);
+   unsigned int maxConcurrentRows = mMaxConcurrentRows.load();
+   while (key.mConcurrentRows > maxConcurrentRows &&
+      mMaxConcurrentRows.compare_exchange_weak(maxConcurrentRows, key.mConcurrentRows) == false)
+   {
+   }
+   mCacheSize += pUnit->getSize();
+
+   return true;
+}
+
+PageCache::Shard& PageCache::getShard(unsigned int band, unsigned int row) const
+{
+   unsigned int block = row / mBlockRowCount;
+   return *mShards[(band * 31 + block) % mShards.size()];
+}
+
 void PageCache::initialize(int bytesPerBand, int columnCount, int bandCount)
 {
+   // Without a row block size, shards are only selected by band
+   initialize(bytesPerBand, columnCount, bandCount, numeric_limits<unsigned int>::max());
+}
+
+void PageCache::initialize(int bytesPerBand, int columnCount, int bandCount, unsigned int blockRowCount)
+{
+   clear();
+
    mBytesPerBand = bytesPerBand;
    mColumnCount = columnCount;
    mBandCount = bandCount;
+   mBlockRowCount = max(blockRowCount, 1U);
+}
+
+unsigned int PageCache::getBlockRowCount() const
+{
+   return mBlockRowCount;
+}
+
+size_t PageCache::getMaxCacheSize() const
+{
+   return MAX_CACHE_SIZE;
+}
+
+size_t PageCache::getCacheSize() const
+{
+   return mCacheSize.load();
+}
+
+void PageCache::clear()
+{
+   for (vector<Shard*>::iterator iter = mShards.begin(); iter != mShards.end(); ++iter)
+   {
+      Shard* pShard = *iter;
+      mta::MutexLock lock(pShard->mMutex);
+      for (Shard::EntryList::iterator entry = pShard->mEntries.begin(); entry != pShard->mEntries.end(); ++entry)
+      {
+         mCacheSize -= entry->mpUnit->getSize();
+      }
+      pShard->mEntries.clear();
+      pShard->mIndex.clear();
+      pShard->mMaxConcurrentRows = 0;
+   }
+   mMaxConcurrentRows = 0;
 }
@@ -0,0 +1,164 @@
+/*
+ * The information in this file is
+ * Copyright(c) 2007 Ball Aerospace & Technologies Corporation
+ * and is subject to the terms and conditions of the
+ * GNU Lesser General Public License Version 2.1
+ * The license text is available from   
+ * http://www.gnu.org/licenses/lgpl.html
+ */
+
+#include "AppConfig.h"
+
+#if defined(WIN_API)
+#include <windows.h>
+#else
+#include <sys/time.h>
+#endif
+
+#include "ModelServices.h"
+#include "PagerCounters.h"
+
+using namespace std;
+
+PagerCounters::Timer::Timer() :
+   mStart(PagerCounters::getMicroseconds())
+{}
+
+uint64_t PagerCounters::Timer::getElapsed() const
+{
+   uint64_t now = PagerCounters::getMicroseconds();
+   return now > mStart ? now - mStart : 0;
+}
+
+PagerCounters::TimedLock::TimedLock(BMutex& mutex, PagerCounters& counters) :
+   mTimer(),
+   mLock(mutex)
+{
+   counters.addLockWaitTime(mTimer.getElapsed());
+}
+
+PagerCounters::PagerCounters(const string& pagerName, const RasterElement* pElement) :
+   mPagerName(pagerName),
+   mpElement(pElement),
+   mGetPageCalls(0),
+   mCacheHits(0),
+   mCacheMisses(0),
+   mBytesFetched(0),
+   mDecodeTime(0),
+   mLockWaitTime(0),
+   mPagesLeased(0),
+   mPagesReleased(0)
+{
+   Service<ModelServices>()->registerRasterPagerCounters(this);
+}
+
+PagerCounters::~PagerCounters()
+{
+   Service<ModelServices>()->unregisterRasterPagerCounters(this);
+}
+
+void PagerCounters::setPagerName(const string& pagerName)
+{
+   mPagerName = pagerName;
+}
+
+void PagerCounters::setRasterElement(const RasterElement* pElement)
+{
+   mpElement = pElement;
+}
+
+void PagerCounters::addGetPageCall()
+{
+   ++mGetPageCalls;
+}
+
+void PagerCounters::addCacheHit()
+{
+   ++mCacheHits;
+}
+
+void PagerCounters::addCacheMiss()
+{
+   ++mCacheMisses;
+}
+
+void PagerCounters::addBytesFetched(uint64_t bytes)
+{
+   mBytesFetched += bytes;
+}
+
+void PagerCounters::addDecodeTime(uint64_t microseconds)
+{
+   mDecodeTime += microseconds;
+}
+
+void PagerCounters::addLockWaitTime(uint64_t microseconds)
+{
+   mLockWaitTime += microseconds;
+}
+
+void PagerCounters::addPageLeased()
+{
+   ++mPagesLeased;
+}
+
+void PagerCounters::addPageReleased()
+{
+   ++mPagesReleased;
+}
+
+uint64_t PagerCounters::getMicroseconds()
+{
+#if defined(WIN_API)
+   LARGE_INTEGER frequency;
+   LARGE_INTEGER counter;
+   if (QueryPerformanceFrequency(&frequency) == FALSE || frequency.QuadPart == 0 ||
+      QueryPerformanceCounter(&counter) == FALSE)
+   {
+      return static_cast<uint64_t>(GetTickCount()) * 1000;
+   }
+
+   return static_cast<uint64_t>(counter.QuadPart / frequency.QuadPart) * 1000000 +
+      static_cast<uint64_t>(counter.QuadPart % frequency.QuadPart) * 1000000 / frequency.QuadPart;
+#else
+   timeval now;
+   gettimeofday(&now, NULL);
+   return static_cast<uint64_t>(now.tv_sec) * 1000000 + now.tv_usec;
+#endif
+}
+
+string PagerCounters::getPagerName() const
+{
+   return mPagerName;
+}
+
+const RasterElement* PagerCounters::getRasterElement() const
+{
+   return mpElement;
+}
+
+RasterPagerCounters::Values PagerCounters::getValues() const
+{
+   Values values;
+   values.mGetPageCalls = mGetPageCalls;
+   values.mCacheHits = mCacheHits;
+   values.mCacheMisses = mCacheMisses;
+   values.mBytesFetched = mBytesFetched;
+   values.mDecodeTime = mDecodeTime;
+   values.mLockWaitTime = mLockWaitTime;
+   values.mPagesLeased = mPagesLeased;
+   values.mPagesReleased = mPagesReleased;
+   return values;
+}
+
+void PagerCounters::reset()
+{
+   mGetPageCalls = 0;
+   mCacheHits = 0;
+   mCacheMisses = 0;
+   mBytesFetched = 0;
+   mDecodeTime = 0;
+   mLockWaitTime = 0;
+   mPagesLeased = 0;
+   mPagesReleased = 0;
+}
@@ -10,8 +10,15 @@
 
 
 #include <assert.h>
+#include "AppConfig.h"
 #include "bthread_signal.h"
 
+#if defined(WIN_API)
+#include <sys/timeb.h>
+#else
+#include <sys/time.h>
+#endif
+
 BThreadSignal::BThreadSignal()
 {
    mThreadSignalID = NULL;
@@ -72,3 +79,30 @@ bool BThreadSignal::ThreadSignalWait(void *mutexData)
 
    return true;
 }
+
+// Returns false if the signal was not activated before the timeout
+bool BThreadSignal::ThreadSignalTimedWait(void *mutexData, unsigned int milliseconds)
+{
+   assert (mThreadSignalID != NULL);
+   assert (mutexData != NULL);
+
+   BMutex *data = (BMutex *) mutexData;
+
+   // pthread_cond_timedwait takes an absolute time
+   struct timespec timeout;
+#if defined(WIN_API)
+   struct _timeb now;
+   _ftime_s(&now);
+   unsigned int millisecondsLeft = now.millitm + milliseconds % 1000;
+   timeout.tv_sec = now.time + milliseconds / 1000 + millisecondsLeft / 1000;
+   timeout.tv_nsec = (millisecondsLeft % 1000) * 1000000L;
+#else
+   struct timeval now;
+   gettimeofday(&now, NULL);
+   long microsecondsLeft = now.tv_usec + (milliseconds % 1000) * 1000L;
+   timeout.tv_sec = now.tv_sec + milliseconds / 1000 + microsecondsLeft / 1000000L;
+   timeout.tv_nsec = (microsecondsLeft % 1000000L) * 1000L;
+#endif
+
+   return pthread_cond_timedwait(mThreadSignalID, data->GetMutexID(), &timeout) == 0;
+}
@@ -22,6 +22,7 @@ class BThreadSignal : public ThreadSignal
       virtual bool ThreadSignalInit();
       virtual bool ThreadSignalDestroy();
       virtual bool ThreadSignalWait(void *mutexData);
+      virtual bool ThreadSignalTimedWait(void *mutexData, unsigned int milliseconds);
       virtual bool ThreadSignalActivate();
 
    private:
@@ -17,6 +17,7 @@ class ThreadSignal
       virtual bool ThreadSignalInit() = 0;
       virtual bool ThreadSignalDestroy() = 0;
       virtual bool ThreadSignalWait(void *) = 0;
+      virtual bool ThreadSignalTimedWait(void *, unsigned int) = 0;
       virtual bool ThreadSignalActivate() = 0;
 };
 
@@ -238,6 +238,19 @@ bool BandMath::getInputSpecification(PlugInArgList*& pArgList)
       VERIFY(pArgList->addArg<bool>("Overlay Results", mbAsLayerOnExistingView, "Flag for whether "
          "the results should be added to the original view or a new view.  A new view is created "
          "by default if results are displayed."));
+
+      VERIFY(pArgList->addArg<vector<string> >("Input Expressions", NULL, "Expressions for band math to evaluate "
+         "in a single pass over the data.  Each expression is written to its own bands of the result, in order.  "
+         "Input Expression is ignored if this is set."));
+      VERIFY(pArgList->addArg<EncodingType>("Output Encoding Type", NULL, "Encoding type of the result.  "
+         "Every expression is stored in this one encoding, since all of them are written as bands of a single "
+         "result cube; use Output Scales and Output Offsets to fit each expression to the range of the type.  "
+         "Values stored as integers are rounded and limited to the range of the type.  The default is "
+         "4-byte floating point."));
+      VERIFY(pArgList->addArg<vector<double> >("Output Scales", NULL, "Factor by which the values of each "
+         "expression are multiplied before they are stored.  The default is 1 for every expression."));
+      VERIFY(pArgList->addArg<vector<double> >("Output Offsets", NULL, "Value which is added to the values of "
+         "each expression after they are scaled.  The default is 0 for every expression."));
    }
 
    return true;
@@ -267,6 +280,10 @@ bool BandMath::initialize()
    mResultsName = "Blank RESULT";
    mExpression = " ";  // prevent WizardNode from considering the empty string
                        // a failure
+   mExpressions.clear();
+   mResultType = FLT4BYTES;
+   mScales.clear();
+   mOffsets.clear();
    meGabbiness = NORMAL;
    mbError = false;
 
@@ -343,7 +360,7 @@ bool BandMath::execute(PlugInArgList* pInputArgList, PlugInArgList* pOutputArgLi
       }
    }
 
-   char errorVal[80];
+   char errorVal[256];
    int errorCode = -1;  
 
    if (mbInteractive)
@@ -362,20 +379,45 @@ bool BandMath::execute(PlugInArgList* pInputArgList, PlugInArgList* pOutputArgLi
       mbDegrees = frmASIT.isDegrees();
       mbCubeMath = frmASIT.isMultiCube();
       mbAsLayerOnExistingView = frmASIT.isResultsMatrix();
+      mExpressions.push_back(mExpression);
    }
    else
    {
       mbCubeMath = false;
+      if (mExpressions.empty())
+      {
+         mExpressions.push_back(mExpression);
+      }
 
       //check for cube math
-      unsigned int pos = mExpression.find_first_of(string("cC"));
-      if ((pos >= 0) && (pos < (mExpression.length() - 1)) && ((mExpression[pos + 1] > '0') &&
-                                                              (mExpression[pos + 1] < '9')))
+      for (vector<string>::const_iterator iter = mExpressions.begin(); iter != mExpressions.end(); ++iter)
+      {
+         const string& expression = *iter;
+         unsigned int pos = expression.find_first_of(string("cC"));
+         if ((pos >= 0) && (pos < (expression.length() - 1)) && ((expression[pos + 1] > '0') &&
+                                                                (expression[pos + 1] < '9')))
+         {
+            mbCubeMath = true;
+         }
+      }
+
+      if ((mScales.empty() == false && mScales.size() != mExpressions.size()) ||
+         (mOffsets.empty() == false && mOffsets.size() != mExpressions.size()))
       {
-         mbCubeMath = true;
+         mstrProgressString = "There must be one output scale and offset for each expression.";
+         meGabbiness = ERRORS;
+         displayErrorMessage();
+         return false;
       }
    }
-   if (!createReturnValue(mExpression))
+
+   string expressionText = mExpressions.front();
+   for (vector<string>::size_type i = 1; i < mExpressions.size(); ++i)
+   {
+      expressionText += ", " + mExpressions[i];
+   }
+
+   if (!createReturnValue(expressionText))
    {
       mstrProgressString = "Could not allocate space for results.";
       meGabbiness = ERRORS;
@@ -385,56 +427,22 @@ bool BandMath::execute(PlugInArgList* pInputArgList, PlugInArgList* pOutputArgLi
    {
       StepResource pResultStep("Compute result", "app", "CDCC12AC-32DD-4831-BC6B-225538C92053");
       mpStep = pResultStep.get();
-      pResultStep->addProperty("Expression", mExpression);
-
-      FactoryResource<DataRequest> pReturnRequest;
-      pReturnRequest->setInterleaveFormat(BIP);
-      pReturnRequest->setWritable(true);
-      DataAccessor returnDa = mpResultData->getDataAccessor(pReturnRequest.release());
-      if (!returnDa.isValid())
-      {
-         mstrProgressString = "Could not access the result data.";
-         meGabbiness = ERRORS;
-         displayErrorMessage();
-         return false;
-      }
+      pResultStep->addProperty("Expression", expressionText);
 
+      // The result and the cubes are read by several threads, each with accessors of its own
       if (!mbCubeMath)
       {
-         FactoryResource<DataRequest> pCubeRequest;
-         pCubeRequest->setInterleaveFormat(BIP);
-         DataAccessor cubeDa = mpCube->getDataAccessor(pCubeRequest.release());
-         if (!cubeDa.isValid())
-         {
-            mstrProgressString = "Reading this cube format is not supported.";
-            meGabbiness = ERRORS;
-            displayErrorMessage();
-            return false;
-         }
-
-         vector<DataAccessor> accessors(1, cubeDa);
+         vector<RasterElement*> cubes(1, mpCube);
          vector<EncodingType> types(1, pDescriptor->getDataType());
 
-         char* mutableExpression = new char[mExpression.size() + 1];
-         strcpy(mutableExpression, mExpression.c_str());
-
-         errorCode = eval(mpProgress, accessors, types, mCubeRows, mCubeColumns,
-            mCubeBands, mutableExpression, returnDa, mbDegrees, errorVal, mbCubeMath, mbInteractive);
-
-         delete [] mutableExpression;
+         errorCode = eval(mpProgress, cubes, types, mCubeRows, mCubeColumns, mCubeBands, mExpressions, mScales,
+            mOffsets, mpResultData, mbDegrees, errorVal, mbCubeMath, mbInteractive);
       }
       else // cube math
       {
-         EncodingType type = pDescriptor->getDataType();
-
-         vector<DataAccessor> accessors;
          vector<EncodingType> dataTypes;
          for (unsigned int i = 0; i < mCubesList.size(); ++i)
          {
-            FactoryResource<DataRequest> pRequest;
-            pRequest->setInterleaveFormat(BIP);
-            DataAccessor daCube = mCubesList[i]->getDataAccessor(pRequest.release());
-            accessors.push_back(daCube);
             const RasterDataDescriptor* pDdCube = dynamic_cast<RasterDataDescriptor*>(mCubesList.at(i)->
                getDataDescriptor());
             if (pDdCube != NULL)
@@ -450,14 +458,8 @@ bool BandMath::execute(PlugInArgList* pInputArgList, PlugInArgList* pOutputArgLi
             }
          }
 
-         char* mutableExpression = new char[mExpression.size() + 1];
-         strcpy(mutableExpression, mExpression.c_str());
-
-         errorCode = eval(mpProgress, accessors, dataTypes, mCubeRows,
-            mCubeColumns, mCubeBands, mutableExpression, returnDa,
-            mbDegrees, errorVal, mbCubeMath, mbInteractive);
-
-         delete [] mutableExpression;
+         errorCode = eval(mpProgress, mCubesList, dataTypes, mCubeRows, mCubeColumns, mCubeBands, mExpressions,
+            mScales, mOffsets, mpResultData, mbDegrees, errorVal, mbCubeMath, mbInteractive);
       }
 
       if (errorCode != 0)
@@ -656,6 +658,32 @@ bool BandMath::parse(PlugInArgList* pArgInList, PlugInArgList* pArgOutList)
 
       // Overlay results
       VERIFY(pArgInList->getPlugInArgValue("Overlay Results", mbAsLayerOnExistingView));
+
+      // Several expressions and the encoding of the result
+      if (pArgInList->getArg("Input Expressions", pArg) && pArg != NULL && pArg->isActualSet())
+      {
+         VERIFY(pArgInList->getPlugInArgValue("Input Expressions", mExpressions));
+      }
+
+      if (pArgInList->getArg("Output Encoding Type", pArg) && pArg != NULL && pArg->isActualSet())
+      {
+         if (pArgInList->getPlugInArgValue("Output Encoding Type", mResultType) == false ||
+            mResultType.isValid() == false || mResultType == INT4SCOMPLEX || mResultType == FLT8COMPLEX)
+         {
+            mstrProgressString = "Invalid output encoding type.";
+            return false;
+         }
+      }
+
+      if (pArgInList->getArg("Output Scales", pArg) && pArg != NULL && pArg->isActualSet())
+      {
+         VERIFY(pArgInList->getPlugInArgValue("Output Scales", mScales));
+      }
+
+      if (pArgInList->getArg("Output Offsets", pArg) && pArg != NULL && pArg->isActualSet())
+      {
+         VERIFY(pArgInList->getPlugInArgValue("Output Offsets", mOffsets));
+      }
    }
 
    return true;
@@ -702,6 +730,7 @@ bool BandMath::createReturnValue(string partialResultsName)
    {
       bandCount = 1;
    }
+   bandCount *= mExpressions.size();
 
    RasterElement* pParent = NULL;
    if (mbAsLayerOnExistingView)
@@ -709,7 +738,7 @@ bool BandMath::createReturnValue(string partialResultsName)
       pParent = mpCube;
    }
    RasterElement* pRaster = RasterUtilities::createRasterElement(mResultsName, origRows.size(),
-      origColumns.size(), bandCount, FLT4BYTES, BIP, pOrigDescriptor->getProcessingLocation() == IN_MEMORY, pParent);
+      origColumns.size(), bandCount, mResultType, BIP, pOrigDescriptor->getProcessingLocation() == IN_MEMORY, pParent);
 
    if (pRaster == NULL)
    {
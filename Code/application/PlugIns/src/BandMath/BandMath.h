@@ -83,6 +83,10 @@ private:
    Progress* mpProgress; 
    std::string mResultsName;
    std::string mExpression;
+   std::vector<std::string> mExpressions;   // evaluated in one pass, each into its own bands of the result
+   EncodingType mResultType;
+   std::vector<double> mScales;
+   std::vector<double> mOffsets;
 
    RasterElement* mpResultData; 
 
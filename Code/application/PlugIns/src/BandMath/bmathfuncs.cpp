@@ -9,8 +9,16 @@
 
 #include "AppConfig.h"
 #include "BandMath.h"
+#include "bmathprogram.h"
+#include "DataRequest.h"
 #include "mbox.h"
+#include "ObjectResource.h"
+#include "RasterDataDescriptor.h"
+#include "RasterElement.h"
 #include "RasterUtilities.h"
+#include "switchOnEncoding.h"
+
+#include <limits>
 
 using namespace std;
 
@@ -934,590 +942,452 @@ int OpParams(char* ops, char* val)
    return retval;
 }
 
-int eval(Progress* pProgress, vector<DataAccessor>& dataCubes, const vector<EncodingType>& types,
-         int rows, int columns, int bands, char* exp, DataAccessor returnAccessor, bool degrees, char* error,
-         bool cubeMath, bool interactive)
+namespace
 {
-   int stringSize = strlen(exp)*2;
-   if (stringSize < 80)
+   bool buildTree(char* exp, int bands, int cubes, bool degrees, char* error, DataNode*& pTree)
    {
-      stringSize = 80;
-   }
+      int stringSize = strlen(exp)*2;
+      if (stringSize < 80)
+      {
+         stringSize = 80;
+      }
 
-   char* pString = new char[stringSize];
+      char* pString = new char[stringSize];
 
-   int iError = ParseExp(exp, bands, pString, stringSize, dataCubes.size());
-   if (iError)
-   {
-      strcpy(error, pString);
-      return -1;
-   }
+      int iError = ParseExp(exp, bands, pString, stringSize, cubes);
+      if (iError)
+      {
+         strcpy(error, pString);
+         delete [] pString;
+         return false;
+      }
 
-   bool lastCharSep = false;
-   int itemsCount = 1;
-   int i;
-   for (i = 0; pString[i]; i++)
-   {
-      if (pString[i] == SEP)
+      bool lastCharSep = false;
+      int itemsCount = 1;
+      int i;
+      for (i = 0; pString[i]; i++)
       {
-         if (lastCharSep == false)
+         if (pString[i] == SEP)
          {
-            itemsCount++;
-         }
+            if (lastCharSep == false)
+            {
+               itemsCount++;
+            }
 
-         lastCharSep = true;
-      }
-      else
-      {
-         lastCharSep = false;
+            lastCharSep = true;
+         }
+         else
+         {
+            lastCharSep = false;
+         }
       }
-   }
 
-   int* pItems = new int[itemsCount];
-   pItems[0] = 0;
-   int pos = 1;
+      int* pItems = new int[itemsCount];
+      pItems[0] = 0;
+      int pos = 1;
 
-   for (i = 0; pString[i]; i++)
-   {
-      if (pString[i] == SEP)
+      for (i = 0; pString[i]; i++)
       {
-         //Skip multiple SEP's
-         while (pString[i+1] == SEP)
+         if (pString[i] == SEP)
          {
+            //Skip multiple SEP's
+            while (pString[i+1] == SEP)
+            {
+               pString[i] = 0;
+               i++;
+            }
+
+            pItems[pos] = i+1;
+            pos++;
             pString[i] = 0;
-            i++;
          }
-
-         pItems[pos] = i+1;
-         pos++;
-         pString[i] = 0;
       }
-   }
-
-   char ops[] = "+ 2 1 - 2 1 * 2 2 / 2 2 ^ 2 3 sqrt 1 9 sin 1 9 cos 1 9 tan 1 9 log 1 9 log10 1 9 "
-      "log2 1 9 exp 1 9 abs 1 9 asin 1 9 acos 1 9 atan 1 9 sinh 1 9 cosh 1 9 tanh 1 9 sec 1 9 csc 1 9 "
-      "cot 1 9 asec 1 9 acsc 1 9 acot 1 9 sech 1 9 csch 1 9 coth 1 9 rand 1 9 ";
-   DataNode* pTree = BuildTreeFromInfix(ops, pString, pItems, itemsCount, degrees);
-   delete [] pItems;
-   delete [] pString;
-   pItems = NULL;
-   pString = NULL;
-
-   bool dispDZMes = true;
-   bool dispUDMes = true;
-   bool dispCMMes = true;
 
-   int j;
+      char ops[] = "+ 2 1 - 2 1 * 2 2 / 2 2 ^ 2 3 sqrt 1 9 sin 1 9 cos 1 9 tan 1 9 log 1 9 log10 1 9 "
+         "log2 1 9 exp 1 9 abs 1 9 asin 1 9 acos 1 9 atan 1 9 sinh 1 9 cosh 1 9 tanh 1 9 sec 1 9 csc 1 9 "
+         "cot 1 9 asec 1 9 acsc 1 9 acot 1 9 sech 1 9 csch 1 9 coth 1 9 rand 1 9 ";
+      pTree = BuildTreeFromInfix(ops, pString, pItems, itemsCount, degrees);
+      delete [] pItems;
+      delete [] pString;
 
-   srand(time(NULL));
-
-   int bandCount = 1;
-   if (cubeMath)
-   {
-      bandCount = bands;
+      return true;
    }
 
-   float* pReturnValue = NULL;
-   vector<void*> cubeValues(dataCubes.size());
-
-   for (i = 0; i < rows; i++)
+   // Converts a value to the encoding of the result, rounding and saturating integers
+   template<typename T>
+   bool convertValue(double value, T& result)
    {
-      for (j = 0; j < columns; j++)
+      if (FINITE(value) == 0)
       {
-         pReturnValue = reinterpret_cast<float*>(returnAccessor->getColumn());
-         for (unsigned int cubeNum = 0; cubeNum < dataCubes.size(); ++cubeNum)
-         {
-            cubeValues[cubeNum] = dataCubes[cubeNum]->getColumn();
-         }
-
-         for (int bandNum = 0; bandNum < bandCount; ++bandNum)
-         {
-            try
-            {
-               float newValue = static_cast<float>(pTree->eval(cubeValues, bandNum, types));
-               if (RasterUtilities::isBad(newValue))
-               {
-                  throw out_of_range("The value is out of range");
-               }
-
-               pReturnValue[bandNum] = newValue;
-            }
-            catch (DivZero)
-            {
-               if (interactive == true)
-               {
-                  if (dispDZMes)
-                  {
-                     MBox mb("Warning", "Warning bandmathfuncs003: Divide By Zero\nSelect 'OK' to continue, \n"
-                        "all bad values will be set to 0.  \nOr 'Cancel' to cancel the operation.",
-                        MB_OK_CANCEL_ALWAYS, NULL);
-
-                     if (mb.exec() == QDialog::Rejected)
-                     {
-                        return -2;
-                     }
-                     else if (mb.cbAlways->isChecked())
-                     {
-                        dispDZMes = false;
-                     }
-                  }
-               }
-               else
-               {
-                  if (dispDZMes)
-                  {
-                     if (pProgress != NULL)
-                     {
-                        pProgress->updateProgress("The band math operation attempted to divide by zero. "
-                           "Operation will continue and bad values will be set to 0.", 100 * i / rows, WARNING);
-                     }
-                     dispDZMes = false;
-                  }
-               }
-
-               memset(pReturnValue, 0, bandCount * sizeof(float)); // clear the point
-            }
-            catch (Undefined)
-            {
-               if (interactive == true)
-               {
-                  if (dispUDMes)
-                  {
-                     MBox mb("Warning", "Warning bandmathfuncs001: Undefined Value\n"
-                        "Select 'OK' to continue, \nall bad values will be set to 0.  \n"
-                        "Or 'Cancel' to cancel the operation.",
-                        MB_OK_CANCEL_ALWAYS, NULL);
-
-                     if (mb.exec() == QDialog::Rejected)
-                     {
-                        return -2;
-                     }
-                     else if (mb.cbAlways->isChecked())
-                     {
-                        dispUDMes = false;
-                     }
-                  }
-               }
-               else
-               {
-                  strcpy(error, "The band math operation encountered an undefined value.");
-                  return -1;
-               }
-
-               memset(pReturnValue, 0, bandCount * sizeof(float)); // clear the point
-            }
-            catch (Complex)
-            {
-               if (interactive == true)
-               {
-                  if (dispCMMes)
-                  {
-                     MBox mb("Warning", "Warning bandmathfuncs002: Math Operation Resulted in a Complex Number\n"
-                        "Select 'OK' to continue, \nall bad values will be set to 0.\n"
-                        "Or 'Cancel' to cancel the operation.",
-                        MB_OK_CANCEL_ALWAYS, NULL);
-
-                     if (mb.exec() == QDialog::Rejected)
-                     {
-                        return -2;
-                     }
-                     else if (mb.cbAlways->isChecked())
-                     {
-                        dispCMMes = false;
-                     }
-                  }
-               }
-               else
-               {
-                  strcpy(error, "The band math operation resulted in an invalid complex number.");
-                  return -1;
-               }
-
-               memset(pReturnValue, 0, bandCount * sizeof(float)); // clear the point
-            }
-
-            catch (NoData)
-            {
-               strcpy(error, "The band math operation could not be perfomed because the data is not available.");
-               return -1;
-            }
+         return false;
+      }
 
-            catch (...)
-            {
-               strcpy(error, "The band math operation resulted in a floating point error.");
-               return -1;
-            }
-         }
-         returnAccessor->nextColumn();
-         for (unsigned int cubeNum = 0; cubeNum < dataCubes.size(); ++cubeNum)
-         {
-            dataCubes[cubeNum]->nextColumn();
-         }
+      double rounded = floor(value + 0.5);
+      if (rounded <= static_cast<double>(numeric_limits<T>::min()))
+      {
+         result = numeric_limits<T>::min();
       }
-      returnAccessor->nextRow();
-      for (unsigned int cubeNum = 0; cubeNum < dataCubes.size(); ++cubeNum)
+      else if (rounded >= static_cast<double>(numeric_limits<T>::max()))
       {
-         dataCubes[cubeNum]->nextRow();
+         result = numeric_limits<T>::max();
       }
-
-      if (pProgress != NULL)
+      else
       {
-         pProgress->updateProgress("Band Math", 100 * i / rows, NORMAL);
+         result = static_cast<T>(rounded);
       }
+      return true;
    }
 
-   return 0;
-}
-
-double doubleFromEncoding(EncodingType encoding, void* data, int offset)
-{
-   if (data == NULL)
+   template<>
+   bool convertValue<float>(double value, float& result)
    {
-      return 0.0;
+      result = static_cast<float>(value);
+      return RasterUtilities::isBad(result) == false;
    }
 
-   switch (encoding)
+   template<>
+   bool convertValue<double>(double value, double& result)
    {
-   case INT1SBYTE:
-      return reinterpret_cast<signed char*>(data)[offset];
-   case INT1UBYTE:
-      return reinterpret_cast<unsigned char*>(data)[offset];
-   case INT2SBYTES:
-      return reinterpret_cast<signed short*>(data)[offset];
-   case INT2UBYTES:
-      return reinterpret_cast<unsigned short*>(data)[offset];
-   case INT4SBYTES:
-      return reinterpret_cast<signed int*>(data)[offset];
-   case INT4UBYTES:
-      return reinterpret_cast<unsigned int*>(data)[offset];
-   case FLT4BYTES:
-      return reinterpret_cast<float*>(data)[offset];
-   case FLT8BYTES:
-      return reinterpret_cast<double*>(data)[offset];
-   default:
-      break;
+      result = value;
+      return FINITE(value) != 0;
    }
-
-   return 0.0;
 }
 
-double DataNode::eval(vector<void*>& data, int band, const vector<EncodingType>& types)
+int eval(Progress* pProgress, const vector<RasterElement*>& cubes, const vector<EncodingType>& types,
+         int rows, int columns, int bands, const vector<string>& expressions, const vector<double>& scales,
+         const vector<double>& offsets, RasterElement* pResult, bool degrees, char* error, bool cubeMath,
+         bool interactive)
 {
-   if (data.empty() || data.size() != types.size() || Opera == NULL)
+   // The expressions are evaluated together so that the cubes are read once
+   BandMathProgram program(types, bands);
+   for (vector<string>::const_iterator iter = expressions.begin(); iter != expressions.end(); ++iter)
    {
-      return 0.0;
-   }
+      vector<char> exp(iter->begin(), iter->end());
+      exp.push_back('\0');
 
-   if (!isOperator)
-   {
-      if (!strcmp(Opera, "pi") || !strcmp(Opera, "PI") || !strcmp(Opera, "Pi"))
+      DataNode* pTree = NULL;
+      if (buildTree(&exp[0], bands, cubes.size(), degrees, error, pTree) == false)
       {
-         return PI;
+         return -1;
       }
 
-      if (!strcmp(Opera, "e") || !strcmp(Opera, "E"))
-      {
-         return exp(1.0);
-      }
-
-      if ((Opera[0] == 'b') || (Opera[0] == 'B'))
-      {
-         int bandOperation = atoi(&Opera[1]) - 1;
-         return doubleFromEncoding(types[0], data[0], bandOperation);
-      }
-
-      if ((Opera[0] == 'c') || (Opera[0] == 'C'))
-      {
-         int cube = atoi(&Opera[1]) - 1;
-
-         if (data.size() > static_cast<unsigned int>(cube))
-         {
-            return doubleFromEncoding(types[cube], data[cube], band);
-         }
-         return 0.0;
-      }
-      return atof(Opera);
+      program.addExpression(pTree);
+      delete pTree;
    }
-   if (!strcmp(Opera, "("))
+
+   BandMathWarnings warnings;
+   BandMathInput input;
+   input.mpProgram = &program;
+   input.mpWarnings = &warnings;
+   input.mCubes = cubes;
+   input.mpResult = pResult;
+   input.mRows = rows;
+   input.mColumns = columns;
+   input.mScales = scales;
+   input.mScales.resize(expressions.size(), 1.0);
+   input.mOffsets = offsets;
+   input.mOffsets.resize(expressions.size(), 0.0);
+   input.mSeed = static_cast<unsigned int>(time(NULL));
+   input.mInteractive = interactive;
+   if (cubeMath)
    {
-      return Right->eval(data, band, types);
+      input.mBandCount = bands;
    }
-   if (!strcmp(Opera, "+"))
+
+   // Each thread evaluates a block of rows
+   BandMathOutput output;
+   mta::ProgressObjectReporter reporter("Band Math", pProgress);
+   mta::MultiThreadedAlgorithm<BandMathInput, BandMathOutput, BandMathThread>
+      alg(mta::getNumRequiredThreads(rows), input, output, &reporter, mta::POLLED_REPORTS);
+   switch (alg.run())
    {
-      return Left->eval(data, band, types) + Right->eval(data, band, types);
+   case mta::SUCCESS:
+      break;
+   case mta::ABORT:
+      return -2;
+   default:
+      strcpy(error, alg.getErrorText().c_str());
+      return -1;
    }
-   if (!strcmp(Opera, "-"))
+
+   if (warnings.isCancelled())
    {
-      return Left->eval(data, band, types) - Right->eval(data, band, types);
+      return -2;
    }
-   if (!strcmp(Opera, "*"))
+
+   // The user was asked about the faults of an interactive operation while the rows were computed
+   if (interactive == false && output.mFaultCounts[BandMathProgram::FAULT_DIVIDE_BY_ZERO] > 0 && pProgress != NULL)
    {
-      return Left->eval(data, band, types) * Right->eval(data, band, types);
+      pProgress->updateProgress("The band math operation attempted to divide by zero. "
+         "Operation will continue and bad values will be set to 0.", 100, WARNING);
    }
-   if (!strcmp(Opera, "/"))
-   {
-      double resRight = Right->eval(data, band, types);
-      if (resRight == 0)
-      {
-         throw DivZero();
-      }
 
-      return Left->eval(data, band, types) / resRight;
-   }
-   if (!strcmp(Opera, "^"))
-   {
-      double resLeft = Left->eval(data, band, types);
-      double resRight = Right->eval(data, band, types);
+   return 0;
+}
 
-      if (resLeft == 0 && resRight <= 0)
-      {
-         throw DivZero();
-      }
-      if (resLeft < 0)
-      {
-         double inter;
-         double frac = modf(resRight, &inter);
-         if (frac)
-         {
-            throw Complex();
-         }
-      }
-      return pow(resLeft, resRight);
-   }
-   if (!strcmp(Opera, "sqrt"))
-   {
-      double resRight = Right->eval(data, band, types);
-      if (resRight <= 0)
-      {
-         throw Complex();
-      }
-      return sqrt(resRight);
-   }
-   if (!strcmp(Opera, "sin"))
-   {
-      if (degrees)
-      {
-         return sin(D_TO_R_MULT*Right->eval(data, band, types));
-      }
+BandMathThread::BandMathThread(const BandMathInput& input, int threadCount, int threadIndex,
+                               mta::ThreadReporter& reporter) :
+   mta::AlgorithmThread(threadIndex, reporter),
+   mInput(input),
+   mRowRange(getThreadRange(threadCount, input.mRows)),
+   mFaultCounts(BandMathProgram::FAULT_BAD_VALUE + 1, 0)
+{
+}
 
-      return sin(Right->eval(data, band, types));
-   }
-   if (!strcmp(Opera, "cos"))
+void BandMathThread::run()
+{
+   const RasterDataDescriptor* pResultDescriptor =
+      static_cast<const RasterDataDescriptor*>(mInput.mpResult->getDataDescriptor());
+   if (mRowRange.mLast < mRowRange.mFirst || mInput.mColumns <= 0)
    {
-      if (degrees)
-      {
-         return cos(D_TO_R_MULT*Right->eval(data, band, types));
-      }
-
-      return cos(Right->eval(data, band, types));
+      return;
    }
-   if (!strcmp(Opera, "tan"))
-   {
-      if (degrees)
-      {
-         return tan(D_TO_R_MULT*Right->eval(data, band, types));
-      }
 
-      return tan(Right->eval(data, band, types));
-   }
-   if (!strcmp(Opera, "log"))
+   FactoryResource<DataRequest> pResultRequest;
+   pResultRequest->setInterleaveFormat(BIP);
+   pResultRequest->setRows(pResultDescriptor->getActiveRow(mRowRange.mFirst),
+      pResultDescriptor->getActiveRow(mRowRange.mLast));
+   pResultRequest->setWritable(true);
+   DataAccessor resultAccessor = mInput.mpResult->getDataAccessor(pResultRequest.release());
+   if (!resultAccessor.isValid())
    {
-      double resRight = Right->eval(data, band, types);
-      if (resRight <= 0)
-      {
-         throw Undefined();
-      }
-      return log(resRight);
+      getReporter().reportError("Could not access the result data.");
+      return;
    }
-   if (!strcmp(Opera, "log10"))
+
+   vector<DataAccessor> cubeAccessors;
+   for (vector<RasterElement*>::const_iterator iter = mInput.mCubes.begin(); iter != mInput.mCubes.end(); ++iter)
    {
-      double resRight = Right->eval(data, band, types);
-      if (resRight <= 0)
+      const RasterDataDescriptor* pDescriptor =
+         static_cast<const RasterDataDescriptor*>((*iter)->getDataDescriptor());
+      FactoryResource<DataRequest> pRequest;
+      pRequest->setInterleaveFormat(BIP);
+      pRequest->setRows(pDescriptor->getActiveRow(mRowRange.mFirst), pDescriptor->getActiveRow(mRowRange.mLast));
+      DataAccessor accessor = (*iter)->getDataAccessor(pRequest.release());
+      if (!accessor.isValid())
       {
-         throw Undefined();
+         getReporter().reportError("Reading this cube format is not supported.");
+         return;
       }
-      return log10(resRight);
+      cubeAccessors.push_back(accessor);
    }
-   if (!strcmp(Opera, "log2"))
+
+   switchOnEncoding(pResultDescriptor->getDataType(), evaluateRows, NULL, resultAccessor, cubeAccessors);
+}
+
+template<typename T>
+void BandMathThread::evaluateRows(T*, DataAccessor& resultAccessor, vector<DataAccessor>& cubeAccessors)
+{
+   const BandMathProgram& program = *mInput.mpProgram;
+   int columns = mInput.mColumns;
+   int bandCount = mInput.mBandCount;
+   int expressionCount = static_cast<int>(mInput.mScales.size());
+   int resultBandCount = expressionCount * bandCount;
+   BandMathProgram::Workspace workspace;
+   workspace.setSeed(mInput.mSeed + getThreadIndex());
+   vector<const void*> cubeRows(cubeAccessors.size());
+   int oldPercentDone = -1;
+
+   for (int row = mRowRange.mFirst; row <= mRowRange.mLast; ++row)
    {
-      double resRight = Right->eval(data, band, types);
-      if (resRight <= 0)
+      int percentDone = mRowRange.computePercent(row);
+      if (percentDone > oldPercentDone)
       {
-         throw Undefined();
+         oldPercentDone = percentDone;
+         getReporter().reportProgress(getThreadIndex(), percentDone);
       }
-      return log(resRight)/log(2.0);
-   }
-   if (!strcmp(Opera, "exp"))
-   {
-      return exp(Right->eval(data, band, types));
-   }
-   if (!strcmp(Opera, "abs"))
-   {
-      return fabs(Right->eval(data, band, types));
-   }
-   if (!strcmp(Opera, "asin"))
-   {
-      double resRight = Right->eval(data, band, types);
-      if (resRight < -1 || resRight > 1)
+      if (getReporter().isAborted() || mInput.mpWarnings->isCancelled())
       {
-         throw Complex();
+         return;
       }
 
-      if (degrees)
+      bool dataValid = resultAccessor.isValid();
+      for (unsigned int cubeNum = 0; cubeNum < cubeAccessors.size(); ++cubeNum)
       {
-         return R_TO_D_MULT * asin(resRight);
+         dataValid = dataValid && cubeAccessors[cubeNum].isValid();
+         cubeRows[cubeNum] = (dataValid ? cubeAccessors[cubeNum]->getRow() : NULL);
       }
-
-      return asin(resRight);
-   }
-   if (!strcmp(Opera, "acos"))
-   {
-      double resRight = Right->eval(data, band, types);
-      if (resRight < -1 || resRight > 1)
+      if (dataValid == false)
       {
-         throw Complex();
+         getReporter().reportError("The band math operation could not be perfomed because the data is not available.");
+         return;
       }
 
-      if (degrees)
+      T* pReturnRow = reinterpret_cast<T*>(resultAccessor->getRow());
+      for (int bandNum = 0; bandNum < bandCount; ++bandNum)
       {
-         return R_TO_D_MULT * acos(resRight);
-      }
+         program.execute(cubeRows, bandNum, columns, workspace);
+         for (int expression = 0; expression < expressionCount; ++expression)
+         {
+            const double* pValues = program.getValues(expression, workspace);
+            const unsigned char* pFaults = program.getFaults(expression, workspace);
+            double scale = mInput.mScales[expression];
+            double offset = mInput.mOffsets[expression];
+            int expressionBand = expression * bandCount;
 
-      return acos(resRight);
-   }
-   if (!strcmp(Opera, "atan"))
-   {
-      if (degrees)
-      {
-         return R_TO_D_MULT * atan(Right->eval(data, band, types));
-      }
+            for (int j = 0; j < columns; j++)
+            {
+               T* pReturnValue = pReturnRow + j * resultBandCount + expressionBand;
+               BandMathProgram::FaultEnum fault = BandMathProgram::NO_FAULT;
+               if (pFaults != NULL)
+               {
+                  fault = static_cast<BandMathProgram::FaultEnum>(pFaults[j]);
+               }
+               if (fault == BandMathProgram::NO_FAULT)
+               {
+                  if (convertValue(pValues[j] * scale + offset, pReturnValue[bandNum]))
+                  {
+                     continue;
+                  }
+                  fault = BandMathProgram::FAULT_BAD_VALUE;
+               }
 
-      return atan(Right->eval(data, band, types));
-   }
-   if (!strcmp(Opera, "sinh"))
-   {
-      if (degrees)
-      {
-         return sinh(D_TO_R_MULT*Right->eval(data, band, types));
-      }
+               switch (fault)
+               {
+               case BandMathProgram::FAULT_DIVIDE_BY_ZERO:
+                  break;
+               case BandMathProgram::FAULT_UNDEFINED:
+                  if (mInput.mInteractive == false)
+                  {
+                     getReporter().reportError("The band math operation encountered an undefined value.");
+                     return;
+                  }
+                  break;
+               case BandMathProgram::FAULT_COMPLEX:
+                  if (mInput.mInteractive == false)
+                  {
+                     getReporter().reportError("The band math operation resulted in an invalid complex number.");
+                     return;
+                  }
+                  break;
+               default:
+                  getReporter().reportError("The band math operation resulted in a floating point error.");
+                  return;
+               }
 
-      return sinh(Right->eval(data, band, types));
-   }
-   if (!strcmp(Opera, "cosh"))
-   {
-      if (degrees)
-      {
-         return cosh(D_TO_R_MULT*Right->eval(data, band, types));
-      }
+               ++mFaultCounts[fault];
 
-      return cosh(Right->eval(data, band, types));
-   }
-   if (!strcmp(Opera, "tanh"))
-   {
-      if (degrees)
-      {
-         return tanh(D_TO_R_MULT*Right->eval(data, band, types));
-      }
+               // Clear the point of this expression; the bands after this one are still written when they
+               // are evaluated
+               memset(pReturnValue, 0, bandCount * sizeof(T));
 
-      return tanh(Right->eval(data, band, types));
-   }
-   if (!strcmp(Opera, "csc"))
-   {
-      if (degrees)
-      {
-         return 1/sin(D_TO_R_MULT*Right->eval(data, band, types));
+               if (mInput.mInteractive && mInput.mpWarnings->confirm(fault, *this) == false)
+               {
+                  return;
+               }
+            }
+         }
       }
 
-      return 1/sin(Right->eval(data, band, types));
-   }
-   if (!strcmp(Opera, "sec"))
-   {
-      if (degrees)
+      resultAccessor->nextRow();
+      for (unsigned int cubeNum = 0; cubeNum < cubeAccessors.size(); ++cubeNum)
       {
-         return 1/cos(D_TO_R_MULT*Right->eval(data, band, types));
+         cubeAccessors[cubeNum]->nextRow();
       }
-
-      return 1/cos(Right->eval(data, band, types));
    }
-   if (!strcmp(Opera, "cot"))
-   {
-      if (degrees)
-      {
-         return 1/tan(D_TO_R_MULT*Right->eval(data, band, types));
-      }
 
-      return 1/tan(Right->eval(data, band, types));
-   }
-   if (!strcmp(Opera, "acsc"))
-   {
-      double resRight = 1 / Right->eval(data, band, types);
-      if (resRight < -1 || resRight > 1)
-      {
-         throw Complex();
-      }
+   getReporter().reportProgress(getThreadIndex(), 100);
+}
 
-      if (degrees)
-      {
-         return R_TO_D_MULT * asin(resRight);
-      }
+unsigned int BandMathThread::getFaultCount(BandMathProgram::FaultEnum fault) const
+{
+   return mFaultCounts[fault];
+}
 
-      return asin(resRight);
-   }
-   if (!strcmp(Opera, "asec"))
+BandMathOutput::BandMathOutput() :
+   mFaultCounts(BandMathProgram::FAULT_BAD_VALUE + 1, 0)
+{
+}
+
+bool BandMathOutput::compileOverallResults(const vector<BandMathThread*>& threads)
+{
+   for (vector<BandMathThread*>::const_iterator iter = threads.begin(); iter != threads.end(); ++iter)
    {
-      double resRight = 1 / Right->eval(data, band, types);
-      if (resRight < -1 || resRight > 1)
+      for (unsigned int fault = 0; fault < mFaultCounts.size(); ++fault)
       {
-         throw Complex();
+         mFaultCounts[fault] += (*iter)->getFaultCount(static_cast<BandMathProgram::FaultEnum>(fault));
       }
+   }
 
-      if (degrees)
-      {
-         return R_TO_D_MULT * acos(resRight);
-      }
+   return true;
+}
 
-      return acos(resRight);
-   }
-   if (!strcmp(Opera, "acot"))
+class BandMathWarnings::Question : public mta::ThreadCommand
+{
+public:
+   Question(BandMathWarnings& warnings, BandMathProgram::FaultEnum fault) :
+      mWarnings(warnings),
+      mFault(fault)
+   {}
+
+   void run()
    {
-      if (degrees)
+      // another thread may have been answered while this one waited
+      if (mWarnings.mCancelled || mWarnings.mAsk[mFault] == false)
       {
-         return R_TO_D_MULT * atan(1/Right->eval(data, band, types));
+         return;
       }
 
-      return atan(1/Right->eval(data, band, types));
-   }
-   if (!strcmp(Opera, "csch"))
-   {
-      if (degrees)
+      const char* pMessage = NULL;
+      switch (mFault)
       {
-         return 1/sinh(D_TO_R_MULT*Right->eval(data, band, types));
+      case BandMathProgram::FAULT_DIVIDE_BY_ZERO:
+         pMessage = "Warning bandmathfuncs003: Divide By Zero\nSelect 'OK' to continue, \n"
+            "all bad values will be set to 0.  \nOr 'Cancel' to cancel the operation.";
+         break;
+      case BandMathProgram::FAULT_UNDEFINED:
+         pMessage = "Warning bandmathfuncs001: Undefined Value\n"
+            "Select 'OK' to continue, \nall bad values will be set to 0.  \n"
+            "Or 'Cancel' to cancel the operation.";
+         break;
+      case BandMathProgram::FAULT_COMPLEX:
+         pMessage = "Warning bandmathfuncs002: Math Operation Resulted in a Complex Number\n"
+            "Select 'OK' to continue, \nall bad values will be set to 0.\n"
+            "Or 'Cancel' to cancel the operation.";
+         break;
+      default:
+         return;
       }
 
-      return 1/sinh(Right->eval(data, band, types));
-   }
-   if (!strcmp(Opera, "sech"))
-   {
-      if (degrees)
+      MBox mb("Warning", pMessage, MB_OK_CANCEL_ALWAYS, NULL);
+      if (mb.exec() == QDialog::Rejected)
       {
-         return 1/cosh(D_TO_R_MULT*Right->eval(data, band, types));
+         mWarnings.mCancelled = true;
       }
-
-      return 1/cosh(Right->eval(data, band, types));
-   }
-   if (!strcmp(Opera, "coth"))
-   {
-      if (degrees)
+      else if (mb.cbAlways->isChecked())
       {
-         return 1/tanh(D_TO_R_MULT*Right->eval(data, band, types));
+         mWarnings.mAsk[mFault] = false;
       }
+   }
+
+private:
+   Question& operator=(const Question& rhs);
+
+   BandMathWarnings& mWarnings;
+   BandMathProgram::FaultEnum mFault;
+};
 
-      return 1/tanh(Right->eval(data, band, types));
+BandMathWarnings::BandMathWarnings() :
+   mCancelled(false)
+{
+   for (int fault = 0; fault <= BandMathProgram::FAULT_BAD_VALUE; ++fault)
+   {
+      mAsk[fault] = true;
    }
-   if (!strcmp(Opera, "rand"))
+}
+
+bool BandMathWarnings::confirm(BandMathProgram::FaultEnum fault, mta::AlgorithmThread& thread)
+{
+   if (mCancelled == false && mAsk[fault])
    {
-      return GRand()*Right->eval(data, band, types);
+      Question question(*this, fault);
+      thread.runInMainThread(question);
    }
 
-   return 0.0;
+   return mCancelled == false;
+}
+
+bool BandMathWarnings::isCancelled() const
+{
+   return mCancelled;
 }
@@ -16,11 +16,18 @@
 #include <math.h>
 #include <ctype.h>
 
+#include <string>
 #include <vector>
 
+#include <boost/atomic.hpp>
+
 #include "Progress.h"
+#include "bmathprogram.h"
 #include "DataAccessor.h"
 #include "DataAccessorImpl.h"
+#include "MultiThreadedAlgorithm.h"
+
+class RasterElement;
 
 #define D_TO_R_MULT     0.017453292519943295
 #define R_TO_D_MULT     57.295779513082321
@@ -28,11 +35,6 @@
 #define MAX_OP_LENGTH   5   // set to length of the longest Operator string
 #define SEP             '@'
 
-class DivZero {};
-class Undefined {};
-class Complex {};
-class NoData {};
-
 bool ParseIsOp(char* ops, char* val);
 int OpParams(char* ops, char* val);
 int ParseExp(char* exp, int bands, char* DelimString, int delimStringLength, int cubes = 0);
@@ -40,10 +42,6 @@ char* ValRight(char* exp, int pos);
 char* ValLeft(char* exp, int pos);
 bool IsOp(char* ops, char* val);
 int OpPres(char* ops, char* val);
-inline double GRand();
-inline double SingleRand();
-
-inline double doubleFromEncoding(EncodingType encoding, void* data, int offset = 0);
 
 class DataNode
 {
@@ -75,8 +73,6 @@ public:
       }
    }
 
-   double eval(std::vector<void*>& data, int band, const std::vector<EncodingType>& types);
-
    bool degrees;
    bool isOperator;
    char* Opera;
@@ -97,25 +93,116 @@ private:
 
 DataNode* BuildTreeFromInfix(char* ops, char* exp, int* offsetTable, int NumElems, bool degrees);
 
-int eval(Progress* pProgress, std::vector<DataAccessor>& dataCubes,
+int eval(Progress* pProgress, const std::vector<RasterElement*>& cubes,
          const std::vector<EncodingType>& types, int rows, int columns,
-         int bands, char* exp, DataAccessor returnAccessor, bool degrees,
-         char* error, bool cubeMath, bool interactive);
+         int bands, const std::vector<std::string>& expressions,
+         const std::vector<double>& scales, const std::vector<double>& offsets,
+         RasterElement* pResult, bool degrees, char* error, bool cubeMath, bool interactive);
+
+/**
+ * Asks the user whether to continue when an interactive operation divides by
+ * zero, or computes an undefined value or a complex number.
+ *
+ * The thread which meets the fault waits while the question is shown in the
+ * main thread.  Once the operation is cancelled, the other threads stop before
+ * their next row.
+ */
+class BandMathWarnings
+{
+public:
+   BandMathWarnings();
+
+   /**
+    * Asks whether to continue after a fault, unless the user has chosen to
+    * always continue after faults of its kind.
+    *
+    * @param fault
+    *        The fault of a value.
+    * @param thread
+    *        The processing thread which computed the value.
+    *
+    * @return False if the operation has been cancelled.
+    */
+   bool confirm(BandMathProgram::FaultEnum fault, mta::AlgorithmThread& thread);
+
+   bool isCancelled() const;
 
-inline double GRand()
+private:
+   BandMathWarnings(const BandMathWarnings& rhs);
+   BandMathWarnings& operator=(const BandMathWarnings& rhs);
+
+   class Question;
+
+   boost::atomic<bool> mAsk[BandMathProgram::FAULT_BAD_VALUE + 1];
+   boost::atomic<bool> mCancelled;
+};
+
+class BandMathInput
 {
-  return sqrt(-2 * log(SingleRand())) * cos(2.0 * acos(-1.0) * SingleRand());
-}
+public:
+   BandMathInput() :
+      mpProgram(NULL),
+      mpWarnings(NULL),
+      mpResult(NULL),
+      mRows(0),
+      mColumns(0),
+      mBandCount(1),
+      mSeed(0),
+      mInteractive(true)
+   {}
+
+   const BandMathProgram* mpProgram;
+   BandMathWarnings* mpWarnings; // asks the user about faults if the operation is interactive
+   std::vector<RasterElement*> mCubes;
+   RasterElement* mpResult;
+   int mRows;
+   int mColumns;
+   int mBandCount;               // the number of bands computed for each pixel by each expression
+   std::vector<double> mScales;  // applied to the values of each expression before they are stored
+   std::vector<double> mOffsets;
+   unsigned int mSeed;           // the random values of each thread are seeded with this plus the thread index
+   bool mInteractive;
+};
 
-inline double SingleRand()
+/**
+ * Evaluates the expressions over a block of rows with accessors of its own.
+ *
+ * The bands of each expression are stored one after the other in each pixel
+ * of the result, in the encoding of the result.
+ *
+ * Faults which the user is warned about are counted, and an interactive
+ * operation asks the user whether to continue when they occur.  Faults which
+ * stop the operation are reported as errors.
+ */
+class BandMathThread : public mta::AlgorithmThread
 {
-   double value = static_cast<double>(rand() + 1) / RAND_MAX;
-   while (value <= 0 || value >= 1)
-   {
-     value = static_cast<double>(rand() + 1) / RAND_MAX;
-   }
+public:
+   BandMathThread(const BandMathInput& input, int threadCount, int threadIndex, mta::ThreadReporter& reporter);
+   virtual ~BandMathThread() {}
+
+   virtual void run();
+
+   unsigned int getFaultCount(BandMathProgram::FaultEnum fault) const;
+
+private:
+   BandMathThread& operator=(const BandMathThread& rhs);
+
+   template<typename T>
+   void evaluateRows(T*, DataAccessor& resultAccessor, std::vector<DataAccessor>& cubeAccessors);
 
-   return value;
-}
+   const BandMathInput& mInput;
+   Range mRowRange;
+   std::vector<unsigned int> mFaultCounts;
+};
+
+class BandMathOutput
+{
+public:
+   BandMathOutput();
+
+   bool compileOverallResults(const std::vector<BandMathThread*>& threads);
+
+   std::vector<unsigned int> mFaultCounts;      // indexed by BandMathProgram::FaultEnum
+};
 
 #endif
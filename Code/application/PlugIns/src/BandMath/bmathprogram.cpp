@@ -0,0 +1,995 @@
+/*
+ * The information in this file is
+ * Copyright(c) 2007 Ball Aerospace & Technologies Corporation
+ * and is subject to the terms and conditions of the
+ * GNU Lesser General Public License Version 2.1
+ * The license text is available from   
+ * http://www.gnu.org/licenses/lgpl.html
+ */
+
+#include "AppConfig.h"
+#include "bmathfuncs.h"
+#include "bmathprogram.h"
+
+#include <math.h>
+#include <string.h>
+
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define BANDMATH_SSE2
+#include <emmintrin.h>
+#endif
+
+using namespace std;
+
+namespace
+{
+   // The operations of the band math functions on one value, which are used both to fold constants when an
+   // expression is compiled and to compute the rows.  Unary operations ignore their second operand.
+   struct Add
+   {
+      static double apply(double x, double y, unsigned char& fault)
+      {
+         return x + y;
+      }
+#if defined(BANDMATH_SSE2)
+      static __m128d applyPair(__m128d x, __m128d y)
+      {
+         return _mm_add_pd(x, y);
+      }
+#endif
+   };
+
+   struct Subtract
+   {
+      static double apply(double x, double y, unsigned char& fault)
+      {
+         return x - y;
+      }
+#if defined(BANDMATH_SSE2)
+      static __m128d applyPair(__m128d x, __m128d y)
+      {
+         return _mm_sub_pd(x, y);
+      }
+#endif
+   };
+
+   struct Multiply
+   {
+      static double apply(double x, double y, unsigned char& fault)
+      {
+         return x * y;
+      }
+#if defined(BANDMATH_SSE2)
+      static __m128d applyPair(__m128d x, __m128d y)
+      {
+         return _mm_mul_pd(x, y);
+      }
+#endif
+   };
+
+   struct Divide
+   {
+      static double apply(double x, double y, unsigned char& fault)
+      {
+         if (y == 0)
+         {
+            fault = BandMathProgram::FAULT_DIVIDE_BY_ZERO;
+            return 0.0;
+         }
+         return x / y;
+      }
+   };
+
+   struct Power
+   {
+      static double apply(double x, double y, unsigned char& fault)
+      {
+         if (x == 0 && y <= 0)
+         {
+            fault = BandMathProgram::FAULT_DIVIDE_BY_ZERO;
+            return 0.0;
+         }
+         if (x < 0)
+         {
+            double integer;
+            if (modf(y, &integer) != 0)
+            {
+               fault = BandMathProgram::FAULT_COMPLEX;
+               return 0.0;
+            }
+         }
+         return pow(x, y);
+      }
+   };
+
+   struct SquareRoot
+   {
+      static double apply(double x, double y, unsigned char& fault)
+      {
+         if (x <= 0)
+         {
+            fault = BandMathProgram::FAULT_COMPLEX;
+            return 0.0;
+         }
+         return sqrt(x);
+      }
+   };
+
+   struct Logarithm
+   {
+      static double apply(double x, double y, unsigned char& fault)
+      {
+         if (x <= 0)
+         {
+            fault = BandMathProgram::FAULT_UNDEFINED;
+            return 0.0;
+         }
+         return log(x);
+      }
+   };
+
+   struct Logarithm10
+   {
+      static double apply(double x, double y, unsigned char& fault)
+      {
+         if (x <= 0)
+         {
+            fault = BandMathProgram::FAULT_UNDEFINED;
+            return 0.0;
+         }
+         return log10(x);
+      }
+   };
+
+   struct Logarithm2
+   {
+      static double apply(double x, double y, unsigned char& fault)
+      {
+         if (x <= 0)
+         {
+            fault = BandMathProgram::FAULT_UNDEFINED;
+            return 0.0;
+         }
+         return log(x) / log(2.0);
+      }
+   };
+
+   struct ArcSine
+   {
+      static double apply(double x, double y, unsigned char& fault)
+      {
+         if (x < -1 || x > 1)
+         {
+            fault = BandMathProgram::FAULT_COMPLEX;
+            return 0.0;
+         }
+         return asin(x);
+      }
+   };
+
+   struct ArcCosine
+   {
+      static double apply(double x, double y, unsigned char& fault)
+      {
+         if (x < -1 || x > 1)
+         {
+            fault = BandMathProgram::FAULT_COMPLEX;
+            return 0.0;
+         }
+         return acos(x);
+      }
+   };
+
+   struct ArcCosecant
+   {
+      static double apply(double x, double y, unsigned char& fault)
+      {
+         return ArcSine::apply(1 / x, y, fault);
+      }
+   };
+
+   struct ArcSecant
+   {
+      static double apply(double x, double y, unsigned char& fault)
+      {
+         return ArcCosine::apply(1 / x, y, fault);
+      }
+   };
+
+   // Operations which cannot fault
+#define BANDMATH_FUNCTION(name, expression) \
+   struct name \
+   { \
+      static double apply(double x, double y, unsigned char& fault) \
+      { \
+         return expression; \
+      } \
+   }
+
+   BANDMATH_FUNCTION(Sine, sin(x));
+   BANDMATH_FUNCTION(Cosine, cos(x));
+   BANDMATH_FUNCTION(Tangent, tan(x));
+   BANDMATH_FUNCTION(Exponential, exp(x));
+   BANDMATH_FUNCTION(Absolute, fabs(x));
+   BANDMATH_FUNCTION(ArcTangent, atan(x));
+   BANDMATH_FUNCTION(HyperbolicSine, sinh(x));
+   BANDMATH_FUNCTION(HyperbolicCosine, cosh(x));
+   BANDMATH_FUNCTION(HyperbolicTangent, tanh(x));
+   BANDMATH_FUNCTION(Secant, 1 / cos(x));
+   BANDMATH_FUNCTION(Cosecant, 1 / sin(x));
+   BANDMATH_FUNCTION(Cotangent, 1 / tan(x));
+   BANDMATH_FUNCTION(ArcCotangent, atan(1 / x));
+   BANDMATH_FUNCTION(HyperbolicSecant, 1 / cosh(x));
+   BANDMATH_FUNCTION(HyperbolicCosecant, 1 / sinh(x));
+   BANDMATH_FUNCTION(HyperbolicCotangent, 1 / tanh(x));
+
+#undef BANDMATH_FUNCTION
+
+   template<class Operation>
+   void applySpan(const double* pLeft, const double* pRight, double* pResult, unsigned char* pFaults, size_t count)
+   {
+      if (pFaults == NULL)
+      {
+         unsigned char fault = BandMathProgram::NO_FAULT;
+         for (size_t i = 0; i < count; ++i)
+         {
+            pResult[i] = Operation::apply(pLeft[i], pRight[i], fault);
+         }
+      }
+      else
+      {
+         for (size_t i = 0; i < count; ++i)
+         {
+            unsigned char fault = BandMathProgram::NO_FAULT;
+            pResult[i] = Operation::apply(pLeft[i], pRight[i], fault);
+            pFaults[i] = fault;
+         }
+      }
+   }
+
+#if defined(BANDMATH_SSE2)
+   template<class Operation>
+   void applyPairSpan(const double* pLeft, const double* pRight, double* pResult, size_t count)
+   {
+      // The registers are not aligned, and the result may be one of the operands
+      size_t i = 0;
+      for (; i + 2 <= count; i += 2)
+      {
+         _mm_storeu_pd(pResult + i, Operation::applyPair(_mm_loadu_pd(pLeft + i), _mm_loadu_pd(pRight + i)));
+      }
+
+      unsigned char fault = BandMathProgram::NO_FAULT;
+      for (; i < count; ++i)
+      {
+         pResult[i] = Operation::apply(pLeft[i], pRight[i], fault);
+      }
+   }
+
+   void divideSpan(const double* pLeft, const double* pRight, double* pResult, unsigned char* pFaults, size_t count)
+   {
+      const __m128d zero = _mm_setzero_pd();
+      size_t i = 0;
+      for (; i + 2 <= count; i += 2)
+      {
+         __m128d left = _mm_loadu_pd(pLeft + i);
+         __m128d right = _mm_loadu_pd(pRight + i);
+         __m128d isZero = _mm_cmpeq_pd(right, zero);
+
+         // Divide by one where the divisor is zero and return zero in its place
+         __m128d divisor = _mm_or_pd(_mm_andnot_pd(isZero, right), _mm_and_pd(isZero, _mm_set1_pd(1.0)));
+         _mm_storeu_pd(pResult + i, _mm_andnot_pd(isZero, _mm_div_pd(left, divisor)));
+
+         int zeroMask = _mm_movemask_pd(isZero);
+         pFaults[i] = (zeroMask & 1) != 0 ? BandMathProgram::FAULT_DIVIDE_BY_ZERO : BandMathProgram::NO_FAULT;
+         pFaults[i + 1] = (zeroMask & 2) != 0 ? BandMathProgram::FAULT_DIVIDE_BY_ZERO : BandMathProgram::NO_FAULT;
+      }
+
+      for (; i < count; ++i)
+      {
+         unsigned char fault = BandMathProgram::NO_FAULT;
+         pResult[i] = Divide::apply(pLeft[i], pRight[i], fault);
+         pFaults[i] = fault;
+      }
+   }
+#endif
+
+   // A xorshift generator of uniform values in (0, 1).  Each workspace has its own state, so the threads do not
+   // share the state or the lock of rand().
+   double uniformRandom(uint32_t& state)
+   {
+      state ^= state << 13;
+      state ^= state >> 17;
+      state ^= state << 5;
+      return (state + 0.5) / 4294967296.0;
+   }
+
+   // Scales normally distributed values, computed with the Box-Muller transform, by the operand
+   void randomSpan(const double* pLeft, double* pResult, size_t count, uint32_t& state)
+   {
+      const double twoPi = 2.0 * acos(-1.0);
+      for (size_t i = 0; i < count; ++i)
+      {
+         double radius = sqrt(-2 * log(uniformRandom(state)));
+         pResult[i] = radius * cos(twoPi * uniformRandom(state)) * pLeft[i];
+      }
+   }
+
+   template<typename T>
+   void loadSpan(const void* pRow, unsigned int offset, unsigned int stride, size_t count, double* pValues)
+   {
+      const T* pData = reinterpret_cast<const T*>(pRow) + offset;
+      for (size_t i = 0; i < count; ++i, pData += stride)
+      {
+         pValues[i] = *pData;
+      }
+   }
+
+   void loadSpan(EncodingType type, const void* pRow, unsigned int offset, unsigned int stride, size_t count,
+      double* pValues)
+   {
+      switch (type)
+      {
+      case INT1SBYTE:
+         loadSpan<signed char>(pRow, offset, stride, count, pValues);
+         break;
+      case INT1UBYTE:
+         loadSpan<unsigned char>(pRow, offset, stride, count, pValues);
+         break;
+      case INT2SBYTES:
+         loadSpan<signed short>(pRow, offset, stride, count, pValues);
+         break;
+      case INT2UBYTES:
+         loadSpan<unsigned short>(pRow, offset, stride, count, pValues);
+         break;
+      case INT4SBYTES:
+         loadSpan<signed int>(pRow, offset, stride, count, pValues);
+         break;
+      case INT4UBYTES:
+         loadSpan<unsigned int>(pRow, offset, stride, count, pValues);
+         break;
+      case FLT4BYTES:
+         loadSpan<float>(pRow, offset, stride, count, pValues);
+         break;
+      case FLT8BYTES:
+         loadSpan<double>(pRow, offset, stride, count, pValues);
+         break;
+      default:
+         fill(pValues, pValues + count, 0.0);
+         break;
+      }
+   }
+
+   // Keeps the first fault of each column, in the order in which the operands were evaluated by the
+   // original recursive evaluation.  Any of the arrays may be NULL, and the result may be one of them.
+   void mergeFaults(const unsigned char* pFirst, const unsigned char* pSecond, const unsigned char* pThird,
+      unsigned char* pResult, size_t count)
+   {
+      for (size_t i = 0; i < count; ++i)
+      {
+         unsigned char fault = (pFirst != NULL ? pFirst[i] : BandMathProgram::NO_FAULT);
+         if (fault == BandMathProgram::NO_FAULT && pSecond != NULL)
+         {
+            fault = pSecond[i];
+         }
+         if (fault == BandMathProgram::NO_FAULT && pThird != NULL)
+         {
+            fault = pThird[i];
+         }
+         pResult[i] = fault;
+      }
+   }
+}
+
+BandMathProgram::Workspace::Workspace() :
+   mRandomState(0),
+   mColumns(0)
+{
+   setSeed(0);
+}
+
+void BandMathProgram::Workspace::setSeed(unsigned int seed)
+{
+   // Mix the seed, so that consecutive seeds start unrelated sequences
+   uint32_t state = seed + 0x9e3779b9U;
+   state = (state ^ (state >> 16)) * 0x85ebca6bU;
+   state = (state ^ (state >> 13)) * 0xc2b2ae35U;
+   state ^= state >> 16;
+
+   // The generator never leaves a state of zero
+   mRandomState = (state == 0 ? 0x9e3779b9U : state);
+}
+
+bool BandMathProgram::ValueKey::operator<(const ValueKey& other) const
+{
+   if (mOperation != other.mOperation)
+   {
+      return mOperation < other.mOperation;
+   }
+   if (mLeft != other.mLeft)
+   {
+      return mLeft < other.mLeft;
+   }
+   if (mRight != other.mRight)
+   {
+      return mRight < other.mRight;
+   }
+   if (mIndex != other.mIndex)
+   {
+      return mIndex < other.mIndex;
+   }
+   return mConstant < other.mConstant;
+}
+
+BandMathProgram::BandMathProgram(const vector<EncodingType>& types, unsigned int bandCount) :
+   mTypes(types),
+   mBandCount(bandCount),
+   mRegisterCount(0)
+{
+}
+
+unsigned int BandMathProgram::addExpression(const DataNode* pTree)
+{
+   mOutputs.push_back(compileNode(pTree));
+   allocateRegisters();
+   return mOutputs.size() - 1;
+}
+
+unsigned int BandMathProgram::getInstructionCount() const
+{
+   unsigned int count = 0;
+   for (vector<Value>::const_iterator iter = mValues.begin(); iter != mValues.end(); ++iter)
+   {
+      if (iter->mOperation != CONSTANT)
+      {
+         ++count;
+      }
+   }
+   return count;
+}
+
+void BandMathProgram::execute(const vector<const void*>& cubeRows, unsigned int band, unsigned int columns,
+                              Workspace& workspace) const
+{
+   if (columns == 0)
+   {
+      return;
+   }
+
+   prepareWorkspace(columns, workspace);
+   for (vector<Value>::const_iterator iter = mValues.begin(); iter != mValues.end(); ++iter)
+   {
+      const Value& value = *iter;
+      if (value.mOperation == CONSTANT || value.mRegister < 0)
+      {
+         continue;
+      }
+
+      double* pResult = &workspace.mValues[value.mRegister][0];
+      if (value.mOperation == LOAD_BAND)
+      {
+         loadSpan(mTypes[0], cubeRows[0], value.mIndex, mBandCount, columns, pResult);
+         continue;
+      }
+      if (value.mOperation == LOAD_CUBE)
+      {
+         loadSpan(mTypes[value.mIndex], cubeRows[value.mIndex], band, mBandCount, columns, pResult);
+         continue;
+      }
+
+      const Value& left = mValues[value.mLeft];
+      const double* pLeft = &workspace.mValues[left.mRegister][0];
+      const double* pRight = pLeft;
+      const unsigned char* pLeftFaults = (left.mMayFault ? &workspace.mFaults[left.mRegister][0] : NULL);
+      const unsigned char* pRightFaults = NULL;
+      if (value.mRight >= 0)
+      {
+         const Value& right = mValues[value.mRight];
+         pRight = &workspace.mValues[right.mRegister][0];
+         pRightFaults = (right.mMayFault ? &workspace.mFaults[right.mRegister][0] : NULL);
+      }
+
+      unsigned char* pInstructionFaults = (canFault(value.mOperation) ? &workspace.mInstructionFaults[0] : NULL);
+      if (value.mOperation == RAND)
+      {
+         randomSpan(pLeft, pResult, columns, workspace.mRandomState);
+      }
+      else
+      {
+         evaluateSpan(value.mOperation, pLeft, pRight, pResult, pInstructionFaults, columns);
+      }
+
+      if (value.mMayFault)
+      {
+         unsigned char* pFaults = &workspace.mFaults[value.mRegister][0];
+         if (value.mOperation == DIVIDE)
+         {
+            // The divisor is evaluated first
+            mergeFaults(pRightFaults, pInstructionFaults, pLeftFaults, pFaults, columns);
+         }
+         else
+         {
+            mergeFaults(pLeftFaults, pRightFaults, pInstructionFaults, pFaults, columns);
+         }
+      }
+   }
+}
+
+const double* BandMathProgram::getValues(unsigned int output, const Workspace& workspace) const
+{
+   const Value& value = mValues[mOutputs[output]];
+   return &workspace.mValues[value.mRegister][0];
+}
+
+const unsigned char* BandMathProgram::getFaults(unsigned int output, const Workspace& workspace) const
+{
+   const Value& value = mValues[mOutputs[output]];
+   if (value.mMayFault == false)
+   {
+      return NULL;
+   }
+   return &workspace.mFaults[value.mRegister][0];
+}
+
+int BandMathProgram::compileNode(const DataNode* pNode)
+{
+   if (pNode == NULL || pNode->Opera == NULL)
+   {
+      return addConstant(0.0);
+   }
+
+   if (pNode->isOperator == false)
+   {
+      return compileLeaf(pNode->Opera);
+   }
+
+   if (strcmp(pNode->Opera, "(") == 0)
+   {
+      return compileNode(pNode->Right);
+   }
+
+   struct Operator
+   {
+      const char* mpName;
+      OperationEnum mOperation;
+      bool mBinary;
+   };
+
+   static const Operator operators[] =
+   {
+      { "+", ADD, true },
+      { "-", SUBTRACT, true },
+      { "*", MULTIPLY, true },
+      { "/", DIVIDE, true },
+      { "^", POWER, true },
+      { "sqrt", SQRT, false },
+      { "sin", SIN, false },
+      { "cos", COS, false },
+      { "tan", TAN, false },
+      { "log", LOG, false },
+      { "log10", LOG10, false },
+      { "log2", LOG2, false },
+      { "exp", EXP, false },
+      { "abs", ABS, false },
+      { "asin", ASIN, false },
+      { "acos", ACOS, false },
+      { "atan", ATAN, false },
+      { "sinh", SINH, false },
+      { "cosh", COSH, false },
+      { "tanh", TANH, false },
+      { "sec", SEC, false },
+      { "csc", CSC, false },
+      { "cot", COT, false },
+      { "asec", ASEC, false },
+      { "acsc", ACSC, false },
+      { "acot", ACOT, false },
+      { "sech", SECH, false },
+      { "csch", CSCH, false },
+      { "coth", COTH, false },
+      { "rand", RAND, false }
+   };
+
+   for (size_t i = 0; i < sizeof(operators) / sizeof(operators[0]); ++i)
+   {
+      const Operator& op = operators[i];
+      if (strcmp(pNode->Opera, op.mpName) != 0)
+      {
+         continue;
+      }
+
+      if (op.mBinary)
+      {
+         int left = compileNode(pNode->Left);
+         int right = compileNode(pNode->Right);
+         return addOperation(op.mOperation, left, right);
+      }
+
+      int operand = compileNode(pNode->Right);
+      if (pNode->degrees)
+      {
+         switch (op.mOperation)
+         {
+         case SIN:
+         case COS:
+         case TAN:
+         case SINH:
+         case COSH:
+         case TANH:
+         case SEC:
+         case CSC:
+         case COT:
+         case SECH:
+         case CSCH:
+         case COTH:
+            operand = addOperation(MULTIPLY, addConstant(D_TO_R_MULT), operand);
+            break;
+         case ASIN:
+         case ACOS:
+         case ATAN:
+         case ASEC:
+         case ACSC:
+         case ACOT:
+            return addOperation(MULTIPLY, addConstant(R_TO_D_MULT), addOperation(op.mOperation, operand, -1));
+         default:
+            break;
+         }
+      }
+      return addOperation(op.mOperation, operand, -1);
+   }
+
+   return addConstant(0.0);
+}
+
+int BandMathProgram::compileLeaf(const char* pOperand)
+{
+   if (!strcmp(pOperand, "pi") || !strcmp(pOperand, "PI") || !strcmp(pOperand, "Pi"))
+   {
+      return addConstant(PI);
+   }
+
+   if (!strcmp(pOperand, "e") || !strcmp(pOperand, "E"))
+   {
+      return addConstant(exp(1.0));
+   }
+
+   if ((pOperand[0] == 'b') || (pOperand[0] == 'B'))
+   {
+      int band = atoi(&pOperand[1]) - 1;
+      if (mTypes.empty() || band < 0 || band >= static_cast<int>(mBandCount))
+      {
+         return addConstant(0.0);
+      }
+      return addLoad(LOAD_BAND, band);
+   }
+
+   if ((pOperand[0] == 'c') || (pOperand[0] == 'C'))
+   {
+      int cube = atoi(&pOperand[1]) - 1;
+      if (cube < 0 || cube >= static_cast<int>(mTypes.size()))
+      {
+         return addConstant(0.0);
+      }
+      return addLoad(LOAD_CUBE, cube);
+   }
+
+   return addConstant(atof(pOperand));
+}
+
+int BandMathProgram::addConstant(double value)
+{
+   Value constant;
+   constant.mOperation = CONSTANT;
+   constant.mLeft = -1;
+   constant.mRight = -1;
+   constant.mIndex = -1;
+   constant.mConstant = value;
+   constant.mMayFault = false;
+   constant.mRegister = -1;
+   return addValue(constant);
+}
+
+int BandMathProgram::addLoad(OperationEnum operation, int index)
+{
+   Value load;
+   load.mOperation = operation;
+   load.mLeft = -1;
+   load.mRight = -1;
+   load.mIndex = index;
+   load.mConstant = 0.0;
+   load.mMayFault = false;
+   load.mRegister = -1;
+   return addValue(load);
+}
+
+int BandMathProgram::addOperation(OperationEnum operation, int left, int right)
+{
+   const Value& leftValue = mValues[left];
+   const Value* pRightValue = (right >= 0 ? &mValues[right] : NULL);
+
+   // Fold operations on constants unless they fault, so that the fault is reported for every pixel
+   if (operation != RAND && leftValue.mOperation == CONSTANT &&
+      (pRightValue == NULL || pRightValue->mOperation == CONSTANT))
+   {
+      unsigned char fault = NO_FAULT;
+      double result = evaluate(operation, leftValue.mConstant,
+         (pRightValue != NULL ? pRightValue->mConstant : leftValue.mConstant), fault);
+      if (fault == NO_FAULT)
+      {
+         return addConstant(result);
+      }
+   }
+
+   Value instruction;
+   instruction.mOperation = operation;
+   instruction.mLeft = left;
+   instruction.mRight = right;
+   instruction.mIndex = -1;
+   instruction.mConstant = 0.0;
+   instruction.mMayFault = canFault(operation) || leftValue.mMayFault ||
+      (pRightValue != NULL && pRightValue->mMayFault);
+   instruction.mRegister = -1;
+   return addValue(instruction);
+}
+
+int BandMathProgram::addValue(const Value& value)
+{
+   // Random values differ each time they are evaluated, and NaN does not compare equal to itself
+   bool shared = (value.mOperation != RAND && value.mConstant == value.mConstant);
+
+   ValueKey key;
+   key.mOperation = value.mOperation;
+   key.mLeft = value.mLeft;
+   key.mRight = value.mRight;
+   key.mIndex = value.mIndex;
+   key.mConstant = value.mConstant;
+   if (shared)
+   {
+      map<ValueKey, int>::const_iterator iter = mValueIndices.find(key);
+      if (iter != mValueIndices.end())
+      {
+         return iter->second;
+      }
+   }
+
+   mValues.push_back(value);
+   int index = static_cast<int>(mValues.size()) - 1;
+   if (shared)
+   {
+      mValueIndices[key] = index;
+   }
+   return index;
+}
+
+void BandMathProgram::allocateRegisters()
+{
+   // Find the last instruction which uses each value; outputs are used after the last instruction
+   int valueCount = static_cast<int>(mValues.size());
+   vector<int> lastUse(valueCount, -1);
+   for (int i = 0; i < valueCount; ++i)
+   {
+      const Value& value = mValues[i];
+      if (value.mLeft >= 0)
+      {
+         lastUse[value.mLeft] = i;
+      }
+      if (value.mRight >= 0)
+      {
+         lastUse[value.mRight] = i;
+      }
+   }
+   for (vector<int>::const_iterator iter = mOutputs.begin(); iter != mOutputs.end(); ++iter)
+   {
+      lastUse[*iter] = valueCount;
+   }
+
+   // Constants keep a register of their own which is filled once, and the other values reuse the
+   // registers of values which are no longer needed
+   mRegisterCount = 0;
+   mRegisterFaults.clear();
+   vector<int> freeRegisters;
+   for (int i = 0; i < valueCount; ++i)
+   {
+      Value& value = mValues[i];
+      value.mRegister = -1;
+      if (lastUse[i] < 0)
+      {
+         continue;
+      }
+
+      if (value.mOperation != CONSTANT)
+      {
+         // Release the operands first so that the result can be computed in place
+         if (value.mLeft >= 0 && lastUse[value.mLeft] == i && mValues[value.mLeft].mOperation != CONSTANT)
+         {
+            freeRegisters.push_back(mValues[value.mLeft].mRegister);
+         }
+         if (value.mRight >= 0 && value.mRight != value.mLeft && lastUse[value.mRight] == i &&
+            mValues[value.mRight].mOperation != CONSTANT)
+         {
+            freeRegisters.push_back(mValues[value.mRight].mRegister);
+         }
+
+         if (freeRegisters.empty() == false)
+         {
+            value.mRegister = freeRegisters.back();
+            freeRegisters.pop_back();
+            if (value.mMayFault)
+            {
+               mRegisterFaults[value.mRegister] = true;
+            }
+            continue;
+         }
+      }
+
+      value.mRegister = mRegisterCount++;
+      mRegisterFaults.push_back(value.mMayFault);
+   }
+}
+
+void BandMathProgram::prepareWorkspace(unsigned int columns, Workspace& workspace) const
+{
+   if (workspace.mColumns == columns && workspace.mValues.size() == mRegisterCount)
+   {
+      return;
+   }
+
+   workspace.mColumns = columns;
+   workspace.mValues.resize(mRegisterCount);
+   workspace.mFaults.resize(mRegisterCount);
+   for (unsigned int i = 0; i < mRegisterCount; ++i)
+   {
+      workspace.mValues[i].resize(columns);
+      workspace.mFaults[i].resize(mRegisterFaults[i] ? columns : 0);
+   }
+   workspace.mInstructionFaults.resize(columns);
+
+   for (vector<Value>::const_iterator iter = mValues.begin(); iter != mValues.end(); ++iter)
+   {
+      if (iter->mOperation == CONSTANT && iter->mRegister >= 0)
+      {
+         fill(workspace.mValues[iter->mRegister].begin(), workspace.mValues[iter->mRegister].end(),
+            iter->mConstant);
+      }
+   }
+}
+
+bool BandMathProgram::canFault(OperationEnum operation)
+{
+   switch (operation)
+   {
+   case DIVIDE:
+   case POWER:
+   case SQRT:
+   case LOG:
+   case LOG10:
+   case LOG2:
+   case ASIN:
+   case ACOS:
+   case ASEC:
+   case ACSC:
+      return true;
+   default:
+      return false;
+   }
+}
+
+double BandMathProgram::evaluate(OperationEnum operation, double left, double right, unsigned char& fault)
+{
+   double result = 0.0;
+   evaluateSpan(operation, &left, &right, &result, &fault, 1);
+   return result;
+}
+
+void BandMathProgram::evaluateSpan(OperationEnum operation, const double* pLeft, const double* pRight,
+                                   double* pResult, unsigned char* pFaults, size_t count)
+{
+   switch (operation)
+   {
+#if defined(BANDMATH_SSE2)
+   case ADD:
+      applyPairSpan<Add>(pLeft, pRight, pResult, count);
+      break;
+   case SUBTRACT:
+      applyPairSpan<Subtract>(pLeft, pRight, pResult, count);
+      break;
+   case MULTIPLY:
+      applyPairSpan<Multiply>(pLeft, pRight, pResult, count);
+      break;
+   case DIVIDE:
+      divideSpan(pLeft, pRight, pResult, pFaults, count);
+      break;
+#else
+   case ADD:
+      applySpan<Add>(pLeft, pRight, pResult, NULL, count);
+      break;
+   case SUBTRACT:
+      applySpan<Subtract>(pLeft, pRight, pResult, NULL, count);
+      break;
+   case MULTIPLY:
+      applySpan<Multiply>(pLeft, pRight, pResult, NULL, count);
+      break;
+   case DIVIDE:
+      applySpan<Divide>(pLeft, pRight, pResult, pFaults, count);
+      break;
+#endif
+   case POWER:
+      applySpan<Power>(pLeft, pRight, pResult, pFaults, count);
+      break;
+   case SQRT:
+      applySpan<SquareRoot>(pLeft, pRight, pResult, pFaults, count);
+      break;
+   case SIN:
+      applySpan<Sine>(pLeft, pRight, pResult, NULL, count);
+      break;
+   case COS:
+      applySpan<Cosine>(pLeft, pRight, pResult, NULL, count);
+      break;
+   case TAN:
+      applySpan<Tangent>(pLeft, pRight, pResult, NULL, count);
+      break;
+   case LOG:
+      applySpan<Logarithm>(pLeft, pRight, pResult, pFaults, count);
+      break;
+   case LOG10:
+      applySpan<Logarithm10>(pLeft, pRight, pResult, pFaults, count);
+      break;
+   case LOG2:
+      applySpan<Logarithm2>(pLeft, pRight, pResult, pFaults, count);
+      break;
+   case EXP:
+      applySpan<Exponential>(pLeft, pRight, pResult, NULL, count);
+      break;
+   case ABS:
+      applySpan<Absolute>(pLeft, pRight, pResult, NULL, count);
+      break;
+   case ASIN:
+      applySpan<ArcSine>(pLeft, pRight, pResult, pFaults, count);
+      break;
+   case ACOS:
+      applySpan<ArcCosine>(pLeft, pRight, pResult, pFaults, count);
+      break;
+   case ATAN:
+      applySpan<ArcTangent>(pLeft, pRight, pResult, NULL, count);
+      break;
+   case SINH:
+      applySpan<HyperbolicSine>(pLeft, pRight, pResult, NULL, count);
+      break;
+   case COSH:
+      applySpan<HyperbolicCosine>(pLeft, pRight, pResult, NULL, count);
+      break;
+   case TANH:
+      applySpan<HyperbolicTangent>(pLeft, pRight, pResult, NULL, count);
+      break;
+   case SEC:
+      applySpan<Secant>(pLeft, pRight, pResult, NULL, count);
+      break;
+   case CSC:
+      applySpan<Cosecant>(pLeft, pRight, pResult, NULL, count);
+      break;
+   case COT:
+      applySpan<Cotangent>(pLeft, pRight, pResult, NULL, count);
+      break;
+   case ASEC:
+      applySpan<ArcSecant>(pLeft, pRight, pResult, pFaults, count);
+      break;
+   case ACSC:
+      applySpan<ArcCosecant>(pLeft, pRight, pResult, pFaults, count);
+      break;
+   case ACOT:
+      applySpan<ArcCotangent>(pLeft, pRight, pResult, NULL, count);
+      break;
+   case SECH:
+      applySpan<HyperbolicSecant>(pLeft, pRight, pResult, NULL, count);
+      break;
+   case CSCH:
+      applySpan<HyperbolicCosecant>(pLeft, pRight, pResult, NULL, count);
+      break;
+   case COTH:
+      applySpan<HyperbolicCotangent>(pLeft, pRight, pResult, NULL, count);
+      break;
+   default:
+      fill(pResult, pResult + count, 0.0);
+      break;
+   }
+}
@@ -0,0 +1,226 @@
+/*
+ * The information in this file is
+ * Copyright(c) 2007 Ball Aerospace & Technologies Corporation
+ * and is subject to the terms and conditions of the
+ * GNU Lesser General Public License Version 2.1
+ * The license text is available from   
+ * http://www.gnu.org/licenses/lgpl.html
+ */
+
+#ifndef BMATHPROGRAM_H
+#define BMATHPROGRAM_H
+
+#include "AppConfig.h"
+#include "TypesFile.h"
+
+#include <map>
+#include <vector>
+
+class DataNode;
+
+/**
+ * Band math expressions compiled into a flat list of instructions which are
+ * evaluated over a whole row of pixels at a time.
+ *
+ * Each value of an expression is computed into a register holding one value
+ * for each column of the row.  Subexpressions whose operands are constants are
+ * evaluated when the expression is compiled, and subexpressions which occur
+ * more than once are computed once.  Errors such as a divide by zero do not
+ * stop the evaluation; each register which can hold an error has a fault for
+ * each column, which is passed on to the values computed from it.
+ */
+class BandMathProgram
+{
+public:
+   /**
+    * The error of a value which could not be computed.
+    */
+   enum FaultEnum
+   {
+      NO_FAULT = 0,
+      FAULT_DIVIDE_BY_ZERO,
+      FAULT_UNDEFINED,
+      FAULT_COMPLEX,
+      FAULT_BAD_VALUE
+   };
+
+   /**
+    * The registers of a program for one row.
+    *
+    * Each thread which executes a program needs its own workspace, which
+    * also holds the generator of the random values computed by the program.
+    */
+   class Workspace
+   {
+   public:
+      Workspace();
+
+      /**
+       * Seeds the generator of the random values.
+       *
+       * @param seed
+       *        The seed.  Workspaces used by different threads should be given
+       *        different seeds, which may be consecutive.
+       */
+      void setSeed(unsigned int seed);
+
+   private:
+      friend class BandMathProgram;
+
+      uint32_t mRandomState;
+      unsigned int mColumns;
+      std::vector<std::vector<double> > mValues;
+      std::vector<std::vector<unsigned char> > mFaults;
+      std::vector<unsigned char> mInstructionFaults;
+   };
+
+   /**
+    * Creates an empty program.
+    *
+    * @param types
+    *        The encoding of each input cube.  Cube operands beyond the number of cubes evaluate to zero.
+    * @param bandCount
+    *        The number of bands in each input cube.
+    */
+   BandMathProgram(const std::vector<EncodingType>& types, unsigned int bandCount);
+
+   /**
+    * Compiles an expression into the program.
+    *
+    * @param pTree
+    *        The parsed expression.  The tree is not needed after this method returns.
+    *
+    * @return The index of the output of the expression.
+    */
+   unsigned int addExpression(const DataNode* pTree);
+
+   /**
+    * Returns the number of instructions which are executed for each row.
+    *
+    * @return The number of instructions.
+    */
+   unsigned int getInstructionCount() const;
+
+   /**
+    * Evaluates every expression of the program for a row.
+    *
+    * @param cubeRows
+    *        The row of each input cube, in BIP order.
+    * @param band
+    *        The band of the cubes used by cube operands.
+    * @param columns
+    *        The number of columns in the row.
+    * @param workspace
+    *        The registers which receive the values.
+    */
+   void execute(const std::vector<const void*>& cubeRows, unsigned int band, unsigned int columns,
+      Workspace& workspace) const;
+
+   /**
+    * Returns the values of an expression computed by the last call to execute().
+    *
+    * @param output
+    *        The index returned by addExpression().
+    * @param workspace
+    *        The workspace passed to execute().
+    *
+    * @return The value of each column.
+    */
+   const double* getValues(unsigned int output, const Workspace& workspace) const;
+
+   /**
+    * Returns the faults of an expression computed by the last call to execute().
+    *
+    * @param output
+    *        The index returned by addExpression().
+    * @param workspace
+    *        The workspace passed to execute().
+    *
+    * @return The FaultEnum of each column, or \c NULL if the expression cannot fault.
+    */
+   const unsigned char* getFaults(unsigned int output, const Workspace& workspace) const;
+
+private:
+   enum OperationEnum
+   {
+      CONSTANT,
+      LOAD_BAND,
+      LOAD_CUBE,
+      ADD,
+      SUBTRACT,
+      MULTIPLY,
+      DIVIDE,
+      POWER,
+      SQRT,
+      SIN,
+      COS,
+      TAN,
+      LOG,
+      LOG10,
+      LOG2,
+      EXP,
+      ABS,
+      ASIN,
+      ACOS,
+      ATAN,
+      SINH,
+      COSH,
+      TANH,
+      SEC,
+      CSC,
+      COT,
+      ASEC,
+      ACSC,
+      ACOT,
+      SECH,
+      CSCH,
+      COTH,
+      RAND
+   };
+
+   struct Value
+   {
+      OperationEnum mOperation;
+      int mLeft;            // the operands of operators, or -1
+      int mRight;
+      int mIndex;           // the band of LOAD_BAND or the cube of LOAD_CUBE
+      double mConstant;
+      bool mMayFault;
+      int mRegister;
+   };
+
+   struct ValueKey
+   {
+      bool operator<(const ValueKey& other) const;
+
+      OperationEnum mOperation;
+      int mLeft;
+      int mRight;
+      int mIndex;
+      double mConstant;
+   };
+
+   int compileNode(const DataNode* pNode);
+   int compileLeaf(const char* pOperand);
+   int addConstant(double value);
+   int addLoad(OperationEnum operation, int index);
+   int addOperation(OperationEnum operation, int left, int right);
+   int addValue(const Value& value);
+   void allocateRegisters();
+   void prepareWorkspace(unsigned int columns, Workspace& workspace) const;
+
+   static bool canFault(OperationEnum operation);
+   static double evaluate(OperationEnum operation, double left, double right, unsigned char& fault);
+   static void evaluateSpan(OperationEnum operation, const double* pLeft, const double* pRight, double* pResult,
+      unsigned char* pFaults, size_t count);
+
+   std::vector<EncodingType> mTypes;
+   unsigned int mBandCount;
+   std::vector<Value> mValues;           // in the order of execution
+   std::map<ValueKey, int> mValueIndices;
+   std::vector<int> mOutputs;
+   unsigned int mRegisterCount;
+   std::vector<bool> mRegisterFaults;    // whether each register holds values which can fault
+};
+
+#endif
@@ -159,7 +159,8 @@ bool ConvolutionFilterShell::execute(PlugInArgList* pInArgList, PlugInArgList* p
    mta::MultiThreadedAlgorithm<ConvolutionFilterThreadInput,
                                ConvolutionFilterThreadOutput,
                                ConvolutionFilterThread>
-          alg(mta::getNumRequiredThreads(iterChecker.getNumSelectedRows()), mInput, outputData, &reporter);
+          alg(mta::getNumRequiredThreads(iterChecker.getNumSelectedRows()), mInput, outputData, &reporter,
+              mta::POLLED_REPORTS);
    switch(alg.run())
    {
    case mta::SUCCESS:
@@ -11,12 +11,13 @@
 #include "GeoTiffPager.h"
 
 GeoTiffPage::GeoTiffPage(GeoTiffOnDisk::CacheUnit* pCacheUnit, size_t offset, unsigned int rowSkip,
-                         unsigned int columnSkip, unsigned int bandSkip) :
+                         unsigned int columnSkip, unsigned int bandSkip, unsigned int interlineBytes) :
    mpCacheUnit(pCacheUnit),
    mOffset(offset),
    mRowSkip(rowSkip),
    mColumnSkip(columnSkip),
-   mBandSkip(bandSkip)
+   mBandSkip(bandSkip),
+   mInterlineBytes(interlineBytes)
 {
 }
 
@@ -54,5 +55,5 @@ unsigned int GeoTiffPage::getNumBands()
 
 unsigned int GeoTiffPage::getInterlineBytes()
 {
-   return 0;
+   return mInterlineBytes;
 }
@@ -23,7 +23,7 @@ class GeoTiffPage : public RasterPage
 {
 public:
    GeoTiffPage(GeoTiffOnDisk::CacheUnit* pCacheUnit, size_t offset, unsigned int rowSkip,
-      unsigned int columnSkip, unsigned int bandSkip);
+      unsigned int columnSkip, unsigned int bandSkip, unsigned int interlineBytes = 0);
    ~GeoTiffPage();
 
    // RasterPage
@@ -39,6 +39,7 @@ private:
    unsigned int mRowSkip;
    unsigned int mColumnSkip;
    unsigned int mBandSkip;
+   unsigned int mInterlineBytes;
 };
 
 #endif
@@ -26,6 +26,7 @@
 
 #include <functional>
 #include <algorithm>
+#include <limits>
 
 using namespace std;
 
@@ -37,7 +38,8 @@ CacheUnit::CacheUnit(const vector<unsigned int>& blockNumbers, size_t blockSize)
    mBlockNumbers(blockNumbers),
    mDataSize(blockSize),
    mpData(NULL),
-   mIsEmpty(true)
+   mIsEmpty(true),
+   mLastAccess(0)
 {
    mpData = mpModelSvcs->getMemoryBlock(mDataSize);
 }
@@ -94,8 +96,21 @@ void CacheUnit::setIsEmpty(bool v)
    mIsEmpty = v;
 }
 
-Cache::Cache() : mCacheSize(8)
+uint64_t CacheUnit::lastAccess() const
 {
+   return mLastAccess;
+}
+
+void CacheUnit::setLastAccess(uint64_t access)
+{
+   mLastAccess = access;
+}
+
+Cache::Cache() :
+   mCacheSize(8),
+   mpRasterElement(NULL)
+{
+   mpModelSvcs->registerRasterCache(this);
 }
 
 void Cache::initCacheSize(unsigned int cacheSize)
@@ -103,8 +118,15 @@ void Cache::initCacheSize(unsigned int cacheSize)
    mCacheSize = cacheSize;
 }
 
+void Cache::setRasterElement(const RasterElement* pElement)
+{
+   mpRasterElement = pElement;
+}
+
 Cache::~Cache()
 {
+   mpModelSvcs->unregisterRasterCache(this);
+
    for (cache_t::iterator it = mCache.begin(); it != mCache.end(); ++it)
    {
       if (*it != NULL)
@@ -130,48 +152,99 @@ CacheUnit *Cache::getCacheUnit(vector<unsigned int> &blocks, size_t blockSize)
 
    // find or create the needed cache blocks
    CacheUnit* returnUnit(NULL);
-   cache_t::iterator locate_it(find_if(mCache.begin(), mCache.end(), bind1st(ptr_fun(Cache::CacheLocator), blocks)));
-   if (locate_it != mCache.end())
    {
-      // we found the CacheUnit
-      returnUnit = *locate_it;
-      mCache.erase(locate_it);
-   }
-   else
-   {
-      // we need to create a new CacheUnit
-      // is the cache full?
-      if (mCache.size() >= mCacheSize)
+      mta::MutexLock lock(mMutex);
+      cache_t::iterator locate_it(find_if(mCache.begin(), mCache.end(), bind1st(ptr_fun(Cache::CacheLocator), blocks)));
+      if (locate_it != mCache.end())
+      {
+         // we found the CacheUnit
+         returnUnit = *locate_it;
+         mCache.erase(locate_it);
+      }
+      else
       {
-         // remove the first available unit
-         cache_t::iterator clean_it(find_if(mCache.begin(), mCache.end(), Cache::CacheCleaner));
-         if (clean_it != mCache.end())
+         // we need to create a new CacheUnit
+         // is the cache full?
+         if (mCache.size() >= mCacheSize)
          {
-            if (*clean_it != NULL)
+            // remove the first available unit
+            cache_t::iterator clean_it(find_if(mCache.begin(), mCache.end(), Cache::CacheCleaner));
+            if (clean_it != mCache.end())
             {
-               delete *clean_it;
+               if (*clean_it != NULL)
+               {
+                  delete *clean_it;
+               }
+               mCache.erase(clean_it);
             }
-            mCache.erase(clean_it);
          }
+         returnUnit = new CacheUnit(blocks, dataSize);
       }
-      returnUnit = new CacheUnit(blocks, dataSize);
-   }
-   if (returnUnit != NULL)
-   {
-      if (returnUnit->data() == NULL)
+      if (returnUnit != NULL)
       {
-         delete returnUnit;
-         returnUnit = NULL;
-      }
-      else
-      {
-         mCache.push_back(returnUnit);
-         returnUnit->get();
+         if (returnUnit->data() == NULL)
+         {
+            delete returnUnit;
+            returnUnit = NULL;
+         }
+         else
+         {
+            mCache.push_back(returnUnit);
+            returnUnit->get();
+            returnUnit->setLastAccess(mpModelSvcs->getRasterCacheAccess());
+         }
       }
    }
+
+   // the returned unit is referenced, so it will not be released by the budget
+   mpModelSvcs->enforceRasterCacheBudget();
    return returnUnit;
 }
 
+const RasterElement* Cache::getRasterElement() const
+{
+   return mpRasterElement;
+}
+
+size_t Cache::getCacheSize() const
+{
+   mta::MutexLock lock(mMutex);
+
+   size_t cacheSize = 0;
+   for (cache_t::const_iterator it = mCache.begin(); it != mCache.end(); ++it)
+   {
+      cacheSize += (*it)->dataSize();
+   }
+   return cacheSize;
+}
+
+uint64_t Cache::getOldestAccess() const
+{
+   mta::MutexLock lock(mMutex);
+
+   // units are moved to the back when used, so the first available unit is the oldest
+   cache_t::const_iterator clean_it(find_if(mCache.begin(), mCache.end(), Cache::CacheCleaner));
+   if (clean_it == mCache.end())
+   {
+      return numeric_limits<uint64_t>::max();
+   }
+   return (*clean_it)->lastAccess();
+}
+
+bool Cache::releaseOldest()
+{
+   mta::MutexLock lock(mMutex);
+
+   cache_t::iterator clean_it(find_if(mCache.begin(), mCache.end(), Cache::CacheCleaner));
+   if (clean_it == mCache.end())
+   {
+      return false;
+   }
+   delete *clean_it;
+   mCache.erase(clean_it);
+   return true;
+}
+
 bool Cache::CacheLocator(vector<unsigned int> blockNumbers, CacheUnit *pUnit)
 {
    // cases:
@@ -203,7 +276,8 @@ GeoTiffPager::GeoTiffPager() :
          mColumnCount(0),
          mBandCount(0),
          mBytesPerElement(0),
-         mpTiff(NULL)
+         mpTiff(NULL),
+         mCounters("GeoTiffPager")
 {
    setName("GeoTiffPager");
    setCopyright(APP_COPYRIGHT);
@@ -235,6 +309,7 @@ bool GeoTiffPager::getInputSpecification(PlugInArgList *&pArgList)
    VERIFY(pArgList->addArg<unsigned int>("numBands"));
    VERIFY(pArgList->addArg<unsigned int>("bytesPerElement"));
    VERIFY(pArgList->addArg<unsigned int>("cacheBlocks", 8));
+   VERIFY(pArgList->addArg<RasterElement>("rasterElement", NULL));
    VERIFY(pArgList->addArg<Filename>("Filename", NULL));
 
    return true;
@@ -288,6 +363,8 @@ bool GeoTiffPager::execute(PlugInArgList *pInputArgList, PlugInArgList *)
    }
 
    mBlockCache.initCacheSize(cacheBlocks);
+   mBlockCache.setRasterElement(pInputArgList->getPlugInArgValue<RasterElement>("rasterElement"));
+   mCounters.setRasterElement(mBlockCache.getRasterElement());
 
    Filename* pFilename = pInputArgList->getPlugInArgValue<Filename>("Filename");
    if (pFilename == NULL)
@@ -307,6 +384,7 @@ RasterPage* GeoTiffPager::getPage(DataRequest *pOriginalRequest,
       DimensionDescriptor startColumn, 
       DimensionDescriptor startBand)
 {
+   mCounters.addGetPageCall();
    if (pOriginalRequest == NULL)
    {
       return NULL;
@@ -320,7 +398,7 @@ RasterPage* GeoTiffPager::getPage(DataRequest *pOriginalRequest,
    GeoTiffPage* pPage(NULL);
 
    // ensure only one thread enters this code at a time
-   mta::MutexLock lock(mMutex);
+   PagerCounters::TimedLock lock(mMutex, mCounters);
 
    // we wrap all this in a try/catch so we can have one exit point
    // and ensure that the mutex gets unlocked on an error
@@ -334,6 +412,14 @@ RasterPage* GeoTiffPager::getPage(DataRequest *pOriginalRequest,
       unsigned int colNumber = startColumn.getOnDiskNumber();
       unsigned int bandNumber = startBand.getOnDiskNumber();
 
+      // the last tile of a tiled request is clipped to the edge of the data
+      const bool tiled = pOriginalRequest->getTiled();
+      if (tiled && rowNumber < mRowCount && colNumber < mColumnCount)
+      {
+         concurrentRows = min(concurrentRows, mRowCount - rowNumber);
+         concurrentColumns = min(concurrentColumns, mColumnCount - colNumber);
+      }
+
       // make sure the request is valid
       if ((rowNumber >= mRowCount) || ((rowNumber + concurrentRows) > mRowCount) ||
          (colNumber >= mColumnCount) || ((colNumber + concurrentColumns) > mColumnCount) ||
@@ -343,6 +429,9 @@ RasterPage* GeoTiffPager::getPage(DataRequest *pOriginalRequest,
          throw string();
       }
 
+      // The number of bands in each pixel of the loaded data
+      const unsigned int bandSkip(mInterleave == BIP ? mBandCount : 1);
+
       if ((mInterleave == BSQ) && (concurrentBands != 1))
       {
          throw string("BSQ data can only be accessed one band at a time.");
@@ -400,7 +489,8 @@ RasterPage* GeoTiffPager::getPage(DataRequest *pOriginalRequest,
                pPage = new GeoTiffPage(pCacheUnit,
                            (numRowsOffset * mColumnCount * mBandCount * mBytesPerElement) +
                            (colNumber * mBandCount * mBytesPerElement) + (bandNumber * mBytesPerElement),
-                           numRowsAvailable, 0, 0);
+                           numRowsAvailable, tiled ? concurrentColumns : 0, 0,
+                           tiled ? (mColumnCount - concurrentColumns) * bandSkip * mBytesPerElement : 0);
             }
          }
          else if (mInterleave == BSQ)
@@ -417,7 +507,8 @@ RasterPage* GeoTiffPager::getPage(DataRequest *pOriginalRequest,
                const unsigned int numRowsAvailable = (uiRowsPerStrip * (endStrip - startStrip + 1)) - numRowsOffset;
                pPage = new GeoTiffPage(pCacheUnit,
                   (numRowsOffset * mColumnCount * mBytesPerElement) + (colNumber * mBytesPerElement),
-                  numRowsAvailable, 0, 0);
+                  numRowsAvailable, tiled ? concurrentColumns : 0, 0,
+                  tiled ? (mColumnCount - concurrentColumns) * bandSkip * mBytesPerElement : 0);
             }
          }
 
@@ -428,6 +519,8 @@ RasterPage* GeoTiffPager::getPage(DataRequest *pOriginalRequest,
          if (pCacheUnit->isEmpty())
          {
             // we need to load this block
+            mCounters.addCacheMiss();
+            PagerCounters::Timer timer;
             char* pData(pCacheUnit->data());
             if (pData == NULL)
             {
@@ -443,10 +536,16 @@ RasterPage* GeoTiffPager::getPage(DataRequest *pOriginalRequest,
                   throw string("Error reading TIFF data");
                }
                pBlockPos += bytesRead;
+               mCounters.addBytesFetched(bytesRead);
             }
 
+            mCounters.addDecodeTime(timer.getElapsed());
             pCacheUnit->setIsEmpty(false);
          }
+         else
+         {
+            mCounters.addCacheHit();
+         }
       }
       else
       {
@@ -495,86 +594,104 @@ RasterPage* GeoTiffPager::getPage(DataRequest *pOriginalRequest,
          // This is stated in the TIFF 6.0 spec on page 68 (in the TileOffsets definition)
          const uint32 tileOffset(mInterleave == BIP ? 0 : bandNumber * tilesAcross * tilesDown);
 
-         // The 0-based index of the first desired tile
-         const ttile_t startTileIndex(rowNumber / tileLength);
+         // The rows of tiles which contain the requested rows
+         const uint32 startTileRow(rowNumber / tileLength);
+         const uint32 endTileRow((rowNumber + concurrentRows - 1) / tileLength);
 
-         // The tile containing the first column of the first requested row
-         const ttile_t startTile(tileOffset + startTileIndex * tilesAcross);
-         if (startTile < 0)
+         // The columns of tiles which contain the requested columns
+         // Unless the request is tiled, entire rows of tiles are loaded
+         uint32 startTileColumn(0);
+         uint32 endTileColumn(tilesAcross - 1);
+         if (tiled)
          {
-            throw string("Cannot determine startTile");
+            startTileColumn = colNumber / tileWidth;
+            endTileColumn = (colNumber + concurrentColumns - 1) / tileWidth;
          }
 
-         // The 0-based index of the last desired tile
-         const ttile_t endTileIndex((rowNumber + concurrentRows - 1) / tileLength);
-
-         // The tile containing the last column of the last requested row
-         const ttile_t endTile(tileOffset + endTileIndex * tilesAcross + tilesAcross - 1);
-         if (endTile < 0)
+         // The tiles to load, in the order in which they are stored in the cache unit
+         vector<unsigned int> tiles;
+         for (uint32 tileRow = startTileRow; tileRow <= endTileRow; ++tileRow)
          {
-            throw string("Cannot determine endTile");
+            for (uint32 tileColumn = startTileColumn; tileColumn <= endTileColumn; ++tileColumn)
+            {
+               tiles.push_back(tileOffset + tileRow * tilesAcross + tileColumn);
+            }
          }
 
          // Retrieve a block from the cache
-         GeoTiffOnDisk::CacheUnit* pCacheUnit(mBlockCache.getCacheUnit(startTile, endTile, tileSize));
+         GeoTiffOnDisk::CacheUnit* pCacheUnit(mBlockCache.getCacheUnit(tiles, tileSize));
          if (pCacheUnit == NULL)
          {
             throw string("Cannot create a cache unit");
          }
 
-         // The number of bands in pPage
-         const unsigned int bandSkip(mInterleave == BIP ? mBandCount : 1);
-
-         // The number of columns in pPage
-         const unsigned int columnSkip(mColumnCount);
+         // The first column and the number of columns in the cache unit
+         const unsigned int unitStartColumn(startTileColumn * tileWidth);
+         const unsigned int unitColumns(min((endTileColumn + 1) * tileWidth, mColumnCount) - unitStartColumn);
+         const size_t pixelSize(bandSkip * mBytesPerElement);
 
          // The offset of the first requested data within pPage
-         const size_t offset(mBytesPerElement *
-            ((rowNumber % tileLength) * columnSkip * bandSkip + (mInterleave == BSQ ? 0 : bandNumber)));
+         const size_t offset(mBytesPerElement * (mInterleave == BSQ ? 0 : bandNumber) +
+            pixelSize * ((rowNumber % tileLength) * unitColumns + (colNumber - unitStartColumn)));
 
          // The number of rows in pPage
-         const unsigned int rowSkip(tileLength * ((endTile - startTile + 1) / tilesAcross));
+         const unsigned int rowSkip(tileLength * (endTileRow - startTileRow + 1) - (rowNumber % tileLength));
 
          // Create a GeoTiffPage based on the computed values
-         pPage = new GeoTiffPage(pCacheUnit, offset, rowSkip, columnSkip, bandSkip);
+         // A tiled page only contains the requested columns of each row of the cache unit
+         if (tiled)
+         {
+            pPage = new GeoTiffPage(pCacheUnit, offset, rowSkip, concurrentColumns, bandSkip,
+               (unitColumns - concurrentColumns) * pixelSize);
+         }
+         else
+         {
+            pPage = new GeoTiffPage(pCacheUnit, offset, rowSkip, unitColumns, bandSkip);
+         }
+
          if (pCacheUnit->isEmpty())
          {
+            mCounters.addCacheMiss();
+            PagerCounters::Timer timer;
+
             // Temporary storage for the working tile
             vector<unsigned char> tileData(tileSize);
-            for (ttile_t curTile = startTile, tileNum = 0; curTile <= endTile; ++curTile, ++tileNum)
+            const uint32 unitTilesAcross(endTileColumn - startTileColumn + 1);
+            for (size_t tileNum = 0; tileNum < tiles.size(); ++tileNum)
             {
-               if (TIFFReadEncodedTile(mpTiff, curTile, &tileData[0], tileSize) != tileSize)
+               if (TIFFReadEncodedTile(mpTiff, tiles[tileNum], &tileData[0], tileSize) != tileSize)
                {
                   throw string("Error reading TIFF data");
                }
+               mCounters.addBytesFetched(tileSize);
 
                // The starting address of this tile within pPage
                char* pBlockPos(pCacheUnit->data());
 
                // Increment by one or more rows of tiles
-               pBlockPos += tileSize * tilesAcross * bandSkip * mBytesPerElement * (tileNum / tilesAcross);
+               pBlockPos += pixelSize * tileLength * unitColumns * (tileNum / unitTilesAcross);
 
                // Increment by one or more tiles within a row
-               pBlockPos += tileWidth * bandSkip * mBytesPerElement * (tileNum % tilesAcross);
+               const unsigned int tileStartColumn(tileWidth * (tileNum % unitTilesAcross));
+               pBlockPos += pixelSize * tileStartColumn;
 
                // The number of bytes to copy - this might be different for partial tiles (e.g.: at the end of a row)
-               size_t numBytesToCopy = tileWidth;
-               if ((tileNum + 1) % tilesAcross == 0 && mColumnCount % tileWidth != 0)
-               {
-                  numBytesToCopy = mColumnCount % tileWidth;
-               }
-
-               numBytesToCopy *= bandSkip * mBytesPerElement;
+               size_t numBytesToCopy = min(tileWidth, unitColumns - tileStartColumn) * pixelSize;
                for (uint32 row = 0; row < tileLength; ++row)
                {
-                  const size_t rowOffset = row * mColumnCount * bandSkip * mBytesPerElement;
-                  const size_t tileOffset = row * tileWidth * bandSkip * mBytesPerElement;
-                  memcpy(pBlockPos + rowOffset, &tileData[tileOffset], numBytesToCopy);
+                  const size_t rowOffset = row * unitColumns * pixelSize;
+                  const size_t tileRowOffset = row * tileWidth * pixelSize;
+                  memcpy(pBlockPos + rowOffset, &tileData[tileRowOffset], numBytesToCopy);
                }
             }
 
+            mCounters.addDecodeTime(timer.getElapsed());
             pCacheUnit->setIsEmpty(false);
          }
+         else
+         {
+            mCounters.addCacheHit();
+         }
       }
    }
    catch (const string& exc)
@@ -588,6 +705,11 @@ RasterPage* GeoTiffPager::getPage(DataRequest *pOriginalRequest,
       }
    }
 
+   if (pPage != NULL)
+   {
+      mCounters.addPageLeased();
+   }
+
    return pPage;
 }
 
@@ -603,9 +725,10 @@ void GeoTiffPager::releasePage(RasterPage *pPage)
 
    GeoTiffPage* pGeoTiffPage = static_cast<GeoTiffPage*>(pPage);
    delete pGeoTiffPage;
+   mCounters.addPageReleased();
 }
 
 int GeoTiffPager::getSupportedRequestVersion() const
 {
-   return 1;
+   return 2;
 }
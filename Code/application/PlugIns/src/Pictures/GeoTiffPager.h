@@ -12,11 +12,14 @@
 
 #include "DMutex.h"
 #include "ModelServices.h"
+#include "PagerCounters.h"
 #include "PlugInManagerServices.h"
+#include "RasterCache.h"
 #include "RasterPagerShell.h"
 #include "tiffio.h"
 #include "TypesFile.h"
 
+#include <boost/atomic.hpp>
 #include <deque>
 
 class GeoTiffPage;
@@ -39,17 +42,20 @@ public:
    char* data() const;
    bool isEmpty() const;
    void setIsEmpty(bool v);
+   uint64_t lastAccess() const;
+   void setLastAccess(uint64_t access);
 
 private:
-   unsigned int mReferenceCount;
+   boost::atomic<unsigned int> mReferenceCount;
    std::vector<unsigned int> mBlockNumbers;
    size_t mDataSize;
    char* mpData;
    Service<ModelServices> mpModelSvcs;
    bool mIsEmpty;
+   uint64_t mLastAccess;
 };
 
-class Cache
+class Cache : public RasterCache
 {
 public:
    typedef std::deque<CacheUnit*> cache_t;
@@ -59,16 +65,25 @@ public:
    ~Cache();
 
    void initCacheSize(unsigned int cacheSize);
+   void setRasterElement(const RasterElement* pElement);
 
    CacheUnit* getCacheUnit(unsigned int startBlock, unsigned int endBlock, size_t blockSize);
    CacheUnit* getCacheUnit(std::vector<unsigned int>& blocks, size_t blockSize);
 
+   // RasterCache
+   const RasterElement* getRasterElement() const;
+   size_t getCacheSize() const;
+   uint64_t getOldestAccess() const;
+   bool releaseOldest();
+
 private:
    static bool CacheLocator(std::vector<unsigned int> blockNumbers, CacheUnit* pUnit);
    static bool CacheCleaner(const CacheUnit* pUnit);
 
    cache_t mCache;
    unsigned int mCacheSize;
+   const RasterElement* mpRasterElement;
+   mutable mta::DMutex mMutex;
    Service<ModelServices> mpModelSvcs;
 };
 
@@ -106,6 +121,7 @@ private:
    Service<PlugInManagerServices> mpPluginSvcs;
    Service<ModelServices> mpModelSvcs;
    GeoTiffOnDisk::Cache mBlockCache;
+   PagerCounters mCounters;
 };
 
 #endif
@@ -86,6 +86,14 @@ void SampleRasterPager::releasePage(RasterPage* pPage)
    delete dynamic_cast<SampleRasterPage*>(pPage);
 }
 
+void SampleRasterPager::prefetchPage(DataRequest* pOriginalRequest,
+                                     DimensionDescriptor startRow,
+                                     DimensionDescriptor startColumn,
+                                     DimensionDescriptor startBand)
+{
+   // Pages are generated on demand, so there is nothing to read ahead
+}
+
 int SampleRasterPager::getSupportedRequestVersion() const
 {
    return 1;
@@ -43,6 +43,8 @@ public:
    virtual RasterPage* getPage(DataRequest* pOriginalRequest, DimensionDescriptor startRow,
       DimensionDescriptor startColumn, DimensionDescriptor startBand);
    virtual void releasePage(RasterPage* pPage);
+   virtual void prefetchPage(DataRequest* pOriginalRequest, DimensionDescriptor startRow,
+      DimensionDescriptor startColumn, DimensionDescriptor startBand);
    virtual int getSupportedRequestVersion() const;
 };
 
@@ -99,10 +99,7 @@ bool RasterTimingTest::execute(PlugInArgList* pInArgList, PlugInArgList* pOutArg
             }
          }
       }
-      for (int i = 0; i < bands; ++i)
-      {
-         pElement->getStatistics(pDesc->getActiveBand(i))->getMin();
-      }
+      pElement->calculateStatistics(pDesc->getBands());
       // set grayscale display mode
       DisplayMode initialDisplayMode = pLayer->getDisplayMode();
       pLayer->setDisplayMode(GRAYSCALE_MODE);
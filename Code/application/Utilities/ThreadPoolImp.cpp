@@ -0,0 +1,275 @@
+/*
+ * The information in this file is
+ * Copyright(c) 2007 Ball Aerospace & Technologies Corporation
+ * and is subject to the terms and conditions of the
+ * GNU Lesser General Public License Version 2.1
+ * The license text is available from   
+ * http://www.gnu.org/licenses/lgpl.html
+ */
+
+#include "AppVerify.h"
+#include "ConfigurationSettings.h"
+#include "ThreadPoolImp.h"
+
+#include <algorithm>
+
+class ThreadPool::TaskGroup
+{
+public:
+   explicit TaskGroup(unsigned int taskCount) :
+      mRemaining(taskCount)
+   {}
+
+   mta::DMutex mMutex;
+   mta::DThreadSignal mCompletedSignal;
+   unsigned int mRemaining;
+};
+
+ThreadPoolImp::ThreadPoolImp() :
+   mStartedCount(0),
+   mQueuedCount(0),
+   mNextWorker(0),
+   mStopping(false)
+{
+   unsigned int workerCount = std::max(ConfigurationSettings::getSettingThreadCount(), 1U);
+   for (unsigned int i = 0; i < workerCount; ++i)
+   {
+      Worker* pWorker = new Worker;
+      pWorker->mpPool = this;
+      pWorker->mIndex = i;
+      pWorker->mThread.ThreadSetThreadData(static_cast<void*>(pWorker));
+      pWorker->mThread.ThreadSetRunFunction(reinterpret_cast<void*>(workerThread));
+      mWorkers.push_back(pWorker);
+   }
+
+   // The workers record their thread IDs before any task is queued, so isWorkerThread() can compare them
+   // without a lock
+   mta::MutexLock lock(mIdleMutex);
+   for (std::vector<Worker*>::iterator iter = mWorkers.begin(); iter != mWorkers.end(); ++iter)
+   {
+      (*iter)->mThread.ThreadLaunch();
+   }
+
+   while (mStartedCount < mWorkers.size())
+   {
+      mStartedSignal.ThreadSignalWait(&mIdleMutex);
+   }
+}
+
+ThreadPoolImp::~ThreadPoolImp()
+{
+   {
+      mta::MutexLock lock(mIdleMutex);
+      mStopping = true;
+      for (std::vector<Worker*>::size_type i = 0; i < mWorkers.size(); ++i)
+      {
+         mWorkSignal.ThreadSignalActivate();
+      }
+   }
+
+   // The workers look in each other's queues until they stop, so none are deleted until all have stopped
+   for (std::vector<Worker*>::iterator iter = mWorkers.begin(); iter != mWorkers.end(); ++iter)
+   {
+      (*iter)->mThread.ThreadWait();
+   }
+
+   for (std::vector<Worker*>::iterator iter = mWorkers.begin(); iter != mWorkers.end(); ++iter)
+   {
+      delete *iter;
+   }
+}
+
+unsigned int ThreadPoolImp::getWorkerCount() const
+{
+   return static_cast<unsigned int>(mWorkers.size());
+}
+
+bool ThreadPoolImp::isWorkerThread() const
+{
+   return getCurrentWorker() >= 0;
+}
+
+ThreadPool::TaskGroup* ThreadPoolImp::startTasks(const std::vector<Task*>& tasks)
+{
+   TaskGroup* pGroup = new TaskGroup(static_cast<unsigned int>(tasks.size()));
+
+   // A worker queues its tasks for itself so that they run while it waits, and the other workers steal them
+   int currentWorker = getCurrentWorker();
+   for (std::vector<Task*>::const_iterator iter = tasks.begin(); iter != tasks.end(); ++iter)
+   {
+      QueuedTask task;
+      task.mpTask = *iter;
+      task.mpGroup = pGroup;
+
+      int workerIndex = currentWorker;
+      if (workerIndex < 0)
+      {
+         mta::MutexLock lock(mIdleMutex);
+         workerIndex = static_cast<int>(mNextWorker++ % mWorkers.size());
+      }
+
+      queueTask(workerIndex, task);
+   }
+
+   return pGroup;
+}
+
+void ThreadPoolImp::waitForTasks(TaskGroup* pGroup)
+{
+   if (pGroup == NULL)
+   {
+      return;
+   }
+
+   // A worker runs queued tasks until none of them are left to take, then waits for the rest like any
+   // other thread
+   int currentWorker = getCurrentWorker();
+   if (currentWorker >= 0)
+   {
+      QueuedTask task;
+      while (true)
+      {
+         {
+            mta::MutexLock lock(pGroup->mMutex);
+            if (pGroup->mRemaining == 0)
+            {
+               break;
+            }
+         }
+
+         if (takeTask(currentWorker, task) == false)
+         {
+            break;
+         }
+
+         runTask(task);
+      }
+   }
+
+   {
+      mta::MutexLock lock(pGroup->mMutex);
+      while (pGroup->mRemaining > 0)
+      {
+         pGroup->mCompletedSignal.ThreadSignalWait(&pGroup->mMutex);
+      }
+   }
+
+   delete pGroup;
+}
+
+void ThreadPoolImp::runTasks(const std::vector<Task*>& tasks)
+{
+   waitForTasks(startTasks(tasks));
+}
+
+void ThreadPoolImp::workerThread(Worker* pWorker)
+{
+   VERIFYNRV(pWorker != NULL);
+   ThreadPoolImp* pPool = pWorker->mpPool;
+
+   {
+      mta::MutexLock lock(pPool->mIdleMutex);
+      pWorker->mThreadId = pthread_self();
+      ++pPool->mStartedCount;
+      pPool->mStartedSignal.ThreadSignalActivate();
+   }
+
+   while (true)
+   {
+      QueuedTask task;
+      if (pPool->takeTask(pWorker->mIndex, task))
+      {
+         pPool->runTask(task);
+         continue;
+      }
+
+      // The queued tasks are run before the workers stop
+      mta::MutexLock lock(pPool->mIdleMutex);
+      while (pPool->mQueuedCount == 0 && pPool->mStopping == false)
+      {
+         pPool->mWorkSignal.ThreadSignalWait(&pPool->mIdleMutex);
+      }
+
+      if (pPool->mQueuedCount == 0 && pPool->mStopping)
+      {
+         return;
+      }
+   }
+}
+
+int ThreadPoolImp::getCurrentWorker() const
+{
+   pthread_t currentThread = pthread_self();
+   for (std::vector<Worker*>::size_type i = 0; i < mWorkers.size(); ++i)
+   {
+      if (pthread_equal(mWorkers[i]->mThreadId, currentThread))
+      {
+         return static_cast<int>(i);
+      }
+   }
+
+   return -1;
+}
+
+void ThreadPoolImp::queueTask(int workerIndex, const QueuedTask& task)
+{
+   {
+      Worker* pWorker = mWorkers[workerIndex];
+      mta::MutexLock lock(pWorker->mMutex);
+      pWorker->mTasks.push_back(task);
+   }
+
+   mta::MutexLock lock(mIdleMutex);
+   ++mQueuedCount;
+   mWorkSignal.ThreadSignalActivate();
+}
+
+bool ThreadPoolImp::takeTask(int workerIndex, QueuedTask& task)
+{
+   // The newest task of the worker's own queue is the most likely to use data which is still cached, and the
+   // oldest task of another queue is the most likely to be a large piece of work
+   std::vector<Worker*>::size_type workerCount = mWorkers.size();
+   for (std::vector<Worker*>::size_type i = 0; i < workerCount; ++i)
+   {
+      Worker* pWorker = mWorkers[(workerIndex + i) % workerCount];
+      bool found = false;
+      {
+         mta::MutexLock lock(pWorker->mMutex);
+         if (pWorker->mTasks.empty() == false)
+         {
+            if (i == 0)
+            {
+               task = pWorker->mTasks.back();
+               pWorker->mTasks.pop_back();
+            }
+            else
+            {
+               task = pWorker->mTasks.front();
+               pWorker->mTasks.pop_front();
+            }
+            found = true;
+         }
+      }
+
+      if (found)
+      {
+         mta::MutexLock lock(mIdleMutex);
+         --mQueuedCount;
+         return true;
+      }
+   }
+
+   return false;
+}
+
+void ThreadPoolImp::runTask(const QueuedTask& task)
+{
+   task.mpTask->run();
+
+   TaskGroup* pGroup = task.mpGroup;
+   mta::MutexLock lock(pGroup->mMutex);
+   if (--pGroup->mRemaining == 0)
+   {
+      pGroup->mCompletedSignal.ThreadSignalActivate();
+   }
+}
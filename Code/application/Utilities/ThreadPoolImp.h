@@ -0,0 +1,71 @@
+/*
+ * The information in this file is
+ * Copyright(c) 2007 Ball Aerospace & Technologies Corporation
+ * and is subject to the terms and conditions of the
+ * GNU Lesser General Public License Version 2.1
+ * The license text is available from   
+ * http://www.gnu.org/licenses/lgpl.html
+ */
+
+#ifndef THREADPOOLIMP_H
+#define THREADPOOLIMP_H
+
+#include "bthread.h"
+#include "DMutex.h"
+#include "ThreadPool.h"
+
+#include <deque>
+#include <vector>
+
+class ThreadPoolImp : public ThreadPool
+{
+public:
+   ThreadPoolImp();
+   ~ThreadPoolImp();
+
+   unsigned int getWorkerCount() const;
+   bool isWorkerThread() const;
+   TaskGroup* startTasks(const std::vector<Task*>& tasks);
+   void waitForTasks(TaskGroup* pGroup);
+   void runTasks(const std::vector<Task*>& tasks);
+
+private:
+   ThreadPoolImp(const ThreadPoolImp& rhs);
+   ThreadPoolImp& operator=(const ThreadPoolImp& rhs);
+
+   struct QueuedTask
+   {
+      Task* mpTask;
+      TaskGroup* mpGroup;
+   };
+
+   struct Worker
+   {
+      ThreadPoolImp* mpPool;
+      unsigned int mIndex;
+      BThread mThread;
+      pthread_t mThreadId;               // set by the worker before the constructor of the pool returns
+      mta::DMutex mMutex;
+      std::deque<QueuedTask> mTasks;     // the worker takes from the back, and other workers steal from the front
+   };
+
+   static void workerThread(Worker* pWorker);
+
+   int getCurrentWorker() const;
+   void queueTask(int workerIndex, const QueuedTask& task);
+   bool takeTask(int workerIndex, QueuedTask& task);
+   void runTask(const QueuedTask& task);
+
+   std::vector<Worker*> mWorkers;
+
+   // Idle workers wait for mQueuedCount to become non-zero
+   mta::DMutex mIdleMutex;
+   mta::DThreadSignal mWorkSignal;
+   mta::DThreadSignal mStartedSignal;
+   unsigned int mStartedCount;
+   unsigned int mQueuedCount;
+   unsigned int mNextWorker;
+   bool mStopping;
+};
+
+#endif
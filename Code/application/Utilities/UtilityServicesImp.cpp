@@ -21,6 +21,7 @@
 #include "ProgressAdapter.h"
 #include "SessionManager.h"
 #include "StringUtilities.h"
+#include "ThreadPoolImp.h"
 #include "ThreadSafeProgressAdapter.h"
 #include "UtilityServicesImp.h"
 #include "xmlreader.h"
@@ -45,6 +46,15 @@ struct SecurityFieldValue
 UtilityServicesImp* UtilityServicesImp::spInstance = NULL;
 bool UtilityServicesImp::mDestroyed = false;
 
+UtilityServicesImp::UtilityServicesImp() :
+   mpThreadPool(NULL)
+{}
+
+UtilityServicesImp::~UtilityServicesImp()
+{
+   delete mpThreadPool;
+}
+
 UtilityServicesImp* UtilityServicesImp::instance()
 {
    if (spInstance == NULL)
@@ -131,6 +141,18 @@ unsigned int UtilityServicesImp::getNumProcessors() const
 #endif
 }
 
+ThreadPool* UtilityServicesImp::getThreadPool()
+{
+   // Algorithms in other threads may ask for the pool at the same time as the main thread
+   mta::MutexLock lock(mThreadPoolMutex);
+   if (mpThreadPool == NULL)
+   {
+      mpThreadPool = new ThreadPoolImp;
+   }
+
+   return mpThreadPool;
+}
+
 std::string UtilityServicesImp::getDefaultClassification() const
 {
    if (!mClassificationOverride.empty())
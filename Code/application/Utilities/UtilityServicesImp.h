@@ -10,6 +10,7 @@
 #ifndef _UTILITYSERVICESIMP_H
 #define _UTILITYSERVICESIMP_H
 
+#include "DMutex.h"
 #include "UtilityServices.h"
 #include "TypesFile.h"
 
@@ -22,6 +23,7 @@ class Progress;
 class ProgressImp;
 class MessageLogMgr;
 class Options;
+class ThreadPoolImp;
 
 class UtilityServicesImp : public UtilityServices
 {
@@ -35,6 +37,7 @@ public:
    void destroyProgress(Progress* pProgress);
    MessageLogMgr* getMessageLog() const;
    unsigned int getNumProcessors() const;
+   ThreadPool* getThreadPool();
    std::string getDefaultClassification() const;
    ColorType getAutoColor(int color_index) const;
 
@@ -69,13 +72,15 @@ public:
    virtual std::string getTextFromFile(const std::string& filename);
 
 protected:
-   virtual ~UtilityServicesImp() {};
-   UtilityServicesImp() {};
+   virtual ~UtilityServicesImp();
+   UtilityServicesImp();
 
 private:
    std::map<DateTime*, DateTimeImp*> mDts;
    std::map<Progress*, ProgressImp*> mProgs;
    std::map<std::string, std::string> mSubtypeDirectories;
+   ThreadPoolImp* mpThreadPool;
+   mta::DMutex mThreadPoolMutex;
 
    std::vector<std::string> mCountryCodes;
    std::vector<std::string> mCodeword;